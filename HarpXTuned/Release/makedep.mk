@@ -0,0 +1,48 @@
+################################################################################
+# Automatically-generated file. Do not edit or delete the file
+################################################################################
+
+src\asf\common\services\clock\xmega\sysclk.c
+
+src\asf\common\services\fifo\fifo.c
+
+src\asf\common\services\hugemem\avr8\avr8_hugemem.c
+
+src\asf\common\services\serial\usart_serial.c
+
+src\asf\common\services\sleepmgr\xmega\sleepmgr.c
+
+src\asf\common\services\spi\xmega_spi\spi_master.c
+
+src\asf\common\utils\stdio\read.c
+
+src\asf\common\utils\stdio\write.c
+
+src\asf\xmega\boards\xmega_a1_xplained\init.c
+
+src\asf\xmega\drivers\adc\adc.c
+
+src\asf\xmega\drivers\cpu\ccp.s
+
+src\asf\xmega\drivers\dac\dac.c
+
+src\asf\xmega\drivers\ebi\ebi.c
+
+src\asf\xmega\drivers\ioport\ioport.c
+
+src\asf\xmega\drivers\nvm\nvm.c
+
+src\asf\xmega\drivers\nvm\nvm_asm.s
+
+src\asf\xmega\drivers\rtc\rtc.c
+
+src\asf\xmega\drivers\spi\spi.c
+
+src\asf\xmega\drivers\tc\tc.c
+
+src\asf\xmega\drivers\usart\usart.c
+
+src\asf\xmega\drivers\wdt\wdt.c
+
+src\main.c
+
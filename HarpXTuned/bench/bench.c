@@ -0,0 +1,1642 @@
+/**
+ * \file
+ *
+ * \brief Benchmarks of the DSP core
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <compiler.h>
+#include <conf_profile.h>
+#include "dsp/adpcm.h"
+#include "dsp/cic.h"
+#include "dsp/fft.h"
+#include "dsp/fixmath.h"
+#include "dsp/goertzel.h"
+#include "dsp/log2.h"
+#include "dsp/window.h"
+#include "dsp/yin.h"
+#include "notes.h"
+#include "bench.h"
+
+//! Transform of the FFT engine, as the profile's
+#define BENCH_LOG2_N            PITCH_FFT_LOG2_N
+#define BENCH_N                 (1U << BENCH_LOG2_N)
+//! Deepest decimation of the FFT engine, as the profile's or pitch_fft.h
+#ifdef PITCH_FFT_LOG2_DECIM_MAX
+#  define BENCH_FFT_LOG2_DECIM_MAX PITCH_FFT_LOG2_DECIM_MAX
+#else
+#  define BENCH_FFT_LOG2_DECIM_MAX 0
+#endif
+//! Partials of the fit of the FFT engine, as the profile's or pitch_fft.h
+#ifdef PITCH_FFT_PARTIALS
+#  define BENCH_FFT_PARTIALS    PITCH_FFT_PARTIALS
+#else
+#  define BENCH_FFT_PARTIALS    0
+#endif
+//! FFT engine settings, the pitch_fft.h defaults
+#define BENCH_FFT_MIN_HZ        25
+#define BENCH_FFT_SHS_HZ        110
+#define BENCH_FFT_SHS_HARMONICS 4
+#define BENCH_FFT_DECIM_BAND_SHIFT 1
+//! Hop of the phase vocoder of the FFT engine, the pitch_fft.h default
+#define BENCH_FFT_PV_HOP        (BENCH_N / 2)
+#define BENCH_FFT_PV_SHIFT      1
+//! Decimated samples kept by the FFT engine, both frames of the vocoder
+#define BENCH_FFT_RING          (2 * BENCH_N)
+//! Coarse transform of the chromatic mode, the pitch_fft.h defaults
+#define BENCH_FFT_COARSE_LOG2_N (BENCH_LOG2_N - 2)
+#define BENCH_FFT_COARSE_N      (1U << BENCH_FFT_COARSE_LOG2_N)
+#define BENCH_FFT_COARSE_LOG2_DECIM 1
+#define BENCH_FFT_CHROMATIC_MAX_HZ 2100
+//! Deepest decimation of the streaming engines
+#define BENCH_STREAM_LOG2_DECIM_MAX 5
+
+//! Smallest level of a reading, the PITCH_*_MIN_LEVEL of every engine
+#define BENCH_MIN_LEVEL         64
+//! Pitch filter settings, the pitch.h defaults
+#define BENCH_FILTER_DRIFT      16
+#define BENCH_FILTER_LOG2_JUMP  6
+
+//! Frames fed per timed slice of the streaming engines
+#define BENCH_CHUNK             64
+//! Signal fed to the streaming engines, ms
+#ifndef BENCH_STREAM_MS
+#  define BENCH_STREAM_MS       1000
+#endif
+//! Error within which a reading counts as settled, cents
+#define BENCH_SETTLED_CENTS     5.0
+
+//! Goertzel block in periods of the note
+#define BENCH_GOERTZEL_PERIODS  16
+
+//! YIN settings, the pitch_yin.h defaults
+#define BENCH_YIN_MAX_LAG       96
+#define BENCH_YIN_HISTORY       128
+#define BENCH_YIN_LAGS_PER_STEP 4
+#define BENCH_YIN_THRESHOLD     38
+#define BENCH_YIN_PERIODS       4
+#define BENCH_YIN_MAX_LEAK      6
+
+//! Synthetic tone: fundamental in ADC LSB, partials 2 and 3 at 1/2 and 1/4
+#define BENCH_AMPLITUDE         900
+//! Peak of the uniform noise added, ADC LSB
+#define BENCH_NOISE             8
+//! Input rate of the CIC decimator
+#define BENCH_ADC_HZ            ((double)SAMPLERATE * OVERSAMPLING)
+
+//! Repetitions of a kernel timing
+#define BENCH_REPS              64
+
+//! \name Gain changes of \ref cic_rescale()
+//@{
+//! Log2 of the top gain, as CAPTURE_AGC_LOG2_GAIN for 4x
+#define BENCH_RESCALE_GAIN      2
+//! Tone at the top gain, ADC LSB peak, and its frequency
+#define BENCH_RESCALE_LEVEL     1800.0
+#define BENCH_RESCALE_HZ        440.0
+//! Frames before and after the change
+#define BENCH_RESCALE_FRAMES    64
+//@}
+
+//! \name Synthetic plucks
+//@{
+//! Notes of the chromatic sweep, C1 to A#6, the 33 Hz to 1.9 kHz of the
+//! chromatic mode
+#define BENCH_CHROMATIC_LO      24
+#define BENCH_CHROMATIC_HI      94
+//! Partials of a plucked string
+#define BENCH_PLUCK_PARTIALS    8
+//! Strings of the other channels ringing on, heard through the pickup
+#define BENCH_SYMPATHETIC       3
+//! Oscillators of a pluck, its own partials and those of the others
+#define BENCH_PLUCK_OSCS        (BENCH_PLUCK_PARTIALS * (1 + BENCH_SYMPATHETIC))
+//! Point plucked, as a fraction of the string from its end
+#define BENCH_PLUCK_POINT       0.3
+//! Level of a sympathetic string against the one plucked
+#define BENCH_SYMPATHY          0.1
+//! Decay time of the fundamental, s, in the bass and the treble
+#define BENCH_DECAY_BASS        3.0
+#define BENCH_DECAY_TREBLE      0.4
+//! Inharmonicity B in the bass and the treble
+#define BENCH_B_BASS            30e-6
+#define BENCH_B_TREBLE          300e-6
+//! Finger noise at the attack, against BENCH_AMPLITUDE, and its decay, s
+#define BENCH_ATTACK            0.25
+#define BENCH_ATTACK_TIME       0.004
+//! Mains hum of the pickup, ADC LSB peak, and its frequency
+#define BENCH_HUM               6.0
+#define BENCH_HUM_HZ            50.0
+//! Gaussian noise of the pickup, ADC LSB rms
+#define BENCH_PICKUP_NOISE      4.0
+//@}
+
+//! Fill \a s with up to \a n frames at SAMPLERATE, returns the count
+typedef uint16_t (*bench_fill_t)(void *ctx, int16_t *s, uint16_t n);
+
+//! Synthetic tone through the CIC decimator of the capture
+struct bench_tone {
+	uint32_t phase;
+	uint32_t step;
+	uint32_t seed;
+	struct cic_state cic;
+};
+
+//! One decaying partial, a phasor turned and shrunk every ADC sample
+struct bench_osc {
+	double re;
+	double im;
+	double c;
+	double s;
+};
+
+//! Synthetic pluck with what the pickup hears besides, through the CIC
+struct bench_pluck {
+	struct bench_osc osc[BENCH_PLUCK_OSCS];
+	uint8_t oscs;
+	double attack;
+	double attack_decay;
+	double hum_phase;
+	double hum_step;
+	uint32_t seed;
+	struct cic_state cic;
+};
+
+//! Frames of a recording
+struct bench_file {
+	const int16_t *s;
+	uint32_t left;
+};
+
+//! Outcome of one engine run
+struct bench_result {
+	//! Last reading, Hz, 0 if none
+	double freq;
+	//! Signal before the readings settled on the reference, ms, or -1
+	double latency;
+	//! Cost per frame of one channel, in bench_unit
+	double cost;
+	//! The note is outside what the engine can tell apart
+	bool unsupported;
+};
+
+//! Filters the readings of a run as pitch_filter() does, and tracks when
+//! they settle on the reference
+struct bench_settle {
+	double ref;
+	double at;
+	//! Filtered pitch, Q16.16 Hz, 0 to start over, and its variance
+	pitch_hz_t freq;
+	uint16_t var;
+};
+
+//! Summary of one engine over the synthetic tones
+struct bench_summary {
+	const char *name;
+	double max_error;
+	double sum_sq;
+	double latency;
+	double cost;
+	uint8_t runs;
+	uint8_t missed;
+	uint8_t unsupported;
+};
+
+//! Second order CIC of the FFT engine, as pitch_fft_fetch()
+struct bench_decim {
+	uint32_t i1;
+	uint32_t i2;
+	uint32_t c1;
+	uint32_t c2;
+	uint8_t d;
+	uint8_t left;
+	//! Outputs still to drop while the integrators fill
+	uint8_t skip;
+};
+
+//! Streaming YIN state, as struct yin_channel of pitch_yin.c
+struct bench_yin {
+	int16_t hist[BENCH_YIN_HISTORY];
+	uint32_t d[BENCH_YIN_MAX_LAG + 1];
+	uint8_t pos;
+	uint8_t cursor;
+	uint8_t min_lag;
+	uint8_t max_lag;
+	uint8_t leak;
+};
+
+static fft_complex_t bench_fft_buf[BENCH_N / 2];
+static uint16_t bench_fft_mag[BENCH_N / 2];
+//! Decimated samples of the FFT engine, the newest BENCH_FFT_RING
+static int16_t bench_fft_ring[BENCH_FFT_RING];
+static struct bench_yin bench_yin_state;
+
+//! Kernel results kept from being optimised away
+static volatile uint32_t bench_sink;
+
+//! Harp strings played, C1 to G7, and how far each is detuned
+static const uint8_t bench_notes[] = {
+	24, 31, 36, 43, 48, 55, 60, 67, 72, 79, 84, 91, 96, 103,
+};
+static const int8_t bench_detune[] = { 7, -13, 3, -22 };
+
+/**
+ * \brief Cents from \a ref to \a freq
+ */
+static double bench_cents(double freq, double ref)
+{
+	return 1200.0 / M_LN2 * log(freq / ref);
+}
+
+/**
+ * \brief Equal temperament frequency of \a note
+ */
+static double bench_note_hz(uint8_t note)
+{
+	return 440.0 * pow(2.0, ((int16_t)note - NOTES_A4) / 12.0);
+}
+
+/**
+ * \brief Equal temperament note nearest to \a freq
+ */
+static uint8_t bench_nearest(double freq)
+{
+	return notes_nearest(notes_from_hz((pitch_hz_t)(freq * 65536.0)));
+}
+
+/**
+ * \brief Start the readings of a run against \a ref
+ */
+static void bench_settle_init(struct bench_settle *st, double ref)
+{
+	st->ref = ref;
+	st->at = -1;
+	st->freq = 0;
+	st->var = 0;
+}
+
+/**
+ * \brief Take an estimate of \a freq at \a level, 0 Hz if none, made
+ * \a frames after the onset
+ *
+ * The estimate goes through the filter of pitch_filter_take() first, and
+ * the readings have settled from the first that is within
+ * BENCH_SETTLED_CENTS of the reference and stays so.
+ *
+ * \return The reading, the filtered pitch
+ */
+static double bench_settle(struct bench_settle *st, double freq,
+		uint16_t level, uint32_t frames)
+{
+	pitch_hz_t est = (pitch_hz_t)(freq * 65536.0 + 0.5);
+	uint16_t noise = Max((BENCH_MIN_LEVEL << 8) / Max(level, 1), 1);
+	int32_t diff = (int32_t)(est - st->freq);
+	uint16_t gain;
+
+	if (freq <= 0 || level < BENCH_MIN_LEVEL) {
+		st->freq = 0;
+		st->at = -1;
+		return 0;
+	}
+	if (!st->freq || (uint32_t)abs(diff)
+			> (st->freq >> BENCH_FILTER_LOG2_JUMP)) {
+		st->freq = est;
+		st->var = noise;
+	} else {
+		st->var += BENCH_FILTER_DRIFT;
+		gain = ((uint32_t)st->var << 8) / (st->var + noise);
+		st->freq += (diff * gain) / 256;
+		st->var = ((uint32_t)st->var * (256 - gain)) >> 8;
+	}
+
+	freq = st->freq / 65536.0;
+	if (fabs(bench_cents(freq, st->ref)) > BENCH_SETTLED_CENTS) {
+		st->at = -1;
+	} else if (st->at < 0) {
+		st->at = frames * 1000.0 / SAMPLERATE;
+	}
+	return freq;
+}
+
+/**
+ * \brief Start a tone of \a freq, returns the frequency actually played
+ */
+static double bench_tone_init(struct bench_tone *t, double freq)
+{
+	memset(t, 0, sizeof(*t));
+	t->step = (uint32_t)(freq / BENCH_ADC_HZ * 4294967296.0 + 0.5);
+	t->seed = 1;
+	return t->step * (BENCH_ADC_HZ / 4294967296.0);
+}
+
+/**
+ * \brief Next ADC sample of a tone
+ */
+static int16_t bench_tone_adc(struct bench_tone *t)
+{
+	int32_t x;
+
+	t->phase += t->step;
+	x = 4L * fft_cos_phase(t->phase >> 16)
+			+ 2L * fft_cos_phase((uint16_t)((t->phase * 2) >> 16))
+			+ fft_cos_phase((uint16_t)((t->phase * 3) >> 16));
+	x = (x * BENCH_AMPLITUDE) >> 17;
+	t->seed = t->seed * 1103515245UL + 12345;
+	return (int16_t)(x + (int32_t)((t->seed >> 16)
+			% (2 * BENCH_NOISE + 1)) - BENCH_NOISE);
+}
+
+/**
+ * \brief \ref bench_fill_t of a tone, decimated as the capture does
+ */
+static uint16_t bench_tone_fill(void *ctx, int16_t *s, uint16_t n)
+{
+	struct bench_tone *t = ctx;
+	uint16_t i;
+	uint8_t j;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < OVERSAMPLING; j++) {
+			cic_integrate(&t->cic, bench_tone_adc(t));
+		}
+		s[i] = cic_compensate(&t->cic, cic_comb(&t->cic));
+	}
+	return n;
+}
+
+/**
+ * \brief Uniform noise in [-1, 1) from the generator of \a seed
+ */
+static double bench_uniform(uint32_t *seed)
+{
+	*seed = *seed * 1103515245UL + 12345;
+	return (double)(*seed >> 8) / 8388608.0 - 1.0;
+}
+
+/**
+ * \brief Add the partials of a string of \a f1 Hz, \a note, to \a p at
+ * \a level of BENCH_AMPLITUDE
+ *
+ * Partial n sits at n f0 sqrt(1 + B n^2), f0 such that the first is at
+ * \a f1, with the amplitude of a pluck at BENCH_PLUCK_POINT, sin(n pi P)
+ * / n^2, and a decay quicker with n. B and the decay go from the bass to
+ * the treble geometrically over the harp strings. Partials above the
+ * Nyquist frequency of the ADC are left out.
+ */
+static void bench_pluck_string(struct bench_pluck *p, uint8_t note,
+		double f1, double level)
+{
+	double t = ((double)note - bench_notes[0])
+			/ (bench_notes[sizeof(bench_notes) - 1] - bench_notes[0]);
+	double b;
+	double tau;
+	double f0;
+	uint8_t n;
+
+	t = Max(0.0, Min(1.0, t));
+	b = BENCH_B_BASS * pow(BENCH_B_TREBLE / BENCH_B_BASS, t);
+	tau = BENCH_DECAY_BASS * pow(BENCH_DECAY_TREBLE / BENCH_DECAY_BASS, t);
+	f0 = f1 / sqrt(1.0 + b);
+
+	for (n = 1; n <= BENCH_PLUCK_PARTIALS; n++) {
+		struct bench_osc *o = &p->osc[p->oscs];
+		double f = n * f0 * sqrt(1.0 + b * n * n);
+		double w = 2.0 * M_PI * f / BENCH_ADC_HZ;
+		double r = exp(-(1.0 + 0.3 * (n - 1)) / (tau * BENCH_ADC_HZ));
+
+		if (f >= BENCH_ADC_HZ / 2 || p->oscs == BENCH_PLUCK_OSCS) {
+			break;
+		}
+		o->re = level * BENCH_AMPLITUDE * sin(n * M_PI * BENCH_PLUCK_POINT)
+				/ (sin(M_PI * BENCH_PLUCK_POINT) * n * n);
+		o->im = 0;
+		o->c = r * cos(w);
+		o->s = r * sin(w);
+		p->oscs++;
+	}
+}
+
+/**
+ * \brief Pluck string \a note at \a f1 Hz, the \a index th of the run
+ *
+ * The other channels ring on at \a sympathy of the level plucked, none
+ * if 0, with the string an octave below, a fifth above and an octave
+ * above, each detuned in turn by \ref bench_detune.
+ */
+static void bench_pluck_init(struct bench_pluck *p, uint8_t note, double f1,
+		uint8_t index, double sympathy)
+{
+	static const int8_t others[BENCH_SYMPATHETIC] = { -12, 7, 12 };
+	uint8_t k;
+
+	memset(p, 0, sizeof(*p));
+	bench_pluck_string(p, note, f1, 1.0);
+	for (k = 0; sympathy > 0 && k < BENCH_SYMPATHETIC; k++) {
+		uint8_t other = note + others[k];
+		int8_t cents = bench_detune[(index + k + 1) % sizeof(bench_detune)];
+
+		bench_pluck_string(p, other, bench_note_hz(other)
+				* pow(2.0, cents / 1200.0), sympathy);
+	}
+	p->attack = BENCH_ATTACK * BENCH_AMPLITUDE;
+	p->attack_decay = exp(-1.0 / (BENCH_ATTACK_TIME * BENCH_ADC_HZ));
+	p->hum_step = 2.0 * M_PI * BENCH_HUM_HZ / BENCH_ADC_HZ;
+	p->seed = 1 + note;
+}
+
+/**
+ * \brief Next ADC sample of a pluck
+ *
+ * The finger noise of the attack, the hum with its third harmonic and the
+ * Gaussian noise of the pickup, the sum of four uniforms, come on top.
+ */
+static int16_t bench_pluck_adc(struct bench_pluck *p)
+{
+	double x = 0;
+	double g = 0;
+	uint8_t i;
+
+	for (i = 0; i < p->oscs; i++) {
+		struct bench_osc *o = &p->osc[i];
+		double re = o->re * o->c - o->im * o->s;
+
+		o->im = o->re * o->s + o->im * o->c;
+		o->re = re;
+		x += o->im;
+	}
+	x += p->attack * bench_uniform(&p->seed);
+	p->attack *= p->attack_decay;
+	p->hum_phase += p->hum_step;
+	if (p->hum_phase > 2.0 * M_PI) {
+		p->hum_phase -= 2.0 * M_PI;
+	}
+	x += BENCH_HUM * (sin(p->hum_phase) + 0.5 * sin(3.0 * p->hum_phase));
+	for (i = 0; i < 4; i++) {
+		g += bench_uniform(&p->seed);
+	}
+	// Four uniforms in [-1, 1) have a variance of 4/3
+	x += BENCH_PICKUP_NOISE * g * 0.8660254;
+	return (int16_t)Max(-2047.0, Min(2047.0, floor(x + 0.5)));
+}
+
+/**
+ * \brief \ref bench_fill_t of a pluck, decimated as the capture does
+ */
+static uint16_t bench_pluck_fill(void *ctx, int16_t *s, uint16_t n)
+{
+	struct bench_pluck *p = ctx;
+	uint16_t i;
+	uint8_t j;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < OVERSAMPLING; j++) {
+			cic_integrate(&p->cic, bench_pluck_adc(p));
+		}
+		s[i] = cic_compensate(&p->cic, cic_comb(&p->cic));
+	}
+	return n;
+}
+
+/**
+ * \brief \ref bench_fill_t of a recording
+ */
+static uint16_t bench_file_fill(void *ctx, int16_t *s, uint16_t n)
+{
+	struct bench_file *f = ctx;
+
+	if (n > f->left) {
+		n = (uint16_t)f->left;
+	}
+	memcpy(s, f->s, n * sizeof(*s));
+	f->s += n;
+	f->left -= n;
+	return n;
+}
+
+/**
+ * \brief Bin nearest partial \a h of fundamental \a f, BENCH_FFT_SHS_HARMONICS
+ * units per bin, as pitch_fft_partial()
+ */
+static uint16_t bench_fft_partial(uint16_t f, uint8_t h)
+{
+	return ((uint32_t)h * f + BENCH_FFT_SHS_HARMONICS / 2)
+			/ BENCH_FFT_SHS_HARMONICS;
+}
+
+/**
+ * \brief Move \a k to the strongest of bin \a k and its neighbours, as
+ * pitch_fft_local()
+ */
+static uint16_t bench_fft_local(uint16_t *k)
+{
+	uint16_t b = *k;
+
+	if (bench_fft_mag[b - 1] > bench_fft_mag[*k]) {
+		*k = b - 1;
+	}
+	if (bench_fft_mag[b + 1] > bench_fft_mag[*k]) {
+		*k = b + 1;
+	}
+	return bench_fft_mag[*k];
+}
+
+/**
+ * \brief Peak of bins \a lo to \a hi, by subharmonic summation of
+ * \a harmonics partials if more than one, as pitch_fft_peak()
+ *
+ * \param partial Receives the partial the peak is of
+ */
+static uint16_t bench_fft_peak(uint16_t lo, uint16_t hi, uint8_t harmonics,
+		uint8_t *partial)
+{
+	uint16_t fundamental = lo * BENCH_FFT_SHS_HARMONICS;
+	uint32_t best = 0;
+	uint16_t peak = lo;
+	uint16_t f;
+	uint16_t k;
+	uint8_t h;
+
+	*partial = 1;
+	if (harmonics == 1) {
+		for (k = lo + 1; k <= hi; k++) {
+			if (bench_fft_mag[k] > bench_fft_mag[peak]) {
+				peak = k;
+			}
+		}
+		return peak;
+	}
+	for (f = fundamental; f <= hi * BENCH_FFT_SHS_HARMONICS; f++) {
+		uint32_t sum = 0;
+
+		for (h = 1; h <= harmonics; h++) {
+			k = bench_fft_partial(f, h);
+			if (k > BENCH_N / 2 - 2) {
+				break;
+			}
+			sum += bench_fft_mag[k];
+		}
+		if (sum > best) {
+			best = sum;
+			fundamental = f;
+		}
+	}
+	peak = bench_fft_partial(fundamental, 1);
+	bench_fft_local(&peak);
+	for (h = 2; h <= harmonics; h++) {
+		k = bench_fft_partial(fundamental, h);
+		if (k > BENCH_N / 2 - 2) {
+			break;
+		}
+		if (bench_fft_local(&k) > bench_fft_mag[peak]) {
+			peak = k;
+			*partial = h;
+		}
+	}
+	return peak;
+}
+
+/**
+ * \brief Copy the BENCH_N decimated samples before ring position \a end
+ * to \a s, oldest first
+ *
+ * \return Their sum
+ */
+static int32_t bench_fft_copy(uint16_t end, int16_t *s)
+{
+	int32_t sum = 0;
+	uint16_t k;
+
+	for (k = 0; k < BENCH_N; k++) {
+		s[k] = bench_fft_ring[(end - BENCH_N + k) & (BENCH_FFT_RING - 1)];
+		sum += s[k];
+	}
+	return sum;
+}
+
+/**
+ * \brief Phase of bin \a k of the BENCH_N samples \a s, 65536 being a full
+ * turn, as pitch_fft_phase()
+ */
+static uint16_t bench_fft_phase(const int16_t *s, uint16_t k)
+{
+	uint16_t step = k << (FFT_LOG2_N_MAX - BENCH_LOG2_N);
+	uint16_t a = 0;
+	int32_t re = 0;
+	int32_t im = 0;
+	uint16_t i;
+
+	for (i = 0; i < BENCH_N; i++) {
+		int16_t v = fixmath_q15_mul(s[i], window_coef(i, BENCH_LOG2_N));
+
+		re += fixmath_mul16(v, fft_cos(a)) >> 8;
+		im -= fixmath_mul16(v,
+				fft_cos((a - FFT_N_MAX / 4) & (FFT_N_MAX - 1))) >> 8;
+		a = (a + step) & (FFT_N_MAX - 1);
+	}
+	return fft_phase(re, im);
+}
+
+/**
+ * \brief Refine the peak at bin \a k by its phase advance over
+ * BENCH_FFT_PV_HOP samples to ring position \a end, as pitch_fft_pv()
+ *
+ * \param pos Parabola estimate, Q8 bins
+ *
+ * \return The refined position, Q16 bins, or \a pos if they disagree
+ */
+static uint32_t bench_fft_pv(uint16_t end, uint16_t k, uint32_t pos)
+{
+	int16_t *s = (int16_t *)bench_fft_buf;
+	uint16_t turn;
+	int32_t m;
+	uint32_t fine;
+
+	bench_fft_copy(end - BENCH_FFT_PV_HOP, s);
+	turn = -bench_fft_phase(s, k);
+	bench_fft_copy(end, s);
+	turn += bench_fft_phase(s, k);
+	m = ((int32_t)(pos >> BENCH_FFT_PV_SHIFT) - (turn >> 8) + 128) >> 8;
+
+	if (m < 0) {
+		return pos << 8;
+	}
+	fine = (((uint32_t)m << 16) + turn) << BENCH_FFT_PV_SHIFT;
+	if (fine > (pos << 8) + 0x10000UL || fine + 0x10000UL < (pos << 8)) {
+		return pos << 8;
+	}
+	return fine;
+}
+
+/**
+ * \brief Start the CIC of pitch_fft_fetch() at a decimation of 2^\a d
+ */
+static void bench_decim_init(struct bench_decim *c, uint8_t d)
+{
+	memset(c, 0, sizeof(*c));
+	c->d = d;
+	c->left = 1U << d;
+	c->skip = d ? 2 : 0;
+}
+
+/**
+ * \brief Take frame \a x into the CIC
+ *
+ * \retval true if \a y holds a new decimated sample
+ */
+static bool bench_decim_step(struct bench_decim *c, int16_t x, int16_t *y)
+{
+	uint32_t d1;
+
+	c->i1 += (uint32_t)(int32_t)x;
+	c->i2 += c->i1;
+	if (--c->left) {
+		return false;
+	}
+	c->left = 1U << c->d;
+	d1 = c->i2 - c->c1;
+	*y = (int16_t)((int32_t)(d1 - c->c2) >> (2 * c->d));
+	c->c1 = c->i2;
+	c->c2 = d1;
+	// The first outputs are those of the integrators filling
+	if (c->skip) {
+		c->skip--;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \brief Left shift taking the \a 2^\a log2_n samples \a s to full scale,
+ * their mean of \a sum going to \a mean
+ */
+static uint8_t bench_fft_shift(const int16_t *s, uint8_t log2_n, int32_t sum,
+		int16_t *mean)
+{
+	uint16_t top = 0;
+	uint8_t shift = 0;
+	uint16_t k;
+
+	*mean = (int16_t)(sum >> log2_n);
+	for (k = 0; k < (1U << log2_n); k++) {
+		top = Max(top, (uint16_t)abs(s[k] - *mean));
+	}
+	while (shift < 14 && ((uint32_t)top << (shift + 1)) <= INT16_MAX) {
+		shift++;
+	}
+	return shift;
+}
+
+/**
+ * \brief Decimation and bins of a search from \a lo_hz to \a hi_hz, as
+ * pitch_fft_set_range()
+ *
+ * \return The decimation, log2
+ */
+static uint8_t bench_fft_range(double lo_hz, double hi_hz, uint8_t harmonics,
+		uint16_t *lo, uint16_t *hi)
+{
+	uint8_t partials = Max(harmonics, BENCH_FFT_PARTIALS);
+	double width;
+	uint8_t d = 0;
+
+	// Deepest decimation keeping the top partial searched clear of it
+	while (d < BENCH_FFT_LOG2_DECIM_MAX && hi_hz * partials
+			< (SAMPLERATE >> (d + 2 + BENCH_FFT_DECIM_BAND_SHIFT))) {
+		d++;
+	}
+	width = (double)(SAMPLERATE >> d) / BENCH_N;
+	*lo = (uint16_t)(lo_hz / width);
+	*lo = Max(*lo, (uint16_t)ceil(BENCH_FFT_MIN_HZ / width));
+	*lo = Max(*lo, 2 * WINDOW_LOBE);
+	*hi = (uint16_t)ceil(hi_hz / width);
+	*hi = Min(*hi, BENCH_N / 2 - 2);
+	*lo = Min(*lo, *hi);
+	return d;
+}
+
+/**
+ * \brief Run the FFT engine on bins \a lo to \a hi at a decimation of
+ * 2^\a d, see \ref bench_fft()
+ */
+static void bench_fft_run(bench_fill_t fill, void *ctx, uint8_t d,
+		uint16_t lo, uint16_t hi, uint8_t harmonics, uint32_t frames,
+		struct bench_settle *st, struct bench_result *r)
+{
+	int16_t *s = (int16_t *)bench_fft_buf;
+	int16_t chunk[BENCH_CHUNK];
+	double width = (double)(SAMPLERATE >> d) / BENCH_N;
+	struct bench_decim cic;
+	uint32_t cost = 0;
+	uint32_t done = 0;
+	uint32_t start;
+	uint32_t vertex;
+	uint16_t filled = 0;
+	uint16_t level;
+	uint16_t pos = 0;
+	uint16_t hop = 0;
+	uint16_t peak;
+	uint16_t i;
+	uint16_t n;
+	uint8_t partial;
+
+	bench_decim_init(&cic, d);
+	r->freq = 0;
+	while (done < frames && (n = fill(ctx, chunk, BENCH_CHUNK))) {
+		for (i = 0; i < n; i++) {
+			int16_t mean;
+			uint8_t shift;
+
+			if (bench_decim_step(&cic, chunk[i], &bench_fft_ring[pos])) {
+				pos = (pos + 1) & (BENCH_FFT_RING - 1);
+				filled = Min(filled + 1, BENCH_FFT_RING);
+			}
+			if (++hop == PITCH_FFT_HOP) {
+				hop = 0;
+			}
+			if (hop || filled < BENCH_N) {
+				continue;
+			}
+
+			// An update: the newest BENCH_N samples
+			shift = bench_fft_shift(s, BENCH_LOG2_N,
+					bench_fft_copy(pos, s), &mean);
+			start = bench_now();
+			window_apply(s, BENCH_LOG2_N, mean, shift);
+			fft_real_mag(bench_fft_buf, bench_fft_mag, BENCH_LOG2_N);
+			peak = bench_fft_peak(lo, hi, harmonics, &partial);
+			vertex = ((uint32_t)peak << 8) + fft_vertex(bench_fft_mag,
+					peak);
+			level = bench_fft_mag[peak];
+			if (peak >= WINDOW_LOBE
+					&& filled >= BENCH_N + BENCH_FFT_PV_HOP) {
+				vertex = bench_fft_pv(pos, peak, vertex);
+			} else {
+				vertex <<= 8;
+			}
+			r->freq = vertex * width / 65536.0 / partial;
+			cost += bench_now() - start;
+			r->freq = bench_settle(st, r->freq, level, done + i + 1);
+		}
+		done += n;
+	}
+	r->latency = st->at;
+	r->cost = done ? (double)cost / done : 0;
+}
+
+/**
+ * \brief FFT engine: a decimated, windowed transform of the newest
+ * BENCH_N samples every PITCH_FFT_HOP frames, and its peak around \a note
+ *
+ * The channel is decimated and searched as pitch_fft_set_range() does for
+ * a single candidate, give or take ten per cent, by subharmonic summation
+ * below BENCH_FFT_SHS_HZ. A note whose partials are closer than the main
+ * lobe of the window at that rate cannot be told from its neighbours or
+ * from DC, and is unsupported. The peak is refined by its parabola and
+ * then by the phase vocoder of pitch_fft.c; the partial tracking is left
+ * out.
+ *
+ * \param note Note searched, or 0 for the peak of the whole spectrum at
+ * SAMPLERATE
+ */
+static void bench_fft(bench_fill_t fill, void *ctx, uint8_t note,
+		uint32_t frames, struct bench_settle *st, struct bench_result *r)
+{
+	double f = bench_note_hz(note);
+	uint8_t harmonics = (f / 1.1 < BENCH_FFT_SHS_HZ)
+			? BENCH_FFT_SHS_HARMONICS : 1;
+	uint16_t lo = WINDOW_LOBE + 1;
+	uint16_t hi = BENCH_N / 2 - 2;
+	uint8_t d = 0;
+
+	r->freq = 0;
+	r->latency = -1;
+	r->cost = 0;
+	r->unsupported = false;
+	if (note) {
+		d = bench_fft_range(f / 1.1, f * 1.1, harmonics, &lo, &hi);
+		r->unsupported = f < 2 * WINDOW_LOBE
+				* (double)(SAMPLERATE >> d) / BENCH_N;
+	} else {
+		harmonics = 1;
+	}
+	if (!r->unsupported) {
+		bench_fft_run(fill, ctx, d, lo, hi, harmonics, frames, st, r);
+	}
+}
+
+/**
+ * \brief Coarse pass of the chromatic mode of the FFT engine, as
+ * pitch_fft_coarse(), on the first BENCH_FFT_COARSE_N decimated samples
+ *
+ * \retval false if they are silent, or \a lo_hz and \a hi_hz hold the
+ * range of the fine pass
+ */
+static bool bench_fft_coarse(bench_fill_t fill, void *ctx, double *lo_hz,
+		double *hi_hz)
+{
+	int16_t *s = (int16_t *)bench_fft_buf;
+	double width = (double)(SAMPLERATE >> BENCH_FFT_COARSE_LOG2_DECIM)
+			/ BENCH_FFT_COARSE_N;
+	struct bench_decim cic;
+	int32_t sum = 0;
+	uint16_t filled = 0;
+	uint16_t peak = 1;
+	uint16_t k;
+	int16_t x;
+	int16_t mean;
+	uint8_t shift;
+
+	bench_decim_init(&cic, BENCH_FFT_COARSE_LOG2_DECIM);
+	while (filled < BENCH_FFT_COARSE_N && fill(ctx, &x, 1)) {
+		if (bench_decim_step(&cic, x, &s[filled])) {
+			sum += s[filled++];
+		}
+	}
+	if (filled < BENCH_FFT_COARSE_N) {
+		return false;
+	}
+	shift = bench_fft_shift(s, BENCH_FFT_COARSE_LOG2_N, sum, &mean);
+	window_apply(s, BENCH_FFT_COARSE_LOG2_N, mean, shift);
+	fft_real_mag(bench_fft_buf, bench_fft_mag, BENCH_FFT_COARSE_LOG2_N);
+
+	for (k = 2; k < BENCH_FFT_COARSE_N / 2 - 1; k++) {
+		if (bench_fft_mag[k] > bench_fft_mag[peak]) {
+			peak = k;
+		}
+	}
+	if (bench_fft_mag[peak] < BENCH_MIN_LEVEL) {
+		return false;
+	}
+	*lo_hz = (peak - 1) * width / BENCH_FFT_SHS_HARMONICS;
+	*hi_hz = (peak + 1) * width;
+	if (peak <= WINDOW_LOBE) {
+		*lo_hz = 0;
+	}
+	*lo_hz = Max(*lo_hz, BENCH_FFT_MIN_HZ);
+	*hi_hz = Min(*hi_hz, BENCH_FFT_CHROMATIC_MAX_HZ);
+	return true;
+}
+
+/**
+ * \brief Goertzel engine: the bin of \a note and two side bins, read out
+ * every block
+ */
+static void bench_goertzel(bench_fill_t fill, void *ctx, uint8_t note,
+		uint32_t frames, struct bench_settle *st, struct bench_result *r)
+{
+	struct goertzel_bin bin[3];
+	int16_t chunk[BENCH_CHUNK];
+	double f = bench_note_hz(note);
+	double rate;
+	uint32_t cost = 0;
+	uint32_t done = 0;
+	uint32_t start;
+	int32_t acc = 0;
+	uint16_t block;
+	uint16_t count = 0;
+	uint16_t phase;
+	uint16_t half;
+	uint16_t i;
+	uint16_t n;
+	int16_t offset;
+	uint16_t level = 0;
+	bool reading;
+	uint8_t acc_count = 0;
+	uint8_t d = 0;
+
+	// A few times the note, as the rates of pitch_goertzel.h
+	while (d < BENCH_STREAM_LOG2_DECIM_MAX
+			&& f * 16 < (SAMPLERATE >> (d + 1))) {
+		d++;
+	}
+	rate = (double)(SAMPLERATE >> d);
+	block = (uint16_t)(BENCH_GOERTZEL_PERIODS * rate / f + 0.5);
+	phase = (uint16_t)(f * 65536.0 / rate + 0.5);
+	half = 0x8000U / block;
+	goertzel_bin_set(&bin[0], phase);
+	goertzel_bin_set(&bin[1], phase - half);
+	goertzel_bin_set(&bin[2], phase + half);
+
+	r->freq = 0;
+	r->unsupported = false;
+	while (done < frames && (n = fill(ctx, chunk, BENCH_CHUNK))) {
+		reading = false;
+		offset = 0;
+		start = bench_now();
+		for (i = 0; i < n; i++) {
+			acc += chunk[i];
+			if (++acc_count < (1U << d)) {
+				continue;
+			}
+			goertzel_step(&bin[0], acc);
+			goertzel_step(&bin[1], acc);
+			goertzel_step(&bin[2], acc);
+			acc = 0;
+			acc_count = 0;
+			if (++count == block) {
+				uint32_t mid = goertzel_mag(&bin[0]);
+				uint32_t lo = goertzel_mag(&bin[1]);
+
+				offset = goertzel_vertex(lo, mid, goertzel_mag(&bin[2]));
+				// Back to the amplitude of a frame, as goertzel_readout()
+				mid /= ((uint32_t)block << d) >> 1;
+				level = Min(mid, UINT16_MAX);
+				count = 0;
+				reading = true;
+			}
+		}
+		cost += bench_now() - start;
+		done += n;
+		// A block is longer than a slice, so one reading at most
+		if (reading) {
+			r->freq = f + offset * rate / (2.0 * block) / 256.0;
+			r->freq = bench_settle(st, r->freq, level, done);
+		}
+	}
+	r->latency = st->at;
+	r->cost = done ? (double)cost / done : 0;
+}
+
+/**
+ * \brief Leak shift of the YIN window, as yin_leak() of pitch_yin.c
+ */
+static uint8_t bench_yin_leak(const struct bench_yin *y, uint8_t tau)
+{
+	uint8_t sweep = (y->max_lag - y->min_lag + BENCH_YIN_LAGS_PER_STEP)
+			/ BENCH_YIN_LAGS_PER_STEP;
+	uint16_t target = (uint16_t)BENCH_YIN_PERIODS * tau / sweep;
+	uint8_t k = 1;
+
+	while (k < BENCH_YIN_MAX_LEAK && (2U << k) <= target) {
+		k++;
+	}
+	return k;
+}
+
+/**
+ * \brief YIN engine: the lags of \a note, give or take a semitone
+ */
+static void bench_yin(bench_fill_t fill, void *ctx, uint8_t note,
+		uint32_t frames, struct bench_settle *st, struct bench_result *r)
+{
+	struct bench_yin *y = &bench_yin_state;
+	int16_t chunk[BENCH_CHUNK];
+	uint16_t periods[BENCH_CHUNK];
+	uint16_t at[BENCH_CHUNK];
+	uint16_t peaks[BENCH_CHUNK];
+	double f = bench_note_hz(note);
+	uint16_t peak = 0;
+	uint16_t rate;
+	uint32_t cost = 0;
+	uint32_t done = 0;
+	uint32_t start;
+	int32_t acc = 0;
+	uint16_t i;
+	uint16_t n;
+	uint8_t found;
+	uint8_t acc_count = 0;
+	uint8_t d = 0;
+	uint8_t j;
+
+	// Periods of up to about 48 decimated samples
+	while (d < BENCH_STREAM_LOG2_DECIM_MAX
+			&& (SAMPLERATE >> d) / f > 48) {
+		d++;
+	}
+	rate = SAMPLERATE >> d;
+	memset(y, 0, sizeof(*y));
+	y->max_lag = (uint8_t)Min(rate * 1.06 / f + 2, BENCH_YIN_MAX_LAG);
+	y->min_lag = (uint8_t)Max(rate / 1.06 / f / 2, 1);
+	y->cursor = y->min_lag;
+	y->leak = bench_yin_leak(y, y->max_lag);
+
+	r->freq = 0;
+	r->unsupported = false;
+	while (done < frames && (n = fill(ctx, chunk, BENCH_CHUNK))) {
+		found = 0;
+		start = bench_now();
+		for (i = 0; i < n; i++) {
+			int16_t x;
+
+			acc += chunk[i];
+			if (++acc_count < (1U << d)) {
+				continue;
+			}
+			// The 4x oversampled scale of pitch_yin_feed()
+			x = (int16_t)(acc >> (d + CIC_LOG2_R - 2));
+			acc = 0;
+			acc_count = 0;
+			peak = Max(peak, (uint16_t)abs(x));
+
+			y->hist[y->pos] = x;
+			for (j = 0; j < BENCH_YIN_LAGS_PER_STEP; j++) {
+				uint8_t tau = y->cursor;
+				int16_t e = x - y->hist[(uint8_t)(y->pos - tau)
+						& (BENCH_YIN_HISTORY - 1)];
+
+				yin_update(&y->d[tau], e, y->leak);
+				if (++y->cursor > y->max_lag) {
+					uint16_t period = yin_period(y->d, y->min_lag,
+							y->max_lag, BENCH_YIN_THRESHOLD);
+
+					y->cursor = y->min_lag;
+					if (period) {
+						y->leak = bench_yin_leak(y, (period + 128) >> 8);
+					}
+					periods[found] = period;
+					peaks[found] = peak;
+					at[found++] = i + 1;
+					peak = 0;
+					break;
+				}
+			}
+			y->pos = (y->pos + 1) & (BENCH_YIN_HISTORY - 1);
+		}
+		cost += bench_now() - start;
+		for (j = 0; j < found; j++) {
+			r->freq = periods[j] ? yin_hz(rate, periods[j]) / 65536.0 : 0;
+			r->freq = bench_settle(st, r->freq, peaks[j], done + at[j]);
+		}
+		done += n;
+	}
+	r->latency = st->at;
+	r->cost = done ? (double)cost / done : 0;
+}
+
+/**
+ * \brief Add a result with an error of \a error cents and a cost of
+ * \a cost to \a sum
+ */
+static void bench_add(struct bench_summary *sum, double error, double cost,
+		const struct bench_result *r)
+{
+	if (r->unsupported) {
+		sum->unsupported++;
+		return;
+	}
+	sum->runs++;
+	sum->cost += cost;
+	if (r->freq <= 0 || r->latency < 0) {
+		sum->missed++;
+		return;
+	}
+	sum->latency += r->latency;
+	sum->sum_sq += error * error;
+	if (fabs(error) > sum->max_error) {
+		sum->max_error = fabs(error);
+	}
+}
+
+/**
+ * \brief How a run went: ok, missed, or unsupported for a note outside
+ * the range of the engine
+ */
+static const char *bench_status(const struct bench_result *r)
+{
+	if (r->unsupported) {
+		return "unsupported";
+	}
+	return (r->freq <= 0 || r->latency < 0) ? "missed" : "ok";
+}
+
+/**
+ * \brief Print the result of \a engine and add it to its summary
+ */
+static void bench_report(struct bench_summary *sum, uint8_t note,
+		double truth, const struct bench_result *r)
+{
+	char name[NOTES_NAME_MAX];
+	double error = r->freq > 0 ? bench_cents(r->freq, truth) : 0;
+
+	notes_name(note, name);
+	printf("accuracy,%s,%s,%.3f,%.3f,%.2f,%.1f,%.1f,%s\n", sum->name,
+			name, truth, r->freq, error, r->latency, r->cost,
+			bench_status(r));
+	bench_add(sum, error, r->cost, r);
+}
+
+/**
+ * \brief Print the summary line of an engine, as a \a kind record
+ */
+static void bench_summarize(const struct bench_summary *sum,
+		const char *kind)
+{
+	uint8_t hit = sum->runs - sum->missed;
+
+	printf("%s,%s,%.2f,%.2f,%.1f,%.1f,%u,%u\n", kind, sum->name,
+			sum->max_error, hit ? sqrt(sum->sum_sq / hit) : 0,
+			hit ? sum->latency / hit : 0,
+			sum->runs ? sum->cost / sum->runs : 0, sum->missed,
+			sum->unsupported);
+}
+
+/**
+ * \brief Print the cost and the error of the kernels
+ */
+void bench_kernels(void)
+{
+	static int16_t sweeps[OVERSAMPLING * 16][CIC_STRIDE];
+	struct cic_state cic[CIC_STRIDE];
+	struct adpcm_state enc;
+	struct adpcm_state dec;
+	struct goertzel_bin bin;
+	struct bench_tone tone;
+	uint32_t d[BENCH_YIN_MAX_LAG + 1];
+	uint8_t codes[BENCH_N];
+	double max_error = 0;
+	double signal = 0;
+	double noise = 0;
+	uint32_t start;
+	uint16_t i;
+	uint8_t ch;
+	uint8_t k;
+
+	printf("# kernel,name,%s per call,calls\n", bench_unit);
+
+	bench_tone_init(&tone, 440.0);
+	for (i = 0; i < OVERSAMPLING * 16; i++) {
+		for (ch = 0; ch < CIC_STRIDE; ch++) {
+			sweeps[i][ch] = bench_tone_adc(&tone);
+		}
+	}
+	memset(cic, 0, sizeof(cic));
+	start = bench_now();
+	for (i = 0; i < 16; i++) {
+		for (ch = 0; ch < CIC_STRIDE; ch++) {
+			bench_sink += cic_compensate(&cic[ch],
+					cic_decimate(&cic[ch], &sweeps[i * OVERSAMPLING][ch]));
+		}
+	}
+	printf("kernel,cic_decimate+compensate sweep group,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / 16), 16);
+
+	bench_tone_fill(&tone, (int16_t *)bench_fft_buf, BENCH_N);
+	start = bench_now();
+	window_apply((int16_t *)bench_fft_buf, BENCH_LOG2_N, 0, 1);
+	printf("kernel,window_apply %u,%lu,1\n", BENCH_N,
+			(unsigned long)(bench_now() - start));
+	start = bench_now();
+	fft_real_mag(bench_fft_buf, bench_fft_mag, BENCH_LOG2_N);
+	printf("kernel,fft_real_mag %u,%lu,1\n", BENCH_N,
+			(unsigned long)(bench_now() - start));
+
+	start = bench_now();
+	for (i = 0; i < BENCH_REPS; i++) {
+		bench_sink += fft_mag((int16_t)(i * 511), (int16_t)(i * -257));
+	}
+	printf("kernel,fft_mag,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_REPS), BENCH_REPS);
+	start = bench_now();
+	for (i = 0; i < BENCH_REPS; i++) {
+		bench_sink += fft_phase(i * 100003L, 50000L - i * 7919L);
+	}
+	printf("kernel,fft_phase,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_REPS), BENCH_REPS);
+
+	goertzel_bin_set(&bin, 0x0800);
+	start = bench_now();
+	for (i = 0; i < BENCH_REPS; i++) {
+		goertzel_step(&bin, (int32_t)(i * 37) - 1000);
+	}
+	printf("kernel,goertzel_step,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_REPS), BENCH_REPS);
+	start = bench_now();
+	bench_sink += goertzel_mag(&bin);
+	printf("kernel,goertzel_mag,%lu,1\n",
+			(unsigned long)(bench_now() - start));
+
+	memset(d, 0, sizeof(d));
+	start = bench_now();
+	for (i = 0; i < BENCH_REPS; i++) {
+		yin_update(&d[i % BENCH_YIN_MAX_LAG + 1],
+				(int16_t)(i * 97 - 3000), 4);
+	}
+	printf("kernel,yin_update,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_REPS), BENCH_REPS);
+	for (k = 1; k <= BENCH_YIN_MAX_LAG; k++) {
+		d[k] = 100000UL + 40000UL * abs((k % 40) - 20);
+	}
+	start = bench_now();
+	bench_sink += yin_period(d, 1, BENCH_YIN_MAX_LAG, BENCH_YIN_THRESHOLD);
+	printf("kernel,yin_period %u lags,%lu,1\n", BENCH_YIN_MAX_LAG,
+			(unsigned long)(bench_now() - start));
+
+	start = bench_now();
+	for (i = 0; i < BENCH_REPS; i++) {
+		bench_sink += notes_from_hz(PITCH_HZ(30) + i * 2000003UL);
+	}
+	printf("kernel,notes_from_hz,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_REPS), BENCH_REPS);
+	start = bench_now();
+	for (i = 0; i < BENCH_REPS; i++) {
+		bench_sink += log2_fix(PITCH_HZ(30) + i * 2000003UL);
+	}
+	printf("kernel,log2_fix,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_REPS), BENCH_REPS);
+
+	// The recorder's coder on a tone at the frame scale
+	bench_tone_fill(&tone, (int16_t *)bench_fft_buf, BENCH_N);
+	adpcm_reset(&enc);
+	start = bench_now();
+	for (i = 0; i < BENCH_N; i++) {
+		codes[i] = adpcm_encode(&enc, ((int16_t *)bench_fft_buf)[i]);
+	}
+	printf("kernel,adpcm_encode,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_N), BENCH_N);
+	adpcm_reset(&dec);
+	start = bench_now();
+	for (i = 0; i < BENCH_N; i++) {
+		bench_sink += adpcm_decode(&dec, codes[i]);
+	}
+	printf("kernel,adpcm_decode,%lu,%u\n",
+			(unsigned long)((bench_now() - start) / BENCH_N), BENCH_N);
+	adpcm_reset(&dec);
+	// Past the first 64 samples, in which the step grows to the tone
+	for (i = 0; i < BENCH_N; i++) {
+		double x = ((int16_t *)bench_fft_buf)[i];
+		double e = adpcm_decode(&dec, codes[i]) - x;
+
+		if (i >= 64) {
+			signal += x * x;
+			noise += e * e;
+		}
+	}
+	printf("conversion,adpcm snr dB,%.1f\n",
+			10.0 * log10(signal / (noise > 0 ? noise : 1)));
+
+	// Conversion error over the harp range and beyond, 20 Hz to 5 kHz
+	for (i = 0; i <= 1000; i++) {
+		double f = 20.0 * pow(250.0, i / 1000.0);
+		double cents = (double)notes_from_hz((pitch_hz_t)(f * 65536.0))
+				/ NOTES_CENTS(1) - bench_cents(f, 440.0);
+
+		if (fabs(cents) > max_error) {
+			max_error = fabs(cents);
+		}
+	}
+	printf("conversion,notes_from_hz,%.4f\n", max_error);
+}
+
+/**
+ * \internal
+ * \brief Decimated frame \a n of the rescale tone at log2 gain \a gain,
+ * taken up to the top gain as \ref capture.h does
+ */
+static int16_t bench_rescale_frame(struct cic_state *st, uint32_t n,
+		uint8_t gain)
+{
+	uint8_t j;
+
+	for (j = 0; j < OVERSAMPLING; j++) {
+		double x = BENCH_RESCALE_LEVEL / (1 << BENCH_RESCALE_GAIN)
+				* sin(2 * M_PI * BENCH_RESCALE_HZ / BENCH_ADC_HZ
+				* (n * OVERSAMPLING + j));
+
+		cic_integrate(st, (int16_t)lround(x * (1 << gain)));
+	}
+	return (int16_t)(cic_comb(st) << (BENCH_RESCALE_GAIN - gain));
+}
+
+/**
+ * \brief Check \ref cic_rescale() on every gain change of the AGC
+ *
+ * A tone runs through one decimator at the top gain and through another
+ * that changes gain halfway, rescaled as the capture does it and once
+ * without. The error against the top gain, in frame LSB, is the
+ * quantisation of the gain before the change, and no more than twice
+ * that of the lower gain right after a good one; a change without the
+ * rescale steps by about the tone's level.
+ */
+void bench_rescale(void)
+{
+	struct cic_state ref;
+	struct cic_state st;
+	struct cic_state raw;
+	int16_t steady_at[BENCH_RESCALE_GAIN + 1];
+	uint8_t from;
+	uint8_t to;
+
+	printf("# rescale,from_gain,to_gain,steady_lsb,change_lsb,"
+			"unscaled_lsb,result\n");
+	for (from = 0; from <= BENCH_RESCALE_GAIN; from++) {
+		for (to = 0; to <= BENCH_RESCALE_GAIN; to++) {
+			int16_t steady = 0;
+			int16_t change = 0;
+			int16_t unscaled = 0;
+			uint32_t n;
+
+			if (from == to) {
+				continue;
+			}
+			memset(&ref, 0, sizeof(ref));
+			memset(&st, 0, sizeof(st));
+			memset(&raw, 0, sizeof(raw));
+			for (n = 0; n < 2 * BENCH_RESCALE_FRAMES; n++) {
+				bool after = n >= BENCH_RESCALE_FRAMES;
+				uint8_t gain = after ? to : from;
+				int16_t y;
+				int16_t e;
+				int16_t e_raw;
+
+				if (n == BENCH_RESCALE_FRAMES) {
+					cic_rescale(&st, (int8_t)to - (int8_t)from);
+				}
+				y = bench_rescale_frame(&ref, n, BENCH_RESCALE_GAIN);
+				e = abs(bench_rescale_frame(&st, n, gain) - y);
+				e_raw = abs(bench_rescale_frame(&raw, n, gain) - y);
+				// The combs reach back two frames
+				if (n < 2) {
+					continue;
+				}
+				if (!after) {
+					steady = Max(steady, e);
+				} else {
+					change = Max(change, e);
+					unscaled = Max(unscaled, e_raw);
+				}
+			}
+			// Gains from 0 up, so the lower one has been measured
+			steady_at[from] = steady;
+			printf("rescale,%u,%u,%d,%d,%d,%s\n", from, to, steady, change,
+					unscaled, change <= 2 * steady_at[Min(from, to)] + 1
+					? "ok" : "FAIL");
+		}
+	}
+}
+
+/**
+ * \brief Run every engine on the synthetic tones
+ */
+void bench_synthetic(void)
+{
+	struct bench_summary sums[3] = {
+		{ .name = "fft" }, { .name = "goertzel" }, { .name = "yin" },
+	};
+	uint32_t frames = (uint32_t)BENCH_STREAM_MS * SAMPLERATE / 1000;
+	struct bench_tone tone;
+	struct bench_settle st;
+	struct bench_result r;
+	uint8_t i;
+
+	printf("# accuracy,engine,note,truth_hz,freq_hz,error_cents,"
+			"latency_ms,%s per frame,status\n", bench_unit);
+	for (i = 0; i < sizeof(bench_notes); i++) {
+		uint8_t note = bench_notes[i];
+		double freq = bench_note_hz(note)
+				* pow(2.0, bench_detune[i % sizeof(bench_detune)] / 1200.0);
+		double truth = bench_tone_init(&tone, freq);
+
+		bench_settle_init(&st, truth);
+		bench_fft(bench_tone_fill, &tone, note, frames, &st, &r);
+		bench_report(&sums[0], note, truth, &r);
+
+		bench_tone_init(&tone, freq);
+		bench_settle_init(&st, truth);
+		bench_goertzel(bench_tone_fill, &tone, note, frames, &st, &r);
+		bench_report(&sums[1], note, truth, &r);
+
+		bench_tone_init(&tone, freq);
+		bench_settle_init(&st, truth);
+		bench_yin(bench_tone_fill, &tone, note, frames, &st, &r);
+		bench_report(&sums[2], note, truth, &r);
+	}
+
+	printf("# summary,engine,max_cents,rms_cents,latency_ms,"
+			"%s per frame,missed,unsupported\n", bench_unit);
+	for (i = 0; i < 3; i++) {
+		bench_summarize(&sums[i], "summary");
+	}
+}
+
+/**
+ * \brief Run every engine on the synthetic plucks, as \a kind records,
+ * with the other strings at \a sympathy
+ */
+static void bench_pluck_run(const char *kind, double sympathy)
+{
+	static struct bench_pluck pluck;
+	struct bench_summary sums[3] = {
+		{ .name = "fft" }, { .name = "goertzel" }, { .name = "yin" },
+	};
+	uint32_t frames = (uint32_t)BENCH_STREAM_MS * SAMPLERATE / 1000;
+	char summary[32];
+	struct bench_settle st;
+	struct bench_result r;
+	uint8_t i;
+	uint8_t e;
+
+	printf("# %s,profile,engine,note,truth_hz,freq_hz,error_cents,"
+			"lock_ms,%s per hop,status\n", kind, bench_unit);
+	for (i = 0; i < sizeof(bench_notes); i++) {
+		uint8_t note = bench_notes[i];
+		double truth = bench_note_hz(note)
+				* pow(2.0, bench_detune[i % sizeof(bench_detune)] / 1200.0);
+		char name[NOTES_NAME_MAX];
+
+		notes_name(note, name);
+		for (e = 0; e < 3; e++) {
+			double error;
+
+			bench_pluck_init(&pluck, note, truth, i, sympathy);
+			bench_settle_init(&st, truth);
+			if (e == 0) {
+				bench_fft(bench_pluck_fill, &pluck, note, frames, &st, &r);
+			} else if (e == 1) {
+				bench_goertzel(bench_pluck_fill, &pluck, note, frames, &st,
+						&r);
+			} else {
+				bench_yin(bench_pluck_fill, &pluck, note, frames, &st, &r);
+			}
+			error = r.freq > 0 ? bench_cents(r.freq, truth) : 0;
+			printf("%s,%u,%s,%s,%.3f,%.3f,%.2f,%.1f,%.1f,%s\n", kind,
+					CONF_PROFILE, sums[e].name, name, truth, r.freq, error,
+					r.latency, r.cost * CAPTURE_HOP, bench_status(&r));
+			bench_add(&sums[e], error, r.cost * CAPTURE_HOP, &r);
+		}
+	}
+
+	printf("# %s_summary,profile,engine,max_cents,rms_cents,lock_ms,"
+			"%s per hop,missed,unsupported\n", kind, bench_unit);
+	snprintf(summary, sizeof(summary), "%s_summary,%u", kind, CONF_PROFILE);
+	for (e = 0; e < 3; e++) {
+		bench_summarize(&sums[e], summary);
+	}
+}
+
+/**
+ * \brief Run every engine on the synthetic plucks
+ *
+ * The records carry the profile so that the runs of several can be
+ * concatenated, as "make suite" does, and the cost is per CAPTURE_HOP
+ * frames, the slice the capture hands the engines. The plucks run twice:
+ * as pluck records with the strings of the other channels ringing on,
+ * and as pluck_damped records with them damped, which tells what the
+ * crosstalk of the pickups costs each engine from what the string does.
+ */
+void bench_plucks(void)
+{
+	bench_pluck_run("pluck", BENCH_SYMPATHY);
+	bench_pluck_run("pluck_damped", 0);
+}
+
+/**
+ * \brief Run the chromatic mode of the FFT engine on a pluck of every note
+ * from BENCH_CHROMATIC_LO to BENCH_CHROMATIC_HI
+ *
+ * The coarse pass of pitch_fft_coarse() on the attack sets the range of
+ * the fine one, which then runs on the pluck from its onset, with the
+ * other strings damped. A note below the main lobe of the window at the
+ * rate of that range is unsupported, as with \ref bench_fft().
+ */
+void bench_chromatic(void)
+{
+	static struct bench_pluck pluck;
+	struct bench_summary sum = { .name = "fft" };
+	uint32_t frames = (uint32_t)BENCH_STREAM_MS * SAMPLERATE / 1000;
+	char summary[32];
+	struct bench_settle st;
+	struct bench_result r;
+	double lo_hz;
+	double hi_hz;
+	uint16_t lo;
+	uint16_t hi;
+	uint8_t note;
+	uint8_t d;
+
+	printf("# chromatic,profile,engine,note,truth_hz,freq_hz,error_cents,"
+			"lock_ms,%s per hop,status\n", bench_unit);
+	for (note = BENCH_CHROMATIC_LO; note <= BENCH_CHROMATIC_HI; note++) {
+		double truth = bench_note_hz(note)
+				* pow(2.0, bench_detune[note % sizeof(bench_detune)] / 1200.0);
+		char name[NOTES_NAME_MAX];
+		double error;
+
+		r.freq = 0;
+		r.latency = -1;
+		r.cost = 0;
+		r.unsupported = false;
+		bench_pluck_init(&pluck, note, truth, note, 0);
+		bench_settle_init(&st, truth);
+		if (bench_fft_coarse(bench_pluck_fill, &pluck, &lo_hz, &hi_hz)) {
+			d = bench_fft_range(lo_hz, hi_hz, BENCH_FFT_SHS_HARMONICS, &lo,
+					&hi);
+			r.unsupported = truth < 2 * WINDOW_LOBE
+					* (double)(SAMPLERATE >> d) / BENCH_N;
+			if (!r.unsupported) {
+				bench_pluck_init(&pluck, note, truth, note, 0);
+				bench_fft_run(bench_pluck_fill, &pluck, d, lo, hi,
+						BENCH_FFT_SHS_HARMONICS, frames, &st, &r);
+			}
+		}
+		notes_name(note, name);
+		error = r.freq > 0 ? bench_cents(r.freq, truth) : 0;
+		printf("chromatic,%u,fft,%s,%.3f,%.3f,%.2f,%.1f,%.1f,%s\n",
+				CONF_PROFILE, name, truth, r.freq, error, r.latency,
+				r.cost * CAPTURE_HOP, bench_status(&r));
+		bench_add(&sum, error, r.cost * CAPTURE_HOP, &r);
+	}
+
+	printf("# chromatic_summary,profile,engine,max_cents,rms_cents,lock_ms,"
+			"%s per hop,missed,unsupported\n", bench_unit);
+	snprintf(summary, sizeof(summary), "chromatic_summary,%u", CONF_PROFILE);
+	bench_summarize(&sum, summary);
+}
+
+/**
+ * \brief Run every engine on \a frames frames of a recording
+ *
+ * \param truth Frequency played, or 0 to measure against the FFT reading
+ */
+void bench_recorded(const int16_t *s, uint32_t frames, double truth)
+{
+	struct bench_summary sums[3] = {
+		{ .name = "fft" }, { .name = "goertzel" }, { .name = "yin" },
+	};
+	struct bench_file file = { s, frames };
+	struct bench_settle st;
+	struct bench_result r;
+	uint8_t note;
+
+	printf("# accuracy,engine,note,truth_hz,freq_hz,error_cents,"
+			"latency_ms,%s per frame,status\n", bench_unit);
+	if (truth <= 0) {
+		// The note from the whole spectrum, the reference from its bins
+		bench_settle_init(&st, 0);
+		bench_fft(bench_file_fill, &file, 0, frames, &st, &r);
+		file.s = s;
+		file.left = frames;
+		if (r.freq <= 0) {
+			printf("# no pitch found, give the frequency played\n");
+			return;
+		}
+		note = bench_nearest(r.freq);
+		bench_settle_init(&st, 0);
+		bench_fft(bench_file_fill, &file, note, frames, &st, &r);
+		file.s = s;
+		file.left = frames;
+		if (r.freq <= 0) {
+			printf("# no pitch found, give the frequency played\n");
+			return;
+		}
+		truth = r.freq;
+	} else {
+		note = bench_nearest(truth);
+	}
+	bench_settle_init(&st, truth);
+	bench_fft(bench_file_fill, &file, note, frames, &st, &r);
+	bench_report(&sums[0], note, truth, &r);
+
+	file.s = s;
+	file.left = frames;
+	bench_settle_init(&st, truth);
+	bench_goertzel(bench_file_fill, &file, note, frames, &st, &r);
+	bench_report(&sums[1], note, truth, &r);
+
+	file.s = s;
+	file.left = frames;
+	bench_settle_init(&st, truth);
+	bench_yin(bench_file_fill, &file, note, frames, &st, &r);
+	bench_report(&sums[2], note, truth, &r);
+}
@@ -0,0 +1,52 @@
+/**
+ * \file
+ *
+ * \brief Benchmarks of the DSP core
+ *
+ * Runs the kernels of src/dsp and the cents conversion of notes.c the way
+ * the engines use them, on synthetic harp tones or on a capture snapshot
+ * from tools/hostlink.py, and reports:
+ *
+ * - the cost of every kernel per call, in nanoseconds on the host and in
+ *   CPU cycles under simavr,
+ * - the step in the decimated frames at each gain change of the
+ *   CAPTURE_AGC build, with and without \ref cic_rescale(),
+ * - the error of each engine in cents against the tone played,
+ * - the signal each engine needs from the onset before its readings
+ *   settle within 5 cents for good, in ms,
+ * - the same for synthetic plucks: inharmonic partials decaying at the
+ *   rate of the string, the strings of the other channels ringing on, the
+ *   finger noise of the attack, mains hum and pickup noise, with the cost
+ *   per capture hop, for each profile with "make suite"; and again with
+ *   the other strings damped,
+ * - the same for the chromatic mode of the FFT engine, coarse pass and
+ *   all, on a pluck of every note from 33 Hz to 1.9 kHz.
+ *
+ * The engines are modelled on pitch_fft.c, pitch_goertzel.c and
+ * pitch_yin.c with a single candidate string, the nearest note of the
+ * tone; the decimation of each is chosen for that note, and the FFT
+ * transforms every PITCH_FFT_HOP frames. Every estimate goes through the
+ * filter of pitch.c. A note an engine cannot tell apart at its rate is
+ * reported as unsupported and left out of the summary. The output is
+ * CSV, one record per line, so runs of two commits can be diffed.
+ *
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <compiler.h>
+
+//! Unit of \ref bench_now()
+extern const char bench_unit[];
+
+uint32_t bench_now(void);
+
+void bench_kernels(void);
+void bench_rescale(void);
+void bench_synthetic(void);
+void bench_plucks(void);
+void bench_chromatic(void);
+void bench_recorded(const int16_t *s, uint32_t frames, double truth);
+
+#endif /* BENCH_H */
@@ -0,0 +1,92 @@
+/**
+ * \file
+ *
+ * \brief simavr build of the DSP bench
+ *
+ * Runs on an ATmega1284P, the simavr core nearest the ATxmega128A1: the
+ * same instruction set bar the XMEGA extensions, which the DSP core does
+ * not use. Timer 1 counts CPU cycles; the report goes out on USART0,
+ * which simavr prints. The run ends sleeping with interrupts off, which
+ * stops simavr.
+ *
+ * The XMEGA takes one cycle less for some stores and loads, so the
+ * counts are a close upper bound of the cycles on the board.
+ *
+ */
+
+#include <stdio.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <compiler.h>
+#include <conf_profile.h>
+#include "bench.h"
+
+const char bench_unit[] = "cycles";
+
+//! \internal Timer 1 overflows, the upper half of the cycle count
+static volatile uint16_t bench_overflows;
+
+ISR(TIMER1_OVF_vect)
+{
+	bench_overflows++;
+}
+
+/**
+ * \brief CPU cycles, wrapping
+ */
+uint32_t bench_now(void)
+{
+	uint8_t sreg = SREG;
+	uint16_t hi;
+	uint16_t lo;
+
+	cli();
+	lo = TCNT1;
+	hi = bench_overflows;
+	// An overflow not yet taken
+	if ((TIFR1 & _BV(TOV1)) && lo < 0x8000) {
+		hi++;
+	}
+	SREG = sreg;
+	return ((uint32_t)hi << 16) | lo;
+}
+
+/**
+ * \internal
+ * \brief Write \a c to USART0
+ */
+static int bench_putchar(char c, FILE *stream)
+{
+	(void)stream;
+	loop_until_bit_is_set(UCSR0A, UDRE0);
+	UDR0 = c;
+	return 0;
+}
+
+static FILE bench_stdout = FDEV_SETUP_STREAM(bench_putchar, NULL,
+		_FDEV_SETUP_WRITE);
+
+int main(void)
+{
+	UCSR0B = _BV(TXEN0);
+	stdout = &bench_stdout;
+
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+	TIMSK1 = _BV(TOIE1);
+	sei();
+
+	printf("# HarpXTuned DSP bench, profile %u, %u Hz, %ux oversampling\n",
+			CONF_PROFILE, SAMPLERATE, OVERSAMPLING);
+	bench_kernels();
+	bench_rescale();
+	bench_synthetic();
+	bench_plucks();
+	bench_chromatic();
+
+	cli();
+	sleep_enable();
+	sleep_cpu();
+	return 0;
+}
@@ -0,0 +1,291 @@
+/**
+ * \file
+ *
+ * \brief Native build of the DSP bench
+ *
+ * Usage:
+ *
+ *     bench-p2                        kernels, synthetic tones and plucks
+ *     bench-p2 -s                     synthetic plucks only
+ *     bench-p2 -r FILE [-n CHANNELS] [-c CH] [-f HZ]
+ *     bench-p2 -d DUMP -o FILE
+ *
+ * FILE is a capture snapshot written by tools/hostlink.py, frames of
+ * CHANNELS interleaved little endian int16 samples at SAMPLERATE. HZ is
+ * the frequency played on channel CH; without it the engines are measured
+ * against the FFT.
+ *
+ * -d decodes DUMP, the output of "record dump" on the shell, into FILE in
+ * the same layout, at the recorded rate with one channel per recorded
+ * one. ADPCM recordings go through the decoder of dsp/adpcm.h.
+ *
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <compiler.h>
+#include <conf_profile.h>
+#include "dsp/adpcm.h"
+#include "bench.h"
+
+const char bench_unit[] = "ns";
+
+/**
+ * \brief Monotonic time, ns, wrapping
+ */
+uint32_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/**
+ * \internal
+ * \brief Load channel \a ch of \a channels from \a path
+ *
+ * \return The frames, to be freed, or NULL
+ */
+static int16_t *bench_load(const char *path, uint8_t channels, uint8_t ch,
+		uint32_t *frames)
+{
+	FILE *f = fopen(path, "rb");
+	int16_t *s = NULL;
+	uint8_t frame[2 * 16];
+	uint32_t n = 0;
+	uint32_t size = 0;
+
+	if (!f) {
+		perror(path);
+		return NULL;
+	}
+	while (fread(frame, 2, channels, f) == channels) {
+		if (n == size) {
+			int16_t *t;
+
+			size = size ? 2 * size : 4096;
+			t = realloc(s, size * sizeof(*s));
+			if (!t) {
+				free(s);
+				fclose(f);
+				return NULL;
+			}
+			s = t;
+		}
+		s[n++] = (int16_t)(frame[2 * ch] | (frame[2 * ch + 1] << 8));
+	}
+	fclose(f);
+	*frames = n;
+	return s;
+}
+
+/**
+ * \internal
+ * \brief Write sample \a x to \a out, little endian
+ */
+static void bench_put16(FILE *out, int16_t x)
+{
+	fputc((uint8_t)x, out);
+	fputc((uint8_t)((uint16_t)x >> 8), out);
+}
+
+/**
+ * \internal
+ * \brief Decode the record dump \a path into the snapshot \a out_path
+ *
+ * The layout is that of record.h: with ADPCM each page starts with the
+ * predictor and step index of every channel, then two frames per group
+ * of one byte per channel, the first in the low nibble.
+ *
+ * \return 0 on success
+ */
+static int bench_decode(const char *path, const char *out_path)
+{
+	struct adpcm_state st[8];
+	char line[256];
+	char format[16];
+	unsigned long bytes;
+	unsigned int rate;
+	unsigned int mask;
+	unsigned int page_size;
+	unsigned int count = 0;
+	uint8_t *data;
+	unsigned long len = 0;
+	unsigned long page;
+	unsigned long frames = 0;
+	FILE *in = fopen(path, "r");
+	FILE *out;
+	unsigned int i;
+
+	if (!in) {
+		perror(path);
+		return 1;
+	}
+	do {
+		if (!fgets(line, sizeof(line), in)) {
+			fprintf(stderr, "%s: no record header\n", path);
+			fclose(in);
+			return 1;
+		}
+	} while (sscanf(line, "record %*[^:]: %lu bytes, %u Hz, channels %x,"
+			" %15[^,], page %u", &bytes, &rate, &mask, format,
+			&page_size) != 5);
+	for (i = 0; i < 8; i++) {
+		count += (mask >> i) & 1;
+	}
+	if (!count || mask > 0xff || !page_size
+			|| (strcmp(format, "pcm") && strcmp(format, "adpcm"))) {
+		fprintf(stderr, "%s: bad record header\n", path);
+		fclose(in);
+		return 1;
+	}
+
+	data = malloc(bytes ? bytes : 1);
+	if (!data) {
+		fclose(in);
+		return 1;
+	}
+	while (len < bytes && fgets(line, sizeof(line), in)) {
+		const char *c = line;
+		unsigned int b;
+
+		while (len < bytes && sscanf(c, "%2x", &b) == 1) {
+			data[len++] = (uint8_t)b;
+			c += 2;
+		}
+	}
+	fclose(in);
+	if (len < bytes) {
+		fprintf(stderr, "%s: %lu of %lu bytes\n", path, len, bytes);
+	}
+
+	out = fopen(out_path, "wb");
+	if (!out) {
+		perror(out_path);
+		free(data);
+		return 1;
+	}
+	for (page = 0; page < len; page += page_size) {
+		const uint8_t *p = &data[page];
+		unsigned long end = Min(len - page, (unsigned long)page_size);
+		unsigned long at = 0;
+
+		if (!strcmp(format, "pcm")) {
+			for (; at + 2 * count <= end; at += 2 * count) {
+				for (i = 0; i < count; i++) {
+					bench_put16(out, (int16_t)(p[at + 2 * i]
+							| (p[at + 2 * i + 1] << 8)));
+				}
+				frames++;
+			}
+			continue;
+		}
+		if (end < 3 * count) {
+			break;
+		}
+		for (i = 0; i < count; i++, at += 3) {
+			st[i].pred = (int16_t)(p[at] | (p[at + 1] << 8));
+			st[i].index = Min(p[at + 2], ADPCM_STEPS - 1);
+		}
+		for (; at + count <= end; at += count) {
+			for (i = 0; i < count; i++) {
+				bench_put16(out, adpcm_decode(&st[i], p[at + i]));
+			}
+			for (i = 0; i < count; i++) {
+				bench_put16(out, adpcm_decode(&st[i], p[at + i] >> 4));
+			}
+			frames += 2;
+		}
+	}
+	fclose(out);
+	free(data);
+	printf("# %s: %lu frames of %u channels at %u Hz, %s\n", out_path,
+			frames, count, rate, format);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = NULL;
+	const char *dump = NULL;
+	const char *out = NULL;
+	bool plucks = false;
+	double truth = 0;
+	int16_t *s;
+	uint32_t frames;
+	int channels = CHANNELS;
+	int ch = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:n:c:f:d:o:s")) != -1) {
+		switch (opt) {
+		case 'r':
+			path = optarg;
+			break;
+		case 'd':
+			dump = optarg;
+			break;
+		case 'o':
+			out = optarg;
+			break;
+		case 's':
+			plucks = true;
+			break;
+		case 'n':
+			channels = atoi(optarg);
+			break;
+		case 'c':
+			ch = atoi(optarg);
+			break;
+		case 'f':
+			truth = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-r FILE [-n CHANNELS] [-c CH]"
+					" [-f HZ] | -d DUMP -o FILE | -s]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (dump) {
+		if (!out) {
+			fprintf(stderr, "-d needs -o FILE\n");
+			return 2;
+		}
+		return bench_decode(dump, out);
+	}
+
+	printf("# HarpXTuned DSP bench, profile %u, %u Hz, %ux oversampling\n",
+			CONF_PROFILE, SAMPLERATE, OVERSAMPLING);
+	if (plucks) {
+		bench_plucks();
+	bench_chromatic();
+		return 0;
+	}
+	if (!path) {
+		bench_kernels();
+		bench_rescale();
+		bench_synthetic();
+		bench_plucks();
+	bench_chromatic();
+		return 0;
+	}
+
+	if (channels < 1 || channels > 16 || ch < 0 || ch >= channels) {
+		fprintf(stderr, "bad channel %d of %d\n", ch, channels);
+		return 2;
+	}
+	s = bench_load(path, (uint8_t)channels, (uint8_t)ch, &frames);
+	if (!s) {
+		return 1;
+	}
+	printf("# %s channel %d, %lu frames\n", path, ch,
+			(unsigned long)frames);
+	bench_recorded(s, frames, truth);
+	free(s);
+	return 0;
+}
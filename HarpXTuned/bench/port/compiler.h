@@ -0,0 +1,44 @@
+/**
+ * \file
+ *
+ * \brief The parts of the ASF compiler.h the DSP core uses, for the bench
+ *
+ * The bench builds src/dsp and the cents conversion with the native
+ * compiler, or with avr-gcc for a megaAVR under simavr, neither of which
+ * has the XMEGA ASF.
+ *
+ */
+
+#ifndef BENCH_COMPILER_H
+#define BENCH_COMPILER_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+//! The multiplies of dsp/fixmath.h are on the megaAVR too
+#ifdef __AVR__
+#  define XMEGA 1
+#else
+#  define XMEGA 0
+#endif
+
+#define Assert(expr)    assert(expr)
+
+#define Min(a, b)       (((a) < (b)) ? (a) : (b))
+#define Max(a, b)       (((a) > (b)) ? (a) : (b))
+
+#if __SIZEOF_INT__ == 4
+#  define bench_clz32(x) ((uint8_t)__builtin_clz(x))
+#else
+#  define bench_clz32(x) ((uint8_t)__builtin_clzl(x))
+#endif
+
+//! Leading zero bits of \a x in its own width, as the ASF clz()
+#define clz(x)          ((sizeof(x) <= 2) \
+		? (uint8_t)(bench_clz32((uint32_t)(x) << 16 | 0x8000U)) \
+		: bench_clz32((uint32_t)(x)))
+
+#endif /* BENCH_COMPILER_H */
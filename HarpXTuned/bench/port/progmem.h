@@ -0,0 +1,27 @@
+/**
+ * \file
+ *
+ * \brief The ASF progmem.h for the bench
+ *
+ * Flash tables on the AVR, plain constants on the host.
+ *
+ */
+
+#ifndef BENCH_PROGMEM_H
+#define BENCH_PROGMEM_H
+
+#include <compiler.h>
+
+#ifdef __AVR__
+#  include <avr/pgmspace.h>
+#  define PROGMEM_DECLARE(type, name) \
+		const type name __attribute__((__progmem__))
+#  define PROGMEM_READ_BYTE(x)  pgm_read_byte(x)
+#  define PROGMEM_READ_WORD(x)  pgm_read_word(x)
+#else
+#  define PROGMEM_DECLARE(type, name)   const type name
+#  define PROGMEM_READ_BYTE(x)  (*(const uint8_t *)(x))
+#  define PROGMEM_READ_WORD(x)  (*(const uint16_t *)(x))
+#endif
+
+#endif /* BENCH_PROGMEM_H */
@@ -46,6 +46,7 @@
  *
  */
 
+#include <string.h>
 #include "fifo.h"
 
 int fifo_init(fifo_desc_t *fifo_desc, void *buffer, uint8_t size)
@@ -72,3 +73,111 @@ int fifo_init(fifo_desc_t *fifo_desc, void *buffer, uint8_t size)
 
 	return FIFO_OK;
 }
+
+/**
+ *  \brief Initializes a new 16-bit index FIFO.
+ *
+ *  \param fifo_desc  Pointer on the FIFO descriptor to initialize.
+ *  \param buffer     Buffer of \a size bytes.
+ *  \param size       Size of the buffer, a power of two up to
+ *                    FIFO16_SIZE_MAX.
+ *
+ *  \return Status
+ *    \retval FIFO_OK when no error occurred.
+ *    \retval FIFO_ERROR when the size is not supported.
+ */
+int fifo16_init(fifo16_desc_t *fifo_desc, void *buffer, uint16_t size)
+{
+	if (!size || (size & (size - 1)) || size > FIFO16_SIZE_MAX) {
+		return FIFO_ERROR;
+	}
+
+	// Fifo starts empty.
+	fifo_desc->read_index  = 0;
+	fifo_desc->write_index = 0;
+
+	fifo_desc->size = size;
+	fifo_desc->mask = 2 * size - 1;
+	fifo_desc->buffer = buffer;
+
+	return FIFO_OK;
+}
+
+/**
+ *  \brief Puts \a count bytes into the FIFO, all of them or none.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *  \param src        Bytes to push.
+ *  \param count      Number of bytes.
+ *
+ *  \return Status
+ *    \retval FIFO_OK when no error occurred.
+ *    \retval FIFO_ERROR_OVERFLOW when the FIFO has less than \a count
+ *            free bytes; nothing is pushed.
+ */
+int fifo16_push_block(fifo16_desc_t *fifo_desc, const void *src,
+		uint16_t count)
+{
+	uint16_t write_index = fifo_desc->write_index;
+	uint16_t used = (write_index - fifo16_load_index(&fifo_desc->read_index))
+			& fifo_desc->mask;
+	uint16_t pos = write_index & (fifo_desc->mask >> 1);
+	uint16_t span = fifo_desc->size - pos;
+
+	if (count > fifo_desc->size - used) {
+		return FIFO_ERROR_OVERFLOW;
+	}
+
+	if (count <= span) {
+		memcpy(&fifo_desc->buffer[pos], src, count);
+	} else {
+		memcpy(&fifo_desc->buffer[pos], src, span);
+		memcpy(fifo_desc->buffer, (const uint8_t *)src + span, count - span);
+	}
+
+	// Must be the last thing to do.
+	barrier();
+	fifo16_store_index(&fifo_desc->write_index,
+			(write_index + count) & fifo_desc->mask);
+
+	return FIFO_OK;
+}
+
+/**
+ *  \brief Gets \a count bytes out of the FIFO, all of them or none.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *  \param dest       Extracted bytes.
+ *  \param count      Number of bytes.
+ *
+ *  \return Status
+ *    \retval FIFO_OK when no error occurred.
+ *    \retval FIFO_ERROR_UNDERFLOW when the FIFO holds less than \a count
+ *            bytes; nothing is pulled.
+ */
+int fifo16_pull_block(fifo16_desc_t *fifo_desc, void *dest, uint16_t count)
+{
+	uint16_t read_index = fifo_desc->read_index;
+	uint16_t used = (fifo16_load_index(&fifo_desc->write_index) - read_index)
+			& fifo_desc->mask;
+	uint16_t pos = read_index & (fifo_desc->mask >> 1);
+	uint16_t span = fifo_desc->size - pos;
+
+	if (count > used) {
+		return FIFO_ERROR_UNDERFLOW;
+	}
+
+	if (count <= span) {
+		memcpy(dest, &fifo_desc->buffer[pos], count);
+	} else {
+		memcpy(dest, &fifo_desc->buffer[pos], span);
+		memcpy((uint8_t *)dest + span, fifo_desc->buffer, count - span);
+	}
+
+	// Must be the last thing to do.
+	barrier();
+	fifo16_store_index(&fifo_desc->read_index,
+			(read_index + count) & fifo_desc->mask);
+
+	return FIFO_OK;
+}
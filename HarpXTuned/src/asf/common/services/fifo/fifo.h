@@ -59,8 +59,8 @@
  * a FIFO of 4 elements can be implemented: the FIFO can really hold up to 4
  * elements. This is particurly well suited for any kind of application
  * needing a lot of small FIFO. The maximum fifo size is 128 items (uint8,
- * uint16 or uint32). Note that the driver, thanks to its conception, does
- * not use interrupt protection.
+ * uint16 or uint32); see \ref fifo16_group for larger ones. Note that the
+ * driver, thanks to its conception, does not use interrupt protection.
  *
  * @{
  */
@@ -513,6 +513,199 @@ static inline void fifo_flush(fifo_desc_t *fifo_desc)
 	fifo_desc->read_index = fifo_desc->write_index = 0;
 }
 
+/**
+ * @}
+ */
+
+/**
+ * \defgroup fifo16_group FIFO with 16-bit indices
+ *
+ * Same double-index range scheme as \ref fifo_group, with 16-bit indices,
+ * so a FIFO holds up to 4096 bytes, and with block push and pull calls
+ * that copy a span with at most two memcpy() calls, one up to the end of
+ * the buffer and one from its start.
+ *
+ * The elements are bytes; a FIFO of larger items, e.g. sample frames,
+ * moves them as blocks that are a multiple of the item size. An 8-bit CPU
+ * reads and writes the 16-bit indices in two steps, so every index access
+ * is made with interrupts off; one side of the FIFO can then run in an
+ * interrupt handler, as with \ref fifo_group.
+ *
+ * @{
+ */
+
+//! Largest size of a 16-bit index FIFO, in bytes
+#define FIFO16_SIZE_MAX 4096
+
+//! 16-bit index FIFO descriptor.
+struct fifo16_desc {
+	uint8_t *buffer;                //!< Buffer of size bytes
+	volatile uint16_t read_index;   //!< Read index
+	volatile uint16_t write_index;  //!< Write index
+	uint16_t size;                  //!< Size of the FIFO in bytes
+	uint16_t mask;                  //!< Mask of the double-index range
+};
+
+typedef struct fifo16_desc fifo16_desc_t;
+
+int fifo16_init(fifo16_desc_t *fifo_desc, void *buffer, uint16_t size);
+int fifo16_push_block(fifo16_desc_t *fifo_desc, const void *src,
+		uint16_t count);
+int fifo16_pull_block(fifo16_desc_t *fifo_desc, void *dest, uint16_t count);
+
+/**
+ *  \brief Reads a FIFO index without tearing.
+ *
+ *  \param index  Index to read.
+ *
+ *  \retval value of the index.
+ */
+static inline uint16_t fifo16_load_index(volatile uint16_t *index)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t value = *index;
+
+	cpu_irq_restore(flags);
+	return value;
+}
+
+/**
+ *  \brief Writes a FIFO index without tearing.
+ *
+ *  \param index  Index to write.
+ *  \param value  New value of the index.
+ */
+static inline void fifo16_store_index(volatile uint16_t *index,
+		uint16_t value)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	*index = value;
+	cpu_irq_restore(flags);
+}
+
+/**
+ *  \brief Returns the number of bytes in the FIFO.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *
+ *  \retval number of bytes.
+ */
+static inline uint16_t fifo16_get_used_size(fifo16_desc_t *fifo_desc)
+{
+	return (fifo16_load_index(&fifo_desc->write_index)
+			- fifo16_load_index(&fifo_desc->read_index)) & fifo_desc->mask;
+}
+
+/**
+ *  \brief Returns the number of free bytes in the FIFO.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *
+ *  \retval number of free bytes.
+ */
+static inline uint16_t fifo16_get_free_size(fifo16_desc_t *fifo_desc)
+{
+	return fifo_desc->size - fifo16_get_used_size(fifo_desc);
+}
+
+/**
+ *  \brief Tests if the FIFO is empty.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *
+ *  \retval true when the FIFO is empty.
+ *  \retval false when the FIFO is not empty.
+ */
+static inline bool fifo16_is_empty(fifo16_desc_t *fifo_desc)
+{
+	return fifo16_get_used_size(fifo_desc) == 0;
+}
+
+/**
+ *  \brief Tests if the FIFO is full.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *
+ *  \retval true when the FIFO is full.
+ *  \retval false when the FIFO is not full.
+ */
+static inline bool fifo16_is_full(fifo16_desc_t *fifo_desc)
+{
+	return fifo16_get_used_size(fifo_desc) == fifo_desc->size;
+}
+
+/**
+ *  \brief Puts a byte into the FIFO.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *  \param item       Byte to push.
+ *
+ *  \return Status
+ *    \retval FIFO_OK when no error occurred.
+ *    \retval FIFO_ERROR_OVERFLOW when the FIFO was already full.
+ */
+static inline int fifo16_push_uint8(fifo16_desc_t *fifo_desc, uint8_t item)
+{
+	uint16_t write_index = fifo_desc->write_index;
+
+	if (((write_index - fifo16_load_index(&fifo_desc->read_index))
+			& fifo_desc->mask) == fifo_desc->size) {
+		return FIFO_ERROR_OVERFLOW;
+	}
+
+	fifo_desc->buffer[write_index & (fifo_desc->mask >> 1)] = item;
+
+	// Must be the last thing to do.
+	barrier();
+	fifo16_store_index(&fifo_desc->write_index,
+			(write_index + 1) & fifo_desc->mask);
+
+	return FIFO_OK;
+}
+
+/**
+ *  \brief Gets a byte out of the FIFO.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ *  \param item       Extracted byte.
+ *
+ *  \return Status
+ *    \retval FIFO_OK when no error occurred.
+ *    \retval FIFO_ERROR_UNDERFLOW when the FIFO was empty.
+ */
+static inline int fifo16_pull_uint8(fifo16_desc_t *fifo_desc, uint8_t *item)
+{
+	uint16_t read_index = fifo_desc->read_index;
+
+	if (read_index == fifo16_load_index(&fifo_desc->write_index)) {
+		return FIFO_ERROR_UNDERFLOW;
+	}
+
+	*item = fifo_desc->buffer[read_index & (fifo_desc->mask >> 1)];
+
+	// Must be the last thing to do.
+	barrier();
+	fifo16_store_index(&fifo_desc->read_index,
+			(read_index + 1) & fifo_desc->mask);
+
+	return FIFO_OK;
+}
+
+/**
+ *  \brief Flushes a 16-bit index FIFO.
+ *
+ *  \param fifo_desc  The FIFO descriptor.
+ */
+static inline void fifo16_flush(fifo16_desc_t *fifo_desc)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	// Fifo starts empty.
+	fifo_desc->read_index = fifo_desc->write_index = 0;
+	cpu_irq_restore(flags);
+}
+
 /**
  * @}
  */
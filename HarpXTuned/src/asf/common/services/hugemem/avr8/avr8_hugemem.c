@@ -111,6 +111,123 @@ void hugemem_write32(hugemem_ptr_t to, uint_fast32_t val)
 		: "r30", "r31"
 	);
 }
+
+/**
+ * \internal
+ * \brief Bytes from \a addr up to the next 64 KiB boundary, at most \a size
+ *
+ * The block functions split their copies there, so that they do not rely on
+ * the post-increment of Z carrying into RAMPZ.
+ */
+static inline uint16_t hugemem_span(const hugemem_ptr_t addr, size_t size)
+{
+	uint16_t span = -(uint16_t)addr;
+
+	if (span == 0 || span > size) {
+		span = size;
+	}
+	return span;
+}
+
+/**
+ * \internal
+ * \brief Copy \a size bytes within one 64 KiB bank of huge memory to \a to
+ *
+ * RAMPZ and RAMPX are set up once, then the bytes are moved two per loop
+ * with post-increment loads and stores, Z in huge memory and X in internal
+ * SRAM.
+ */
+static void hugemem_read_span(uint8_t *to, const hugemem_ptr_t from,
+		uint16_t size)
+{
+	uint16_t pairs = size >> 1;
+
+	if (pairs) {
+		asm volatile(
+			"movw r30, %A2 \n\t"
+			"out %3, %C2 \n\t"
+			"out %4, __zero_reg__ \n\t"
+			"1: \n\t"
+			"ld __tmp_reg__, Z+ \n\t"
+			"st X+, __tmp_reg__ \n\t"
+			"ld __tmp_reg__, Z+ \n\t"
+			"st X+, __tmp_reg__ \n\t"
+			"sbiw %1, 1 \n\t"
+			"brne 1b \n\t"
+			"out %3, __zero_reg__ \n\t"
+			: "+x"(to), "+w"(pairs)
+			: "r"(from), "i"(&RAMPZ), "i"(&RAMPX)
+			: "r30", "r31", "memory"
+		);
+	}
+	if (size & 1) {
+		*to = hugemem_read8(from + size - 1);
+	}
+}
+
+/**
+ * \internal
+ * \brief Copy \a size bytes from \a from to one 64 KiB bank of huge memory
+ *
+ * As \ref hugemem_read_span(), the other way.
+ */
+static void hugemem_write_span(hugemem_ptr_t to, const uint8_t *from,
+		uint16_t size)
+{
+	uint16_t pairs = size >> 1;
+
+	if (pairs) {
+		asm volatile(
+			"movw r30, %A2 \n\t"
+			"out %3, %C2 \n\t"
+			"out %4, __zero_reg__ \n\t"
+			"1: \n\t"
+			"ld __tmp_reg__, X+ \n\t"
+			"st Z+, __tmp_reg__ \n\t"
+			"ld __tmp_reg__, X+ \n\t"
+			"st Z+, __tmp_reg__ \n\t"
+			"sbiw %1, 1 \n\t"
+			"brne 1b \n\t"
+			"out %3, __zero_reg__ \n\t"
+			: "+x"(from), "+w"(pairs)
+			: "r"(to), "i"(&RAMPZ), "i"(&RAMPX)
+			: "r30", "r31", "memory"
+		);
+	}
+	if (size & 1) {
+		hugemem_write8(to + size - 1, *from);
+	}
+}
+
+void hugemem_read_block(void *to, const hugemem_ptr_t from, size_t size)
+{
+	uint8_t *dest = to;
+	hugemem_ptr_t src = from;
+
+	while (size) {
+		uint16_t span = hugemem_span(src, size);
+
+		hugemem_read_span(dest, src, span);
+		dest += span;
+		src += span;
+		size -= span;
+	}
+}
+
+void hugemem_write_block(hugemem_ptr_t to, const void *from, size_t size)
+{
+	hugemem_ptr_t dest = to;
+	const uint8_t *src = from;
+
+	while (size) {
+		uint16_t span = hugemem_span(dest, size);
+
+		hugemem_write_span(dest, src, span);
+		dest += span;
+		src += span;
+		size -= span;
+	}
+}
 # endif /* __GNUC__ */
 
 # ifdef __ICCAVR__
@@ -111,6 +111,9 @@ static inline void hugemem_write8(hugemem_ptr_t to, uint_fast8_t val)
 void hugemem_write16(hugemem_ptr_t to, uint_fast16_t val);
 void hugemem_write32(hugemem_ptr_t to, uint_fast32_t val);
 
+void hugemem_read_block(void *to, const hugemem_ptr_t from, size_t size);
+void hugemem_write_block(hugemem_ptr_t to, const void *from, size_t size);
+
 # elif defined(__ICCAVR__)
 #include <stdint.h>
 
@@ -147,6 +150,28 @@ static inline void hugemem_write32(hugemem_ptr_t to, uint_fast32_t val)
 {
 	*(__huge uint32_t *)to = val;
 }
+
+static inline void hugemem_read_block(void *to, const hugemem_ptr_t from,
+		size_t size)
+{
+	uint8_t *dest = to;
+	const __huge uint8_t *src = from;
+
+	while (size--) {
+		*dest++ = *src++;
+	}
+}
+
+static inline void hugemem_write_block(hugemem_ptr_t to, const void *from,
+		size_t size)
+{
+	__huge uint8_t *dest = to;
+	const uint8_t *src = from;
+
+	while (size--) {
+		*dest++ = *src++;
+	}
+}
 # endif /* __ICCAVR__ */
 
 #else
@@ -93,6 +93,18 @@ static inline void hugemem_write32(hugemem_ptr_t to, uint32_t val)
 	*(uint32_t *)to = val;
 }
 
+static inline void hugemem_read_block(void *to, const hugemem_ptr_t from,
+		size_t size)
+{
+	memcpy(to, from, size);
+}
+
+static inline void hugemem_write_block(hugemem_ptr_t to, const void *from,
+		size_t size)
+{
+	memcpy(to, from, size);
+}
+
 //@}
 
 #endif /* GENERIC_HUGEMEM_H */
@@ -119,6 +119,24 @@
  * \brief Write 32-bit value \a val to huge memory address \a to.
  */
 
+/**
+ * \fn void hugemem_read_block(void *to, const hugemem_ptr_t from, size_t size)
+ *
+ * \brief Copy \a size bytes from huge memory address \a from to 64 kB data
+ * memory address \a to.
+ *
+ * The copy may cross 64 kB boundaries in huge memory.
+ */
+
+/**
+ * \fn void hugemem_write_block(hugemem_ptr_t to, const void *from, size_t size)
+ *
+ * \brief Copy \a size bytes from 64 kB data memory address \a from to huge
+ * memory address \a to.
+ *
+ * The copy may cross 64 kB boundaries in huge memory.
+ */
+
 //@}
 
 #endif /* HUGEMEM_H_INCLUDED */
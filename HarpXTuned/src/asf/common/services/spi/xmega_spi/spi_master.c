@@ -115,6 +115,10 @@ void spi_master_setup_device(SPI_t *spi, struct spi_device *device,
  *
  * Received bytes on the SPI bus are discarded.
  *
+ * The SPI data register is not buffered on transmit, so the next byte is
+ * fetched while the current one shifts out, and written as soon as the
+ * transfer complete flag rises.
+ *
  * \param spi Base address of the SPI instance.
  * \param data   data buffer to write
  * \param len    Length of data
@@ -123,20 +127,28 @@ void spi_master_setup_device(SPI_t *spi, struct spi_device *device,
  */
 status_code_t spi_write_packet(SPI_t *spi,const uint8_t *data, size_t len)
 {
-	size_t i=0;
-	while(len) {
-		spi_write_single(spi,*(data+i));
+	uint8_t next;
+
+	if (!len) {
+		return STATUS_OK;
+	}
+	spi_write_single(spi, *data++);
+	while (--len) {
+		next = *data++;
 		while(!spi_is_rx_full(spi));
-		len--;
-		i++;
+		spi_write_single(spi, next);
 	}
+	while(!spi_is_rx_full(spi));
 	return STATUS_OK;
 }
 
 /**
  * \brief Receive a sequence of bytes from a SPI device
  *
- * All bytes sent out on SPI bus are sent as value 0.
+ * All bytes sent out on SPI bus are sent as value CONFIG_SPI_MASTER_DUMMY.
+ *
+ * The next dummy byte is sent before the received one is read: the
+ * receive side is buffered and keeps it until the next transfer ends.
  *
  * \param spi Base address of the SPI instance.
  * \param data   data buffer to read
@@ -146,16 +158,140 @@ status_code_t spi_write_packet(SPI_t *spi,const uint8_t *data, size_t len)
  */
 status_code_t spi_read_packet(SPI_t *spi, uint8_t *data, size_t len)
 {
-	while(len) {
-		spi_write_single(spi,CONFIG_SPI_MASTER_DUMMY); //Dummy write
+	return spi_transfer_packet(spi, NULL, data, len);
+}
+
+/**
+ * \brief Exchange a sequence of bytes with a SPI device
+ *
+ * Pipelined as \ref spi_write_packet() and \ref spi_read_packet().
+ *
+ * \param spi Base address of the SPI instance.
+ * \param tx     data buffer to write, or NULL to send the dummy byte
+ * \param rx     data buffer to read, or NULL to discard, may equal \a tx
+ * \param len    Length of data
+ *
+ * \pre SPI device must be selected with spi_select_device() first
+ */
+status_code_t spi_transfer_packet(SPI_t *spi, const uint8_t *tx,
+		uint8_t *rx, size_t len)
+{
+	uint8_t next;
+
+	if (!len) {
+		return STATUS_OK;
+	}
+	spi_write_single(spi, tx ? *tx++ : CONFIG_SPI_MASTER_DUMMY);
+	while (--len) {
+		next = tx ? *tx++ : CONFIG_SPI_MASTER_DUMMY;
 		while(!spi_is_rx_full(spi));
-		spi_read_single(spi,data);
-		len--;
-		data++;
- 	}
+		spi_write_single(spi, next);
+		if (rx) {
+			// Byte of the transfer that just ended
+			spi_read_single(spi, rx++);
+		}
+	}
+	while(!spi_is_rx_full(spi));
+	if (rx) {
+		spi_read_single(spi, rx);
+	}
 	return STATUS_OK;
 }
 
+#ifdef CONFIG_SPI_MASTER_ASYNC_vect
+
+//! \internal State of the interrupt driven transfer
+static struct {
+	SPI_t *spi;
+	const uint8_t *tx;
+	uint8_t *rx;
+	size_t len;
+	spi_callback_t callback;
+} volatile spi_async;
+
+/**
+ * \brief Start an interrupt driven exchange with a SPI device
+ *
+ * Returns at once. The transfer complete interrupt of \a spi, which must
+ * be the module CONFIG_SPI_MASTER_ASYNC_vect belongs to, moves one byte
+ * per transfer; \a callback runs from it when the last byte is in, at
+ * CONFIG_SPI_MASTER_ASYNC_LEVEL. Worth it at low baud rates, where a byte
+ * takes much longer than the interrupt; at the fastest ones the polled
+ * \ref spi_transfer_packet() costs less.
+ *
+ * \param spi Base address of the SPI instance.
+ * \param tx     data buffer to write, or NULL to send the dummy byte
+ * \param rx     data buffer to read, or NULL to discard
+ * \param len    Length of data, at least 1
+ * \param callback Called from the interrupt when done, or NULL
+ *
+ * \retval STATUS_OK the transfer is started
+ * \retval ERR_BUSY another asynchronous transfer is running
+ *
+ * \pre SPI device must be selected with spi_select_device() first
+ */
+status_code_t spi_transfer_start(SPI_t *spi, const uint8_t *tx,
+		uint8_t *rx, size_t len, spi_callback_t callback)
+{
+	Assert(len);
+
+	if (spi_transfer_is_busy()) {
+		return ERR_BUSY;
+	}
+	spi_async.spi = spi;
+	spi_async.tx = tx;
+	spi_async.rx = rx;
+	spi_async.len = len;
+	spi_async.callback = callback;
+
+	spi->INTCTRL = CONFIG_SPI_MASTER_ASYNC_LEVEL;
+	spi_write_single(spi, tx ? *spi_async.tx++ : CONFIG_SPI_MASTER_DUMMY);
+	return STATUS_OK;
+}
+
+/**
+ * \brief Test if an asynchronous transfer is running
+ */
+bool spi_transfer_is_busy(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	bool busy = spi_async.len != 0;
+
+	cpu_irq_restore(flags);
+	return busy;
+}
+
+/**
+ * \internal
+ * \brief Transfer complete interrupt, one byte per call
+ */
+ISR(CONFIG_SPI_MASTER_ASYNC_vect)
+{
+	SPI_t *spi = spi_async.spi;
+	spi_callback_t callback;
+	uint8_t next;
+
+	if (--spi_async.len) {
+		next = spi_async.tx ? *spi_async.tx++ : CONFIG_SPI_MASTER_DUMMY;
+		spi_write_single(spi, next);
+		if (spi_async.rx) {
+			spi_read_single(spi, spi_async.rx++);
+		}
+		return;
+	}
+
+	spi->INTCTRL = SPI_INTLVL_OFF_gc;
+	if (spi_async.rx) {
+		spi_read_single(spi, spi_async.rx);
+	}
+	callback = spi_async.callback;
+	if (callback) {
+		callback();
+	}
+}
+
+#endif /* CONFIG_SPI_MASTER_ASYNC_vect */
+
 /**
  * \brief Select given device on the SPI bus
  *
@@ -226,7 +226,7 @@ inline static void spi_read_single(SPI_t *spi, uint8_t *data)
 /**
  * \brief Receive a sequence of bytes from a SPI device
  *
- * All bytes sent out on SPI bus are sent as value 0.
+ * All bytes sent out on SPI bus are sent as value CONFIG_SPI_MASTER_DUMMY.
  *
  * \param spi Base address of the SPI instance.
  * \param data   data buffer to read
@@ -247,6 +247,41 @@ inline static bool spi_is_rx_full(SPI_t *spi)
 	return spi_is_tx_ok(spi);
 }
 
+/**
+ * \brief Exchange a sequence of bytes with a SPI device
+ *
+ * \param spi Base address of the SPI instance.
+ * \param tx     data buffer to write, or NULL to send the dummy byte
+ * \param rx     data buffer to read, or NULL to discard, may equal \a tx
+ * \param len    Length of data
+ *
+ * \pre SPI device must be selected with spi_select_device() first
+ */
+extern status_code_t spi_transfer_packet(SPI_t *spi, const uint8_t *tx,
+		uint8_t *rx, size_t len);
+
+/*! \name Asynchronous transfer
+ *
+ * Available when conf_spi_master.h defines CONFIG_SPI_MASTER_ASYNC_vect,
+ * the transfer complete interrupt vector of the SPI module to use. One
+ * transfer runs at a time.
+ */
+//! @{
+
+//! Default interrupt level of the asynchronous transfer
+#ifndef CONFIG_SPI_MASTER_ASYNC_LEVEL
+#define CONFIG_SPI_MASTER_ASYNC_LEVEL        SPI_INTLVL_LO_gc
+#endif
+
+//! Called from the interrupt when an asynchronous transfer is done
+typedef void (*spi_callback_t)(void);
+
+extern status_code_t spi_transfer_start(SPI_t *spi, const uint8_t *tx,
+		uint8_t *rx, size_t len, spi_callback_t callback);
+extern bool spi_transfer_is_busy(void);
+
+//! @}
+
 //! @}
 
 
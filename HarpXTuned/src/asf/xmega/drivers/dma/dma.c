@@ -0,0 +1,193 @@
+/**
+ * \file
+ *
+ * \brief AVR XMEGA Direct Memory Access Controller driver
+ *
+ */
+#include <compiler.h>
+#include <interrupt.h>
+#include <sysclk.h>
+#include <sleepmgr.h>
+
+#include "dma.h"
+
+//! \internal Local storage of DMA channel interrupt callback functions
+static dma_callback_t dma_data_callback[DMA_NUMBER_OF_CHANNELS];
+
+/**
+ * \brief Enable the DMA controller
+ *
+ * Enables the peripheral clock, resets the controller and sets it up with
+ * round-robin priority and no double buffering.
+ */
+void dma_enable(void)
+{
+	sysclk_enable_module(SYSCLK_PORT_GEN, SYSCLK_DMA);
+	sleepmgr_lock_mode(SLEEPMGR_IDLE);
+
+	DMA.CTRL = 0;
+	DMA.CTRL = DMA_RESET_bm;
+	while (DMA.CTRL & DMA_RESET_bm) {
+		// Wait for the reset to complete
+	}
+	DMA.CTRL = DMA_ENABLE_bm;
+}
+
+/**
+ * \brief Disable the DMA controller
+ *
+ * \note Ongoing transfers are aborted.
+ */
+void dma_disable(void)
+{
+	DMA.CTRL = 0;
+	sysclk_disable_module(SYSCLK_PORT_GEN, SYSCLK_DMA);
+	sleepmgr_unlock_mode(SLEEPMGR_IDLE);
+}
+
+/**
+ * \brief Write a configuration to a DMA channel
+ *
+ * The channel is reset first, so any ongoing transfer on it is lost. The
+ * channel is left disabled unless \c DMA_CH_ENABLE_bm is set in
+ * \a config->ctrla.
+ *
+ * \param num DMA channel number
+ * \param config Pointer to the channel configuration
+ */
+void dma_channel_write_config(dma_channel_num_t num,
+		const struct dma_channel_config *config)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+	irqflags_t flags = cpu_irq_save();
+
+	channel->CTRLA = DMA_CH_RESET_bm;
+	channel->CTRLA = 0;
+
+	channel->REPCNT = config->repcnt;
+	channel->TRFCNT = config->trfcnt;
+	channel->SRCADDR0 = config->srcaddr & 0xff;
+	channel->SRCADDR1 = (config->srcaddr >> 8) & 0xff;
+	channel->SRCADDR2 = (config->srcaddr >> 16) & 0xff;
+	channel->DESTADDR0 = config->destaddr & 0xff;
+	channel->DESTADDR1 = (config->destaddr >> 8) & 0xff;
+	channel->DESTADDR2 = (config->destaddr >> 16) & 0xff;
+	channel->ADDRCTRL = config->addrctrl;
+	channel->TRIGSRC = config->trigsrc;
+	channel->CTRLB = config->ctrlb;
+	channel->CTRLA = config->ctrla;
+
+	cpu_irq_restore(flags);
+}
+
+/**
+ * \brief Read the current configuration of a DMA channel
+ *
+ * \param num DMA channel number
+ * \param config Pointer to the configuration to fill in
+ */
+void dma_channel_read_config(dma_channel_num_t num,
+		struct dma_channel_config *config)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+	irqflags_t flags = cpu_irq_save();
+
+	config->ctrla = channel->CTRLA;
+	config->ctrlb = channel->CTRLB;
+	config->addrctrl = channel->ADDRCTRL;
+	config->trigsrc = channel->TRIGSRC;
+	config->trfcnt = channel->TRFCNT;
+	config->repcnt = channel->REPCNT;
+	config->srcaddr = channel->SRCADDR0
+			| ((uint32_t)channel->SRCADDR1 << 8)
+			| ((uint32_t)channel->SRCADDR2 << 16);
+	config->destaddr = channel->DESTADDR0
+			| ((uint32_t)channel->DESTADDR1 << 8)
+			| ((uint32_t)channel->DESTADDR2 << 16);
+
+	cpu_irq_restore(flags);
+}
+
+/**
+ * \brief Set the callback for a DMA channel
+ *
+ * The callback is run from the channel interrupt, both on transaction
+ * complete and on error. The interrupt level is part of the channel
+ * configuration, see \ref dma_channel_set_interrupt_level().
+ *
+ * \param num DMA channel number
+ * \param callback Callback function, or NULL to disable
+ */
+void dma_set_callback(dma_channel_num_t num, dma_callback_t callback)
+{
+	Assert(num < DMA_NUMBER_OF_CHANNELS);
+
+	dma_data_callback[num] = callback;
+}
+
+/**
+ * \brief Get the status of a DMA channel
+ *
+ * \param num DMA channel number
+ */
+enum dma_channel_status dma_get_channel_status(dma_channel_num_t num)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+	uint8_t flags = channel->CTRLB;
+
+	if (flags & DMA_CH_ERRIF_bm) {
+		return DMA_CH_TRANSFER_ERROR;
+	} else if (flags & DMA_CH_TRNIF_bm) {
+		return DMA_CH_TRANSFER_COMPLETED;
+	} else if (flags & DMA_CH_CHBUSY_bm) {
+		return DMA_CH_BUSY;
+	} else if (flags & DMA_CH_CHPEND_bm) {
+		return DMA_CH_PENDING;
+	}
+	return DMA_CH_FREE;
+}
+
+/**
+ * \internal
+ * \brief Common DMA channel interrupt handler
+ *
+ * Clears the flags of the channel and calls its callback.
+ *
+ * \param num DMA channel number
+ */
+static inline void dma_interrupt(const dma_channel_num_t num)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+	enum dma_channel_status status;
+
+	status = dma_get_channel_status(num);
+	channel->CTRLB |= DMA_CH_ERRIF_bm | DMA_CH_TRNIF_bm;
+
+	if (dma_data_callback[num]) {
+		dma_data_callback[num](status);
+	}
+}
+
+//! \internal DMA channel 0 interrupt handler
+ISR(DMA_CH0_vect)
+{
+	dma_interrupt(0);
+}
+
+//! \internal DMA channel 1 interrupt handler
+ISR(DMA_CH1_vect)
+{
+	dma_interrupt(1);
+}
+
+//! \internal DMA channel 2 interrupt handler
+ISR(DMA_CH2_vect)
+{
+	dma_interrupt(2);
+}
+
+//! \internal DMA channel 3 interrupt handler
+ISR(DMA_CH3_vect)
+{
+	dma_interrupt(3);
+}
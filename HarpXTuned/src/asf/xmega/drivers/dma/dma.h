@@ -0,0 +1,303 @@
+/**
+ * \file
+ *
+ * \brief AVR XMEGA Direct Memory Access Controller driver
+ *
+ */
+#ifndef DRIVERS_DMA_DMA_H
+#define DRIVERS_DMA_DMA_H
+
+#include <compiler.h>
+#include <parts.h>
+#include <interrupt.h>
+
+/**
+ * \defgroup dma_group Direct Memory Access Controller (DMA)
+ *
+ * This is a driver for the AVR XMEGA DMA controller. It provides functions
+ * for enabling the controller, writing channel configurations and getting
+ * notified, through a callback, when a channel has completed a block
+ * transfer or has stopped on an error.
+ *
+ * A channel configuration is built up in a \ref dma_channel_config struct
+ * with the helper functions below and written to the channel in one go with
+ * \ref dma_channel_write_config().
+ *
+ * @{
+ */
+
+//! Number of DMA channels
+#define DMA_NUMBER_OF_CHANNELS    4
+
+//! DMA channel number
+typedef uint8_t dma_channel_num_t;
+
+//! DMA channel status passed to the callback
+enum dma_channel_status {
+	DMA_CH_FREE = 0,        //!< Channel is idle
+	DMA_CH_BUSY,            //!< Channel has a block transfer ongoing
+	DMA_CH_PENDING,         //!< Channel has a block transfer pending
+	DMA_CH_TRANSFER_COMPLETED, //!< Channel has completed a block transfer
+	DMA_CH_TRANSFER_ERROR,  //!< Channel stopped on a bus or configuration error
+};
+
+//! DMA interrupt callback function pointer
+typedef void (*dma_callback_t)(enum dma_channel_status status);
+
+//! DMA channel configuration
+struct dma_channel_config {
+	uint8_t ctrla;
+	uint8_t ctrlb;
+	uint8_t addrctrl;
+	uint8_t trigsrc;
+	uint16_t trfcnt;
+	uint8_t repcnt;
+	uint32_t srcaddr;
+	uint32_t destaddr;
+};
+
+void dma_enable(void);
+void dma_disable(void);
+
+void dma_channel_write_config(dma_channel_num_t num,
+		const struct dma_channel_config *config);
+void dma_channel_read_config(dma_channel_num_t num,
+		struct dma_channel_config *config);
+
+void dma_set_callback(dma_channel_num_t num, dma_callback_t callback);
+
+enum dma_channel_status dma_get_channel_status(dma_channel_num_t num);
+
+/**
+ * \internal
+ * \brief Get DMA channel pointer from channel number
+ *
+ * \param num DMA channel number
+ *
+ * \return Pointer to the DMA channel register block
+ */
+static inline DMA_CH_t *dma_get_channel_address_from_num(dma_channel_num_t num)
+{
+	Assert(num < DMA_NUMBER_OF_CHANNELS);
+
+	return &DMA.CH0 + num;
+}
+
+/**
+ * \brief Enable a DMA channel
+ *
+ * \param num DMA channel number
+ */
+static inline void dma_channel_enable(dma_channel_num_t num)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+
+	channel->CTRLA |= DMA_CH_ENABLE_bm;
+}
+
+/**
+ * \brief Disable a DMA channel
+ *
+ * \note The channel finishes an ongoing burst before it is disabled.
+ *
+ * \param num DMA channel number
+ */
+static inline void dma_channel_disable(dma_channel_num_t num)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+
+	channel->CTRLA &= ~DMA_CH_ENABLE_bm;
+}
+
+/**
+ * \brief Check if a DMA channel is enabled
+ *
+ * \param num DMA channel number
+ *
+ * \retval true when the channel is enabled
+ */
+static inline bool dma_channel_is_enabled(dma_channel_num_t num)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+
+	return channel->CTRLA & DMA_CH_ENABLE_bm;
+}
+
+/**
+ * \brief Read the remaining byte count of the current block transfer
+ *
+ * \param num DMA channel number
+ */
+static inline uint16_t dma_channel_get_transfer_count(dma_channel_num_t num)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+	irqflags_t flags = cpu_irq_save();
+	uint16_t count = channel->TRFCNT;
+
+	cpu_irq_restore(flags);
+	return count;
+}
+
+/**
+ * \brief Set double buffer mode
+ *
+ * In double buffer mode two channels are chained: when one of them completes
+ * its block transfer, the other one is enabled and takes over. The completed
+ * channel must be re-enabled by the application before its partner is done.
+ *
+ * \param mode Double buffer channel pairing, \c DMA_DBUFMODE_t
+ */
+static inline void dma_set_double_buffer_mode(DMA_DBUFMODE_t mode)
+{
+	DMA.CTRL = (DMA.CTRL & ~DMA_DBUFMODE_gm) | mode;
+}
+
+/**
+ * \brief Set channel priority mode
+ *
+ * \param mode Priority mode, \c DMA_PRIMODE_t
+ */
+static inline void dma_set_priority_mode(DMA_PRIMODE_t mode)
+{
+	DMA.CTRL = (DMA.CTRL & ~DMA_PRIMODE_gm) | mode;
+}
+
+//! \name DMA channel configuration helpers
+//@{
+
+/**
+ * \brief Set burst length
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param burst_length \c DMA_CH_BURSTLEN_t
+ */
+static inline void dma_channel_set_burst_length(
+		struct dma_channel_config *config,
+		DMA_CH_BURSTLEN_t burst_length)
+{
+	config->ctrla &= ~DMA_CH_BURSTLEN_gm;
+	config->ctrla |= burst_length;
+}
+
+/**
+ * \brief Make each trigger start a single burst instead of a whole block
+ *
+ * \param config Pointer to DMA channel configuration
+ */
+static inline void dma_channel_set_single_shot(
+		struct dma_channel_config *config)
+{
+	config->ctrla |= DMA_CH_SINGLE_bm;
+}
+
+/**
+ * \brief Enable repeat mode
+ *
+ * The channel reloads the transfer count and repeats the block transfer
+ * \a repcnt times. A repeat count of zero means repeat forever.
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param repcnt Number of block transfers
+ */
+static inline void dma_channel_set_repeats(struct dma_channel_config *config,
+		uint8_t repcnt)
+{
+	config->ctrla |= DMA_CH_REPEAT_bm;
+	config->repcnt = repcnt;
+}
+
+/**
+ * \brief Set block transfer count in bytes
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param count Block size in bytes, 0 means 64 KiB
+ */
+static inline void dma_channel_set_transfer_count(
+		struct dma_channel_config *config, uint16_t count)
+{
+	config->trfcnt = count;
+}
+
+/**
+ * \brief Set transfer trigger source
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param source \c DMA_CH_TRIGSRC_t
+ */
+static inline void dma_channel_set_trigger_source(
+		struct dma_channel_config *config, DMA_CH_TRIGSRC_t source)
+{
+	config->trigsrc = source;
+}
+
+/**
+ * \brief Set source address reload and direction
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param reload \c DMA_CH_SRCRELOAD_t
+ * \param dir \c DMA_CH_SRCDIR_t
+ */
+static inline void dma_channel_set_src_mode(struct dma_channel_config *config,
+		DMA_CH_SRCRELOAD_t reload, DMA_CH_SRCDIR_t dir)
+{
+	config->addrctrl &= ~(DMA_CH_SRCRELOAD_gm | DMA_CH_SRCDIR_gm);
+	config->addrctrl |= reload | dir;
+}
+
+/**
+ * \brief Set destination address reload and direction
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param reload \c DMA_CH_DESTRELOAD_t
+ * \param dir \c DMA_CH_DESTDIR_t
+ */
+static inline void dma_channel_set_dest_mode(struct dma_channel_config *config,
+		DMA_CH_DESTRELOAD_t reload, DMA_CH_DESTDIR_t dir)
+{
+	config->addrctrl &= ~(DMA_CH_DESTRELOAD_gm | DMA_CH_DESTDIR_gm);
+	config->addrctrl |= reload | dir;
+}
+
+/**
+ * \brief Set 24-bit source address
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param address Source address, may point into EBI memory
+ */
+static inline void dma_channel_set_source_address(
+		struct dma_channel_config *config, uint32_t address)
+{
+	config->srcaddr = address;
+}
+
+/**
+ * \brief Set 24-bit destination address
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param address Destination address, may point into EBI memory
+ */
+static inline void dma_channel_set_destination_address(
+		struct dma_channel_config *config, uint32_t address)
+{
+	config->destaddr = address;
+}
+
+/**
+ * \brief Set transaction complete interrupt level
+ *
+ * \param config Pointer to DMA channel configuration
+ * \param level \c DMA_CH_TRNINTLVL_t
+ */
+static inline void dma_channel_set_interrupt_level(
+		struct dma_channel_config *config, DMA_CH_TRNINTLVL_t level)
+{
+	config->ctrlb &= ~(DMA_CH_TRNINTLVL_gm | DMA_CH_ERRINTLVL_gm);
+	config->ctrlb |= level | (level << (DMA_CH_ERRINTLVL_gp
+			- DMA_CH_TRNINTLVL_gp));
+}
+
+//@}
+
+//! @}
+
+#endif /* DRIVERS_DMA_DMA_H */
@@ -416,6 +416,27 @@ static inline void ioport_tgl_group(port_id_t port_id,pin_mask_t port_mask)
 	port->OUTTGL = port_mask;
 }
 
+/*! \brief Drives the pins of a group of a port to the levels of a value.
+ *
+ * Each pin of \a mask is driven once, low by OUTCLR or high by OUTSET, so
+ * none glitches and the pins outside \a mask are left alone without a
+ * read-modify-write. A whole port in a constant mask is one OUT store.
+ *
+ * \param port Base address of the port.
+ * \param mask The mask of the pins to drive.
+ * \param value The levels, high for each set bit.
+ */
+static inline void ioport_set_port_mask(PORT_t *port, pin_mask_t mask,
+		pin_mask_t value)
+{
+	if (__builtin_constant_p(mask) && mask == 0xff) {
+		port->OUT = value;
+		return;
+	}
+	port->OUTCLR = mask & ~value;
+	port->OUTSET = mask & value;
+}
+
 /*@}*/
 
 #endif /* IOPORT_H */
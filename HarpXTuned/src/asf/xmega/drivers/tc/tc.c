@@ -49,6 +49,15 @@
 #include "sleepmgr.h"
 #include "status_codes.h"
 
+/**
+ * \internal
+ * \brief Weak interrupt handler
+ *
+ * The handlers below dispatch to the registered callbacks. They are weak,
+ * so a handler bound with \ref TC_BIND_DIRECT() replaces them at link time.
+ */
+#define TC_ISR(vect)    ISR(vect, __attribute__((weak)))
+
 #if defined(TCC0) || defined(__DOXYGEN__)
 //! \internal Local storage of Timer Counter TCC0 interrupt callback function
 static tc_callback_t tc_tcc0_ovf_callback;
@@ -66,7 +75,7 @@ static tc_callback_t tc_tcc0_ccd_callback;
  * This function will handle interrupt on Timer Counter CO overflow and
  * call the callback function.
  */
-ISR(TCC0_OVF_vect)
+TC_ISR(TCC0_OVF_vect)
 {
 	if (tc_tcc0_ovf_callback) {
 		tc_tcc0_ovf_callback();
@@ -80,7 +89,7 @@ ISR(TCC0_OVF_vect)
  * This function will handle interrupt on Timer Counter CO error and
  * call the callback function.
  */
-ISR(TCC0_ERR_vect)
+TC_ISR(TCC0_ERR_vect)
 {
 	if (tc_tcc0_err_callback) {
 		tc_tcc0_err_callback();
@@ -94,7 +103,7 @@ ISR(TCC0_ERR_vect)
  * This function will handle interrupt on Timer Counter CO Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCC0_CCA_vect)
+TC_ISR(TCC0_CCA_vect)
 {
 	if (tc_tcc0_cca_callback) {
 		tc_tcc0_cca_callback();
@@ -108,7 +117,7 @@ ISR(TCC0_CCA_vect)
  * This function will handle interrupt on Timer Counter CO Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCC0_CCB_vect)
+TC_ISR(TCC0_CCB_vect)
 {
 	if (tc_tcc0_ccb_callback) {
 		tc_tcc0_ccb_callback();
@@ -122,7 +131,7 @@ ISR(TCC0_CCB_vect)
  * This function will handle interrupt on Timer Counter CO Compare/CaptureC and
  * call the callback function.
  */
-ISR(TCC0_CCC_vect)
+TC_ISR(TCC0_CCC_vect)
 {
 	if (tc_tcc0_ccc_callback) {
 		tc_tcc0_ccc_callback();
@@ -136,7 +145,7 @@ ISR(TCC0_CCC_vect)
  * This function will handle interrupt on Timer Counter CO Compare/CaptureD and
  * call the callback function.
  */
-ISR(TCC0_CCD_vect)
+TC_ISR(TCC0_CCD_vect)
 {
 	if (tc_tcc0_ccd_callback) {
 		tc_tcc0_ccd_callback();
@@ -159,7 +168,7 @@ static tc_callback_t tc_tcc1_ccb_callback;
  * This function will handle interrupt on Timer Counter C1 overflow and
  * call the callback function.
  */
-ISR(TCC1_OVF_vect)
+TC_ISR(TCC1_OVF_vect)
 {
 	if (tc_tcc1_ovf_callback) {
 		tc_tcc1_ovf_callback();
@@ -173,7 +182,7 @@ ISR(TCC1_OVF_vect)
  * This function will handle interrupt on Timer Counter C1 error and
  * call the callback function.
  */
-ISR(TCC1_ERR_vect)
+TC_ISR(TCC1_ERR_vect)
 {
 	if (tc_tcc1_err_callback) {
 		tc_tcc1_err_callback();
@@ -187,7 +196,7 @@ ISR(TCC1_ERR_vect)
  * This function will handle interrupt on Timer Counter C1 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCC1_CCA_vect)
+TC_ISR(TCC1_CCA_vect)
 {
 	if (tc_tcc1_cca_callback) {
 		tc_tcc1_cca_callback();
@@ -201,7 +210,7 @@ ISR(TCC1_CCA_vect)
  * This function will handle interrupt on Timer Counter C1 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCC1_CCB_vect)
+TC_ISR(TCC1_CCB_vect)
 {
 	if (tc_tcc1_ccb_callback) {
 		tc_tcc1_ccb_callback();
@@ -227,7 +236,7 @@ static tc_callback_t tc_tcd0_ccd_callback;
  * This function will handle interrupt on Timer Counter D0 overflow and
  * call the callback function.
  */
-ISR(TCD0_OVF_vect)
+TC_ISR(TCD0_OVF_vect)
 {
 	if (tc_tcd0_ovf_callback) {
 		tc_tcd0_ovf_callback();
@@ -241,7 +250,7 @@ ISR(TCD0_OVF_vect)
  * This function will handle interrupt on Timer Counter D0 error and
  * call the callback function.
  */
-ISR(TCD0_ERR_vect)
+TC_ISR(TCD0_ERR_vect)
 {
 	if (tc_tcd0_err_callback) {
 		tc_tcd0_err_callback();
@@ -255,7 +264,7 @@ ISR(TCD0_ERR_vect)
  * This function will handle interrupt on Timer Counter D0 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCD0_CCA_vect)
+TC_ISR(TCD0_CCA_vect)
 {
 	if (tc_tcd0_cca_callback) {
 		tc_tcd0_cca_callback();
@@ -269,7 +278,7 @@ ISR(TCD0_CCA_vect)
  * This function will handle interrupt on Timer Counter D0 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCD0_CCB_vect)
+TC_ISR(TCD0_CCB_vect)
 {
 	if (tc_tcd0_ccb_callback) {
 		tc_tcd0_ccb_callback();
@@ -283,7 +292,7 @@ ISR(TCD0_CCB_vect)
  * This function will handle interrupt on Timer Counter D0 Compare/CaptureC and
  * call the callback function.
  */
-ISR(TCD0_CCC_vect)
+TC_ISR(TCD0_CCC_vect)
 {
 	if (tc_tcd0_ccc_callback) {
 		tc_tcd0_ccc_callback();
@@ -297,7 +306,7 @@ ISR(TCD0_CCC_vect)
  * This function will handle interrupt on Timer Counter D0 Compare/CaptureD and
  * call the callback function.
  */
-ISR(TCD0_CCD_vect)
+TC_ISR(TCD0_CCD_vect)
 {
 	if (tc_tcd0_ccd_callback) {
 		tc_tcd0_ccd_callback();
@@ -320,7 +329,7 @@ static tc_callback_t tc_tcd1_ccb_callback;
  * This function will handle interrupt on Timer Counter D1 overflow and
  * call the callback function.
  */
-ISR(TCD1_OVF_vect)
+TC_ISR(TCD1_OVF_vect)
 {
 	if (tc_tcd1_ovf_callback) {
 		tc_tcd1_ovf_callback();
@@ -334,7 +343,7 @@ ISR(TCD1_OVF_vect)
  * This function will handle interrupt on Timer Counter D1 error and
  * call the callback function.
  */
-ISR(TCD1_ERR_vect)
+TC_ISR(TCD1_ERR_vect)
 {
 	if (tc_tcd1_err_callback) {
 		tc_tcd1_err_callback();
@@ -348,7 +357,7 @@ ISR(TCD1_ERR_vect)
  * This function will handle interrupt on Timer Counter D1 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCD1_CCA_vect)
+TC_ISR(TCD1_CCA_vect)
 {
 	if (tc_tcd1_cca_callback) {
 		tc_tcd1_cca_callback();
@@ -362,7 +371,7 @@ ISR(TCD1_CCA_vect)
  * This function will handle interrupt on Timer Counter D1 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCD1_CCB_vect)
+TC_ISR(TCD1_CCB_vect)
 {
 	if (tc_tcd1_ccb_callback) {
 		tc_tcd1_ccb_callback();
@@ -389,7 +398,7 @@ static tc_callback_t tc_tce0_ccd_callback;
  * This function will handle interrupt on Timer Counter E0 overflow and
  * call the callback function.
  */
-ISR(TCE0_OVF_vect)
+TC_ISR(TCE0_OVF_vect)
 {
 	if (tc_tce0_ovf_callback) {
 		tc_tce0_ovf_callback();
@@ -403,7 +412,7 @@ ISR(TCE0_OVF_vect)
  * This function will handle interrupt on Timer Counter E0 error and
  * call the callback function.
  */
-ISR(TCE0_ERR_vect)
+TC_ISR(TCE0_ERR_vect)
 {
 	if (tc_tce0_err_callback) {
 		tc_tce0_err_callback();
@@ -417,7 +426,7 @@ ISR(TCE0_ERR_vect)
  * This function will handle interrupt on Timer Counter E0 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCE0_CCA_vect)
+TC_ISR(TCE0_CCA_vect)
 {
 	if (tc_tce0_cca_callback) {
 		tc_tce0_cca_callback();
@@ -431,7 +440,7 @@ ISR(TCE0_CCA_vect)
  * This function will handle interrupt on Timer Counter E0 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCE0_CCB_vect)
+TC_ISR(TCE0_CCB_vect)
 {
 	if (tc_tce0_ccb_callback) {
 		tc_tce0_ccb_callback();
@@ -445,7 +454,7 @@ ISR(TCE0_CCB_vect)
  * This function will handle interrupt on Timer Counter E0 Compare/CaptureC and
  * call the callback function.
  */
-ISR(TCE0_CCC_vect)
+TC_ISR(TCE0_CCC_vect)
 {
 	if (tc_tce0_ccc_callback) {
 		tc_tce0_ccc_callback();
@@ -459,7 +468,7 @@ ISR(TCE0_CCC_vect)
  * This function will handle interrupt on Timer Counter E0 Compare/CaptureD and
  * call the callback function.
  */
-ISR(TCE0_CCD_vect)
+TC_ISR(TCE0_CCD_vect)
 {
 	if (tc_tce0_ccd_callback) {
 		tc_tce0_ccd_callback();
@@ -482,7 +491,7 @@ static tc_callback_t tc_tce1_ccb_callback;
  * This function will handle interrupt on Timer Counter E1 overflow and
  * call the callback function.
  */
-ISR(TCE1_OVF_vect)
+TC_ISR(TCE1_OVF_vect)
 {
 	if (tc_tce1_ovf_callback) {
 		tc_tce1_ovf_callback();
@@ -496,7 +505,7 @@ ISR(TCE1_OVF_vect)
  * This function will handle interrupt on Timer Counter E1 error and
  * call the callback function.
  */
-ISR(TCE1_ERR_vect)
+TC_ISR(TCE1_ERR_vect)
 {
 	if (tc_tce1_err_callback) {
 		tc_tce1_err_callback();
@@ -510,7 +519,7 @@ ISR(TCE1_ERR_vect)
  * This function will handle interrupt on Timer Counter E1 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCE1_CCA_vect)
+TC_ISR(TCE1_CCA_vect)
 {
 	if (tc_tce1_cca_callback) {
 		tc_tce1_cca_callback();
@@ -524,7 +533,7 @@ ISR(TCE1_CCA_vect)
  * This function will handle interrupt on Timer Counter E1 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCE1_CCB_vect)
+TC_ISR(TCE1_CCB_vect)
 {
 	if (tc_tce1_ccb_callback) {
 		tc_tce1_ccb_callback();
@@ -550,7 +559,7 @@ static tc_callback_t tc_tcf0_ccd_callback;
  * This function will handle interrupt on Timer Counter F0 overflow and
  * call the callback function.
  */
-ISR(TCF0_OVF_vect)
+TC_ISR(TCF0_OVF_vect)
 {
 	if (tc_tcf0_ovf_callback) {
 		tc_tcf0_ovf_callback();
@@ -564,7 +573,7 @@ ISR(TCF0_OVF_vect)
  * This function will handle interrupt on Timer Counter F0 error and
  * call the callback function.
  */
-ISR(TCF0_ERR_vect)
+TC_ISR(TCF0_ERR_vect)
 {
 	if (tc_tcf0_err_callback) {
 		tc_tcf0_err_callback();
@@ -578,7 +587,7 @@ ISR(TCF0_ERR_vect)
  * This function will handle interrupt on Timer Counter F0 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCF0_CCA_vect)
+TC_ISR(TCF0_CCA_vect)
 {
 	if (tc_tcf0_cca_callback) {
 		tc_tcf0_cca_callback();
@@ -592,7 +601,7 @@ ISR(TCF0_CCA_vect)
  * This function will handle interrupt on Timer Counter F0 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCF0_CCB_vect)
+TC_ISR(TCF0_CCB_vect)
 {
 	if (tc_tcf0_ccb_callback) {
 		tc_tcf0_ccb_callback();
@@ -606,7 +615,7 @@ ISR(TCF0_CCB_vect)
  * This function will handle interrupt on Timer Counter F0 Compare/CaptureC and
  * call the callback function.
  */
-ISR(TCF0_CCC_vect)
+TC_ISR(TCF0_CCC_vect)
 {
 	if (tc_tcf0_ccc_callback) {
 		tc_tcf0_ccc_callback();
@@ -620,7 +629,7 @@ ISR(TCF0_CCC_vect)
  * This function will handle interrupt on Timer Counter F0 Compare/CaptureD and
  * call the callback function.
  */
-ISR(TCF0_CCD_vect)
+TC_ISR(TCF0_CCD_vect)
 {
 	if (tc_tcf0_ccd_callback) {
 		tc_tcf0_ccd_callback();
@@ -643,7 +652,7 @@ static tc_callback_t tc_tcf1_ccb_callback;
  * This function will handle interrupt on Timer Counter F1 overflow and
  * call the callback function.
  */
-ISR(TCF1_OVF_vect)
+TC_ISR(TCF1_OVF_vect)
 {
 	if (tc_tcf1_ovf_callback) {
 		tc_tcf1_ovf_callback();
@@ -657,7 +666,7 @@ ISR(TCF1_OVF_vect)
  * This function will handle interrupt on Timer Counter F1 error and
  * call the callback function.
  */
-ISR(TCF1_ERR_vect)
+TC_ISR(TCF1_ERR_vect)
 {
 	if (tc_tcf1_err_callback) {
 		tc_tcf1_err_callback();
@@ -671,7 +680,7 @@ ISR(TCF1_ERR_vect)
  * This function will handle interrupt on Timer Counter F1 Compare/CaptureA and
  * call the callback function.
  */
-ISR(TCF1_CCA_vect)
+TC_ISR(TCF1_CCA_vect)
 {
 	if (tc_tcf1_cca_callback) {
 		tc_tcf1_cca_callback();
@@ -685,7 +694,7 @@ ISR(TCF1_CCA_vect)
  * This function will handle interrupt on Timer Counter F1 Compare/CaptureB and
  * call the callback function.
  */
-ISR(TCF1_CCB_vect)
+TC_ISR(TCF1_CCB_vect)
 {
 	if (tc_tcf1_ccb_callback) {
 		tc_tcf1_ccb_callback();
@@ -83,6 +83,36 @@ extern "C" {
  */
 typedef void (*tc_callback_t) (void);
 
+/**
+ * \brief Bind \a handler straight to interrupt \a vec of timer \a tc
+ *
+ * For hot timers the callback pointer costs a call and the save of every
+ * call-clobbered register on each interrupt. This binding defines the
+ * interrupt vector itself and calls \a handler from it; make the handler
+ * static inline and it is inlined, so only the registers it uses are saved.
+ * The callback handler of the driver for that vector is weak and drops out
+ * at link time, so a callback set for it is never called.
+ *
+ * Use once per vector, at file scope:
+ * \code
+	static inline void sample_tick(void)
+	{
+		...
+	}
+
+	TC_BIND_DIRECT(TCC1, OVF, sample_tick)
+\endcode
+ *
+ * \param tc Timer name, e.g. TCC1
+ * \param vec Interrupt name: OVF, ERR, CCA, CCB, CCC or CCD
+ * \param handler Function taking and returning nothing
+ */
+#define TC_BIND_DIRECT(tc, vec, handler) \
+	ISR(tc##_##vec##_vect) \
+	{ \
+		handler(); \
+	}
+
 //! Timer Counter Capture Compare Channel index
 enum tc_cc_channel_t {
 	//! Channel A
@@ -0,0 +1,63 @@
+/**
+ * \file
+ *
+ * \brief Occasional single conversions of the board sensors on ADCB
+ *
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "auxadc.h"
+
+/**
+ * \brief Set up ADCB for signed 12-bit single conversions against VCC/1.6
+ *
+ * Leaves the ADC off. Does nothing when the capture owns ADCB.
+ */
+void auxadc_init(void)
+{
+#if AUXADC_ENABLE
+	struct adc_config adc_conf;
+
+	memset(&adc_conf, 0, sizeof(adc_conf));
+	adc_set_conversion_parameters(&adc_conf, ADC_SIGN_ON, ADC_RES_12,
+			ADC_REF_VCC);
+	adc_set_conversion_trigger(&adc_conf, ADC_TRIG_MANUAL, 1, 0);
+	adc_set_clock_rate(&adc_conf, AUXADC_CLOCK_HZ);
+	adc_write_configuration(&AUXADC_ADC, &adc_conf);
+#endif
+}
+
+/**
+ * \brief Convert \a input once, waiting for the result
+ *
+ * The first conversion after the ADC is turned on is thrown away, two take
+ * under 100 us in all. Only call with AUXADC_ENABLE.
+ *
+ * \return the signed result, from 0 at ground to 2047 at the reference
+ */
+int16_t auxadc_read(enum adcch_positive_input input)
+{
+#if AUXADC_ENABLE
+	struct adc_channel_config adcch_conf;
+	int16_t result;
+	uint8_t i;
+
+	memset(&adcch_conf, 0, sizeof(adcch_conf));
+	adcch_set_input(&adcch_conf, input, ADCCH_NEG_NONE, 1);
+	adcch_write_configuration(&AUXADC_ADC, ADC_CH0, &adcch_conf);
+
+	adc_enable(&AUXADC_ADC);
+	for (i = 0; i < 2; i++) {
+		adc_start_conversion(&AUXADC_ADC, ADC_CH0);
+		adc_wait_for_interrupt_flag(&AUXADC_ADC, ADC_CH0);
+	}
+	result = adc_get_signed_result(&AUXADC_ADC, ADC_CH0);
+	adc_disable(&AUXADC_ADC);
+	return result;
+#else
+	UNUSED(input);
+	Assert(false);
+	return 0;
+#endif
+}
@@ -0,0 +1,41 @@
+/**
+ * \file
+ *
+ * \brief Occasional single conversions of the board sensors on ADCB
+ *
+ * With CAPTURE_ADC_SINGLE the capture leaves ADCB alone, and the board
+ * sensors on PORTB share it: the temperature sensor for \ref tempcomp.h
+ * and the light sensor for \ref display.h, each read a second or so
+ * apart. \ref auxadc_read() turns the ADC on, converts one input on
+ * channel 0 and turns it off again, all within the calling task, so no
+ * conversion is ever left running for another reader to clash with and
+ * ADCB draws nothing in between.
+ *
+ * In the dual arrangements ADCB is part of the capture and AUXADC_ENABLE
+ * is 0; the readers then leave their sensors unread.
+ *
+ */
+
+#ifndef AUXADC_H
+#define AUXADC_H
+
+#include <compiler.h>
+#include <adc.h>
+#include "capture.h"
+
+#if CAPTURE_ADC == CAPTURE_ADC_SINGLE
+#  define AUXADC_ENABLE         1
+#else
+#  define AUXADC_ENABLE         0
+#endif
+
+//! ADC of the board sensors, as named by board.h for both
+#define AUXADC_ADC              ADCB
+
+//! ADC clock, a 12-bit conversion takes about 35 us at this rate
+#define AUXADC_CLOCK_HZ         200000UL
+
+void auxadc_init(void);
+int16_t auxadc_read(enum adcch_positive_input input);
+
+#endif /* AUXADC_H */
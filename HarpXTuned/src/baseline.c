@@ -0,0 +1,128 @@
+/**
+ * \file
+ *
+ * \brief Boot time DC offset and noise floor of each channel
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "baseline.h"
+#include "calib.h"
+#include "gate.h"
+
+#if (BASELINE_SETTLE_HOPS * CAPTURE_HOP + BASELINE_FRAMES) > MAXBUFFER
+#  error "The baseline capture must not wrap the ring"
+#endif
+#if 3 * CHANNELS > CALIB_VALUE_MAX
+#  error "The baseline record exceeds a calibration record"
+#endif
+
+/**
+ * \internal
+ * \brief Work out the offset and noise floor of channel \a ch from
+ * \a view
+ */
+static void baseline_channel(const struct capture_view *view,
+		struct baseline_record *rec, uint8_t ch)
+{
+	int32_t sum = 0;
+	uint16_t noise = 0;
+	int16_t min = INT16_MAX;
+	int16_t max = INT16_MIN;
+	uint8_t left = CAPTURE_BLOCK_FRAMES;
+	uint8_t span;
+
+	for (span = 0; span < 2; span++) {
+		hugemem_ptr_t from = view->addr[span];
+		uint16_t count = view->len[span];
+
+		while (count--) {
+			int16_t v = hugemem_read16(from);
+
+			sum += v;
+			if (v < min) {
+				min = v;
+			}
+			if (v > max) {
+				max = v;
+			}
+			// Peak-to-peak of each block, as the gate sees it
+			if (!--left) {
+				uint16_t p2p = (uint16_t)((int32_t)max - min);
+
+				if (p2p > noise) {
+					noise = p2p;
+				}
+				min = INT16_MAX;
+				max = INT16_MIN;
+				left = CAPTURE_BLOCK_FRAMES;
+			}
+			from += CAPTURE_POS_STRIDE;
+		}
+	}
+
+	// The decimated samples carry OVERSAMPLING times the input at the
+	// top gain
+	sum = ((sum << (4 - CAPTURE_LOG2_OVERSAMPLING))
+			+ (BASELINE_FRAMES / 2)) >> BASELINE_LOG2_FRAMES;
+	rec->offset[ch] = (sum > INT16_MAX) ? INT16_MAX
+			: (sum < INT16_MIN) ? INT16_MIN : (int16_t)sum;
+	noise >>= CAPTURE_LOG2_OVERSAMPLING;
+	rec->noise[ch] = (noise > UINT8_MAX) ? UINT8_MAX : noise;
+}
+
+/**
+ * \brief Measure the offset and noise floor of every channel
+ *
+ * Runs the capture on its own, with no offsets, and stops it again; the
+ * strings must be quiet.
+ */
+void baseline_measure(struct baseline_record *rec)
+{
+	struct capture_view view;
+	uint8_t seen = 0;
+	uint16_t end_pos;
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		capture_set_offset(ch, 0);
+	}
+	capture_start();
+	while (capture_hops < BASELINE_SETTLE_HOPS
+			+ BASELINE_FRAMES / CAPTURE_HOP);
+	capture_stop();
+
+	capture_hop_take(&seen, &end_pos);
+	for (ch = 0; ch < CHANNELS; ch++) {
+		capture_view(ch, end_pos, BASELINE_FRAMES, &view);
+		baseline_channel(&view, rec, ch);
+	}
+}
+
+/**
+ * \brief Set up the offsets and noise floors
+ *
+ * From the \ref calib.h store, or measured and stored if it has none or
+ * BASELINE_BUTTON is held. Interrupts must be enabled, and
+ * \ref serial_tx_init() and \ref capture_init() must have been set up;
+ * call before the real \ref capture_start().
+ */
+void baseline_init(void)
+{
+	struct baseline_record rec;
+	uint8_t ch;
+
+	if (!calib_read(CALIB_KEY_BASELINE, &rec, sizeof(rec))
+			|| gpio_pin_is_low(BASELINE_BUTTON)) {
+		baseline_measure(&rec);
+		calib_write(CALIB_KEY_BASELINE, &rec, sizeof(rec));
+	}
+	for (ch = 0; ch < CHANNELS; ch++) {
+		capture_set_offset(ch, rec.offset[ch]);
+		gate_set_floor(ch, (uint16_t)rec.noise[ch]
+				<< CAPTURE_LOG2_OVERSAMPLING);
+		printf_P(PSTR("baseline ch%u offset %d/16 LSB noise %u LSB\r\n"),
+				ch, rec.offset[ch], rec.noise[ch]);
+	}
+}
@@ -0,0 +1,59 @@
+/**
+ * \file
+ *
+ * \brief Boot time DC offset and noise floor of each channel
+ *
+ * The XMEGA ADC has a factory gain and linearity calibration, which
+ * adc_write_configuration() loads, but no offset correction, and the
+ * pickup bias differs from channel to channel. \ref baseline_init()
+ * captures BASELINE_FRAMES frames with the strings quiet. The mean of
+ * each channel becomes the offset its decimator takes off, see
+ * \ref capture_set_offset(), so every stage downstream sees samples
+ * around 0 at no cost in the sample path. The largest peak-to-peak value
+ * of a block becomes the channel's noise floor for \ref gate.h.
+ *
+ * The results are kept in the \ref calib.h store and measured only when
+ * it has none, or when board button 7 is held at reset, e.g. after
+ * changing a pickup. They are printed on the stdio USART either way.
+ *
+ */
+
+#ifndef BASELINE_H
+#define BASELINE_H
+
+#include <compiler.h>
+#include "capture.h"
+
+//! log2 of the frames measured, a power of two so the mean is a shift
+#ifndef BASELINE_LOG2_FRAMES
+#  define BASELINE_LOG2_FRAMES  11
+#endif
+#define BASELINE_FRAMES         (1U << BASELINE_LOG2_FRAMES)
+
+//! Capture hops let by before measuring, for the filters to settle
+#ifndef BASELINE_SETTLE_HOPS
+#  define BASELINE_SETTLE_HOPS  2
+#endif
+
+//! Button that forces a new measurement when held at reset
+#define BASELINE_BUTTON         GPIO_PUSH_BUTTON_7
+
+#if BASELINE_FRAMES > MAXBUFFER || BASELINE_FRAMES % CAPTURE_BLOCK_FRAMES
+#  error "BASELINE_FRAMES must be whole blocks and fit the ring"
+#endif
+#if BASELINE_FRAMES % CAPTURE_HOP
+#  error "BASELINE_FRAMES must be whole capture hops"
+#endif
+
+//! Record of CALIB_KEY_BASELINE
+struct baseline_record {
+	//! DC offset, 1/16 ADC LSB
+	int16_t offset[CHANNELS];
+	//! Noise floor, ADC LSB peak-to-peak, saturated
+	uint8_t noise[CHANNELS];
+};
+
+void baseline_init(void);
+void baseline_measure(struct baseline_record *rec);
+
+#endif /* BASELINE_H */
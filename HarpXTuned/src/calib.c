@@ -0,0 +1,248 @@
+/**
+ * \file
+ *
+ * \brief Calibration store in EEPROM
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+#include <asf.h>
+#include "calib.h"
+
+//! \internal Key of an erased page
+#define CALIB_KEY_NONE          0xff
+
+//! \internal Bytes of a record header read by calib_scan()
+#define CALIB_HEADER_SIZE       6
+
+#if CALIB_PAGES >= CALIB_KEY_NONE
+#  error "Log pages must fit the 8-bit index"
+#endif
+
+//! \internal One record, laid out as one EEPROM page
+struct calib_record {
+	//! Write count, the highest record of a key wins
+	uint32_t seq;
+	uint8_t key;
+	uint8_t len;
+	uint8_t value[CALIB_VALUE_MAX];
+	//! CRC-CCITT of everything above
+	uint16_t crc;
+};
+
+//! \internal Page of the newest record of each key, CALIB_KEY_NONE if none
+static uint8_t calib_index[CALIB_KEYS];
+//! \internal Page the next write goes to, if it is free by then
+static uint8_t calib_head;
+//! \internal Sequence number of the next write
+static uint32_t calib_seq;
+//! \internal The log has been scanned
+static bool calib_scanned;
+
+//! \internal Page buffer for reads and writes
+static struct calib_record calib_page;
+
+/**
+ * \internal
+ * \brief EEPROM address of log page \a page
+ */
+static eeprom_addr_t calib_addr(uint8_t page)
+{
+	return (eeprom_addr_t)(CALIB_FIRST_PAGE + page) * EEPROM_PAGE_SIZE;
+}
+
+/**
+ * \internal
+ * \brief CRC of \ref calib_page
+ */
+static uint16_t calib_crc(void)
+{
+	const uint8_t *p = (const uint8_t *)&calib_page;
+	uint16_t crc = 0xffff;
+	uint8_t i;
+
+	for (i = 0; i < offsetof(struct calib_record, crc); i++) {
+		crc = _crc_ccitt_update(crc, p[i]);
+	}
+	return crc;
+}
+
+/**
+ * \internal
+ * \brief Load log page \a page into \ref calib_page and check it
+ *
+ * \retval true if the page holds a whole record
+ */
+static bool calib_load(uint8_t page)
+{
+	nvm_eeprom_read_buffer(calib_addr(page), &calib_page,
+			sizeof(calib_page));
+	return calib_page.key < CALIB_KEYS
+			&& calib_page.len <= CALIB_VALUE_MAX
+			&& calib_page.crc == calib_crc();
+}
+
+/**
+ * \internal
+ * \brief Whether log page \a page holds the newest record of a key
+ */
+static bool calib_is_live(uint8_t page)
+{
+	uint8_t key;
+
+	for (key = 0; key < CALIB_KEYS; key++) {
+		if (calib_index[key] == page) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * \internal
+ * \brief Find the newest record of every key, on the first use of the
+ * store
+ *
+ * Reads the header of every page and the whole page only where it is the
+ * newest of its key so far.
+ */
+static void calib_scan(void)
+{
+	struct calib_record *head = &calib_page;
+	uint32_t newest[CALIB_KEYS];
+	uint8_t page;
+	uint8_t key;
+
+	if (calib_scanned) {
+		return;
+	}
+	calib_scanned = true;
+
+	for (key = 0; key < CALIB_KEYS; key++) {
+		calib_index[key] = CALIB_KEY_NONE;
+	}
+	calib_head = 0;
+	calib_seq = 0;
+
+	for (page = 0; page < CALIB_PAGES; page++) {
+		nvm_eeprom_read_buffer(calib_addr(page), head, CALIB_HEADER_SIZE);
+		key = head->key;
+		if (key >= CALIB_KEYS || (calib_index[key] != CALIB_KEY_NONE
+				&& head->seq <= newest[key])) {
+			continue;
+		}
+		if (!calib_load(page)) {
+			continue;
+		}
+		calib_index[key] = page;
+		newest[key] = head->seq;
+
+		// Carry on after the newest record of all
+		if (head->seq >= calib_seq) {
+			calib_seq = head->seq + 1;
+			calib_head = page + 1;
+		}
+	}
+	if (calib_head == CALIB_PAGES) {
+		calib_head = 0;
+	}
+}
+
+/**
+ * \brief Read the value of \a key
+ *
+ * \param value Buffer for \a len bytes
+ * \param len Size of the value, which must match the stored one
+ *
+ * \retval true if \a value holds the stored value
+ * \retval false if \a key was never written or its size has changed,
+ * \a value is left alone
+ */
+bool calib_read(enum calib_key key, void *value, uint8_t len)
+{
+	uint8_t page;
+
+	Assert(key < CALIB_KEYS);
+
+	calib_scan();
+	page = calib_index[key];
+	if (page == CALIB_KEY_NONE || !calib_load(page)
+			|| calib_page.len != len) {
+		return false;
+	}
+	memcpy(value, calib_page.value, len);
+	return true;
+}
+
+/**
+ * \brief Store \a len bytes of \a value under \a key
+ *
+ * Writes the next page of the log that does not hold a newest record,
+ * in one page buffer load and atomic write. Returns once the write has
+ * started; the NVM controller takes a few milliseconds to finish it and
+ * the next EEPROM access waits for it. Interrupts are held off while the
+ * page buffer is loaded, as the NVM command then in force would break
+ * program memory reads from an interrupt.
+ */
+void calib_write(enum calib_key key, const void *value, uint8_t len)
+{
+	irqflags_t flags;
+	uint8_t page;
+
+	Assert(key < CALIB_KEYS);
+	Assert(len <= CALIB_VALUE_MAX);
+
+	calib_scan();
+	page = calib_head;
+
+	// A write always finds a free page, there are more pages than keys
+	while (calib_is_live(page)) {
+		if (++page == CALIB_PAGES) {
+			page = 0;
+		}
+	}
+
+	memset(&calib_page, CALIB_KEY_NONE, sizeof(calib_page));
+	calib_page.key = key;
+	calib_page.len = len;
+	calib_page.seq = calib_seq++;
+	memcpy(calib_page.value, value, len);
+	calib_page.crc = calib_crc();
+
+	// Let a previous write finish with interrupts still on
+	nvm_wait_until_ready();
+	flags = cpu_irq_save();
+	nvm_eeprom_load_page_to_buffer((const uint8_t *)&calib_page);
+	nvm_eeprom_atomic_write_page(CALIB_FIRST_PAGE + page);
+	cpu_irq_restore(flags);
+
+	calib_index[key] = page;
+	calib_head = (page + 1 == CALIB_PAGES) ? 0 : page + 1;
+}
+
+/**
+ * \brief Print the newest record of every key on the stdio USART
+ */
+void calib_dump(void)
+{
+	uint8_t key;
+	uint8_t i;
+
+	calib_scan();
+	for (key = 0; key < CALIB_KEYS; key++) {
+		printf_P(PSTR("calib %u:"), key);
+		if (calib_index[key] == CALIB_KEY_NONE
+				|| !calib_load(calib_index[key])) {
+			printf_P(PSTR(" default\r\n"));
+			continue;
+		}
+		printf_P(PSTR(" page %u seq %lu,"), calib_index[key],
+				(unsigned long)calib_page.seq);
+		for (i = 0; i < calib_page.len; i++) {
+			printf_P(PSTR(" %02x"), calib_page.value[i]);
+		}
+		printf_P(PSTR("\r\n"));
+	}
+}
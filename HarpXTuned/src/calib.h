@@ -0,0 +1,72 @@
+/**
+ * \file
+ *
+ * \brief Calibration store in EEPROM
+ *
+ * A small key/value log for the tuning settings that have to survive a
+ * power cycle. Every record fills one EEPROM page and every write goes to
+ * a new page, round the CALIB_PAGES pages of the log, so the pages wear
+ * evenly; the pages that hold the newest record of some key are skipped,
+ * and nothing else needs to be moved. A page is written in one atomic
+ * erase and write from the page buffer, and a record only counts if its
+ * CRC matches, so a write cut short by a power loss leaves the previous
+ * value in place.
+ *
+ * The first use of the store reads the page headers once through the
+ * mapped EEPROM and keeps the page of the newest record of each key; a
+ * read is then a single copy from that page.
+ *
+ */
+
+#ifndef CALIB_H
+#define CALIB_H
+
+#include <compiler.h>
+#include <nvm.h>
+
+//! First EEPROM page of the log
+#ifndef CALIB_FIRST_PAGE
+#  define CALIB_FIRST_PAGE      0
+#endif
+
+//! EEPROM pages of the log
+#ifndef CALIB_PAGES
+#  define CALIB_PAGES           (EEPROM_SIZE / EEPROM_PAGE_SIZE)
+#endif
+
+//! Value bytes of one record: a page less sequence, key, length and CRC
+#define CALIB_VALUE_MAX         (EEPROM_PAGE_SIZE - 8)
+
+//! Keys, each with a fixed value layout
+enum calib_key {
+	//! A4 reference, \ref pitch_hz_t
+	CALIB_KEY_A4,
+	//! Temperament, int8_t cents from equal temperament for C, D .. B
+	CALIB_KEY_TEMPERAMENT,
+	//! int8_t cents of each string on top of the temperament
+	CALIB_KEY_STRINGS_LOW,
+	CALIB_KEY_STRINGS_HIGH,
+	//! Pickup gain offsets, int8_t per channel
+	CALIB_KEY_GAIN,
+	//! DC offset and noise floor of each channel, see \ref baseline.h
+	CALIB_KEY_BASELINE,
+	//! Flash CRC of the constant tables, see \ref tables.h
+	CALIB_KEY_TABLES,
+	CALIB_KEYS
+};
+
+//! Strings of CALIB_KEY_STRINGS_LOW, from string 0; the rest are HIGH
+#define CALIB_STRINGS_LOW       CALIB_VALUE_MAX
+
+#if CALIB_KEYS >= CALIB_PAGES
+#  error "The log needs more pages than keys"
+#endif
+#if (CALIB_FIRST_PAGE + CALIB_PAGES) * EEPROM_PAGE_SIZE > EEPROM_SIZE
+#  error "The log exceeds the EEPROM"
+#endif
+
+bool calib_read(enum calib_key key, void *value, uint8_t len);
+void calib_write(enum calib_key key, const void *value, uint8_t len);
+void calib_dump(void);
+
+#endif /* CALIB_H */
@@ -0,0 +1,1002 @@
+/**
+ * \file
+ *
+ * \brief HarpXTuned capture engine
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <string.h>
+#include <asf.h>
+#include <dma.h>
+#include "capture.h"
+#include "evsys.h"
+#include "frameq.h"
+#include "gate.h"
+#include "irqlevel.h"
+#include "jitter.h"
+#include "prof.h"
+#include "sched.h"
+#include "sram.h"
+#include "sync.h"
+#include "timebase.h"
+#include "dsp/cic.h"
+
+hugemem_ptr_t capture_ring;
+volatile uint16_t capture_write_pos;
+int16_t capture_window[CHANNELS][CAPTURE_WINDOW];
+volatile uint8_t capture_hops;
+
+//! \internal Queue slot being filled, capture_discard while the queue is full
+static frameq_block_t *capture_block;
+//! \internal Frames left to fill in capture_block
+static uint8_t capture_block_left;
+#if FRAMEQ_FRAMES
+//! \internal Next frame of capture_block
+static capture_frame_t *capture_next;
+#endif
+//! \internal Stand-in slot while the queue is full, never committed
+static frameq_block_t capture_discard;
+//! \internal SDRAM address of channel 0 at capture_write_pos
+static hugemem_ptr_t capture_write_addr;
+//! \internal Blocks left in the current hop
+static uint8_t capture_hop_blocks;
+//! \internal \ref capture_state, written with the ADC interrupts in mind
+static volatile uint8_t capture_state;
+//! \internal The ADCs are set up for listening, not for the sweeps
+static bool capture_adc_listen;
+
+#if CAPTURE_HOP / CAPTURE_BLOCK_FRAMES > 255 || CAPTURE_BLOCK_FRAMES > 255
+#  error "The blocks of a hop and the frames of a block must fit 8-bit counts"
+#endif
+
+//! \internal Decimator state of every channel
+static struct cic_state capture_cic[CHANNELS];
+//! \internal Input offset of every channel, see \ref capture_set_offset()
+static int16_t capture_offsets[CHANNELS];
+
+//! \internal ADCA mux input of each sweep channel
+static const enum adcch_positive_input
+		capture_inputs[CAPTURE_SWEEP_CHANNELS] = CAPTURE_CHANNEL_INPUTS;
+#if CAPTURE_ADC != CAPTURE_ADC_SINGLE
+//! \internal ADCB mux input of each sweep channel
+static const enum adcch_positive_input
+		capture_inputs_b[CAPTURE_SWEEP_CHANNELS] = CAPTURE_ADCB_INPUTS;
+#endif
+
+#if CAPTURE_AGC
+//! \internal Log2 of the gain the decimator decodes each channel at
+static uint8_t capture_gain[CHANNELS];
+//! \internal Log2 of the gain last written to the ADC for each channel
+static uint8_t capture_gain_adc[CHANNELS];
+//! \internal Log2 of the gain picked from the last block of each channel
+static uint8_t capture_gain_want[CHANNELS];
+
+//! \internal Half the ADC range at log2 gain \a gain, in frame units
+#define CAPTURE_AGC_HALF(gain)  (2048U << (CAPTURE_LOG2_SCALE - (gain)))
+
+/**
+ * \internal
+ * \brief Write log2 gain \a gain to the ADC channel of channel \a ch
+ */
+static void capture_agc_set_gain(uint8_t ch, uint8_t gain)
+{
+	uint8_t setting = adcch_get_gain_setting(1 << gain);
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+	ADC_t *adc = (ch < CAPTURE_SWEEP_CHANNELS) ? &ADCA : &ADCB;
+	ADC_CH_t *adc_ch = &(&adc->CH0)[ch % CAPTURE_SWEEP_CHANNELS];
+#else
+	ADC_CH_t *adc_ch = &(&ADCA.CH0)[ch];
+#endif
+
+	adc_ch->CTRL = (adc_ch->CTRL & ~ADC_CH_GAIN_gm) | setting;
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST
+	// Both ADCs read the same pickup
+	adc_ch = &(&ADCB.CH0)[ch];
+	adc_ch->CTRL = (adc_ch->CTRL & ~ADC_CH_GAIN_gm) | setting;
+#endif
+}
+
+/**
+ * \internal
+ * \brief Pick the gain of every channel from the block just completed
+ *
+ * Call before \ref gate_block() clears the block ranges.
+ */
+static inline void capture_agc_pick(void)
+{
+	uint8_t closed = ~gate_get_active();
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		const struct gate_channel *gc = &gate_ch[ch];
+		uint16_t p2p = (uint16_t)((int32_t)gc->max - gc->min);
+		uint8_t gain = capture_gain[ch];
+		uint16_t half = CAPTURE_AGC_HALF(gain);
+
+		/*
+		 * Up only below a sixteenth of the range, so the block still has
+		 * 4 times the room to the way down at the doubled gain
+		 */
+		if (p2p > half) {
+			if (gain) {
+				gain--;
+			}
+		} else if ((closed & (1 << ch)) && gain < CAPTURE_AGC_LOG2_GAIN
+				&& p2p < half / 8) {
+			gain++;
+		}
+		capture_gain_want[ch] = gain;
+	}
+}
+
+/**
+ * \internal
+ * \brief Write the picked gains to the ADCs
+ */
+static void capture_agc_write(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		uint8_t gain = capture_gain_want[ch];
+
+		if (gain != capture_gain_adc[ch]) {
+			capture_gain_adc[ch] = gain;
+			capture_agc_set_gain(ch, gain);
+		}
+	}
+}
+
+/**
+ * \internal
+ * \brief Decode the following samples at the gains written to the ADCs
+ *
+ * Call between two frames. The offsets are at the top gain.
+ */
+static void capture_agc_rescale(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		struct cic_state *st = &capture_cic[ch];
+		uint8_t gain = capture_gain_adc[ch];
+
+		if (gain != capture_gain[ch]) {
+			cic_rescale(st, (int8_t)gain - (int8_t)capture_gain[ch]);
+			cic_set_offset(st, capture_offsets[ch]
+					>> (CAPTURE_AGC_LOG2_GAIN - gain));
+			capture_gain[ch] = gain;
+		}
+	}
+}
+
+/**
+ * \internal
+ * \brief Start every channel at the top gain
+ *
+ * The ADCs must be enabled.
+ */
+static void capture_agc_reset(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		capture_gain[ch] = CAPTURE_AGC_LOG2_GAIN;
+		capture_gain_adc[ch] = CAPTURE_AGC_LOG2_GAIN;
+		capture_gain_want[ch] = CAPTURE_AGC_LOG2_GAIN;
+		capture_agc_set_gain(ch, CAPTURE_AGC_LOG2_GAIN);
+	}
+}
+#endif /* CAPTURE_AGC */
+
+/**
+ * \internal
+ * \brief Take decimated sample \a x of channel \a ch to the frame scale
+ *
+ * Shifted up by the gain below the top one, clamped to 16 bits.
+ */
+static inline int16_t capture_agc_scale(uint8_t ch, int16_t x)
+{
+#if CAPTURE_AGC
+	uint8_t shift = CAPTURE_AGC_LOG2_GAIN - capture_gain[ch];
+	int16_t limit = INT16_MAX >> shift;
+
+	if (x > limit) {
+		return INT16_MAX;
+	} else if (x < -limit - 1) {
+		return INT16_MIN;
+	}
+	return (int16_t)((uint16_t)x << shift);
+#else
+	UNUSED(ch);
+	return x;
+#endif
+}
+
+/**
+ * \internal
+ * \brief Claim the next queue slot, or the stand-in while the queue is full
+ */
+static inline void capture_claim(void)
+{
+	capture_block = frameq_get_free();
+	if (!capture_block) {
+		capture_block = &capture_discard;
+	}
+	capture_block_left = CAPTURE_BLOCK_FRAMES;
+#if FRAMEQ_FRAMES
+	capture_next = capture_block->frame;
+#endif
+}
+
+/**
+ * \internal
+ * \brief Store one decimated frame into the SDRAM rings and the queue
+ *
+ * Every CAPTURE_BLOCK_FRAMES frames the current queue slot is committed and
+ * the next one claimed, and every CAPTURE_HOP frames a hop is counted.
+ * While the queue is full the frames go to capture_discard, so the
+ * per-frame path has no branch on the queue state.
+ * The ring address and the slot frame are kept as running pointers instead
+ * of being computed from the indices. Without streaming channels the
+ * slot has no frames, and the ring is the only copy of a sample.
+ *
+ * \param frame Decimated frame
+ * \param pos Write position
+ *
+ * \return Next write position
+ */
+static inline uint16_t capture_store(const capture_frame_t *frame,
+		uint16_t pos)
+{
+	hugemem_ptr_t addr = capture_write_addr;
+	uint8_t ch;
+
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_FRAME
+	// Contiguous frame, two channels per write
+	for (ch = 0; ch < CHANNELS; ch += 2) {
+		hugemem_write32(addr, (uint16_t)frame->ch[ch]
+				| ((uint32_t)(uint16_t)frame->ch[ch + 1] << 16));
+		addr += 2 * sizeof(int16_t);
+	}
+#else
+	for (ch = 0; ch < CHANNELS; ch++) {
+		hugemem_write16(addr, frame->ch[ch]);
+		addr += CAPTURE_CH_STRIDE;
+	}
+#endif
+	if (++pos >= MAXBUFFER) {
+		pos = 0;
+		capture_write_addr = capture_ring;
+	} else {
+		capture_write_addr += CAPTURE_POS_STRIDE;
+	}
+
+	gate_frame(frame);
+#if FRAMEQ_FRAMES
+	*capture_next++ = *frame;
+#endif
+	if (!--capture_block_left) {
+		uint8_t active;
+
+#if CAPTURE_AGC
+		capture_agc_pick();
+#  if CAPTURE_MODE == CAPTURE_MODE_SWEEP
+		// The next sweep is not triggered yet
+		capture_agc_write();
+		capture_agc_rescale();
+#  endif
+#endif
+		active = gate_block();
+
+		if (!--capture_hop_blocks) {
+			capture_hop_blocks = CAPTURE_HOP / CAPTURE_BLOCK_FRAMES;
+			capture_hops++;
+			sync_hop();
+		}
+		sync_block();
+		sram_note();
+		if (capture_block != &capture_discard) {
+			capture_block->time = timebase_now();
+			capture_block->end_pos = pos;
+			capture_block->active = active;
+			capture_block->onset = gate_take_onsets();
+			frameq_commit();
+			sched_post(SCHED_CONSUME);
+		}
+		capture_claim();
+	}
+	return pos;
+}
+
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+
+#if CAPTURE_ADC == CAPTURE_ADC_SINGLE
+#  define CAPTURE_ADCS          1
+#else
+#  define CAPTURE_ADCS          2
+#endif
+
+//! \internal Raw sweeps of each ADC, one half per channel of its DMA pair
+static capture_sweep_t capture_dma_buf[CAPTURE_ADCS][2][CAPTURE_BLOCK_SWEEPS];
+
+/**
+ * \internal
+ * \brief Decimate the oversampled sweeps of one DMA half into the rings
+ *
+ * \param half Half of the raw buffers that just completed
+ */
+static void capture_decimate(uint8_t half)
+{
+	const capture_sweep_t *a = capture_dma_buf[0][half];
+#if CAPTURE_ADCS == 2
+	const capture_sweep_t *b = capture_dma_buf[1][half];
+#endif
+	uint16_t pos = capture_write_pos;
+	capture_frame_t out;
+	uint8_t frame;
+	uint8_t ch;
+
+	jitter_entry(CAPTURE_BLOCK_SWEEPS);
+#if CAPTURE_AGC
+	// Into the half now filling, which the next call decimates
+	capture_agc_write();
+#endif
+	for (frame = 0; frame < CAPTURE_BLOCK_FRAMES; frame++) {
+#if CAPTURE_ADC == CAPTURE_ADC_SINGLE
+		for (ch = 0; ch < CHANNELS; ch++) {
+			out.ch[ch] = cic_compensate(&capture_cic[ch],
+					capture_agc_scale(ch, cic_decimate(
+					&capture_cic[ch], &a->ch[ch])));
+		}
+#elif CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+		for (ch = 0; ch < CAPTURE_SWEEP_CHANNELS; ch++) {
+			struct cic_state *st = &capture_cic[ch];
+			struct cic_state *st_b = &capture_cic[ch
+					+ CAPTURE_SWEEP_CHANNELS];
+
+			out.ch[ch] = cic_compensate(st, capture_agc_scale(ch,
+					cic_decimate(st, &a->ch[ch])));
+			out.ch[ch + CAPTURE_SWEEP_CHANNELS] = cic_compensate(st_b,
+					capture_agc_scale(ch + CAPTURE_SWEEP_CHANNELS,
+					cic_decimate(st_b, &b->ch[ch])));
+		}
+#else
+		for (ch = 0; ch < CHANNELS; ch++) {
+			out.ch[ch] = cic_compensate(&capture_cic[ch],
+					capture_agc_scale(ch, cic_decimate_pair(
+					&capture_cic[ch], &a->ch[ch], &b->ch[ch])));
+		}
+#endif
+		a += CAPTURE_ADC_SWEEPS;
+#if CAPTURE_ADCS == 2
+		b += CAPTURE_ADC_SWEEPS;
+#endif
+		pos = capture_store(&out, pos);
+	}
+	capture_write_pos = pos;
+#if CAPTURE_AGC
+	capture_agc_rescale();
+#endif
+}
+
+/*
+ * The DMA channels run at fixed priority, so of the sweeps taken on one
+ * trigger ADCB's is moved after ADCA's, and in the fast arrangement ADCB
+ * sweeps last anyway. The last pair to complete a half runs the decimation.
+ */
+
+//! \internal First half of the raw buffers is complete
+static void capture_dma_half0_done(enum dma_channel_status status)
+{
+	if (status == DMA_CH_TRANSFER_COMPLETED) {
+		PROF_BEGIN(PROF_CAPTURE);
+		capture_decimate(0);
+		PROF_END(PROF_CAPTURE);
+	}
+}
+
+//! \internal Second half of the raw buffers is complete
+static void capture_dma_half1_done(enum dma_channel_status status)
+{
+	if (status == DMA_CH_TRANSFER_COMPLETED) {
+		PROF_BEGIN(PROF_CAPTURE);
+		capture_decimate(1);
+		PROF_END(PROF_CAPTURE);
+	}
+}
+
+/**
+ * \internal
+ * \brief Configure one DMA channel of a double buffer pair
+ *
+ * Each ADC group request, \a trigger, moves one 8 byte burst, CH0RES..CH3RES
+ * of \a adc, into the next sweep of \a dest. The source address is reloaded
+ * after every burst, the destination after every block.
+ */
+static void capture_dma_channel_init(dma_channel_num_t num,
+		DMA_CH_TRIGSRC_t trigger, ADC_t *adc, void *dest)
+{
+	struct dma_channel_config config;
+
+	memset(&config, 0, sizeof(config));
+	dma_channel_set_burst_length(&config, DMA_CH_BURSTLEN_8BYTE_gc);
+	dma_channel_set_single_shot(&config);
+	dma_channel_set_repeats(&config, 0);
+	dma_channel_set_transfer_count(&config, sizeof(capture_dma_buf[0][0]));
+	dma_channel_set_trigger_source(&config, trigger);
+	dma_channel_set_src_mode(&config, DMA_CH_SRCRELOAD_BURST_gc,
+			DMA_CH_SRCDIR_INC_gc);
+	dma_channel_set_dest_mode(&config, DMA_CH_DESTRELOAD_BLOCK_gc,
+			DMA_CH_DESTDIR_INC_gc);
+	dma_channel_set_source_address(&config, (uint16_t)&adc->CH0RES);
+	dma_channel_set_destination_address(&config, (uint16_t)dest);
+	dma_channel_set_interrupt_level(&config, IRQLEVEL_CAPTURE_DMA);
+	dma_channel_write_config(num, &config);
+}
+
+#elif CAPTURE_MODE == CAPTURE_MODE_SWEEP
+
+/*
+ * Number of sweeps integrated for the frame being built. It lives in a
+ * general purpose I/O register, so the interrupt reads and writes it with
+ * single cycle IN and OUT instructions.
+ */
+#ifdef GPIO_GPIOR0
+#  define CAPTURE_SWEEP_COUNT   GPIO_GPIOR0
+#else
+#  define CAPTURE_SWEEP_COUNT   GPIO_GPIO0
+#endif
+
+/**
+ * \internal
+ * \brief ADCA CH3 conversion complete, i.e. the whole sweep is done
+ *
+ * CH0RES..CH3RES are contiguous, so they are read as one frame.
+ */
+ISR(ADCA_CH3_vect)
+{
+	const int16_t *res = (const int16_t *)&ADCA.CH0RES;
+	capture_frame_t out;
+	uint8_t ch;
+	PROF_BEGIN(PROF_CAPTURE);
+
+	jitter_entry(1);
+	for (ch = 0; ch < CHANNELS; ch++) {
+		cic_integrate(&capture_cic[ch], res[ch]);
+	}
+
+	if (++CAPTURE_SWEEP_COUNT == OVERSAMPLING) {
+		CAPTURE_SWEEP_COUNT = 0;
+		for (ch = 0; ch < CHANNELS; ch++) {
+			out.ch[ch] = cic_compensate(&capture_cic[ch],
+					capture_agc_scale(ch,
+					cic_comb(&capture_cic[ch])));
+		}
+		capture_write_pos = capture_store(&out, capture_write_pos);
+	}
+	PROF_END(PROF_CAPTURE);
+}
+
+#else
+#  error "Unknown CAPTURE_MODE"
+#endif
+
+/**
+ * \internal
+ * \brief Set up \a adc for event-triggered sweeps of all its channels
+ *
+ * \param adc ADC to configure
+ * \param inputs Mux input of each channel
+ * \param event_ch Event channel starting the sweep
+ */
+static void capture_adc_init(ADC_t *adc,
+		const enum adcch_positive_input *inputs, uint8_t event_ch)
+{
+	struct adc_config adc_conf;
+	struct adc_channel_config adcch_conf;
+	uint8_t ch;
+
+	// Signed 12-bit, event-triggered sweep of all channels
+	memset(&adc_conf, 0, sizeof(adc_conf));
+	adc_set_conversion_parameters(&adc_conf, ADC_SIGN_ON, ADC_RES_12,
+			ADC_REF_VCC);
+	adc_set_conversion_trigger(&adc_conf, ADC_TRIG_EVENT_SWEEP,
+			CAPTURE_SWEEP_CHANNELS, event_ch);
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+	adc_set_dma_request_group(&adc_conf, CAPTURE_SWEEP_CHANNELS);
+#endif
+	adc_set_clock_rate(&adc_conf, PROFILE_ADC_HZ);
+	adc_write_configuration(adc, &adc_conf);
+
+	for (ch = 0; ch < CAPTURE_SWEEP_CHANNELS; ch++) {
+		memset(&adcch_conf, 0, sizeof(adcch_conf));
+#if CAPTURE_AGC
+		adcch_set_input(&adcch_conf, inputs[ch], CAPTURE_AGC_NEG,
+				1 << CAPTURE_AGC_LOG2_GAIN);
+#else
+		adcch_set_input(&adcch_conf, inputs[ch], ADCCH_NEG_NONE, 1);
+#endif
+#if CAPTURE_MODE == CAPTURE_MODE_SWEEP
+		if (ch == CAPTURE_SWEEP_CHANNELS - 1) {
+			adcch_set_interrupt_mode(&adcch_conf,
+					ADCCH_MODE_COMPLETE);
+			adcch_conf.intctrl |= IRQLEVEL_CAPTURE_ADC;
+		}
+#endif
+		adcch_write_configuration(adc, ADC_CH0 << ch, &adcch_conf);
+	}
+}
+
+/**
+ * \internal
+ * \brief Set up the ADCs of the CAPTURE_ADC arrangement for the sweeps
+ */
+static void capture_adcs_init(void)
+{
+	capture_adc_init(&ADCA, capture_inputs, CAPTURE_EVENT_CH);
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+	capture_adc_init(&ADCB, capture_inputs_b, CAPTURE_EVENT_CH);
+#elif CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST
+	capture_adc_init(&ADCB, capture_inputs_b, CAPTURE_EVENT_CH_B);
+#endif
+	capture_adc_listen = false;
+}
+
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+
+/**
+ * \internal
+ * \brief A sample rose above the compare value, disarm and restart
+ *
+ * The ADCs run on until the restart, with their interrupts off. One still
+ * pending from before \ref capture_stop() is ignored.
+ */
+static void capture_heard(void)
+{
+	uint8_t ch;
+
+	if (capture_state != CAPTURE_LISTENING) {
+		return;
+	}
+	for (ch = 0; ch < CAPTURE_SWEEP_CHANNELS; ch++) {
+		(&ADCA.CH0)[ch].INTCTRL = ADC_CH_INTLVL_OFF_gc;
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+		(&ADCB.CH0)[ch].INTCTRL = ADC_CH_INTLVL_OFF_gc;
+#endif
+	}
+	capture_state = CAPTURE_HEARD;
+	sched_post(SCHED_LISTEN);
+}
+
+ISR(ADCA_CH0_vect)
+{
+	capture_heard();
+}
+
+ISR(ADCA_CH1_vect, ISR_ALIASOF(ADCA_CH0_vect));
+ISR(ADCA_CH2_vect, ISR_ALIASOF(ADCA_CH0_vect));
+ISR(ADCA_CH3_vect, ISR_ALIASOF(ADCA_CH0_vect));
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+ISR(ADCB_CH0_vect, ISR_ALIASOF(ADCA_CH0_vect));
+ISR(ADCB_CH1_vect, ISR_ALIASOF(ADCA_CH0_vect));
+ISR(ADCB_CH2_vect, ISR_ALIASOF(ADCA_CH0_vect));
+ISR(ADCB_CH3_vect, ISR_ALIASOF(ADCA_CH0_vect));
+#endif
+
+/**
+ * \internal
+ * \brief Set up \a adc to free-run over its channels and interrupt on a
+ * sample above the open level of any of them
+ *
+ * \param adc ADC to configure
+ * \param first Capture channel of its sweep channel 0
+ */
+static void capture_adc_listen_init(ADC_t *adc, uint8_t first)
+{
+	struct adc_config adc_conf;
+	struct adc_channel_config adcch_conf;
+	int16_t level = INT16_MIN;
+	uint8_t ch;
+
+	// DC offset in ADC LSB plus half the open level, peak-to-peak at a
+	// gain of OVERSAMPLING
+	for (ch = first; ch < first + CAPTURE_SWEEP_CHANNELS; ch++) {
+		int16_t above = (capture_offsets[ch] >> 4) + (int16_t)(gate_ch[ch].open
+				>> (CAPTURE_LOG2_OVERSAMPLING + 1));
+
+		level = Max(level, above);
+	}
+
+	adc_read_configuration(adc, &adc_conf);
+	adc_set_conversion_trigger(&adc_conf, ADC_TRIG_FREERUN_SWEEP,
+			CAPTURE_SWEEP_CHANNELS, 0);
+	adc_set_clock_rate(&adc_conf, CAPTURE_LISTEN_ADC_HZ);
+	adc_set_config_compare_value((&adc_conf), level);
+	adc_write_configuration(adc, &adc_conf);
+
+	for (ch = 0; ch < CAPTURE_SWEEP_CHANNELS; ch++) {
+		adcch_read_configuration(adc, ADC_CH0 << ch, &adcch_conf);
+#if CAPTURE_AGC
+		// The compare value is at the top gain
+		adcch_conf.ctrl = (adcch_conf.ctrl & ~ADC_CH_GAIN_gm)
+				| adcch_get_gain_setting(1 << CAPTURE_AGC_LOG2_GAIN);
+#endif
+		adcch_set_interrupt_mode(&adcch_conf, ADCCH_MODE_ABOVE);
+		adcch_conf.intctrl |= IRQLEVEL_LISTEN_ADC;
+		adcch_write_configuration(adc, ADC_CH0 << ch, &adcch_conf);
+	}
+}
+
+/**
+ * \brief Stop the sweeps and listen for the next pluck
+ *
+ * The compare values follow the offsets and the gate levels, so call it
+ * once the capture has run. Holds the idle sleep lock, which the ADCs run
+ * in, until the matching \ref capture_stop().
+ */
+void capture_listen(void)
+{
+	capture_stop();
+	capture_adc_listen_init(&ADCA, 0);
+	adc_enable(&ADCA);
+#if CAPTURE_ADC != CAPTURE_ADC_SINGLE
+#  if CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+	capture_adc_listen_init(&ADCB, CAPTURE_SWEEP_CHANNELS);
+#  endif
+	// Enabled either way, capture_stop() disables it
+	adc_enable(&ADCB);
+#endif
+	capture_adc_listen = true;
+	sleepmgr_lock_mode(SLEEPMGR_IDLE);
+	capture_state = CAPTURE_LISTENING;
+}
+
+#endif /* CAPTURE_MODE_DMA */
+
+/**
+ * \brief Set up ADCA, the event system, DMA and TCC1 for capture
+ *
+ * The sample rings are reserved from the SDRAM arena, so \ref sdram_init()
+ * must have been called. Nothing runs until \ref capture_start() is called.
+ *
+ * \retval true on success
+ * \retval false if the SDRAM arena could not hold the rings
+ */
+bool capture_init(void)
+{
+	capture_ring = sdram_alloc((uint32_t)CHANNELS * MAXBUFFER
+			* sizeof(int16_t));
+	if (capture_ring == HUGEMEM_NULL) {
+		return false;
+	}
+
+	capture_adcs_init();
+
+	// TCC1 overflow -> event channel 0 -> ADCA sweep (and ADCB, wide)
+	evsys_route(CAPTURE_EVENT_CH, EVSYS_CHMUX_TCC1_OVF_gc);
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST
+	// TCC1 compare A, half a period later -> event channel 1 -> ADCB sweep
+	evsys_route(CAPTURE_EVENT_CH_B, EVSYS_CHMUX_TCC1_CCA_gc);
+#endif
+
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+	// DMA channel 0/1 double buffer pair, 2/3 for ADCB
+	dma_enable();
+#  if CAPTURE_ADC == CAPTURE_ADC_SINGLE
+	dma_set_double_buffer_mode(DMA_DBUFMODE_CH01_gc);
+	dma_set_callback(CAPTURE_DMA_CH_A, capture_dma_half0_done);
+	dma_set_callback(CAPTURE_DMA_CH_B, capture_dma_half1_done);
+#  else
+	dma_set_double_buffer_mode(DMA_DBUFMODE_CH01CH23_gc);
+	dma_set_priority_mode(DMA_PRIMODE_CH0123_gc);
+	dma_set_callback(CAPTURE_DMA_CH_C, capture_dma_half0_done);
+	dma_set_callback(CAPTURE_DMA_CH_D, capture_dma_half1_done);
+#  endif
+#endif
+
+	tc_enable(&TCC1);
+	tc_write_clock_source(&TCC1, TC_CLKSEL_OFF_gc);
+	// Exact period, checked against the clock in conf_profile.h
+	Assert(sysclk_get_per_hz() == PROFILE_PER_HZ);
+	tc_write_period(&TCC1, PROFILE_SWEEP_PERIOD - 1);
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST
+	tc_write_cc(&TCC1, TC_CCA, PROFILE_SWEEP_PERIOD / 2);
+	tc_enable_cc_channels(&TCC1, TC_CCAEN);
+#endif
+
+	return true;
+}
+
+/**
+ * \internal
+ * \brief Start capturing into ring position \a pos, at a hop boundary
+ *
+ * In DMA mode all capture channels are reprogrammed, so a capture stopped
+ * with \ref capture_stop() restarts on a frame boundary. The first channel
+ * of each pair is armed here; the second is enabled by the DMA controller
+ * when the first completes its block.
+ */
+static void capture_run(uint16_t pos)
+{
+	uint8_t ch;
+
+	if (capture_adc_listen) {
+		capture_adcs_init();
+	}
+	capture_write_pos = pos;
+	capture_hop_blocks = CAPTURE_HOP / CAPTURE_BLOCK_FRAMES;
+	frameq_reset();
+	gate_reset();
+	capture_write_addr = capture_ring_addr(0, pos);
+	capture_claim();
+	memset(capture_cic, 0, sizeof(capture_cic));
+	for (ch = 0; ch < CHANNELS; ch++) {
+		cic_set_offset(&capture_cic[ch], capture_offsets[ch]);
+	}
+
+	adc_enable(&ADCA);
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+	capture_dma_channel_init(CAPTURE_DMA_CH_A, DMA_CH_TRIGSRC_ADCA_CH4_gc,
+			&ADCA, capture_dma_buf[0][0]);
+	capture_dma_channel_init(CAPTURE_DMA_CH_B, DMA_CH_TRIGSRC_ADCA_CH4_gc,
+			&ADCA, capture_dma_buf[0][1]);
+	dma_channel_enable(CAPTURE_DMA_CH_A);
+#  if CAPTURE_ADC != CAPTURE_ADC_SINGLE
+	adc_enable(&ADCB);
+	capture_dma_channel_init(CAPTURE_DMA_CH_C, DMA_CH_TRIGSRC_ADCB_CH4_gc,
+			&ADCB, capture_dma_buf[1][0]);
+	capture_dma_channel_init(CAPTURE_DMA_CH_D, DMA_CH_TRIGSRC_ADCB_CH4_gc,
+			&ADCB, capture_dma_buf[1][1]);
+	dma_channel_enable(CAPTURE_DMA_CH_C);
+#  endif
+#else
+	CAPTURE_SWEEP_COUNT = 0;
+#endif
+#if CAPTURE_AGC
+	capture_agc_reset();
+#endif
+	// TCC1, the ADCs and the DMA controller stop in any deeper mode
+	sleepmgr_lock_mode(SLEEPMGR_IDLE);
+	jitter_restart();
+	tc_write_count(&TCC1, 0);
+	tc_write_clock_source(&TCC1, TC_CLKSEL_DIV1_gc);
+	capture_state = CAPTURE_RUNNING;
+}
+
+/**
+ * \brief Start capturing, from the start of the ring
+ *
+ * Holds the idle sleep lock until the matching \ref capture_stop().
+ */
+void capture_start(void)
+{
+	capture_hops = 0;
+	capture_run(0);
+}
+
+/**
+ * \brief Carry on capturing after \ref capture_stop()
+ *
+ * As \ref capture_start(), but the hop count goes on and the ring is
+ * written from the end of the last whole hop, so the readers of
+ * \ref capture_hop_take() resume with the next hop. The frame queue and
+ * the gates start afresh; the queue must have been drained.
+ */
+void capture_resume(void)
+{
+	capture_run((uint16_t)(capture_hops & (CAPTURE_RING_HOPS - 1))
+			* CAPTURE_HOP);
+}
+
+/**
+ * \brief Set the DC offset of channel \a ch, taken off in the decimator
+ *
+ * \param offset In 1/16 ADC LSB, see \ref baseline.h
+ *
+ * Takes effect at the next \ref capture_start().
+ */
+void capture_set_offset(uint8_t ch, int16_t offset)
+{
+	capture_offsets[ch] = offset;
+}
+
+/**
+ * \brief Stop capturing
+ */
+void capture_stop(void)
+{
+	tc_write_clock_source(&TCC1, TC_CLKSEL_OFF_gc);
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+	dma_channel_disable(CAPTURE_DMA_CH_A);
+	dma_channel_disable(CAPTURE_DMA_CH_B);
+#  if CAPTURE_ADC != CAPTURE_ADC_SINGLE
+	dma_channel_disable(CAPTURE_DMA_CH_C);
+	dma_channel_disable(CAPTURE_DMA_CH_D);
+	adc_disable(&ADCB);
+#  endif
+#endif
+	adc_disable(&ADCA);
+	sleepmgr_unlock_mode(SLEEPMGR_IDLE);
+	capture_state = CAPTURE_STOPPED;
+}
+
+/**
+ * \brief Whether the capture runs, listens or is stopped
+ */
+enum capture_state capture_get_state(void)
+{
+	return (enum capture_state)capture_state;
+}
+
+/**
+ * \brief Copy \a count samples of channel \a ch, starting at ring position
+ * \a pos, into internal SRAM
+ *
+ * The copy wraps around the end of the ring. In the channel layout the
+ * samples are contiguous up to there and go in one block copy per span.
+ */
+void capture_read(uint8_t ch, uint16_t pos, int16_t *dest, uint16_t count)
+{
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_CHANNEL
+	while (count) {
+		uint16_t span = Min(count, MAXBUFFER - pos);
+
+		sdram_read(dest, capture_ring_addr(ch, pos),
+				span * sizeof(int16_t));
+		dest += span;
+		count -= span;
+		pos = 0;
+	}
+#else
+	hugemem_ptr_t from = capture_ring_addr(ch, pos);
+
+	while (count--) {
+		*dest++ = hugemem_read16(from);
+		if (++pos >= MAXBUFFER) {
+			pos = 0;
+			from = capture_ring_addr(ch, 0);
+		} else {
+			from += CAPTURE_POS_STRIDE;
+		}
+	}
+#endif
+}
+
+/**
+ * \brief Copy \a count whole frames, starting at ring position \a pos, into
+ * internal SRAM
+ *
+ * In the frame layout the ring holds the frames as they are, and this is
+ * one block copy per span. The copy wraps around the end of the ring;
+ * \a count is at most MAXBUFFER.
+ */
+void capture_read_frames(uint16_t pos, capture_frame_t *dest,
+		uint16_t count)
+{
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_FRAME
+	struct ring_span sp;
+
+	ring_span_after(&sp, pos, count, MAXBUFFER);
+	sdram_read(dest, capture_ring_addr(0, sp.pos),
+			sp.len[0] * sizeof(capture_frame_t));
+	sdram_read(dest + sp.len[0], capture_ring,
+			sp.len[1] * sizeof(capture_frame_t));
+#else
+	hugemem_ptr_t from = capture_ring_addr(0, pos);
+	uint8_t ch;
+
+	while (count--) {
+		for (ch = 0; ch < CHANNELS; ch++) {
+			dest->ch[ch] = hugemem_read16(from + ch * CAPTURE_CH_STRIDE);
+		}
+		dest++;
+		if (++pos >= MAXBUFFER) {
+			pos = 0;
+			from = capture_ring;
+		} else {
+			from += CAPTURE_POS_STRIDE;
+		}
+	}
+#endif
+}
+
+/**
+ * \brief Refresh \ref capture_window with the newest samples
+ *
+ * In the frame layout the window is filled in one pass over the frames,
+ * de-interleaving on the way.
+ *
+ * \return Ring position following the last sample of the window
+ */
+uint16_t capture_fetch_window(void)
+{
+	uint16_t end = capture_write_pos;
+	uint16_t start = (end - CAPTURE_WINDOW) & (MAXBUFFER - 1);
+	uint8_t ch;
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_FRAME
+	hugemem_ptr_t from;
+	uint16_t i;
+#endif
+
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_FRAME
+	from = capture_ring_addr(0, start);
+	for (i = 0; i < CAPTURE_WINDOW; i++) {
+		for (ch = 0; ch < CHANNELS; ch += 2) {
+			uint32_t pair = hugemem_read32(from);
+
+			capture_window[ch][i] = (int16_t)pair;
+			capture_window[ch + 1][i] = (int16_t)(pair >> 16);
+			from += 2 * sizeof(int16_t);
+		}
+		if (++start >= MAXBUFFER) {
+			start = 0;
+			from = capture_ring;
+		}
+	}
+#else
+	for (ch = 0; ch < CHANNELS; ch++) {
+		capture_read(ch, start, capture_window[ch], CAPTURE_WINDOW);
+	}
+#endif
+	return end;
+}
+
+/**
+ * \brief Describe the \a len samples of channel \a ch before ring
+ * position \a end_pos
+ *
+ * \param len At most MAXBUFFER; the caller sees to it that the capture
+ * has not overwritten them by the time they are read
+ */
+void capture_view(uint8_t ch, uint16_t end_pos, uint16_t len,
+		struct capture_view *view)
+{
+	struct ring_span sp;
+
+	Assert(len <= MAXBUFFER);
+
+	ring_span_before(&sp, end_pos, len, MAXBUFFER);
+	view->addr[0] = capture_ring_addr(ch, sp.pos);
+	view->addr[1] = capture_ring_addr(ch, 0);
+	view->len[0] = sp.len[0];
+	view->len[1] = sp.len[1];
+}
+
+/**
+ * \brief Copy the samples of \a view into internal SRAM
+ *
+ * In the channel layout each span is one block copy, and the sum is taken
+ * over the copy in SRAM, which is quicker to read than the SDRAM.
+ *
+ * \return Sum of the samples, for the caller's DC removal
+ */
+int32_t capture_view_read(const struct capture_view *view, int16_t *dest)
+{
+	int32_t sum = 0;
+	uint8_t span;
+
+	for (span = 0; span < 2; span++) {
+		uint16_t count = view->len[span];
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_CHANNEL
+		sdram_read(dest, view->addr[span], count * sizeof(int16_t));
+		while (count--) {
+			sum += *dest++;
+		}
+#else
+		hugemem_ptr_t from = view->addr[span];
+
+		while (count--) {
+			int16_t v = hugemem_read16(from);
+
+			*dest++ = v;
+			sum += v;
+			from += CAPTURE_POS_STRIDE;
+		}
+#endif
+	}
+	return sum;
+}
@@ -0,0 +1,391 @@
+/**
+ * \file
+ *
+ * \brief HarpXTuned capture engine
+ *
+ * TCC1 overflows are routed through event channel 0 to start a sweep of
+ * ADCA CH0..CH3; every channel has its own mux input, so one trigger
+ * converts all string groups and the results form one interleaved
+ * \ref capture_frame_t.
+ *
+ * Two ways of collecting the sweeps are available, selected with
+ * \ref CAPTURE_MODE:
+ * - \ref CAPTURE_MODE_DMA: the ADC raises a group DMA request when the sweep
+ *   is done, and DMA channels 0 and 1 move the frame into two halves of a
+ *   raw buffer, working in double buffer mode. The CPU only runs, in the DMA
+ *   transaction complete interrupt, when one half is full.
+ * - \ref CAPTURE_MODE_SWEEP: the CH3 conversion complete interrupt reads the
+ *   whole frame. One interrupt per sweep instead of one per channel, for
+ *   builds where the DMA channels are needed elsewhere. This mode keeps its
+ *   sweep count in GPIOR0.
+ *
+ * With \ref CAPTURE_ADC set to a dual arrangement ADCB runs a second sweep,
+ * read by DMA channels 2 and 3 (DMA mode only):
+ * - \ref CAPTURE_ADC_DUAL_WIDE: on the same trigger as ADCA, its results
+ *   are channels 4..7 of the frame.
+ * - \ref CAPTURE_ADC_DUAL_FAST: on TCC1 compare A, half a sweep period
+ *   after ADCA, reading the same pickups on the PORTB pins. The two sweeps
+ *   interleave into one stream at twice the sweep rate of either ADC.
+ *
+ * Either way the OVERSAMPLING sweeps are decimated by a CIC filter with
+ * droop compensation, see \ref cic.h, and stored in rings of MAXBUFFER
+ * frames in external SDRAM, laid out as selected with \ref CAPTURE_LAYOUT.
+ * Every CAPTURE_BLOCK_FRAMES frames a block is also handed to the
+ * main loop through the \ref frameq.h queue, with a copy of its frames
+ * only if a streaming engine is to read them. For longer history the analysis
+ * stage works on \ref capture_window, a short copy of the newest samples in
+ * internal SRAM, filled by \ref capture_fetch_window().
+ *
+ * Batch stages instead follow the hops: every CAPTURE_HOP frames the
+ * capture interrupt counts one in \ref capture_hops, whatever the state of
+ * the queue, and \ref capture_hop_take() gives the ring position the
+ * newest hop ends at. A \ref capture_view of any window ending there, as
+ * long as the ring holds it, describes it in place as at most two spans of
+ * SDRAM split where the ring wraps, so overlapping windows are read
+ * straight from the ring with no copy of the history.
+ *
+ * In CAPTURE_MODE_DMA, \ref capture_listen() stops the sweeps and leaves
+ * the ADCs free-running at CAPTURE_LISTEN_ADC_HZ with their compare
+ * interrupts armed, so nothing runs on the CPU until a pickup rises above
+ * its gate's open level. The ADC has a single compare value, so it is set
+ * for the channel with the highest DC offset, and only rises are heard.
+ * The interrupt disarms the compare and posts SCHED_LISTEN to restart the
+ * capture.
+ *
+ * With \ref CAPTURE_AGC the channels are converted differentially through
+ * the ADC gain stage, and the gain of each is picked between blocks from
+ * its peak-to-peak value: one step down as soon as a block fills half the
+ * ADC range, one step up while the channel's gate is closed and a block
+ * stays below a sixteenth of it. The decimated samples are shifted back up
+ * by the gain below the top one, so the frames keep one scale whatever
+ * the gain and only the quantisation of a quiet string improves. The
+ * decimator state is rescaled with the change, see \ref cic_rescale(),
+ * so nothing downstream sees a step. In sweep mode the new gain starts
+ * with the next frame; in DMA mode it is written at the start of the next
+ * half-buffer interrupt, a sweep or so into the half then filling, and
+ * that sweep is decoded at the wrong gain.
+ *
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <compiler.h>
+#include <adc.h>
+#include <conf_profile.h>
+#include "ring.h"
+#include "sdram.h"
+
+/*
+ * CHANNELS, SAMPLERATE, OVERSAMPLING, MAXBUFFER, CAPTURE_WINDOW and
+ * CAPTURE_BLOCK_FRAMES come from the profile, see \ref conf_profile.h.
+ * OVERSAMPLING is a plain 4, 8 or 16 (see \ref cic.h).
+ */
+#if OVERSAMPLING == 4
+#  define CAPTURE_LOG2_OVERSAMPLING 2
+#elif OVERSAMPLING == 8
+#  define CAPTURE_LOG2_OVERSAMPLING 3
+#elif OVERSAMPLING == 16
+#  define CAPTURE_LOG2_OVERSAMPLING 4
+#else
+#  error "OVERSAMPLING must be 4, 8 or 16"
+#endif
+
+//! \name Capture modes
+//@{
+#define CAPTURE_MODE_DMA       0   //!< DMA double buffer, IRQ per half-buffer
+#define CAPTURE_MODE_SWEEP     1   //!< CH3 complete IRQ per sweep
+//@}
+
+#ifndef CAPTURE_MODE
+#  define CAPTURE_MODE CAPTURE_MODE_DMA
+#endif
+
+//! \name Ring layouts
+//@{
+//! One ring per channel, channel after channel
+#define CAPTURE_LAYOUT_CHANNEL  0
+//! One ring of interleaved frames, in sweep order
+#define CAPTURE_LAYOUT_FRAME    1
+//@}
+
+/**
+ * \brief SDRAM ring layout
+ *
+ * The frame layout stores a frame as one contiguous run, two channels per
+ * 32-bit write, and \ref capture_read_frames() copies them out in one
+ * block; analysis that can step over \ref capture_frame_t uses those frames
+ * as they are. Reading a single channel with \ref capture_read() then
+ * skips CHANNELS samples per step, so the channel layout is better for
+ * engines that only read channel by channel.
+ */
+#ifndef CAPTURE_LAYOUT
+#  define CAPTURE_LAYOUT CAPTURE_LAYOUT_CHANNEL
+#endif
+
+/**
+ * \brief Automatic gain of each channel through the ADC gain stage
+ *
+ * The gain stage only takes its negative input from pins 4..7, so the
+ * pickups move to pins 0..3 with CAPTURE_AGC_NEG wired to their bias. On
+ * the Xplained PB0..PB3 also carry the light and temperature sensors,
+ * which have to be cut off for the dual arrangements.
+ *
+ * Gain buys the resolution of a quiet string that OVERSAMPLING would
+ * otherwise have to: the frames carry 2^CAPTURE_LOG2_SCALE times the input
+ * in unity gain LSB, so a 4x profile with 4x gain has the scale of a 16x
+ * one at a quarter of the sweeps, leaving sweep rate for SAMPLERATE.
+ */
+#ifndef CAPTURE_AGC
+#  define CAPTURE_AGC           0
+#endif
+
+#if CAPTURE_AGC
+#  ifndef CAPTURE_CHANNEL_INPUTS
+#    define CAPTURE_CHANNEL_INPUTS \
+	{ ADCCH_POS_PIN0, ADCCH_POS_PIN1, ADCCH_POS_PIN2, ADCCH_POS_PIN3 }
+#  endif
+#  ifndef CAPTURE_ADCB_INPUTS
+#    define CAPTURE_ADCB_INPUTS \
+	{ ADCCH_POS_PIN0, ADCCH_POS_PIN1, ADCCH_POS_PIN2, ADCCH_POS_PIN3 }
+#  endif
+//! Negative input of every channel, the pickup bias, pin 4..7
+#  ifndef CAPTURE_AGC_NEG
+#    define CAPTURE_AGC_NEG     ADCCH_NEG_PIN4
+#  endif
+//! Log2 of the top gain, filling the 16-bit frames at full scale
+#  ifndef CAPTURE_AGC_LOG2_GAIN
+#    define CAPTURE_AGC_LOG2_GAIN (4 - CAPTURE_LOG2_OVERSAMPLING)
+#  endif
+#  if CAPTURE_AGC_LOG2_GAIN < 1 || CAPTURE_AGC_LOG2_GAIN > 6
+#    error "CAPTURE_AGC_LOG2_GAIN must be 1..6, OVERSAMPLING below 16"
+#  endif
+#  if CAPTURE_LOG2_OVERSAMPLING + CAPTURE_AGC_LOG2_GAIN > 4
+#    error "OVERSAMPLING times the top gain must not exceed 16"
+#  endif
+#else
+#  define CAPTURE_AGC_LOG2_GAIN 0
+#endif
+
+/**
+ * \brief Log2 of the frame scale, frames per ADC LSB at unity gain
+ *
+ * CAPTURE_LOG2_OVERSAMPLING gives the frames per LSB at the top gain,
+ * the one the offsets, the noise floors and the listen compare values are
+ * taken at.
+ */
+#define CAPTURE_LOG2_SCALE \
+	(CAPTURE_LOG2_OVERSAMPLING + CAPTURE_AGC_LOG2_GAIN)
+
+/**
+ * \brief ADCA mux input of each string group, in channel order
+ *
+ * Override to match the pickup wiring.
+ */
+#ifndef CAPTURE_CHANNEL_INPUTS
+#  define CAPTURE_CHANNEL_INPUTS \
+	{ ADCCH_POS_PIN4, ADCCH_POS_PIN5, ADCCH_POS_PIN6, ADCCH_POS_PIN7 }
+#endif
+
+/**
+ * \brief ADCB mux inputs for the dual arrangements
+ *
+ * Channels 4..7 for \ref CAPTURE_ADC_DUAL_WIDE, the same pickups as
+ * CAPTURE_CHANNEL_INPUTS for \ref CAPTURE_ADC_DUAL_FAST. PB4..PB7 by default,
+ * clear of the light and temperature sensors.
+ */
+#ifndef CAPTURE_ADCB_INPUTS
+#  define CAPTURE_ADCB_INPUTS \
+	{ ADCCH_POS_PIN4, ADCCH_POS_PIN5, ADCCH_POS_PIN6, ADCCH_POS_PIN7 }
+#endif
+
+//! Channels converted per ADC sweep
+#define CAPTURE_SWEEP_CHANNELS  PROFILE_SWEEP_CHANNELS
+
+#if CAPTURE_SWEEP_CHANNELS != ADC_NR_OF_CHANNELS
+#  error "A sweep converts every ADC channel"
+#endif
+#if CAPTURE_ADC == CAPTURE_ADC_SINGLE || CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST
+#  if CHANNELS != CAPTURE_SWEEP_CHANNELS
+#    error "One ADC sweep carries one frame of CHANNELS samples"
+#  endif
+#elif CAPTURE_ADC == CAPTURE_ADC_DUAL_WIDE
+#  if CHANNELS != 2 * CAPTURE_SWEEP_CHANNELS
+#    error "CAPTURE_ADC_DUAL_WIDE needs CHANNELS of both ADCs"
+#  endif
+#else
+#  error "Unknown CAPTURE_ADC"
+#endif
+#if CAPTURE_ADC != CAPTURE_ADC_SINGLE && CAPTURE_MODE != CAPTURE_MODE_DMA
+#  error "The dual ADC arrangements need CAPTURE_MODE_DMA"
+#endif
+
+/**
+ * \brief Frames per hop of the batch stages
+ *
+ * Whole blocks, and whole hops to the ring.
+ */
+#ifndef CAPTURE_HOP
+#  define CAPTURE_HOP           256
+#endif
+//! Hops per lap of the ring
+#define CAPTURE_RING_HOPS       (MAXBUFFER / CAPTURE_HOP)
+
+#if MAXBUFFER > 32768 || (MAXBUFFER & (MAXBUFFER - 1))
+#  error "MAXBUFFER must be a power of two for the 16-bit ring arithmetic"
+#endif
+#if CAPTURE_HOP % CAPTURE_BLOCK_FRAMES || MAXBUFFER % CAPTURE_HOP
+#  error "CAPTURE_HOP must be whole blocks and divide MAXBUFFER"
+#endif
+#if (CAPTURE_RING_HOPS & (CAPTURE_RING_HOPS - 1)) || CAPTURE_RING_HOPS > 256
+#  error "A lap of the ring must be a power of two hops, at most 256"
+#endif
+#if CAPTURE_WINDOW > MAXBUFFER
+#  error "CAPTURE_WINDOW must not exceed MAXBUFFER"
+#endif
+
+//! Sweeps of each ADC per decimated frame
+#define CAPTURE_ADC_SWEEPS     PROFILE_ADC_SWEEPS
+//! Sweeps of each ADC per DMA half-buffer
+#define CAPTURE_BLOCK_SWEEPS   (CAPTURE_BLOCK_FRAMES * CAPTURE_ADC_SWEEPS)
+//! Rate of the TCC1 sweep trigger in Hz
+#define CAPTURE_SWEEP_RATE     PROFILE_SWEEP_HZ
+
+/**
+ * \brief Cycle target of one capture interrupt
+ *
+ * From the cost estimates of conf_profile.h: a DMA half-buffer in DMA mode,
+ * the sweep that completes a frame in sweep mode. \ref prof_dump() checks
+ * the measured maximum against it.
+ */
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+#  define CAPTURE_CYCLE_TARGET \
+	((uint32_t)CAPTURE_BLOCK_FRAMES * CHANNELS * (PROFILE_CYCLES_PER_SAMPLE \
+	+ OVERSAMPLING * PROFILE_CYCLES_PER_SWEEP))
+#else
+#  define CAPTURE_CYCLE_TARGET \
+	((uint32_t)CHANNELS * (PROFILE_CYCLES_PER_SAMPLE \
+	+ PROFILE_CYCLES_PER_SWEEP))
+#endif
+
+//! DMA channels used as double buffer pair
+#define CAPTURE_DMA_CH_A       0
+#define CAPTURE_DMA_CH_B       1
+//! DMA double buffer pair of ADCB in the dual arrangements
+#define CAPTURE_DMA_CH_C       2
+#define CAPTURE_DMA_CH_D       3
+//! Event channel carrying the sweep trigger
+#define CAPTURE_EVENT_CH       0
+//! Event channel carrying the ADCB trigger of CAPTURE_ADC_DUAL_FAST
+#define CAPTURE_EVENT_CH_B     1
+
+//! ADC clock while listening, the slowest prescaler
+#ifndef CAPTURE_LISTEN_ADC_HZ
+#  define CAPTURE_LISTEN_ADC_HZ (PROFILE_PER_HZ / 512)
+#endif
+
+//! States of the capture, see \ref capture_get_state()
+enum capture_state {
+	CAPTURE_STOPPED,
+	//! Sweeps at the sample rate into the rings and the queue
+	CAPTURE_RUNNING,
+	//! ADCs free-running slowly, compare interrupts armed
+	CAPTURE_LISTENING,
+	//! A sample rose above the compare value, the capture may restart
+	CAPTURE_HEARD,
+};
+
+//! One decimated frame: a sample of every string group
+typedef struct {
+	int16_t ch[CHANNELS];
+} capture_frame_t;
+
+//! Raw results of one ADC sweep, CH0RES..CH3RES
+typedef struct {
+	int16_t ch[CAPTURE_SWEEP_CHANNELS];
+} capture_sweep_t;
+
+#if CAPTURE_LAYOUT == CAPTURE_LAYOUT_CHANNEL
+//! Bytes from a sample to the one of the next channel at the same position
+#  define CAPTURE_CH_STRIDE     ((uint32_t)MAXBUFFER * sizeof(int16_t))
+//! Bytes from a sample to the next one of the same channel
+#  define CAPTURE_POS_STRIDE    sizeof(int16_t)
+#elif CAPTURE_LAYOUT == CAPTURE_LAYOUT_FRAME
+#  define CAPTURE_CH_STRIDE     sizeof(int16_t)
+#  define CAPTURE_POS_STRIDE    sizeof(capture_frame_t)
+#  if CHANNELS % 2
+#    error "CAPTURE_LAYOUT_FRAME needs an even number of channels"
+#  endif
+#else
+#  error "Unknown CAPTURE_LAYOUT"
+#endif
+
+/**
+ * \brief A window of one channel, in place in its ring
+ *
+ * Oldest samples first; the second span is empty unless the window
+ * wraps. Samples of a span are CAPTURE_POS_STRIDE bytes apart.
+ */
+struct capture_view {
+	//! SDRAM address of the first sample of each span
+	hugemem_ptr_t addr[2];
+	//! Samples of each span
+	uint16_t len[2];
+};
+
+//! SDRAM address of the decimated sample rings, channel after channel
+extern hugemem_ptr_t capture_ring;
+//! Next write position in the rings
+extern volatile uint16_t capture_write_pos;
+//! Newest CAPTURE_WINDOW samples of every channel, oldest first
+extern int16_t capture_window[CHANNELS][CAPTURE_WINDOW];
+//! Hops completed since \ref capture_start(), written by the interrupt only
+extern volatile uint8_t capture_hops;
+
+/**
+ * \brief SDRAM address of sample \a pos of channel \a ch
+ */
+static inline hugemem_ptr_t capture_ring_addr(uint8_t ch, uint16_t pos)
+{
+	return capture_ring + ch * CAPTURE_CH_STRIDE
+			+ (uint32_t)pos * CAPTURE_POS_STRIDE;
+}
+
+/**
+ * \brief Take the hops completed since the last call
+ *
+ * A single byte is read, so the interrupt need not be held off.
+ *
+ * \param seen \ref capture_hops as last taken, updated
+ * \param end_pos Receives the ring position the newest hop ends at
+ *
+ * \return Hops completed since, 0 if none
+ */
+static inline uint8_t capture_hop_take(uint8_t *seen, uint16_t *end_pos)
+{
+	uint8_t hops = capture_hops;
+	uint8_t count = hops - *seen;
+
+	*seen = hops;
+	*end_pos = (uint16_t)(hops & (CAPTURE_RING_HOPS - 1)) * CAPTURE_HOP;
+	return count;
+}
+
+bool capture_init(void);
+void capture_start(void);
+void capture_resume(void);
+void capture_stop(void);
+#if CAPTURE_MODE == CAPTURE_MODE_DMA
+void capture_listen(void);
+#endif
+enum capture_state capture_get_state(void);
+void capture_set_offset(uint8_t ch, int16_t offset);
+void capture_read(uint8_t ch, uint16_t pos, int16_t *dest, uint16_t count);
+void capture_read_frames(uint16_t pos, capture_frame_t *dest,
+		uint16_t count);
+uint16_t capture_fetch_window(void);
+void capture_view(uint8_t ch, uint16_t end_pos, uint16_t len,
+		struct capture_view *view);
+int32_t capture_view_read(const struct capture_view *view, int16_t *dest);
+
+#endif /* CAPTURE_H */
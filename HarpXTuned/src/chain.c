@@ -0,0 +1,473 @@
+/**
+ * \file
+ *
+ * \brief Several boards on one bus, for a pickup on every string
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+#include <asf.h>
+#include "chain.h"
+#include "cobs.h"
+#include "harp.h"
+#include "irqlevel.h"
+#include "pedal.h"
+#include "pitch.h"
+#include "sched.h"
+
+#if CHAIN_ROLE != CHAIN_NONE
+
+//! \internal Bytes of an answer record
+#define CHAIN_RECORD            6
+//! \internal Largest frame before encoding, an answer from every channel
+#define CHAIN_RAW_MAX           (2 + 1 + CHAIN_RECORD * CHANNELS + 2)
+//! \internal Largest frame encoded, without the ending 0
+#define CHAIN_RX_MAX            (COBS_ENCODED_SIZE(CHAIN_RAW_MAX) - 1)
+
+#if CHAIN_RAW_MAX > COBS_RAW_MAX
+#  error "Frames must fit one COBS block"
+#endif
+
+//! \internal Frame received and its encoded length, 0 while receiving
+static uint8_t chain_rx_buf[CHAIN_RX_MAX];
+static volatile uint8_t chain_rx_ready;
+//! \internal Bytes of the frame being received, 0xff if it is being
+//! thrown away
+static uint8_t chain_rx_len;
+
+//! \internal Frame being sent, its length and the next byte
+static uint8_t chain_tx_buf[COBS_ENCODED_SIZE(CHAIN_RAW_MAX)];
+static uint8_t chain_tx_len;
+static volatile uint8_t chain_tx_pos;
+
+//! \internal Frame being built, and its length; a frame received is
+//! decoded here in place, from up to CHAIN_RX_MAX bytes
+static uint8_t chain_raw[CHAIN_RX_MAX];
+static uint8_t chain_len;
+
+//! \internal Frames thrown away as they arrived, too long or overrunning
+//! the last
+static volatile uint8_t chain_lost;
+//! \internal Frames failing the CRC or out of place, and sends refused
+static uint16_t chain_bad;
+
+#if CHAIN_ROLE == CHAIN_MASTER
+//! \internal Newest reading of each string
+static struct chain_string chain_strings[HARP_STRINGS];
+//! \internal Slave polled last, and whether it has answered
+static uint8_t chain_polled = CHAIN_UNITS - 1;
+static bool chain_answered = true;
+//! \internal RTC time of the last poll
+static uint32_t chain_poll_time;
+//! \internal Polls left unanswered, per unit
+static uint16_t chain_misses[CHAIN_UNITS];
+#endif
+
+/**
+ * \internal
+ * \brief Collect the bytes of a frame, and hand it to the task at its 0
+ *
+ * A frame that arrives while the task still has the last one is thrown
+ * away whole.
+ */
+ISR(CHAIN_RXC_vect)
+{
+	uint8_t c = usart_get(CHAIN_USART);
+
+	if (c) {
+		if (chain_rx_ready || chain_rx_len >= CHAIN_RX_MAX) {
+			chain_rx_len = 0xff;
+		} else {
+			chain_rx_buf[chain_rx_len++] = c;
+		}
+		return;
+	}
+	if (chain_rx_len == 0xff) {
+		chain_lost++;
+	} else if (chain_rx_len) {
+		chain_rx_ready = chain_rx_len;
+		sched_post(SCHED_CHAIN);
+	}
+	chain_rx_len = 0;
+}
+
+/**
+ * \internal
+ * \brief Move the next byte of the frame to the USART
+ *
+ * After the last, waits for it to leave the shift register before the
+ * driver is released.
+ */
+ISR(CHAIN_DRE_vect)
+{
+	if (chain_tx_pos == chain_tx_len) {
+		usart_set_dre_interrupt_level(CHAIN_USART, USART_INT_LVL_OFF);
+		usart_clear_tx_complete(CHAIN_USART);
+		usart_set_tx_interrupt_level(CHAIN_USART, IRQLEVEL_USART);
+		return;
+	}
+	usart_put(CHAIN_USART, chain_tx_buf[chain_tx_pos++]);
+}
+
+/**
+ * \internal
+ * \brief Release the bus once the last bit is out
+ */
+ISR(CHAIN_TXC_vect)
+{
+	usart_set_tx_interrupt_level(CHAIN_USART, USART_INT_LVL_OFF);
+	gpio_set_pin_low(CHAIN_DE_PIN);
+}
+
+//! \internal Append \a v to the frame
+static void chain_u8(uint8_t v)
+{
+	chain_raw[chain_len++] = v;
+}
+
+//! \internal Append \a v to the frame, little endian
+static void chain_u16(uint16_t v)
+{
+	chain_u8(v);
+	chain_u8(v >> 8);
+}
+
+//! \internal Little endian 16 bits at \a p
+static uint16_t chain_get16(const uint8_t *p)
+{
+	return p[0] | ((uint16_t)p[1] << 8);
+}
+
+//! \internal CRC-16/CCITT of the \a len bytes at \a p
+static uint16_t chain_crc(const uint8_t *p, uint8_t len)
+{
+	uint16_t crc = 0xffff;
+
+	while (len--) {
+		crc = _crc_ccitt_update(crc, *p++);
+	}
+	return crc;
+}
+
+/**
+ * \internal
+ * \brief Start a frame of \a type to or from \a unit
+ */
+static void chain_begin(enum chain_type type, uint8_t unit)
+{
+	chain_len = 0;
+	chain_u8(type);
+	chain_u8(unit);
+}
+
+/**
+ * \internal
+ * \brief Add the CRC and put the frame on the bus
+ *
+ * The poll and answer alternate, so the last frame has left long before.
+ */
+static void chain_send(void)
+{
+	chain_u16(chain_crc(chain_raw, chain_len));
+	if (chain_tx_pos != chain_tx_len
+			|| gpio_pin_is_high(CHAIN_DE_PIN)) {
+		chain_bad++;
+		return;
+	}
+	chain_tx_len = cobs_encode(chain_raw, chain_len, chain_tx_buf);
+	chain_tx_pos = 0;
+	gpio_set_pin_high(CHAIN_DE_PIN);
+	usart_set_dre_interrupt_level(CHAIN_USART, IRQLEVEL_USART);
+}
+
+/**
+ * \internal
+ * \brief Take the frame received into chain_raw
+ *
+ * \return its length without the CRC, or 0 if there is none or it is bad
+ */
+static uint8_t chain_receive(void)
+{
+	uint8_t len = chain_rx_ready;
+
+	if (!len) {
+		return 0;
+	}
+	memcpy(chain_raw, chain_rx_buf, len);
+	chain_rx_ready = 0;
+
+	len = cobs_decode(chain_raw, len);
+	if (len < 4 || chain_crc(chain_raw, len - 2)
+			!= chain_get16(&chain_raw[len - 2])) {
+		chain_bad++;
+		return 0;
+	}
+	return len - 2;
+}
+
+/**
+ * \internal
+ * \brief Nearest string and the cents off it of channel \a ch
+ *
+ * \retval false if the channel reads no pitch
+ */
+static bool chain_reading(uint8_t ch, uint8_t *string, notes_offset_t *cents)
+{
+	pitch_hz_t freq = pitch_readings[ch].freq;
+
+	if (!freq) {
+		return false;
+	}
+	*string = harp_nearest_string(ch, freq);
+	*cents = notes_offset(notes_from_hz(freq), harp_string_pitch(*string));
+	return true;
+}
+
+#if CHAIN_ROLE == CHAIN_MASTER
+/**
+ * \internal
+ * \brief Enter a reading of \a unit
+ */
+static void chain_enter(uint8_t unit, uint8_t string, notes_offset_t cents,
+		uint16_t level, uint32_t now)
+{
+	struct chain_string *entry;
+
+	if (string >= HARP_STRINGS) {
+		return;
+	}
+	entry = &chain_strings[string];
+	entry->cents = cents;
+	entry->level = level;
+	entry->unit = unit;
+	entry->time = now;
+}
+
+/**
+ * \internal
+ * \brief Enter the readings of an answer of \a len bytes
+ *
+ * Each record names a string of the group of one channel of the unit,
+ * which \ref HARP_UNIT_GROUPS places on the harp.
+ */
+static void chain_take_answer(uint8_t len, uint32_t now)
+{
+	uint8_t unit = chain_raw[1];
+	uint8_t count = chain_raw[2];
+	const uint8_t *rec = &chain_raw[3];
+	const struct harp_group *group;
+
+	if (unit != chain_polled || len != 3 + CHAIN_RECORD * count) {
+		chain_bad++;
+		return;
+	}
+	chain_answered = true;
+	for (; count--; rec += CHAIN_RECORD) {
+		if (rec[0] >= CHANNELS) {
+			chain_bad++;
+			continue;
+		}
+		group = &harp_unit_groups[unit * CHANNELS + rec[0]];
+		if (rec[1] >= group->count) {
+			chain_bad++;
+			continue;
+		}
+		chain_enter(unit, group->first + rec[1], chain_get16(&rec[2]),
+				chain_get16(&rec[4]), now);
+	}
+}
+
+/**
+ * \internal
+ * \brief Poll the next slave with the pedals and the A4 reference
+ */
+static void chain_poll(uint32_t now)
+{
+	pitch_hz_t a4 = harp_get_a4();
+	uint16_t pedals = 0;
+	uint8_t pc;
+
+	if (!chain_answered) {
+		chain_misses[chain_polled]++;
+	}
+	if (++chain_polled == CHAIN_UNITS) {
+		chain_polled = 1;
+	}
+
+	for (pc = 0; pc < 7; pc++) {
+		pedals |= (uint16_t)(harp_pedal(pc) + 1) << (2 * pc);
+	}
+	chain_begin(CHAIN_POLL, chain_polled);
+	chain_u16(pedals);
+	chain_u16(a4);
+	chain_u16(a4 >> 16);
+	chain_send();
+	chain_answered = false;
+	chain_poll_time = now;
+}
+#endif /* CHAIN_ROLE == CHAIN_MASTER */
+
+#if CHAIN_ROLE == CHAIN_SLAVE
+/**
+ * \internal
+ * \brief Take over the harp of a poll of \a len bytes, and answer it
+ */
+static void chain_answer(uint8_t len)
+{
+	uint16_t pedals;
+	pitch_hz_t a4;
+	uint8_t count = 0;
+	uint8_t pc;
+	uint8_t ch;
+
+	if (len != 8) {
+		chain_bad++;
+		return;
+	}
+	pedals = chain_get16(&chain_raw[2]);
+	a4 = chain_get16(&chain_raw[4])
+			| ((pitch_hz_t)chain_get16(&chain_raw[6]) << 16);
+
+	chain_begin(CHAIN_ANSWER, CHAIN_UNIT);
+	chain_u8(0);
+	for (ch = 0; ch < CHANNELS; ch++) {
+		notes_offset_t cents;
+		uint8_t string;
+
+		if (chain_reading(ch, &string, &cents)) {
+			chain_u8(ch);
+			chain_u8(string - harp_groups[ch].first);
+			chain_u16(cents);
+			chain_u16(pitch_readings[ch].level);
+			count++;
+		}
+	}
+	chain_raw[2] = count;
+	chain_send();
+
+	// After the answer is on its way
+	if (a4 != harp_get_a4() && harp_set_a4(a4)) {
+		for (ch = 0; ch < CHANNELS; ch++) {
+			pitch_retune(ch);
+		}
+	}
+	for (pc = 0; pc < 7; pc++) {
+		uint8_t pedal = (pedals >> (2 * pc)) & 3;
+
+		if (pedal <= HARP_SHARP + 1) {
+			pedal_set(pc, (enum harp_pedal)(pedal - 1));
+		}
+	}
+}
+#endif /* CHAIN_ROLE == CHAIN_SLAVE */
+
+#endif /* CHAIN_ROLE != CHAIN_NONE */
+
+/**
+ * \brief Set up the bus USART, listening
+ *
+ * Call after \ref harp_init().
+ */
+void chain_init(void)
+{
+#if CHAIN_ROLE != CHAIN_NONE
+	const usart_rs232_options_t options = {
+		.baudrate = CHAIN_BAUDRATE,
+		.charlength = USART_CHSIZE_8BIT_gc,
+		.paritytype = USART_PMODE_DISABLED_gc,
+		.stopbits = false,
+	};
+
+	ioport_configure_pin(CHAIN_DE_PIN, IOPORT_DIR_OUTPUT | IOPORT_INIT_LOW);
+	ioport_configure_pin(CHAIN_TX_PIN, IOPORT_DIR_OUTPUT | IOPORT_INIT_HIGH);
+	ioport_configure_pin(CHAIN_RX_PIN, IOPORT_DIR_INPUT);
+	usart_init_rs232(CHAIN_USART, &options);
+	usart_set_rx_interrupt_level(CHAIN_USART, IRQLEVEL_USART);
+#endif
+}
+
+/**
+ * \brief Answer or gather the frame received and poll, scheduler task
+ *
+ * Posted for every frame received, and released every CHAIN_PERIOD for
+ * the master to poll the next slave and enter its own readings.
+ *
+ * \retval false always
+ */
+bool chain_run(void)
+{
+#if CHAIN_ROLE != CHAIN_NONE
+	uint8_t len = chain_receive();
+#  if CHAIN_ROLE == CHAIN_MASTER
+	uint32_t now = rtc_get_time();
+	notes_offset_t cents;
+	uint8_t string;
+	uint8_t ch;
+
+	if (len && chain_raw[0] == CHAIN_ANSWER) {
+		chain_take_answer(len, now);
+	}
+	if (now - chain_poll_time >= CHAIN_PERIOD) {
+		chain_poll(now);
+		for (ch = 0; ch < CHANNELS; ch++) {
+			if (chain_reading(ch, &string, &cents)) {
+				chain_enter(CHAIN_UNIT, string, cents,
+						pitch_readings[ch].level, now);
+			}
+		}
+	}
+#  else
+	if (len && chain_raw[0] == CHAIN_POLL && chain_raw[1] == CHAIN_UNIT) {
+		chain_answer(len);
+	}
+#  endif
+#endif
+	return false;
+}
+
+/**
+ * \brief Newest reading of \a string on any unit, master only
+ *
+ * \retval false if no unit has read it within CHAIN_STALE
+ */
+bool chain_get_string(uint8_t string, struct chain_string *entry)
+{
+#if CHAIN_ROLE == CHAIN_MASTER
+	*entry = chain_strings[string];
+	return entry->level
+			&& rtc_get_time() - entry->time < CHAIN_STALE;
+#else
+	UNUSED(string);
+	UNUSED(entry);
+	return false;
+#endif
+}
+
+/**
+ * \brief Print the strings read across the chain and the slaves' misses
+ */
+void chain_dump(void)
+{
+#if CHAIN_ROLE == CHAIN_MASTER
+	struct chain_string entry;
+	uint8_t i;
+
+	for (i = 0; i < HARP_STRINGS; i++) {
+		if (chain_get_string(i, &entry)) {
+			printf_P(PSTR("string %u unit %u level %u cents %d/256\r\n"),
+					i, entry.unit, entry.level, entry.cents);
+		}
+	}
+	for (i = 1; i < CHAIN_UNITS; i++) {
+		printf_P(PSTR("unit %u %u polls missed\r\n"), i, chain_misses[i]);
+	}
+#endif
+#if CHAIN_ROLE != CHAIN_NONE
+	printf_P(PSTR("chain %u frames lost, %u bad\r\n"), chain_lost,
+			chain_bad);
+#else
+	printf_P(PSTR("chain off\r\n"));
+#endif
+}
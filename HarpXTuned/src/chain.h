@@ -0,0 +1,147 @@
+/**
+ * \file
+ *
+ * \brief Several boards on one bus, for a pickup on every string
+ *
+ * One board reads CHANNELS pickups, too few for a pickup on each string of
+ * a pedal harp. With CHAIN_ROLE set, several boards share a half duplex
+ * RS-485 bus on CHAIN_USART through a transceiver whose driver
+ * CHAIN_DE_PIN enables. The master, unit 0, polls the slaves, units 1 to
+ * CHAIN_UNITS - 1, one every CHAIN_PERIOD in turn, and only the slave
+ * polled answers: the bus never has two talkers, and its load is one poll
+ * and one answer per period however many strings sound. Frames are COBS
+ * framed as on the \ref hostlink.h link,
+ * \code
+	type    u8      enum chain_type
+	unit    u8      unit polled, or answering
+	payload
+	crc     u16     CRC-16/CCITT of type to payload
+\endcode
+ * little endian. A \ref CHAIN_POLL carries the master's harp, which every
+ * slave takes over, so that the whole chain reads the same strings:
+ * \code
+	pedals  u16     harp_pedal() + 1 of C to B, 2 bits each from bit 0
+	a4      u32     harp_get_a4(), Q16.16 Hz
+\endcode
+ * and a \ref CHAIN_ANSWER one compact record per channel reading a pitch,
+ * never any samples:
+ * \code
+	count   u8
+	count times:
+	ch      u8      channel
+	string  u8      nearest string, of the group of the channel
+	cents   s16     Q8.8 cents from the string
+	level   u16     engine level
+\endcode
+ * Each unit reads its pickups with its own row of the \ref harp.h
+ * HARP_UNIT_GROUPS, and the master places a record with the row of the
+ * unit that sent it.
+ *
+ * The master folds the answers and its own readings into one entry per
+ * string, the newest reading of any unit, for \ref chain_get_string();
+ * an entry older than CHAIN_STALE is dropped. The \ref shell.h command
+ * "chain dump" prints them and the polls each slave left unanswered.
+ *
+ * The bus takes USARTF0, PF2 and PF3, and PF1 to drive; USARTD0 would
+ * take the pins of pedal buttons 2 and 3. PF0 carries the \ref sync.h
+ * hop edges of the master.
+ *
+ */
+
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <compiler.h>
+#include "notes.h"
+
+//! \name Roles of a board
+//@{
+//! On its own, no bus
+#define CHAIN_NONE              0
+//! Polls the slaves and gathers the strings
+#define CHAIN_MASTER            1
+//! Answers the master's polls
+#define CHAIN_SLAVE             2
+//@}
+
+#ifndef CHAIN_ROLE
+#  define CHAIN_ROLE            CHAIN_NONE
+#endif
+
+//! Number of this unit, 0 for the master
+#ifndef CHAIN_UNIT
+#  define CHAIN_UNIT            0
+#endif
+
+//! Units on the bus, the master included
+#ifndef CHAIN_UNITS
+#  define CHAIN_UNITS           4
+#endif
+
+//! \name Bus USART and its driver enable
+//@{
+#define CHAIN_USART             (&USARTF0)
+#define CHAIN_RXC_vect          USARTF0_RXC_vect
+#define CHAIN_DRE_vect          USARTF0_DRE_vect
+#define CHAIN_TXC_vect          USARTF0_TXC_vect
+#define CHAIN_TX_PIN            IOPORT_CREATE_PIN(PORTF, 3)
+#define CHAIN_RX_PIN            IOPORT_CREATE_PIN(PORTF, 2)
+#define CHAIN_DE_PIN            IOPORT_CREATE_PIN(PORTF, 1)
+//@}
+
+//! Bus rate, exact from the 32 MHz peripheral clock
+#ifndef CHAIN_BAUDRATE
+#  define CHAIN_BAUDRATE        250000UL
+#endif
+
+//! Poll period in RTC ticks, also the time a slave has to answer
+#ifndef CHAIN_PERIOD
+#  define CHAIN_PERIOD          8
+#endif
+
+//! Release period of the chain task, none without a bus
+#if CHAIN_ROLE == CHAIN_NONE
+#  define CHAIN_TASK_PERIOD     0
+#else
+#  define CHAIN_TASK_PERIOD     CHAIN_PERIOD
+#endif
+
+//! Age in RTC ticks past which a string entry is dropped
+#ifndef CHAIN_STALE
+#  define CHAIN_STALE           (4 * CHAIN_PERIOD * CHAIN_UNITS)
+#endif
+
+#if CHAIN_ROLE == CHAIN_SLAVE && (CHAIN_UNIT == 0 || CHAIN_UNIT >= CHAIN_UNITS)
+#  error "A slave is unit 1 to CHAIN_UNITS - 1"
+#endif
+#if CHAIN_ROLE == CHAIN_MASTER && CHAIN_UNIT != 0
+#  error "The master is unit 0"
+#endif
+#if CHAIN_UNITS < 2 || CHAIN_UNITS > 16
+#  error "CHAIN_UNITS out of range"
+#endif
+
+//! Frame types
+enum chain_type {
+	CHAIN_POLL = 1,
+	CHAIN_ANSWER = 2,
+};
+
+//! Newest reading of a string, on any unit
+struct chain_string {
+	//! Q8.8 cents from the string
+	notes_offset_t cents;
+	//! Engine level, 0 for no reading
+	uint16_t level;
+	//! Unit that read it
+	uint8_t unit;
+	//! RTC time of the reading
+	uint32_t time;
+};
+
+void chain_init(void);
+bool chain_run(void);
+bool chain_get_string(uint8_t string, struct chain_string *entry);
+void chain_dump(void);
+
+#endif /* CHAIN_H */
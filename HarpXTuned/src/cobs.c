@@ -0,0 +1,69 @@
+/**
+ * \file
+ *
+ * \brief COBS framing of the serial links
+ *
+ */
+
+#include "cobs.h"
+
+/**
+ * \brief Encode the \a len bytes at \a raw into \a out, with the ending 0
+ *
+ * \a out must have room for COBS_ENCODED_SIZE(\a len) bytes.
+ *
+ * \return the encoded length
+ */
+uint8_t cobs_encode(const uint8_t *raw, uint8_t len, uint8_t *out)
+{
+	uint8_t code_pos = 0;
+	uint8_t n = 1;
+	uint8_t i;
+
+	Assert(len <= COBS_RAW_MAX);
+
+	for (i = 0; i < len; i++) {
+		uint8_t v = raw[i];
+
+		if (v) {
+			out[n++] = v;
+		} else {
+			out[code_pos] = n - code_pos;
+			code_pos = n++;
+		}
+	}
+	out[code_pos] = n - code_pos;
+	out[n++] = 0;
+	return n;
+}
+
+/**
+ * \brief Decode the \a len bytes at \a buf in place, the ending 0 left off
+ *
+ * \return the decoded length, or 0 if \a buf is no single block frame
+ */
+uint8_t cobs_decode(uint8_t *buf, uint8_t len)
+{
+	uint8_t in = 0;
+	uint8_t n = 0;
+
+	while (in < len) {
+		uint8_t code = buf[in++];
+		uint16_t end = in + code - 1;
+
+		// 0xff starts a block of a longer frame
+		if (!code || code == 0xff || end > len) {
+			return 0;
+		}
+		while (in < end) {
+			if (!buf[in]) {
+				return 0;
+			}
+			buf[n++] = buf[in++];
+		}
+		if (in < len) {
+			buf[n++] = 0;
+		}
+	}
+	return n;
+}
@@ -0,0 +1,29 @@
+/**
+ * \file
+ *
+ * \brief COBS framing of the serial links
+ *
+ * Consistent overhead byte stuffing replaces each 0 of a frame by the
+ * distance to the next one, in the code byte that starts each run, and
+ * ends the frame with a 0: a receiver resynchronises at the next 0 after
+ * a lost byte. Frames shorter than COBS_RAW_MAX bytes are a single block,
+ * one code byte longer. The CRC the \ref hostlink.h and \ref chain.h
+ * frames carry is up to the callers.
+ *
+ */
+
+#ifndef COBS_H
+#define COBS_H
+
+#include <compiler.h>
+
+//! Longest frame before encoding, a single block
+#define COBS_RAW_MAX            253
+
+//! Encoded length of a frame of \a len bytes, with the code byte and the 0
+#define COBS_ENCODED_SIZE(len)  ((len) + 2)
+
+uint8_t cobs_encode(const uint8_t *raw, uint8_t len, uint8_t *out);
+uint8_t cobs_decode(uint8_t *buf, uint8_t len);
+
+#endif /* COBS_H */
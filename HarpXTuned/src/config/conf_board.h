@@ -25,7 +25,15 @@
 
 // Enable UART Communication Port interface (UART)
 #define CONF_BOARD_ENABLE_USARTC0
-#define CONF_BOARD_ENABLE_USARTD0
+// USARTD0 would take PD2 and PD3 from pedal buttons 2 and 3
+//#define CONF_BOARD_ENABLE_USARTD0
+
+// On-board 8 MB SDRAM (EBI three-port mode, chip select 3)
+// CONFIG_HAVE_HUGEMEM is set as a compiler symbol so that every unit,
+// including hugemem itself, sees the same hugemem_ptr_t.
+#define BOARD_EBI_SDRAM_BASE    0x800000UL
+// Its timing profile is in sdram.h.
+#define BOARD_EBI_SDRAM_SIZE    0x800000UL
 
 // Enable Sensors Xplained board interface
 //#define SENSORS_XPLAINED_BOARD
@@ -41,12 +41,23 @@
 #ifndef CONF_CLOCK_H_INCLUDED
 #define CONF_CLOCK_H_INCLUDED
 
-#define CONFIG_SYSCLK_SOURCE          SYSCLK_SRC_RC2MHZ
-//#define CONFIG_SYSCLK_SOURCE        SYSCLK_SRC_RC32MHZ
+//#define CONFIG_SYSCLK_SOURCE        SYSCLK_SRC_RC2MHZ
+#define CONFIG_SYSCLK_SOURCE          SYSCLK_SRC_RC32MHZ
 //#define CONFIG_SYSCLK_SOURCE        SYSCLK_SRC_RC32KHZ
 //#define CONFIG_SYSCLK_SOURCE        SYSCLK_SRC_XOSC
 //#define CONFIG_SYSCLK_SOURCE        SYSCLK_SRC_PLL
 
+/*
+ * HarpXTuned runs the CPU and peripherals from the 32 MHz RC oscillator,
+ * kept at 32 MHz by the DFLL against the internal 32 kHz RC oscillator.
+ * The capture timer period and ADC prescaler in conf_profile.h assume
+ * PROFILE_PER_HZ, so keep the two in step. For a tighter reference fit
+ * the 32 kHz crystal on TOSC and use OSC_ID_XOSC instead.
+ */
+#define CONFIG_OSC_AUTOCAL            OSC_ID_RC32MHZ
+#define CONFIG_OSC_AUTOCAL_REF_OSC    OSC_ID_RC32KHZ
+//#define CONFIG_OSC_AUTOCAL_REF_OSC  OSC_ID_XOSC
+
 /* Fbus = Fsys / (2 ^ BUS_div) */
 #define CONFIG_SYSCLK_PSADIV          SYSCLK_PSADIV_1
 #define CONFIG_SYSCLK_PSBCDIV         SYSCLK_PSBCDIV_1_1
@@ -0,0 +1,258 @@
+/**
+ * \file
+ *
+ * \brief Capture and analysis profile configuration
+ *
+ * A profile fixes the channel count, rates and buffer sizes of one kind of
+ * build. Below the profiles, every setting is checked against the clock,
+ * the ADC, the memories and the capture interrupt budget, so a profile
+ * that cannot work fails to compile instead of running at the wrong rate.
+ *
+ * Select a profile by defining CONF_PROFILE, e.g. -DCONF_PROFILE=1.
+ *
+ */
+
+#ifndef CONF_PROFILE_H
+#define CONF_PROFILE_H
+
+#include <conf_board.h>
+
+//! \name Profiles
+//@{
+//! Short history and a streaming engine, readings after a few periods
+#define PROFILE_FAST_TUNE       1
+//! Long history, 8x oversampling and a large FFT
+#define PROFILE_PRECISION       2
+//! The FFT on the bass channels and a Goertzel bank on the treble
+#define PROFILE_MIXED           3
+//@}
+
+//! \name Pitch engines
+//@{
+#define PITCH_ENGINE_FFT        0   //!< Batch FFT every PITCH_FFT_HOP frames
+#define PITCH_ENGINE_GOERTZEL   1   //!< Streaming per-string Goertzel bank
+#define PITCH_ENGINE_YIN        2   //!< Streaming YIN, period-scaled window
+//@}
+
+//! \name ADC arrangements
+//@{
+//! ADCA alone, one sweep of four channels per trigger
+#define CAPTURE_ADC_SINGLE      0
+//! ADCA and ADCB on the same trigger, eight pickups
+#define CAPTURE_ADC_DUAL_WIDE   1
+//! ADCA and ADCB on alternate triggers, four pickups at twice the rate
+#define CAPTURE_ADC_DUAL_FAST   2
+//@}
+
+#ifndef CONF_PROFILE
+#  define CONF_PROFILE PROFILE_PRECISION
+#endif
+
+/**
+ * \name Release build
+ *
+ * The Release configuration sets CONF_RELEASE and builds for size with
+ * link-time optimisation. The files on the sample path, the capture and
+ * the engines with their DSP kernels, are built for speed instead: they
+ * put PROFILE_HOT_FILE ahead of their other includes, so the inline
+ * kernels of the headers get the same level and still inline.
+ */
+//@{
+#ifndef CONF_RELEASE
+#  define CONF_RELEASE 0
+#endif
+#if CONF_RELEASE
+#  define PROFILE_HOT_FILE      _Pragma("GCC optimize(\"O2\")")
+#else
+#  define PROFILE_HOT_FILE
+#endif
+//@}
+
+//! Peripheral clock in Hz, must match conf_clock.h
+#define PROFILE_PER_HZ          32000000UL
+//! ADC clock in Hz, one conversion per clock when pipelined
+#define PROFILE_ADC_HZ          2000000UL
+
+#if CONF_PROFILE == PROFILE_FAST_TUNE
+#  define CHANNELS              4
+#  define SAMPLERATE            40000
+#  define OVERSAMPLING          4
+#  define MAXBUFFER             4096
+#  define CAPTURE_WINDOW        128
+#  define CAPTURE_BLOCK_FRAMES  16
+#  define CAPTURE_HOP           256
+#  define FRAMEQ_SLOTS          4
+#  define PITCH_ENGINE          PITCH_ENGINE_YIN
+#  define PITCH_FFT_LOG2_N      9
+// About 20 Hz
+#  define PITCH_FFT_HOP         (8 * CAPTURE_HOP)
+
+#elif CONF_PROFILE == PROFILE_PRECISION
+#  define CHANNELS              4
+#  define SAMPLERATE            20000
+#  define OVERSAMPLING          8
+#  define MAXBUFFER             16384
+#  define CAPTURE_WINDOW        128
+#  define CAPTURE_BLOCK_FRAMES  8
+#  define CAPTURE_HOP           256
+#  define FRAMEQ_SLOTS          4
+#  define PITCH_ENGINE          PITCH_ENGINE_FFT
+#  define PITCH_FFT_LOG2_N      10
+// About 10 Hz
+#  define PITCH_FFT_HOP         (8 * CAPTURE_HOP)
+#  define PITCH_FFT_PARTIALS    4
+#  define PITCH_FFT_LOG2_DECIM_MAX 2
+// Engine rates for 20 kHz, see pitch_goertzel.h and pitch_yin.h
+#  define PITCH_GOERTZEL_RATES \
+	{ { 5, 213 }, { 3, 320 }, { 2, 160 }, { 1, 80 } }
+#  define PITCH_YIN_RATES \
+	{ { 3, 96 }, { 2, 52 }, { 1, 28 }, { 0, 16 } }
+
+#elif CONF_PROFILE == PROFILE_MIXED
+#  define CHANNELS              4
+#  define SAMPLERATE            20000
+#  define OVERSAMPLING          4
+#  define MAXBUFFER             16384
+#  define CAPTURE_WINDOW        64
+#  define CAPTURE_BLOCK_FRAMES  8
+#  define CAPTURE_HOP           256
+// 12.8 ms of blocks, for an FFT slice of up to half that in between
+#  define FRAMEQ_SLOTS          32
+#  define PITCH_ENGINE          PITCH_ENGINE_FFT
+#  define PITCH_GOERTZEL_CHANNELS 0x0c
+// Differential through the ADC gain stage, 4x at the top, see capture.h
+#  define CAPTURE_AGC           1
+#  define PITCH_FFT_LOG2_N      9
+// About 10 Hz
+#  define PITCH_FFT_HOP         (8 * CAPTURE_HOP)
+#  define PITCH_FFT_PARTIALS    4
+#  define PITCH_FFT_LOG2_DECIM_MAX 2
+#  define PITCH_GOERTZEL_RATES \
+	{ { 5, 213 }, { 3, 320 }, { 2, 160 }, { 1, 80 } }
+
+#else
+#  error "Unknown CONF_PROFILE"
+#endif
+
+/**
+ * \name Channels of each pitch engine, bit n for channel n
+ *
+ * A build may run a different engine on each channel, a Goertzel bank on
+ * the treble and the FFT on the bass say. Channels not given to an engine
+ * here go to PITCH_ENGINE; an engine with no channel is left out of the
+ * link.
+ */
+//@{
+#define PITCH_ALL_CHANNELS      ((1 << CHANNELS) - 1)
+#if !defined(PITCH_FFT_CHANNELS) && PITCH_ENGINE != PITCH_ENGINE_FFT
+#  define PITCH_FFT_CHANNELS    0
+#endif
+#if !defined(PITCH_GOERTZEL_CHANNELS) && PITCH_ENGINE != PITCH_ENGINE_GOERTZEL
+#  define PITCH_GOERTZEL_CHANNELS 0
+#endif
+#if !defined(PITCH_YIN_CHANNELS) && PITCH_ENGINE != PITCH_ENGINE_YIN
+#  define PITCH_YIN_CHANNELS    0
+#endif
+#ifndef PITCH_FFT_CHANNELS
+#  define PITCH_FFT_CHANNELS \
+	(PITCH_ALL_CHANNELS & ~(PITCH_GOERTZEL_CHANNELS | PITCH_YIN_CHANNELS))
+#endif
+#ifndef PITCH_GOERTZEL_CHANNELS
+#  define PITCH_GOERTZEL_CHANNELS \
+	(PITCH_ALL_CHANNELS & ~(PITCH_FFT_CHANNELS | PITCH_YIN_CHANNELS))
+#endif
+#ifndef PITCH_YIN_CHANNELS
+#  define PITCH_YIN_CHANNELS \
+	(PITCH_ALL_CHANNELS & ~(PITCH_FFT_CHANNELS | PITCH_GOERTZEL_CHANNELS))
+#endif
+//! Channels fed block by block, and those analysed from the ring
+#define PITCH_STREAM_CHANNELS   (PITCH_GOERTZEL_CHANNELS | PITCH_YIN_CHANNELS)
+#define PITCH_BATCH_CHANNELS    PITCH_FFT_CHANNELS
+//@}
+
+/**
+ * \name Capture interrupt cost targets, CPU cycles
+ *
+ * Used for the load check below and for CAPTURE_CYCLE_TARGET, which the
+ * PROF_CAPTURE probe is checked against on hardware.
+ */
+//@{
+//! Per channel and decimated sample: combs, compensator, store, queue, gate
+#define PROFILE_CYCLES_PER_SAMPLE   95
+//! Per channel and sweep: one CIC integrator step
+#if OVERSAMPLING == 4
+#  define PROFILE_CYCLES_PER_SWEEP  6
+#else
+#  define PROFILE_CYCLES_PER_SWEEP  10
+#endif
+//! Largest share of the CPU the capture interrupt may take, in percent
+#define PROFILE_MAX_CAPTURE_LOAD    60
+//@}
+
+//! \name Internal SRAM budget, bytes
+//@{
+//! Left to the capture buffers and the engine scratch; the rest is stack
+#define PROFILE_SRAM_BUDGET         6656
+//! Capture DMA buffer, analysis window, frame queue and its stand-in slot
+#define PROFILE_SRAM_CAPTURE \
+	(2UL * CAPTURE_BLOCK_FRAMES * OVERSAMPLING * CHANNELS * 2 \
+	+ 2UL * CHANNELS * CAPTURE_WINDOW \
+	+ (FRAMEQ_SLOTS + 1) * ((PITCH_STREAM_CHANNELS \
+	? 2UL * CAPTURE_BLOCK_FRAMES * CHANNELS : 0) + 8))
+//! Scratch and state of the engines in use, each sized for every channel
+#define PROFILE_SRAM_ENGINE \
+	((PITCH_FFT_CHANNELS ? (3UL << PITCH_FFT_LOG2_N) : 0) \
+	+ (PITCH_GOERTZEL_CHANNELS ? CHANNELS * 240UL : 0) \
+	+ (PITCH_YIN_CHANNELS ? CHANNELS * 660UL : 0))
+//@}
+
+#ifndef CAPTURE_ADC
+#  define CAPTURE_ADC CAPTURE_ADC_SINGLE
+#endif
+
+//! Channels of one ADC sweep
+#define PROFILE_SWEEP_CHANNELS  4
+//! Sweeps of each ADC per decimated frame
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST
+#  define PROFILE_ADC_SWEEPS    (OVERSAMPLING / 2)
+#else
+#  define PROFILE_ADC_SWEEPS    OVERSAMPLING
+#endif
+//! Sweep trigger rate of each ADC in Hz
+#define PROFILE_SWEEP_HZ        (SAMPLERATE * 1UL * PROFILE_ADC_SWEEPS)
+//! TCC1 clocks per sweep; tc_write_period() takes one less
+#define PROFILE_SWEEP_PERIOD    (PROFILE_PER_HZ / PROFILE_SWEEP_HZ)
+
+#if PROFILE_PER_HZ % PROFILE_SWEEP_HZ
+#  error "The sweep rate does not divide the peripheral clock"
+#endif
+#if PROFILE_SWEEP_PERIOD < 2 || PROFILE_SWEEP_PERIOD > 65536UL
+#  error "Sweep period out of TCC1 range"
+#endif
+#if CAPTURE_ADC == CAPTURE_ADC_DUAL_FAST && PROFILE_SWEEP_PERIOD % 2
+#  error "ADCB triggers half a sweep period late, which must be whole"
+#endif
+#if PROFILE_SWEEP_HZ * PROFILE_SWEEP_CHANNELS > PROFILE_ADC_HZ
+#  error "Conversion rate exceeds the ADC clock"
+#endif
+#if 2UL * CHANNELS * MAXBUFFER > BOARD_EBI_SDRAM_SIZE
+#  error "Capture rings exceed the SDRAM"
+#endif
+#if (PITCH_FFT_CHANNELS & PITCH_GOERTZEL_CHANNELS) \
+		|| (PITCH_FFT_CHANNELS & PITCH_YIN_CHANNELS) \
+		|| (PITCH_GOERTZEL_CHANNELS & PITCH_YIN_CHANNELS)
+#  error "A channel is given to two pitch engines"
+#endif
+#if (PITCH_STREAM_CHANNELS | PITCH_BATCH_CHANNELS) != PITCH_ALL_CHANNELS
+#  error "Every channel needs a pitch engine"
+#endif
+#if PROFILE_SRAM_CAPTURE + PROFILE_SRAM_ENGINE > PROFILE_SRAM_BUDGET
+#  error "Capture and engine buffers exceed the SRAM budget"
+#endif
+#if SAMPLERATE * 1UL * CHANNELS * (PROFILE_CYCLES_PER_SAMPLE \
+		+ OVERSAMPLING * PROFILE_CYCLES_PER_SWEEP) \
+		> PROFILE_PER_HZ / 100 * PROFILE_MAX_CAPTURE_LOAD
+#  error "Capture interrupt exceeds its cycle budget"
+#endif
+
+#endif /* CONF_PROFILE_H */
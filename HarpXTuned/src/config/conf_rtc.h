@@ -41,8 +41,9 @@
 #ifndef CONF_RTC_H
 #define CONF_RTC_H
 
-#define CONFIG_RTC_PRESCALER          RTC_PRESCALER_DIV1024_gc
-#define CONFIG_RTC_CLOCK_SOURCE       CLK_RTCSRC_ULP_gc
+#define CONFIG_RTC_PRESCALER          RTC_PRESCALER_DIV1_gc
+#define CONFIG_RTC_CLOCK_SOURCE       CLK_RTCSRC_RCOSC_gc
+// Housekeeping, as planned in irqlevel.h
 #define CONFIG_RTC_COMPARE_INT_LEVEL  RTC_COMPINTLVL_LO_gc
 #define CONFIG_RTC_OVERFLOW_INT_LEVEL RTC_OVFINTLVL_LO_gc
 
@@ -44,4 +44,7 @@
 //! Default Config Spi Master Dummy Field
 // #define CONFIG_SPI_MASTER_DUMMY                0xFF
 
+//! Transfer complete vector of the SPI for spi_transfer_start(), if used
+// #define CONFIG_SPI_MASTER_ASYNC_vect           SPIC_INT_vect
+
 #endif /* CONF_SPI_MASTER_H_INCLUDED */
@@ -42,4 +42,14 @@
 #ifndef CONF_USART_SERIAL_H_INCLUDED
 #define CONF_USART_SERIAL_H_INCLUDED
 
+//! Board controller virtual COM port
+#define USART_SERIAL                     &USARTC0
+#define USART_SERIAL_DRE_vect            USARTC0_DRE_vect
+#define USART_SERIAL_RXC_vect            USARTC0_RXC_vect
+#define USART_SERIAL_RXC_TRIGSRC         DMA_CH_TRIGSRC_USARTC0_RXC_gc
+#define USART_SERIAL_BAUDRATE            115200
+#define USART_SERIAL_CHAR_LENGTH         USART_CHSIZE_8BIT_gc
+#define USART_SERIAL_PARITY              USART_PMODE_DISABLED_gc
+#define USART_SERIAL_STOP_BIT            false
+
 #endif /* CONF_USART_SERIAL_H_INCLUDED */
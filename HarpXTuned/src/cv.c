@@ -0,0 +1,112 @@
+/**
+ * \file
+ *
+ * \brief Analog output of the tuning error on DACB channel 1
+ *
+ */
+
+#include <asf.h>
+#include "cv.h"
+#include "harp.h"
+#include "notes.h"
+#include "pitch.h"
+#include "tone.h"
+
+//! \internal DAC code of mid scale, of 12 bits
+#define CV_MID                  2048
+//! \internal Largest DAC code
+#define CV_MAX                  4095
+
+//! \internal What the output shows
+static enum cv_mode cv_mode;
+//! \internal Channel of the current string
+static uint8_t cv_ch;
+
+/**
+ * \internal
+ * \brief Error of \a reading of channel \a ch off its string or note
+ */
+static notes_offset_t cv_error(uint8_t ch, const struct pitch_reading *reading)
+{
+	notes_cents_t target;
+
+	if (pitch_is_chromatic(ch)) {
+		harp_nearest_note(reading->freq, &target);
+	} else {
+		target = harp_string_pitch(harp_nearest_string(ch, reading->freq));
+	}
+	return notes_offset(notes_from_hz(reading->freq), target);
+}
+
+/**
+ * \internal
+ * \brief DAC code of \a reading of channel \a ch
+ */
+static uint16_t cv_code(uint8_t ch, const struct pitch_reading *reading)
+{
+	int32_t code;
+
+	if (cv_mode == CV_LEVEL) {
+		return reading->freq ? Min(reading->level >> CV_LEVEL_SHIFT,
+				CV_MAX) : 0;
+	}
+	if (!reading->freq) {
+		return CV_MID;
+	}
+	code = CV_MID + (int32_t)cv_error(ch, reading) * (CV_MID - 1)
+			/ NOTES_OFFSET(CV_RANGE_CENTS);
+	return Max(Min(code, CV_MAX), 0);
+}
+
+/**
+ * \brief Show \a mode on the output, or let it go with CV_OFF
+ */
+void cv_set_mode(enum cv_mode mode)
+{
+	if (mode == cv_mode) {
+		return;
+	}
+	if (cv_mode == CV_OFF) {
+		tone_dac_get(CV_DAC_CHANNEL);
+	} else if (mode == CV_OFF) {
+		tone_dac_put(CV_DAC_CHANNEL);
+	}
+	cv_mode = mode;
+	if (mode != CV_OFF) {
+		dac_set_channel_value(&SPEAKER_DAC_MODULE, CV_DAC_CHANNEL,
+				(mode == CV_CENTS) ? CV_MID : 0);
+	}
+}
+
+/**
+ * \brief What the output shows
+ */
+enum cv_mode cv_get_mode(void)
+{
+	return cv_mode;
+}
+
+/**
+ * \brief Take the new reading of channel \a ch, from \ref pitch_filter()
+ *
+ * A channel louder than the current one takes over the output; the
+ * current one keeps it until then, and rests it when it goes silent.
+ */
+void cv_reading(uint8_t ch)
+{
+	const struct pitch_reading *reading = &pitch_readings[ch];
+	const struct pitch_reading *current = &pitch_readings[cv_ch];
+
+	if (cv_mode == CV_OFF) {
+		return;
+	}
+	if (ch != cv_ch) {
+		if (!reading->freq || (current->freq
+				&& reading->level <= current->level)) {
+			return;
+		}
+		cv_ch = ch;
+	}
+	dac_set_channel_value(&SPEAKER_DAC_MODULE, CV_DAC_CHANNEL,
+			cv_code(ch, reading));
+}
@@ -0,0 +1,65 @@
+/**
+ * \file
+ *
+ * \brief Analog output of the tuning error on DACB channel 1
+ *
+ * For an external meter or light bar that shows the reading with the
+ * \ref display.h stack idle. "cv cents" on the \ref shell.h drives PB3,
+ * DACB channel 1, with the error of the current string, "cv level" with
+ * its level, and "cv off" lets the pin go high impedance.
+ *
+ * The current string is that of the loudest channel with a reading, as
+ * with "tone". Each new reading, as \ref pitch_filter() hands it on,
+ * writes the channel data register, and the DAC converts on the write:
+ * the output follows the readings at their own rate, with no polling
+ * and nothing else to keep running. Channel 0 stays with the
+ * \ref tone.h speaker, and the two share the DAC with
+ * \ref tone_dac_get().
+ *
+ * \note The DAC runs both channels in dual channel mode while the output
+ * is on. That PB3 holds its level while the tone plays on channel 0 has
+ * not been checked on a board yet.
+ *
+ * In cents, mid scale, AVCC / 2, is in tune and the ends of the scale
+ * are CV_RANGE_CENTS flat and sharp, clipped beyond. The output rests at
+ * mid scale with no reading. In level, the level of the engine is taken
+ * down by CV_LEVEL_SHIFT bits, 0 V with no reading.
+ *
+ */
+
+#ifndef CV_H
+#define CV_H
+
+#include <compiler.h>
+
+//! What the output shows
+enum cv_mode {
+	CV_OFF,
+	//! Error of the current string
+	CV_CENTS,
+	//! Level of the current string
+	CV_LEVEL,
+};
+
+//! DACB channel of the output, next to the speaker's
+#define CV_DAC_CHANNEL          DAC_CH1
+
+//! Cents flat or sharp at either end of the scale
+#ifndef CV_RANGE_CENTS
+#  define CV_RANGE_CENTS        50
+#endif
+
+//! Right shift from the engine level to the 12-bit code
+#ifndef CV_LEVEL_SHIFT
+#  define CV_LEVEL_SHIFT        4
+#endif
+
+#if CV_RANGE_CENTS < 1 || CV_RANGE_CENTS > 100
+#  error "CV_RANGE_CENTS must be 1 to 100 cents"
+#endif
+
+void cv_set_mode(enum cv_mode mode);
+enum cv_mode cv_get_mode(void);
+void cv_reading(uint8_t ch);
+
+#endif /* CV_H */
@@ -0,0 +1,149 @@
+/**
+ * \file
+ *
+ * \brief AT45DB DataFlash on the SPIC pins
+ *
+ */
+
+#include <asf.h>
+#include "dataflash.h"
+#include "power.h"
+
+//! \internal \name Opcodes
+//@{
+#define DATAFLASH_READ_ID       0x9f
+#define DATAFLASH_READ_STATUS   0xd7
+#define DATAFLASH_READ_ARRAY    0x03
+//@}
+
+//! \internal Status register ready bit
+#define DATAFLASH_STATUS_READY  0x80
+
+//! \internal Buffer write and buffer to page program with erase, per buffer
+static const uint8_t dataflash_op_write[2] = { 0x84, 0x87 };
+static const uint8_t dataflash_op_program[2] = { 0x83, 0x86 };
+
+static struct spi_device dataflash_device = {
+	.id = AT45DBX_CS,
+};
+
+/**
+ * \internal
+ * \brief Start the SPIC clock and select the chip
+ */
+static void dataflash_select(void)
+{
+	power_get(POWER_SPIC);
+	spi_select_device(DATAFLASH_SPI, &dataflash_device);
+}
+
+/**
+ * \internal
+ * \brief Deselect the chip and let the SPIC clock go
+ */
+static void dataflash_deselect(void)
+{
+	spi_deselect_device(DATAFLASH_SPI, &dataflash_device);
+	power_put(POWER_SPIC);
+}
+
+/**
+ * \internal
+ * \brief Select the chip and send \a op with a 24-bit address
+ */
+static void dataflash_command(uint8_t op, uint32_t addr)
+{
+	uint8_t cmd[4] = { op, addr >> 16, addr >> 8, addr };
+
+	dataflash_select();
+	spi_write_packet(DATAFLASH_SPI, cmd, sizeof(cmd));
+}
+
+/**
+ * \brief Set up SPIC and check that a DataFlash answers
+ *
+ * spi_master_init() starts the SPIC clock; it is stopped again at the
+ * end, and runs only while the chip is selected from then on.
+ *
+ * \retval true if an AT45DB642D was found
+ * \retval false if the footprint is empty or holds another part
+ */
+bool dataflash_init(void)
+{
+	uint8_t id[3] = { DATAFLASH_READ_ID };
+
+	ioport_configure_pin(DATAFLASH_SPI_SS, IOPORT_DIR_OUTPUT
+			| IOPORT_INIT_HIGH);
+	power_get(POWER_SPIC);
+	spi_master_init(DATAFLASH_SPI);
+	spi_master_setup_device(DATAFLASH_SPI, &dataflash_device, SPI_MODE_0,
+			DATAFLASH_BAUDRATE, 0);
+	spi_enable(DATAFLASH_SPI);
+
+	dataflash_select();
+	spi_transfer_packet(DATAFLASH_SPI, id, id, sizeof(id));
+	dataflash_deselect();
+	power_put(POWER_SPIC);
+
+	return id[1] == DATAFLASH_ID_ATMEL && id[2] == DATAFLASH_ID_DEVICE;
+}
+
+/**
+ * \brief Whether the last page program has finished
+ */
+bool dataflash_is_ready(void)
+{
+	uint8_t status[2] = { DATAFLASH_READ_STATUS };
+
+	dataflash_select();
+	spi_transfer_packet(DATAFLASH_SPI, status, status, sizeof(status));
+	dataflash_deselect();
+
+	return status[1] & DATAFLASH_STATUS_READY;
+}
+
+/**
+ * \brief Write \a len bytes into SRAM buffer \a buffer, 0 or 1, from
+ * byte \a offset
+ *
+ * Allowed while the other buffer is being programmed.
+ */
+void dataflash_buffer_write(uint8_t buffer, uint16_t offset,
+		const void *data, uint16_t len)
+{
+	Assert(offset + len <= DATAFLASH_PAGE_SIZE);
+
+	dataflash_command(dataflash_op_write[buffer], offset);
+	spi_write_packet(DATAFLASH_SPI, data, len);
+	dataflash_deselect();
+}
+
+/**
+ * \brief Erase \a page and program it from SRAM buffer \a buffer
+ *
+ * Returns at once; the chip is busy until \ref dataflash_is_ready().
+ * Only call while it is ready.
+ */
+void dataflash_buffer_program(uint8_t buffer, uint16_t page)
+{
+	Assert(page < DATAFLASH_PAGES);
+
+	dataflash_command(dataflash_op_program[buffer],
+			(uint32_t)page << DATAFLASH_PAGE_SHIFT);
+	dataflash_deselect();
+}
+
+/**
+ * \brief Read \a len bytes of the array from byte \a offset of \a page
+ *
+ * The read continues into the following pages. Only call while the chip
+ * is ready.
+ */
+void dataflash_read(uint16_t page, uint16_t offset, void *data,
+		uint16_t len)
+{
+	dataflash_command(DATAFLASH_READ_ARRAY,
+			((uint32_t)page << DATAFLASH_PAGE_SHIFT) | offset);
+	spi_read_packet(DATAFLASH_SPI, data, len);
+	dataflash_deselect();
+}
@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * \brief AT45DB DataFlash on the SPIC pins
+ *
+ * A minimal polled driver for the optional AT45DB642D footprint of the
+ * XMEGA-A1 Xplained, in its default DataFlash page size. The chip has two
+ * SRAM page buffers: one can be written over SPI while the other is being
+ * programmed into the array, which is what \ref record.h streams through.
+ *
+ * The board header names USARTC0 as the DataFlash SPI, but the pins it
+ * configures, PC4..PC7, are those of SPIC, which is what is used here.
+ * USARTC0 stays with the stdio console.
+ *
+ */
+
+#ifndef DATAFLASH_H
+#define DATAFLASH_H
+
+#include <compiler.h>
+#include <board.h>
+
+//! SPI module wired to the DataFlash
+#define DATAFLASH_SPI           &SPIC
+//! Slave select pin of SPIC, must be an output in master mode
+#define DATAFLASH_SPI_SS        IOPORT_CREATE_PIN(PORTC, 4)
+
+//! SPI clock in Hz
+#ifndef DATAFLASH_BAUDRATE
+#  define DATAFLASH_BAUDRATE    8000000UL
+#endif
+
+//! \name AT45DB642D geometry
+//@{
+#define DATAFLASH_PAGE_SIZE     1056
+//! Byte address bits below the page address
+#define DATAFLASH_PAGE_SHIFT    11
+#define DATAFLASH_PAGES         8192
+//@}
+
+//! JEDEC manufacturer and device id bytes
+#define DATAFLASH_ID_ATMEL      0x1f
+#define DATAFLASH_ID_DEVICE     0x28
+
+bool dataflash_init(void);
+bool dataflash_is_ready(void);
+void dataflash_buffer_write(uint8_t buffer, uint16_t offset,
+		const void *data, uint16_t len);
+void dataflash_buffer_program(uint8_t buffer, uint16_t page);
+void dataflash_read(uint16_t page, uint16_t offset, void *data,
+		uint16_t len);
+
+#endif /* DATAFLASH_H */
@@ -0,0 +1,437 @@
+/**
+ * \file
+ *
+ * \brief Tuning display on the board LEDs
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "auxadc.h"
+#include "display.h"
+#include "gliss.h"
+#include "harp.h"
+#include "notes.h"
+#include "pitch.h"
+#include "timebase.h"
+
+//! \internal PORTE pins of the LED pair of channel \a ch
+#define DISPLAY_PAIR(ch)        (3U << (2 * (ch)))
+
+//! \internal Stamp of the reading last shown on each channel
+static uint32_t display_stamp[CHANNELS];
+//! \internal Latency of the newest reading shown and the longest, in us
+static uint32_t display_latency_last;
+static uint32_t display_latency_max;
+
+#if DISPLAY_DIM
+//! \internal log2 of the smoothing of the light sensor codes, in readings
+#define DISPLAY_LOG2_SMOOTH     2
+
+//! \internal Dead time in PWM clocks, 0 at full brightness
+static uint8_t display_dti;
+//! \internal Smoothed light sensor code, scaled by 2^DISPLAY_LOG2_SMOOTH,
+//! or -1 before the first reading
+static int16_t display_light = -1;
+//! \internal Refreshes until the next light sensor reading
+static uint8_t display_dim_wait;
+
+//! \internal Whether the dead time dims the LEDs
+#  define DISPLAY_DIMMED()      (display_dti != 0)
+#else
+#  define DISPLAY_DIMMED()      false
+#endif
+
+#if DISPLAY_LCD
+//! \internal Panel column of the needle in tune
+#define DISPLAY_NEEDLE_MID      (LCD_WIDTH / 2)
+//! \internal Needle columns either side of the middle
+#define DISPLAY_NEEDLE_SPAN     (LCD_WIDTH / 2 - 2)
+//! \internal Column of the cents on the text page
+#define DISPLAY_CENTS_COL       (8 * LCD_CHAR_WIDTH)
+
+//! \internal Whether the panel has been set up, and has a framebuffer
+static bool display_lcd_started;
+static bool display_lcd;
+//! \internal Whether dirty pages are left from the last refresh
+static bool display_lcd_flushing;
+//! \internal Needle column of each channel, 0 while hidden
+static uint8_t display_needle[CHANNELS];
+//! \internal \ref gliss.h report on the panel, 0 for the channels
+static uint8_t display_report;
+
+//! \internal Column of the second string of a page of the report
+#define DISPLAY_REPORT_COL      (LCD_WIDTH / 2)
+
+/**
+ * \internal
+ * \brief Scale column \a x of a needle page: a tick every 16 columns, a
+ * long one in the middle
+ */
+static uint8_t display_scale(uint8_t x)
+{
+	if (x == DISPLAY_NEEDLE_MID) {
+		return 0xf0;
+	}
+	return (x % 16) ? 0 : 0x80;
+}
+
+/**
+ * \internal
+ * \brief Move the needle of channel \a ch to column \a x, 0 to hide it
+ */
+static void display_lcd_needle(uint8_t ch, uint8_t x)
+{
+	uint8_t page = 2 * ch + 1;
+	uint8_t old = display_needle[ch];
+
+	if (x == old) {
+		return;
+	}
+	if (old) {
+		lcd_put(page, old, display_scale(old));
+		lcd_put(page, old + 1, display_scale(old + 1));
+	}
+	if (x) {
+		lcd_put(page, x, display_scale(x) | 0x3f);
+		lcd_put(page, x + 1, display_scale(x + 1) | 0x3f);
+	}
+	display_needle[ch] = x;
+}
+
+/**
+ * \internal
+ * \brief Write \a error, Q8.8 cents, into \a text as a sign and three
+ * places of whole cents
+ */
+static void display_cents_text(notes_offset_t error, char *text)
+{
+	// Q8.8 to whole cents, rounded away from 0
+	int16_t cents = (error + ((error < 0) ? -128 : 128)) / 256;
+
+	text[0] = (cents < 0) ? '-' : '+';
+	if (cents < 0) {
+		cents = -cents;
+	}
+	text[1] = (cents >= 100) ? '0' + cents / 100 : ' ';
+	text[2] = (cents >= 10) ? '0' + cents / 10 % 10 : ' ';
+	text[3] = '0' + cents % 10;
+	text[4] = '\0';
+}
+
+/**
+ * \internal
+ * \brief Show \a error off \a note on the pages of channel \a ch, or
+ * dashes with no needle if \a freq is 0
+ */
+static void display_lcd_channel(uint8_t ch, pitch_hz_t freq, uint8_t note,
+		notes_offset_t error)
+{
+	char text[NOTES_NAME_MAX + 1] = "----";
+	uint8_t col;
+
+	if (!freq) {
+		col = lcd_text(2 * ch, 0, text);
+		lcd_text(2 * ch, DISPLAY_CENTS_COL, "    ");
+		while (col < DISPLAY_CENTS_COL) {
+			lcd_put(2 * ch, col++, 0);
+		}
+		display_lcd_needle(ch, 0);
+		return;
+	}
+
+	notes_name(note, text);
+	col = lcd_text(2 * ch, 0, text);
+	while (col < DISPLAY_CENTS_COL) {
+		lcd_put(2 * ch, col++, 0);
+	}
+	display_cents_text(error, text);
+	lcd_text(2 * ch, DISPLAY_CENTS_COL, text);
+
+	if (error > NOTES_OFFSET(DISPLAY_RANGE_CENTS)) {
+		error = NOTES_OFFSET(DISPLAY_RANGE_CENTS);
+	} else if (error < -NOTES_OFFSET(DISPLAY_RANGE_CENTS)) {
+		error = -NOTES_OFFSET(DISPLAY_RANGE_CENTS);
+	}
+	display_lcd_needle(ch, DISPLAY_NEEDLE_MID + (int32_t)error
+			* DISPLAY_NEEDLE_SPAN / NOTES_OFFSET(DISPLAY_RANGE_CENTS));
+}
+
+/**
+ * \internal
+ * \brief Draw the scales, and dashes on every channel
+ */
+static void display_lcd_scales(void)
+{
+	uint8_t ch;
+	uint8_t x;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		for (x = 0; x < LCD_WIDTH; x++) {
+			lcd_put(2 * ch + 1, x, display_scale(x));
+		}
+		display_lcd_channel(ch, 0, 0, 0);
+	}
+}
+
+/**
+ * \internal
+ * \brief Set up the panel and draw the scales, at the first refresh
+ */
+static void display_lcd_init(void)
+{
+	display_lcd = lcd_init();
+	if (display_lcd) {
+		display_lcd_scales();
+	}
+}
+
+/**
+ * \internal
+ * \brief List the strings of \ref gliss.h report \a report over the
+ * whole panel, two to a page, or go back to the channels for 0
+ *
+ * Strings past the end of the panel are only in the printed report.
+ */
+static void display_lcd_report(uint8_t report)
+{
+	char text[NOTES_NAME_MAX + 1];
+	notes_offset_t error;
+	uint8_t string;
+	uint8_t page;
+	uint8_t col;
+	uint8_t i;
+
+	for (page = 0; page < LCD_PAGES; page++) {
+		for (col = 0; col < LCD_WIDTH; col++) {
+			lcd_put(page, col, 0);
+		}
+	}
+	memset(display_needle, 0, sizeof(display_needle));
+	if (!report) {
+		display_lcd_scales();
+		return;
+	}
+	for (i = 0; i < 2 * LCD_PAGES; i++) {
+		string = gliss_report_string(i, &error);
+		if (string >= HARP_STRINGS) {
+			break;
+		}
+		notes_name(harp_string_note(string), text);
+		col = (i % 2) * DISPLAY_REPORT_COL;
+		col = lcd_text(i / 2, col, text) + LCD_CHAR_WIDTH;
+		display_cents_text(error, text);
+		lcd_text(i / 2, col, text);
+	}
+}
+#endif /* DISPLAY_LCD */
+
+#if DISPLAY_DIM
+/**
+ * \internal
+ * \brief Read the light sensor and set the dead time and the contrast
+ *
+ * The dead time takes effect at the end of a period, with the compare
+ * values.
+ */
+static void display_dim(void)
+{
+	int16_t code = Max(auxadc_read(LIGHT_SENSOR_ADC_INPUT), 0);
+	uint8_t dti;
+
+	if (display_light < 0) {
+		display_light = code << DISPLAY_LOG2_SMOOTH;
+	} else {
+		display_light += code - (display_light >> DISPLAY_LOG2_SMOOTH);
+	}
+	code = display_light >> DISPLAY_LOG2_SMOOTH;
+
+	if (code >= DISPLAY_LIGHT_BRIGHT) {
+		dti = 0;
+	} else if (code <= DISPLAY_LIGHT_DARK) {
+		dti = DISPLAY_DIM_MAX;
+	} else {
+		dti = (uint32_t)(DISPLAY_LIGHT_BRIGHT - code) * DISPLAY_DIM_MAX
+				/ (DISPLAY_LIGHT_BRIGHT - DISPLAY_LIGHT_DARK);
+	}
+	if (dti == display_dti) {
+		return;
+	}
+	display_dti = dti;
+	tc_awex_set_dti_both_buffer(&AWEXE, dti);
+#  if DISPLAY_LCD
+	if (display_lcd) {
+		lcd_set_contrast((uint32_t)LCD_CONTRAST
+				* (DISPLAY_PWM_LEVELS - 2 * dti) / DISPLAY_PWM_LEVELS);
+	}
+#  endif
+}
+#endif /* DISPLAY_DIM */
+
+/**
+ * \brief Start the PWM of the LED pairs, all dark, and set up the panel
+ *
+ * The pins stay under PORTE until a channel first reads a pitch off the
+ * string. They are inverted, so the LEDs, active low, are lit by a high
+ * output and dark during the dead time. Assumes the AWEXE fault protection
+ * is not locked on by the fuses. Call after \ref sdram_init() and
+ * \ref auxadc_init().
+ */
+void display_init(void)
+{
+	uint8_t ch;
+
+	ioport_configure_port_pin(&PORTE, 0xff, IOPORT_DIR_OUTPUT
+			| IOPORT_INIT_LOW | IOPORT_INV_ENABLED);
+
+	tc_enable(&TCE0);
+	tc_set_wgm(&TCE0, TC_WG_SS);
+	tc_write_period(&TCE0, DISPLAY_PWM_LEVELS - 1);
+	for (ch = 0; ch < CHANNELS; ch++) {
+		tc_write_cc(&TCE0, (enum tc_cc_channel_t)(TC_CCA + ch),
+				DISPLAY_PWM_LEVELS / 2);
+	}
+	tc_enable_cc_channels(&TCE0, TC_CCAEN | TC_CCBEN | TC_CCCEN | TC_CCDEN);
+
+	// Low side on the compare output, high side on its complement
+	tc_awex_enable_cca_deadtime(&AWEXE);
+	tc_awex_enable_ccb_deadtime(&AWEXE);
+	tc_awex_enable_ccc_deadtime(&AWEXE);
+	tc_awex_enable_ccd_deadtime(&AWEXE);
+	tc_awex_set_dti_both(&AWEXE, 0);
+	tc_awex_set_output_override(&AWEXE, 0);
+
+	tc_write_clock_source(&TCE0, DISPLAY_PWM_CLKSEL);
+}
+
+/**
+ * \brief Show the current \ref pitch_readings, scheduler task
+ *
+ * The compare output is high, so the low side LED lit, for the compare
+ * value in clocks of the period, and the high side LED is dark just as
+ * long: the compare value goes down with the error. Buffered compare
+ * values take effect at the end of a period, without a glitch.
+ *
+ * \retval true while panel pages are left to send, one per slice
+ * \retval false when the refresh is done
+ */
+bool display_run(void)
+{
+	uint8_t pwm = 0;
+	uint8_t lit = 0;
+	uint8_t ch;
+
+#if DISPLAY_LCD
+	if (!display_lcd_started) {
+		display_lcd_started = true;
+		display_lcd_init();
+		display_lcd_flushing = display_lcd;
+		return display_lcd_flushing;
+	}
+	if (display_lcd_flushing) {
+		display_lcd_flushing = lcd_flush();
+		return display_lcd_flushing;
+	}
+	if (display_lcd && display_report != gliss_get_report()) {
+		display_report = gliss_get_report();
+		display_lcd_report(display_report);
+		display_lcd_flushing = lcd_flush();
+		return display_lcd_flushing;
+	}
+#endif
+#if DISPLAY_DIM
+	if (!display_dim_wait--) {
+		display_dim();
+		display_dim_wait = DISPLAY_DIM_PERIOD - 1;
+	}
+#endif
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_hz_t freq = pitch_readings[ch].freq;
+		uint32_t stamp = pitch_readings[ch].time;
+		int32_t level;
+		notes_cents_t target;
+		notes_offset_t error;
+		uint8_t note;
+
+		if (!freq) {
+#if DISPLAY_LCD
+			if (display_lcd && !display_report) {
+				display_lcd_channel(ch, 0, 0, 0);
+			}
+#endif
+			continue;
+		}
+		if (stamp != display_stamp[ch]) {
+			display_stamp[ch] = stamp;
+			display_latency_last = timebase_now() - stamp;
+			display_latency_max = Max(display_latency_max,
+					display_latency_last);
+		}
+		if (pitch_is_chromatic(ch)) {
+			note = harp_nearest_note(freq, &target);
+		} else {
+			uint8_t string = harp_nearest_string(ch, freq);
+
+			note = harp_string_note(string);
+			target = harp_string_pitch(string);
+		}
+		error = notes_offset(notes_from_hz(freq), target);
+#if DISPLAY_LCD
+		if (display_lcd && !display_report) {
+			display_lcd_channel(ch, freq, note, error);
+		}
+#endif
+		if (error <= NOTES_OFFSET(DISPLAY_TUNE_CENTS)
+				&& error >= -NOTES_OFFSET(DISPLAY_TUNE_CENTS)) {
+			if (!DISPLAY_DIMMED()) {
+				lit |= DISPLAY_PAIR(ch);
+				continue;
+			}
+			// Both LEDs on the PWM, at the same brightness
+			error = 0;
+		}
+		if (error > NOTES_OFFSET(DISPLAY_RANGE_CENTS)) {
+			error = NOTES_OFFSET(DISPLAY_RANGE_CENTS);
+		} else if (error < -NOTES_OFFSET(DISPLAY_RANGE_CENTS)) {
+			error = -NOTES_OFFSET(DISPLAY_RANGE_CENTS);
+		}
+		level = DISPLAY_PWM_LEVELS / 2 - (int32_t)error
+				* (DISPLAY_PWM_LEVELS / 2)
+				/ NOTES_OFFSET(DISPLAY_RANGE_CENTS);
+		tc_write_cc_buffer(&TCE0, (enum tc_cc_channel_t)(TC_CCA + ch),
+				(uint16_t)level);
+		pwm |= DISPLAY_PAIR(ch);
+	}
+
+	// Inverted pins, high is lit
+	ioport_set_port_mask(&PORTE, 0xff, lit);
+	tc_awex_set_output_override(&AWEXE, (int8_t)pwm);
+
+#if DISPLAY_LCD
+	display_lcd_flushing = display_lcd && lcd_flush();
+	return display_lcd_flushing;
+#else
+	return false;
+#endif
+}
+
+/**
+ * \brief Print the capture to display latency of the readings shown
+ */
+void display_latency_dump(void)
+{
+	printf_P(PSTR("display latency last %lu  max %lu us\r\n"),
+			(unsigned long)display_latency_last,
+			(unsigned long)display_latency_max);
+}
+
+/**
+ * \brief Clear the longest latency
+ */
+void display_latency_reset(void)
+{
+	display_latency_last = 0;
+	display_latency_max = 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * \file
+ *
+ * \brief Tuning display on the board LEDs
+ *
+ * Each channel gets a pair of the board LEDs, the lower one for flat and
+ * the upper one for sharp, as a two-LED bar. The share of brightness moves
+ * from the flat LED to the sharp one as the pitch goes from
+ * DISPLAY_RANGE_CENTS below the nearest string of the group to as far
+ * above it; both are fully lit inside DISPLAY_TUNE_CENTS and dark while
+ * the channel reads no pitch.
+ *
+ * The LEDs are on PORTE, where TCE0 runs single-slope PWM and the AWEXE
+ * dead time insertion splits each compare channel into a complementary
+ * pair, pins 2n and 2n + 1 for channel n. The brightness thus costs no
+ * CPU time at all; \ref display_run() only writes the buffered compare
+ * values and the pins taken off the PWM, once per refresh.
+ *
+ * With DISPLAY_DIM, every DISPLAY_DIM_PERIOD refreshes the board light
+ * sensor is read with \ref auxadc_read(), and between DISPLAY_LIGHT_BRIGHT
+ * and DISPLAY_LIGHT_DARK the dead time grows to DISPLAY_DIM_MAX: the pins
+ * are inverted, so the dead time is dark on both LEDs of every pair and
+ * takes twice its length off each period. An in-tune pair then stays on
+ * the PWM at the middle, at the same total brightness as the others,
+ * instead of being lit whole from the port. The panel contrast follows.
+ * The sensor is only read when the capture leaves ADCB free.
+ *
+ * With DISPLAY_LCD, the stage units also show each channel on an
+ * \ref lcd.h panel, in two pages: the nearest string and the cents off it,
+ * and a needle over a scale of DISPLAY_RANGE_CENTS either way. Only the
+ * text that changed and the old and new needle columns are drawn, and the
+ * display task goes on for one slice per dirty page to send them. The
+ * panel is set up at the first refresh, not at start-up, and its scales
+ * go out the same way. After a \ref gliss.h burst the panel lists the
+ * strings out of tune instead, with the cents off each, until the next
+ * burst starts.
+ *
+ * Each new reading shown is timed from the \ref timebase.h stamp of its
+ * newest sample, so \ref display_latency_dump() gives the capture to
+ * display latency, up to a panel that still has pages to send.
+ *
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <compiler.h>
+#include <board.h>
+#include <conf_board.h>
+#include "auxadc.h"
+#include "capture.h"
+#include "lcd.h"
+
+//! In tune within this many cents of the string
+#ifndef DISPLAY_TUNE_CENTS
+#  define DISPLAY_TUNE_CENTS    7
+#endif
+
+//! Cents off the string at which one LED of the pair is fully lit
+#ifndef DISPLAY_RANGE_CENTS
+#  define DISPLAY_RANGE_CENTS   50
+#endif
+
+//! Draw on an SSD1306 panel as well as on the board LEDs
+#ifndef DISPLAY_LCD
+#  define DISPLAY_LCD           0
+#endif
+
+//! Refresh period in RTC ticks, 25 Hz
+#ifndef DISPLAY_PERIOD
+#  define DISPLAY_PERIOD        41
+#endif
+
+//! Dim the display in the dark, from the board light sensor
+#ifndef DISPLAY_DIM
+#  if AUXADC_ENABLE && defined(CONF_BOARD_ENABLE_LIGHT_SENSOR)
+#    define DISPLAY_DIM         1
+#  else
+#    define DISPLAY_DIM         0
+#  endif
+#endif
+
+//! Refreshes per light sensor reading, 1 s
+#ifndef DISPLAY_DIM_PERIOD
+#  define DISPLAY_DIM_PERIOD    25
+#endif
+
+/**
+ * \name Light sensor codes of full brightness and of the dimmest display
+ *
+ * The sensor reads higher in more light; \ref auxadc_read() codes.
+ */
+//@{
+#ifndef DISPLAY_LIGHT_BRIGHT
+#  define DISPLAY_LIGHT_BRIGHT  512
+#endif
+#ifndef DISPLAY_LIGHT_DARK
+#  define DISPLAY_LIGHT_DARK    32
+#endif
+//@}
+
+//! Dead time in the dark in PWM clocks, leaving a pair lit 1/8 of the time
+#ifndef DISPLAY_DIM_MAX
+#  define DISPLAY_DIM_MAX       112
+#endif
+
+//! TCE0 clocks per PWM period, about 2 kHz from the 32 MHz clock
+#define DISPLAY_PWM_LEVELS      256
+#define DISPLAY_PWM_CLKSEL      TC_CLKSEL_DIV64_gc
+
+//! Board LEDs of each channel
+#define DISPLAY_LEDS_PER_CH     (LED_COUNT / CHANNELS)
+
+#if DISPLAY_LEDS_PER_CH != 2
+#  error "The display needs one LED pair, and TCE0 compare channel, per channel"
+#endif
+#if DISPLAY_RANGE_CENTS <= DISPLAY_TUNE_CENTS || DISPLAY_RANGE_CENTS > 100
+#  error "DISPLAY_RANGE_CENTS out of range"
+#endif
+#if DISPLAY_DIM && !AUXADC_ENABLE
+#  error "DISPLAY_DIM needs ADCB, which the capture has"
+#endif
+#if DISPLAY_DIM && (DISPLAY_DIM_MAX >= DISPLAY_PWM_LEVELS / 2 \
+		|| DISPLAY_LIGHT_DARK >= DISPLAY_LIGHT_BRIGHT)
+#  error "DISPLAY_DIM settings out of range"
+#endif
+#if DISPLAY_LCD && 2 * CHANNELS > LCD_PAGES
+#  error "The panel has two pages per channel"
+#endif
+
+void display_init(void);
+bool display_run(void);
+void display_latency_dump(void);
+void display_latency_reset(void);
+
+#endif /* DISPLAY_H */
@@ -0,0 +1,91 @@
+/**
+ * \file
+ *
+ * \brief IMA ADPCM coder, 4 bits per sample
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "adpcm.h"
+#include "fixmath.h"
+
+//! \internal Step sizes of the IMA ADPCM standard
+static PROGMEM_DECLARE(uint16_t, adpcm_steps[ADPCM_STEPS]) = {
+	    7,     8,     9,    10,    11,    12,    13,    14,
+	   16,    17,    19,    21,    23,    25,    28,    31,
+	   34,    37,    41,    45,    50,    55,    60,    66,
+	   73,    80,    88,    97,   107,   118,   130,   143,
+	  157,   173,   190,   209,   230,   253,   279,   307,
+	  337,   371,   408,   449,   494,   544,   598,   658,
+	  724,   796,   876,   963,  1060,  1166,  1282,  1411,
+	 1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,
+	 3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,
+	 7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+	32767,
+};
+
+/**
+ * \brief Take the predictor and the step past \a code
+ *
+ * The half of the decoder the encoder shares.
+ */
+void adpcm_step(struct adpcm_state *st, uint8_t code)
+{
+	uint16_t step = PROGMEM_READ_WORD(&adpcm_steps[st->index]);
+	uint16_t diff = step >> 3;
+	uint8_t mag = code & 7;
+	int8_t index;
+
+	if (mag & 4) {
+		diff += step;
+	}
+	if (mag & 2) {
+		diff += step >> 1;
+	}
+	if (mag & 1) {
+		diff += step >> 2;
+	}
+	st->pred = fixmath_sat16((code & 8) ? (int32_t)st->pred - diff
+			: (int32_t)st->pred + diff);
+
+	// Down one step on codes 0..3, up 2, 4, 6 or 8 steps on 4..7
+	index = (int8_t)st->index + ((mag < 4) ? -1 : (int8_t)(2 * mag - 6));
+	st->index = (index < 0) ? 0
+			: (index >= ADPCM_STEPS) ? ADPCM_STEPS - 1 : (uint8_t)index;
+}
+
+/**
+ * \brief Encode sample \a x
+ *
+ * \return The 4-bit code, \ref adpcm_decode() of it gives the predictor
+ */
+uint8_t adpcm_encode(struct adpcm_state *st, int16_t x)
+{
+	int32_t d = (int32_t)x - st->pred;
+	uint16_t step = PROGMEM_READ_WORD(&adpcm_steps[st->index]);
+	uint16_t diff;
+	uint8_t code = 0;
+
+	if (d < 0) {
+		code = 8;
+		d = -d;
+	}
+	diff = (uint16_t)d;
+	if (diff >= step) {
+		code |= 4;
+		diff -= step;
+	}
+	step >>= 1;
+	if (diff >= step) {
+		code |= 2;
+		diff -= step;
+	}
+	step >>= 1;
+	if (diff >= step) {
+		code |= 1;
+	}
+	adpcm_step(st, code);
+	return code;
+}
@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * \brief IMA ADPCM coder, 4 bits per sample
+ *
+ * The IMA/DVI ADPCM of the WAV format: each 16-bit sample is coded as a
+ * sign and three bits of its difference from a predictor, in units of a
+ * step that grows by about 1.1 on a large code and shrinks on a small
+ * one, over the 89 steps of the standard table. The predictor is the
+ * decoded signal, so \ref adpcm_encode() and \ref adpcm_decode() share
+ * \ref adpcm_step() and a decoder started from the same
+ * \ref adpcm_state gives back the encoder's reconstruction bit for bit.
+ *
+ */
+
+#ifndef DSP_ADPCM_H
+#define DSP_ADPCM_H
+
+#include <compiler.h>
+
+//! Entries of the step table
+#define ADPCM_STEPS     89
+
+//! Coder state of one channel
+struct adpcm_state {
+	//! Decoded value of the last sample
+	int16_t pred;
+	//! Step table index, 0..ADPCM_STEPS - 1
+	uint8_t index;
+};
+
+/**
+ * \brief Start a channel from zero, at the smallest step
+ */
+static inline void adpcm_reset(struct adpcm_state *st)
+{
+	st->pred = 0;
+	st->index = 0;
+}
+
+void adpcm_step(struct adpcm_state *st, uint8_t code);
+uint8_t adpcm_encode(struct adpcm_state *st, int16_t x);
+
+/**
+ * \brief Decode one 4-bit \a code
+ */
+static inline int16_t adpcm_decode(struct adpcm_state *st, uint8_t code)
+{
+	adpcm_step(st, code & 0x0f);
+	return st->pred;
+}
+
+#endif /* DSP_ADPCM_H */
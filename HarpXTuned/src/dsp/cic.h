@@ -0,0 +1,196 @@
+/**
+ * \file
+ *
+ * \brief Second order CIC decimator with droop compensation
+ *
+ * Decimates by OVERSAMPLING with two integrators at the input rate and two
+ * combs at the output rate. The integrators wrap; only the output has to
+ * fit the accumulator, which takes 12 + 2 * log2(OVERSAMPLING) bits. For 4x
+ * that is 16 bits, so the 4x build runs on 16-bit adds, 8x and 16x on
+ * 32-bit ones.
+ *
+ * The output is scaled to a gain of OVERSAMPLING, the same scale as the
+ * plain sum of OVERSAMPLING samples it replaces. A symmetric 3-tap FIR at
+ * the output rate, [-a, 1 + 2a, -a], lifts the CIC droop back up around
+ * a quarter of the output rate.
+ *
+ * A DC offset set with \ref cic_set_offset() is taken off in the second
+ * comb, one subtraction per output sample, so nothing downstream has to
+ * remove it.
+ *
+ * OVERSAMPLING must be a plain number, 4, 8 or 16: \ref cic_decimate() is
+ * unrolled with MREPEAT.
+ *
+ */
+
+#ifndef DSP_CIC_H
+#define DSP_CIC_H
+
+#include <compiler.h>
+#include <preprocessor.h>
+#include <conf_profile.h>
+#include "fixmath.h"
+
+#if OVERSAMPLING == 4
+#  define CIC_LOG2_R    2
+#  define CIC_HALF_R    2
+typedef uint16_t cic_acc_t;
+#elif OVERSAMPLING == 8
+#  define CIC_LOG2_R    3
+#  define CIC_HALF_R    4
+typedef uint32_t cic_acc_t;
+#else
+#  define CIC_LOG2_R    4
+#  define CIC_HALF_R    8
+typedef uint32_t cic_acc_t;
+#endif
+
+//! Samples from one sweep to the next in the input of \ref cic_decimate()
+#define CIC_STRIDE      PROFILE_SWEEP_CHANNELS
+
+//! Compensator coefficient a, Q8
+#ifndef CIC_COMP_ALPHA
+#  define CIC_COMP_ALPHA 28
+#endif
+
+//! Decimator and compensator state of one channel
+struct cic_state {
+	cic_acc_t i1;
+	cic_acc_t i2;
+	cic_acc_t c1;
+	cic_acc_t c2;
+	int16_t fir1;
+	int16_t fir2;
+	//! Offset taken off the comb output, at its scale
+	cic_acc_t offset;
+};
+
+/**
+ * \brief Set the input offset, in 1/16 input LSB, taken off the output
+ *
+ * The output before scaling carries OVERSAMPLING^2 times a constant input.
+ */
+static inline void cic_set_offset(struct cic_state *st, int16_t offset)
+{
+	st->offset = (cic_acc_t)((int32_t)offset << (2 * CIC_LOG2_R - 4));
+}
+
+/**
+ * \brief Run one input sample through the integrators
+ */
+static inline void cic_integrate(struct cic_state *st, int16_t x)
+{
+	st->i1 += (cic_acc_t)x;
+	st->i2 += st->i1;
+}
+
+/**
+ * \brief Run the combs, giving the decimated sample
+ *
+ * Call after every OVERSAMPLING integrator steps.
+ */
+static inline int16_t cic_comb(struct cic_state *st)
+{
+	cic_acc_t c1 = st->i2 - st->c1;
+	cic_acc_t y = c1 - st->c2 - st->offset;
+
+	st->c1 = st->i2;
+	st->c2 = c1;
+#if OVERSAMPLING == 4
+	return (int16_t)y >> CIC_LOG2_R;
+#else
+	return (int16_t)((int32_t)y >> CIC_LOG2_R);
+#endif
+}
+
+//! \internal One unrolled integrator step of \ref cic_decimate()
+#define CIC_STEP(k, in) \
+	i1 += (cic_acc_t)(in)[(k) * CIC_STRIDE]; \
+	i2 += i1;
+
+//! \internal Two unrolled integrator steps of \ref cic_decimate_pair()
+#define CIC_STEP_PAIR(k, unused) \
+	CIC_STEP(k, a) \
+	CIC_STEP(k, b)
+
+/**
+ * \brief Decimate OVERSAMPLING samples, one per sweep of CIC_STRIDE samples
+ * starting at \a in, as in \ref capture_sweep_t
+ *
+ * Same result as OVERSAMPLING cic_integrate() calls and a cic_comb(), with
+ * the integrators kept in registers.
+ */
+static inline int16_t cic_decimate(struct cic_state *st, const int16_t *in)
+{
+	cic_acc_t i1 = st->i1;
+	cic_acc_t i2 = st->i2;
+
+	MREPEAT(OVERSAMPLING, CIC_STEP, in)
+
+	st->i1 = i1;
+	st->i2 = i2;
+	return cic_comb(st);
+}
+
+/**
+ * \brief Decimate OVERSAMPLING samples taken alternately from two ADCs
+ *
+ * \a a and \a b each give OVERSAMPLING / 2 samples, one per sweep, with
+ * every sample of \a b taken after the one of \a a at the same index.
+ */
+static inline int16_t cic_decimate_pair(struct cic_state *st,
+		const int16_t *a, const int16_t *b)
+{
+	cic_acc_t i1 = st->i1;
+	cic_acc_t i2 = st->i2;
+
+	MREPEAT(CIC_HALF_R, CIC_STEP_PAIR, ~)
+
+	st->i1 = i1;
+	st->i2 = i2;
+	return cic_comb(st);
+}
+
+/**
+ * \brief Rescale the state for inputs 2^\a shift times as large
+ *
+ * Call between two decimated samples, before the first input at the new
+ * scale. Right after a comb only the next output still holds the samples
+ * before it, as R * i1 - c2 of its value, so c2 is moved to scale that
+ * part; the integrators may wrap as they please. The offset is left as
+ * it is.
+ *
+ * \param shift Log2 of the scale change, negative to scale down
+ */
+static inline void cic_rescale(struct cic_state *st, int8_t shift)
+{
+	cic_acc_t r_i1 = st->i1 << CIC_LOG2_R;
+#if OVERSAMPLING == 4
+	int16_t part = (int16_t)(r_i1 - st->c2);
+#else
+	int32_t part = (int32_t)(r_i1 - st->c2);
+#endif
+
+	if (shift > 0) {
+		part <<= shift;
+	} else {
+		part >>= -shift;
+	}
+	st->c2 = r_i1 - (cic_acc_t)part;
+}
+
+/**
+ * \brief Droop compensation, delays by one output sample
+ */
+static inline int16_t cic_compensate(struct cic_state *st, int16_t x)
+{
+	int32_t y = fixmath_mul16(st->fir1, 256 + 2 * CIC_COMP_ALPHA)
+			- (int32_t)CIC_COMP_ALPHA * ((int32_t)x + st->fir2);
+
+	st->fir2 = st->fir1;
+	st->fir1 = x;
+
+	return fixmath_sat16(y >> 8);
+}
+
+#endif /* DSP_CIC_H */
@@ -0,0 +1,227 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point radix-2 FFT
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <compiler.h>
+#include "fft.h"
+
+//! \internal CORDIC steps of \ref fft_phase()
+#define FFT_PHASE_STEPS 14
+
+//! \internal atan(2^-i), 65536 being a full turn
+static PROGMEM_DECLARE(uint16_t, fft_atan_table[FFT_PHASE_STEPS]) = {
+	8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1,
+};
+
+/**
+ * \brief Magnitude of a complex value, sqrt(re^2 + im^2)
+ *
+ * Bitwise integer square root, no division or multiply in the loop.
+ */
+uint16_t fft_mag(int16_t re, int16_t im)
+{
+	uint32_t pow = (uint32_t)fixmath_mul16(re, re)
+			+ (uint32_t)fixmath_mul16(im, im);
+	uint32_t bit = 1UL << 30;
+	uint32_t root = 0;
+
+	while (bit > pow) {
+		bit >>= 2;
+	}
+	while (bit) {
+		if (pow >= root + bit) {
+			pow -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)root;
+}
+
+/**
+ * \brief cos of a 16-bit phase, 65536 being a full turn, in Q15
+ *
+ * Linear interpolation between the table entries, for coefficients that
+ * do not fall on the FFT grid.
+ */
+q15_t fft_cos_phase(uint16_t phase)
+{
+	uint16_t i = phase >> (16 - FFT_LOG2_N_MAX);
+	int16_t frac = phase & ((1U << (16 - FFT_LOG2_N_MAX)) - 1);
+	q15_t a = fft_cos(i);
+	q15_t b = fft_cos((i + 1) & (FFT_N_MAX - 1));
+
+	return a + (q15_t)(((int32_t)(b - a) * frac) >> (16 - FFT_LOG2_N_MAX));
+}
+
+/**
+ * \brief Phase of a complex value, 65536 being a full turn
+ *
+ * CORDIC vectoring with shifts and adds only, to within two units. The
+ * value is first scaled to use the full 32 bits less the CORDIC gain.
+ */
+uint16_t fft_phase(int32_t re, int32_t im)
+{
+	uint16_t phase = 0;
+	uint8_t i;
+
+	if (!re && !im) {
+		return 0;
+	}
+	// Into the right half plane, where the rotations converge
+	if (re < 0) {
+		re = -re;
+		im = -im;
+		phase = 0x8000;
+	}
+	while (re >= (1L << 29) || im >= (1L << 29) || im < -(1L << 29)) {
+		re >>= 1;
+		im >>= 1;
+	}
+	while (re < (1L << 28) && im < (1L << 28) && im > -(1L << 28)) {
+		re <<= 1;
+		im <<= 1;
+	}
+
+	for (i = 0; i < FFT_PHASE_STEPS; i++) {
+		int32_t t = re;
+		uint16_t step = PROGMEM_READ_WORD(&fft_atan_table[i]);
+
+		if (im > 0) {
+			re += im >> i;
+			im -= t >> i;
+			phase += step;
+		} else {
+			re -= im >> i;
+			im += t >> i;
+			phase -= step;
+		}
+	}
+	return phase;
+}
+
+/**
+ * \brief Offset of the peak at bin \a k of \a mag from the bin, Q8 bins
+ *
+ * Vertex of the parabola through the bin and its neighbours. A peak picked
+ * by its neighbourhood may sit on a slope, so the offset is kept within
+ * half a bin.
+ */
+int16_t fft_vertex(const uint16_t *mag, uint16_t k)
+{
+	int32_t num = (int32_t)mag[k - 1] - mag[k + 1];
+	int32_t den = (int32_t)mag[k - 1] - 2 * (int32_t)mag[k] + mag[k + 1];
+	int16_t offset = 0;
+
+	if (den != 0) {
+		offset = (int16_t)((num * 128) / den);
+	}
+	if (offset > 128) {
+		offset = 128;
+	} else if (offset < -128) {
+		offset = -128;
+	}
+	return offset;
+}
+
+/**
+ * \brief In-place complex FFT of 2^\a log2n points
+ *
+ * Decimation in time, natural order in and out. The result is scaled by
+ * 2^-\a log2n.
+ */
+void fft_complex(fft_complex_t *x, uint8_t log2n)
+{
+	uint16_t n = 1U << log2n;
+	uint16_t half;
+	uint16_t i;
+	uint16_t j;
+	uint16_t k;
+	uint8_t shift;
+
+	// Bit reversed reordering
+	for (i = 1, j = 0; i < n; i++) {
+		uint16_t bit = n >> 1;
+
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			fft_complex_t t = x[i];
+			x[i] = x[j];
+			x[j] = t;
+		}
+	}
+
+	// Butterflies; shift turns the twiddle index k into table angle units
+	for (half = 1, shift = FFT_LOG2_N_MAX - 1; half < n;
+			half <<= 1, shift--) {
+		for (k = 0; k < half; k++) {
+			q15_t c = fft_cos(k << shift);
+			q15_t s = fft_sin(k << shift);
+
+			for (i = k; i < n; i += half << 1) {
+				fft_complex_t *a = &x[i];
+				fft_complex_t *b = &x[i + half];
+				int16_t tr = fixmath_shr15(fixmath_mac16(
+						fixmath_mul16(b->re, c), b->im, s));
+				int16_t ti = fixmath_shr15(fixmath_mul16(b->im, c)
+						- fixmath_mul16(b->re, s));
+
+				b->re = (int16_t)(((int32_t)a->re - tr) >> 1);
+				b->im = (int16_t)(((int32_t)a->im - ti) >> 1);
+				a->re = (int16_t)(((int32_t)a->re + tr) >> 1);
+				a->im = (int16_t)(((int32_t)a->im + ti) >> 1);
+			}
+		}
+	}
+}
+
+/**
+ * \brief Magnitude spectrum of 2^\a log2n real samples
+ *
+ * \param x The samples packed as 2^(\a log2n - 1) complex values, even
+ *          samples in re and odd samples in im. Destroyed.
+ * \param mag Receives bins 0 .. 2^(\a log2n - 1) - 1, scaled by 2^-\a log2n
+ * \param log2n Transform size, at most FFT_LOG2_N_MAX
+ */
+void fft_real_mag(fft_complex_t *x, uint16_t *mag, uint8_t log2n)
+{
+	uint16_t m = 1U << (log2n - 1);
+	uint8_t shift = FFT_LOG2_N_MAX - log2n;
+	uint16_t k;
+
+	fft_complex(x, log2n - 1);
+
+	mag[0] = fft_mag((int16_t)(((int32_t)x[0].re + x[0].im) >> 1), 0);
+
+	// Untangle the even/odd spectra, bins k and m - k at a time
+	for (k = 1; k <= m / 2; k++) {
+		const fft_complex_t *zk = &x[k];
+		const fft_complex_t *zm = &x[m - k];
+		q15_t c = fft_cos(k << shift);
+		q15_t s = fft_sin(k << shift);
+		int16_t er = (int16_t)(((int32_t)zk->re + zm->re) >> 1);
+		int16_t ei = (int16_t)(((int32_t)zk->im - zm->im) >> 1);
+		int16_t or = (int16_t)(((int32_t)zk->re - zm->re) >> 1);
+		int16_t oi = (int16_t)(((int32_t)zk->im + zm->im) >> 1);
+		int16_t p = fixmath_shr15(fixmath_mul16(oi, c)
+				- fixmath_mul16(or, s));
+		int16_t q = fixmath_shr15(fixmath_mac16(fixmath_mul16(or, c),
+				oi, s));
+
+		mag[k] = fft_mag((int16_t)(((int32_t)er + p) >> 1),
+				(int16_t)(((int32_t)ei - q) >> 1));
+		mag[m - k] = fft_mag((int16_t)(((int32_t)er - p) >> 1),
+				(int16_t)(((int32_t)ei + q) >> 1));
+	}
+}
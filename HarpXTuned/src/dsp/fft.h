@@ -0,0 +1,72 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point radix-2 FFT
+ *
+ * All data is Q15. Every butterfly stage halves its output, so a transform
+ * of 2^n points returns the spectrum scaled by 2^-n and can never overflow.
+ * Twiddle factors come from a quarter-wave sine table in flash; no floating
+ * point is used.
+ *
+ */
+
+#ifndef DSP_FFT_H
+#define DSP_FFT_H
+
+#include <compiler.h>
+#include <progmem.h>
+#include "fixmath.h"
+
+//! Largest supported real transform, sets the twiddle table resolution
+#define FFT_N_MAX       1024
+#define FFT_LOG2_N_MAX  10
+
+typedef struct {
+	q15_t re;
+	q15_t im;
+} fft_complex_t;
+
+extern PROGMEM_DECLARE(int16_t, fft_sin_table[FFT_N_MAX / 4 + 1]);
+
+/**
+ * \brief sin(2 pi a / FFT_N_MAX) in Q15, for 0 <= a <= FFT_N_MAX / 2
+ */
+static inline q15_t fft_sin(uint16_t a)
+{
+	if (a > FFT_N_MAX / 4) {
+		a = FFT_N_MAX / 2 - a;
+	}
+	return (q15_t)PROGMEM_READ_WORD(&fft_sin_table[a]);
+}
+
+/**
+ * \brief cos(2 pi a / FFT_N_MAX) in Q15, for 0 <= a < FFT_N_MAX
+ */
+static inline q15_t fft_cos(uint16_t a)
+{
+	if (a > FFT_N_MAX / 2) {
+		a = FFT_N_MAX - a;
+	}
+	if (a > FFT_N_MAX / 4) {
+		return -(q15_t)PROGMEM_READ_WORD(&fft_sin_table[a - FFT_N_MAX / 4]);
+	}
+	return (q15_t)PROGMEM_READ_WORD(&fft_sin_table[FFT_N_MAX / 4 - a]);
+}
+
+q15_t fft_cos_phase(uint16_t phase);
+
+/**
+ * \brief sin of a 16-bit phase, 65536 being a full turn, in Q15
+ */
+static inline q15_t fft_sin_phase(uint16_t phase)
+{
+	return fft_cos_phase(phase - 0x4000);
+}
+
+uint16_t fft_phase(int32_t re, int32_t im);
+void fft_complex(fft_complex_t *x, uint8_t log2n);
+void fft_real_mag(fft_complex_t *x, uint16_t *mag, uint8_t log2n);
+uint16_t fft_mag(int16_t re, int16_t im);
+int16_t fft_vertex(const uint16_t *mag, uint16_t k);
+
+#endif /* DSP_FFT_H */
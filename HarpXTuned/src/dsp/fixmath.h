@@ -0,0 +1,170 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point kernels of the DSP hot loops
+ *
+ * avr-gcc at -O1 widens both factors of a 16x16 bit product to 32 bits and
+ * calls its multiply routine, and shifts a 32-bit value by 15 one bit at a
+ * time. The kernels here do the products on MUL, MULS and MULSU and the
+ * Q15 products on FMULS, FMUL and FMULSU inline, and take Q30 to Q15 by
+ * moving bytes. Without the hardware multiplier, as in the native bench
+ * build, they are plain C with the same results.
+ *
+ */
+
+#ifndef DSP_FIXMATH_H
+#define DSP_FIXMATH_H
+
+#include <compiler.h>
+
+typedef int16_t q15_t;
+
+/**
+ * \brief Signed 16x16 bit product
+ */
+static inline int32_t fixmath_mul16(int16_t a, int16_t b)
+{
+#if XMEGA
+	int32_t r;
+	uint8_t zero;
+
+	// Atmel AVR201 muls16x16_32
+	__asm__ (
+		"clr    %[z]"           "\n\t"
+		"muls   %B[a], %B[b]"   "\n\t"
+		"movw   %C[r], r0"      "\n\t"
+		"mul    %A[a], %A[b]"   "\n\t"
+		"movw   %A[r], r0"      "\n\t"
+		"mulsu  %B[a], %A[b]"   "\n\t"
+		"sbc    %D[r], %[z]"    "\n\t"
+		"add    %B[r], r0"      "\n\t"
+		"adc    %C[r], r1"      "\n\t"
+		"adc    %D[r], %[z]"    "\n\t"
+		"mulsu  %B[b], %A[a]"   "\n\t"
+		"sbc    %D[r], %[z]"    "\n\t"
+		"add    %B[r], r0"      "\n\t"
+		"adc    %C[r], r1"      "\n\t"
+		"adc    %D[r], %[z]"    "\n\t"
+		"clr    r1"
+		: [r] "=&r" (r), [z] "=&r" (zero)
+		: [a] "a" (a), [b] "a" (b)
+		: "r0");
+	return r;
+#else
+	return (int32_t)a * b;
+#endif
+}
+
+/**
+ * \brief \a acc plus the product of \a a and \a b
+ */
+static inline int32_t fixmath_mac16(int32_t acc, int16_t a, int16_t b)
+{
+	return acc + fixmath_mul16(a, b);
+}
+
+/**
+ * \brief Bits 15 to 30 of \a x, (int16_t)(x >> 15) without the shift loop
+ */
+static inline int16_t fixmath_shr15(int32_t x)
+{
+	return (int16_t)(((uint16_t)((uint32_t)x >> 16) << 1)
+			| ((uint16_t)x >> 15));
+}
+
+/**
+ * \brief \a x clamped to 16 bits
+ */
+static inline int16_t fixmath_sat16(int32_t x)
+{
+	if (x > INT16_MAX) {
+		return INT16_MAX;
+	} else if (x < INT16_MIN) {
+		return INT16_MIN;
+	}
+	return (int16_t)x;
+}
+
+/**
+ * \brief Q15 product, rounded toward minus infinity
+ *
+ * -1 times -1 does not fit and gives -1.
+ */
+static inline q15_t fixmath_q15_mul(q15_t a, q15_t b)
+{
+#if XMEGA
+	q15_t r;
+	uint8_t t;
+	uint8_t zero;
+
+	// Atmel AVR201 fmuls16x16_32, keeping the upper 16 bits
+	__asm__ (
+		"clr    %[z]"           "\n\t"
+		"fmuls  %B[a], %B[b]"   "\n\t"
+		"movw   %A[r], r0"      "\n\t"
+		"fmul   %A[a], %A[b]"   "\n\t"
+		"adc    %A[r], %[z]"    "\n\t"
+		"mov    %[t], r1"       "\n\t"
+		"fmulsu %B[a], %A[b]"   "\n\t"
+		"sbc    %B[r], %[z]"    "\n\t"
+		"add    %[t], r0"       "\n\t"
+		"adc    %A[r], r1"      "\n\t"
+		"adc    %B[r], %[z]"    "\n\t"
+		"fmulsu %B[b], %A[a]"   "\n\t"
+		"sbc    %B[r], %[z]"    "\n\t"
+		"add    %[t], r0"       "\n\t"
+		"adc    %A[r], r1"      "\n\t"
+		"adc    %B[r], %[z]"    "\n\t"
+		"clr    r1"
+		: [r] "=&r" (r), [t] "=&r" (t), [z] "=&r" (zero)
+		: [a] "a" (a), [b] "a" (b)
+		: "r0");
+	return r;
+#else
+	return (q15_t)(((int32_t)a * b) >> 15);
+#endif
+}
+
+/**
+ * \brief Q15 product, rounded to nearest, halves up
+ *
+ * As \ref fixmath_q15_mul(), with bit 15 of the product added in.
+ */
+static inline q15_t fixmath_q15_mul_round(q15_t a, q15_t b)
+{
+#if XMEGA
+	q15_t r;
+	uint8_t t;
+	uint8_t zero;
+
+	__asm__ (
+		"clr    %[z]"           "\n\t"
+		"fmuls  %B[a], %B[b]"   "\n\t"
+		"movw   %A[r], r0"      "\n\t"
+		"fmul   %A[a], %A[b]"   "\n\t"
+		"adc    %A[r], %[z]"    "\n\t"
+		"mov    %[t], r1"       "\n\t"
+		"fmulsu %B[a], %A[b]"   "\n\t"
+		"sbc    %B[r], %[z]"    "\n\t"
+		"add    %[t], r0"       "\n\t"
+		"adc    %A[r], r1"      "\n\t"
+		"adc    %B[r], %[z]"    "\n\t"
+		"fmulsu %B[b], %A[a]"   "\n\t"
+		"sbc    %B[r], %[z]"    "\n\t"
+		"add    %[t], r0"       "\n\t"
+		"adc    %A[r], r1"      "\n\t"
+		"adc    %B[r], %[z]"    "\n\t"
+		"lsl    %[t]"           "\n\t"
+		"adc    %A[r], %[z]"    "\n\t"
+		"adc    %B[r], %[z]"    "\n\t"
+		"clr    r1"
+		: [r] "=&r" (r), [t] "=&r" (t), [z] "=&r" (zero)
+		: [a] "a" (a), [b] "a" (b)
+		: "r0");
+	return r;
+#else
+	return (q15_t)(((int32_t)a * b + (1L << 14)) >> 15);
+#endif
+}
+
+#endif /* DSP_FIXMATH_H */
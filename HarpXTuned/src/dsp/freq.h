@@ -0,0 +1,19 @@
+/**
+ * \file
+ *
+ * \brief Frequencies as the analysis engines give them
+ *
+ */
+
+#ifndef DSP_FREQ_H
+#define DSP_FREQ_H
+
+#include <compiler.h>
+
+//! Frequency in Hz, unsigned Q16.16
+typedef uint32_t pitch_hz_t;
+
+//! Convert an integer number of Hz to \ref pitch_hz_t
+#define PITCH_HZ(hz)    ((pitch_hz_t)(hz) << 16)
+
+#endif /* DSP_FREQ_H */
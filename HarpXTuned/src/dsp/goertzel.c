@@ -0,0 +1,80 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point Goertzel resonator
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <compiler.h>
+#include "goertzel.h"
+
+/**
+ * \brief Set a resonator to \a phase, 65536 being the sample rate, and
+ * clear it
+ */
+void goertzel_bin_set(struct goertzel_bin *bin, uint16_t phase)
+{
+	bin->cos = fft_cos_phase(phase);
+	bin->sin = fft_sin_phase(phase);
+	goertzel_clear(bin);
+}
+
+/**
+ * \brief Magnitude of a resonator at the end of a block, then clear it
+ */
+uint32_t goertzel_mag(struct goertzel_bin *bin)
+{
+	int32_t s1 = bin->s1;
+	int32_t s2 = bin->s2;
+	uint8_t shift = 0;
+	int16_t re;
+	int16_t im;
+
+	while (s1 >= (1L << 14) || s1 < -(1L << 14)
+			|| s2 >= (1L << 14) || s2 < -(1L << 14)) {
+		s1 >>= 1;
+		s2 >>= 1;
+		shift++;
+	}
+	re = (int16_t)s1 - fixmath_q15_mul((int16_t)s2, bin->cos);
+	im = fixmath_q15_mul((int16_t)s2, bin->sin);
+
+	goertzel_clear(bin);
+	return (uint32_t)fft_mag(re, im) << shift;
+}
+
+/**
+ * \brief Offset of a peak from the middle of three bins half a bin apart,
+ * Q8 half bins
+ *
+ * Vertex of the parabola through the magnitudes, within one half bin
+ * either way; if the middle bin is not above the line through the outer
+ * ones, the louder side.
+ */
+int16_t goertzel_vertex(uint32_t lo, uint32_t mid, uint32_t hi)
+{
+	int32_t num;
+	int32_t den;
+	int16_t offset;
+
+	while ((mid | lo | hi) >= (1UL << 22)) {
+		mid >>= 1;
+		lo >>= 1;
+		hi >>= 1;
+	}
+	num = (int32_t)lo - (int32_t)hi;
+	den = (int32_t)lo - 2 * (int32_t)mid + (int32_t)hi;
+	if (den >= 0) {
+		return (hi > lo) ? 256 : -256;
+	}
+	offset = (int16_t)((num * 128) / den);
+	if (offset > 256) {
+		offset = 256;
+	} else if (offset < -256) {
+		offset = -256;
+	}
+	return offset;
+}
@@ -0,0 +1,57 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point Goertzel resonator
+ *
+ * One DFT bin evaluated sample by sample, s0 = x + 2 cos(w) s1 - s2, with
+ * 32-bit state and Q15 coefficients from \ref fft.h. After a block of N
+ * samples \ref goertzel_mag() gives the magnitude of the bin at w, scaled
+ * by N / 2 for a sine of amplitude 1, and starts the next block.
+ *
+ */
+
+#ifndef DSP_GOERTZEL_H
+#define DSP_GOERTZEL_H
+
+#include <compiler.h>
+#include "fft.h"
+
+//! One resonator
+struct goertzel_bin {
+	q15_t cos;
+	q15_t sin;
+	int32_t s1;
+	int32_t s2;
+};
+
+/**
+ * \brief One resonator step
+ *
+ * cos(w) s1 is split into two 16x16 bit products so the state can be wider
+ * than 16 bits without a 32x32 bit multiply.
+ */
+static inline void goertzel_step(struct goertzel_bin *bin, int32_t x)
+{
+	int32_t s1 = bin->s1;
+	int32_t p = fixmath_mul16(fixmath_shr15(s1), bin->cos)
+			+ (fixmath_mul16((int16_t)(s1 & 0x7fff), bin->cos) >> 15);
+	int32_t s0 = x + 2 * p - bin->s2;
+
+	bin->s2 = s1;
+	bin->s1 = s0;
+}
+
+/**
+ * \brief Drop the partial block of a resonator
+ */
+static inline void goertzel_clear(struct goertzel_bin *bin)
+{
+	bin->s1 = 0;
+	bin->s2 = 0;
+}
+
+void goertzel_bin_set(struct goertzel_bin *bin, uint16_t phase);
+uint32_t goertzel_mag(struct goertzel_bin *bin);
+int16_t goertzel_vertex(uint32_t lo, uint32_t mid, uint32_t hi);
+
+#endif /* DSP_GOERTZEL_H */
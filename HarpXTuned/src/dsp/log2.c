@@ -0,0 +1,47 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point base 2 logarithm
+ *
+ */
+
+#include "fixmath.h"
+#include "log2.h"
+
+//! \internal Minimax polynomial of log2(1 + m) - m, m^1 .. m^5, Q15
+#define LOG2_C1         14484
+#define LOG2_C2         (-23243)
+#define LOG2_C3         13591
+#define LOG2_C4         (-6272)
+#define LOG2_C5         1439
+
+//! \internal Q15 product, rounded to nearest
+#define LOG2_MUL(a, m)  fixmath_q15_mul_round(a, m)
+
+/**
+ * \brief log2(\a x) in Q16.16
+ *
+ * \param x Argument, not 0. For a fixed-point argument with n fraction
+ * bits, subtract n * LOG2_ONE from the result.
+ */
+log2_t log2_fix(uint32_t x)
+{
+	uint8_t shift;
+	int16_t m;
+	int16_t p;
+
+	Assert(x);
+
+	// x = 2^(31 - shift) * (1 + m), m in Q15
+	shift = clz(x);
+	m = (int16_t)(((x << shift) >> 16) & 0x7fff);
+
+	p = LOG2_C5;
+	p = LOG2_C4 + LOG2_MUL(p, m);
+	p = LOG2_C3 + LOG2_MUL(p, m);
+	p = LOG2_C2 + LOG2_MUL(p, m);
+	p = LOG2_C1 + LOG2_MUL(p, m);
+	p = m + LOG2_MUL(p, m);
+
+	return ((log2_t)(31 - shift) << 16) + ((uint16_t)p << 1);
+}
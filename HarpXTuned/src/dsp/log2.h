@@ -0,0 +1,26 @@
+/**
+ * \file
+ *
+ * \brief Fixed-point base 2 logarithm
+ *
+ * \ref log2_fix() normalises its argument with \ref clz() and evaluates a
+ * fifth order polynomial for log2(1 + m), 0 <= m < 1, in Q15 with Horner's
+ * scheme: five 16x16 bit products, no table and no floating point. The
+ * result is within 1.1e-4 of log2, 0.13 cents.
+ *
+ */
+
+#ifndef DSP_LOG2_H
+#define DSP_LOG2_H
+
+#include <compiler.h>
+
+//! log2 in Q16.16
+typedef int32_t log2_t;
+
+//! One octave in \ref log2_t
+#define LOG2_ONE        (1L << 16)
+
+log2_t log2_fix(uint32_t x);
+
+#endif /* DSP_LOG2_H */
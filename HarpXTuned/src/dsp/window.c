@@ -0,0 +1,60 @@
+/**
+ * \file
+ *
+ * \brief Analysis windows from flash
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <compiler.h>
+#include "window.h"
+
+/**
+ * \internal
+ * \brief Remove \a mean from \a v and scale it up by \a shift, saturated
+ */
+static inline q15_t window_level(int16_t v, int16_t mean, uint8_t shift)
+{
+	v -= mean;
+	if (v > (INT16_MAX >> shift)) {
+		return INT16_MAX;
+	} else if (v < (INT16_MIN >> shift)) {
+		return INT16_MIN;
+	}
+	return v << shift;
+}
+
+/**
+ * \brief Remove the mean of 2^\a log2_n samples, scale and window them, in
+ * place
+ *
+ * The table is read rising through the first half of the block and
+ * falling through the second, so there is no index arithmetic per sample.
+ *
+ * \param mean Mean of the samples
+ * \param shift Left shift taking the samples to full Q15 scale
+ */
+void window_apply(q15_t *x, uint8_t log2_n, int16_t mean, uint8_t shift)
+{
+	uint16_t half = 1U << (log2_n - 1);
+	uint8_t step = 1U << (WINDOW_LOG2_N_MAX - log2_n);
+	const uint16_t *w = window_table;
+	uint16_t i;
+
+	Assert(log2_n > 0 && log2_n <= WINDOW_LOG2_N_MAX);
+
+	for (i = 0; i < half; i++) {
+		*x = fixmath_q15_mul(window_level(*x, mean, shift),
+				(q15_t)PROGMEM_READ_WORD(w));
+		x++;
+		w += step;
+	}
+	for (i = 0; i < half; i++) {
+		*x = fixmath_q15_mul(window_level(*x, mean, shift),
+				(q15_t)PROGMEM_READ_WORD(w));
+		x++;
+		w -= step;
+	}
+}
@@ -0,0 +1,64 @@
+/**
+ * \file
+ *
+ * \brief Analysis windows from flash
+ *
+ * The selected window lives in flash as the first half of a periodic
+ * table of WINDOW_N_MAX points, see window_table.c; smaller transforms
+ * step through it. \ref window_apply() removes the mean, scales and
+ * windows a block in one pass, with the product on the FMULS family of
+ * fractional multiplies on the XMEGA, see \ref fixmath_q15_mul().
+ *
+ */
+
+#ifndef DSP_WINDOW_H
+#define DSP_WINDOW_H
+
+#include <compiler.h>
+#include <progmem.h>
+#include "fft.h"
+
+//! \name Windows
+//@{
+//! Main lobe 4 bins wide, sidelobes at -31 dB
+#define WINDOW_HANN     0
+//! Main lobe 6 bins wide, sidelobes at -58 dB
+#define WINDOW_BLACKMAN 1
+//@}
+
+#ifndef WINDOW_TYPE
+#  define WINDOW_TYPE WINDOW_HANN
+#endif
+
+//! Largest window, must match window_table.c
+#define WINDOW_N_MAX        FFT_N_MAX
+#define WINDOW_LOG2_N_MAX   FFT_LOG2_N_MAX
+
+//! Half width of the main lobe in bins; a constant leaks into the bins
+//! below it
+#if WINDOW_TYPE == WINDOW_HANN
+#  define WINDOW_LOBE       2
+#elif WINDOW_TYPE == WINDOW_BLACKMAN
+#  define WINDOW_LOBE       3
+#else
+#  error "Unknown WINDOW_TYPE"
+#endif
+
+extern PROGMEM_DECLARE(uint16_t, window_table[WINDOW_N_MAX / 2 + 1]);
+
+/**
+ * \brief Value \a i of the window of 2^\a log2_n points, Q15
+ */
+static inline q15_t window_coef(uint16_t i, uint8_t log2_n)
+{
+	uint16_t a = i << (WINDOW_LOG2_N_MAX - log2_n);
+
+	if (a > WINDOW_N_MAX / 2) {
+		a = WINDOW_N_MAX - a;
+	}
+	return (q15_t)PROGMEM_READ_WORD(&window_table[a]);
+}
+
+void window_apply(q15_t *x, uint8_t log2_n, int16_t mean, uint8_t shift);
+
+#endif /* DSP_WINDOW_H */
@@ -0,0 +1,155 @@
+/**
+ * \file
+ *
+ * \brief Window tables of dsp/window.h
+ *
+ * The first half of each periodic window of WINDOW_N_MAX points, to its
+ * peak, in Q15. Generated by tools/window_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "window.h"
+
+#if WINDOW_TYPE == WINDOW_HANN
+// Hann
+PROGMEM_DECLARE(uint16_t, window_table[WINDOW_N_MAX / 2 + 1]) = {
+	    0,     0,     1,     3,     5,     8,    11,    15,
+	   20,    25,    31,    37,    44,    52,    60,    69,
+	   79,    89,   100,   111,   123,   136,   149,   163,
+	  177,   192,   208,   224,   241,   259,   277,   295,
+	  315,   335,   355,   376,   398,   420,   443,   467,
+	  491,   516,   541,   567,   593,   621,   648,   677,
+	  705,   735,   765,   796,   827,   859,   891,   924,
+	  958,   992,  1027,  1062,  1098,  1134,  1171,  1209,
+	 1247,  1286,  1325,  1365,  1406,  1447,  1488,  1530,
+	 1573,  1616,  1660,  1704,  1749,  1795,  1841,  1887,
+	 1935,  1982,  2030,  2079,  2128,  2178,  2229,  2279,
+	 2331,  2383,  2435,  2488,  2542,  2596,  2650,  2706,
+	 2761,  2817,  2874,  2931,  2989,  3047,  3105,  3165,
+	 3224,  3284,  3345,  3406,  3468,  3530,  3592,  3655,
+	 3719,  3783,  3847,  3912,  3978,  4044,  4110,  4177,
+	 4244,  4312,  4380,  4449,  4518,  4587,  4657,  4728,
+	 4799,  4870,  4942,  5014,  5086,  5159,  5233,  5307,
+	 5381,  5456,  5531,  5606,  5682,  5759,  5835,  5912,
+	 5990,  6068,  6146,  6225,  6304,  6383,  6463,  6543,
+	 6624,  6705,  6786,  6868,  6950,  7032,  7115,  7198,
+	 7281,  7365,  7449,  7534,  7618,  7703,  7789,  7875,
+	 7961,  8047,  8134,  8221,  8308,  8396,  8484,  8572,
+	 8660,  8749,  8838,  8928,  9017,  9107,  9197,  9288,
+	 9379,  9470,  9561,  9652,  9744,  9836,  9929, 10021,
+	10114, 10207, 10300, 10393, 10487, 10581, 10675, 10770,
+	10864, 10959, 11054, 11149, 11244, 11340, 11436, 11532,
+	11628, 11724, 11820, 11917, 12014, 12111, 12208, 12305,
+	12403, 12500, 12598, 12696, 12794, 12892, 12990, 13089,
+	13187, 13286, 13385, 13484, 13583, 13682, 13781, 13880,
+	13980, 14079, 14179, 14278, 14378, 14478, 14578, 14678,
+	14778, 14878, 14978, 15078, 15178, 15279, 15379, 15479,
+	15580, 15680, 15780, 15881, 15981, 16082, 16182, 16283,
+	16383, 16484, 16585, 16685, 16786, 16886, 16987, 17087,
+	17187, 17288, 17388, 17488, 17589, 17689, 17789, 17889,
+	17989, 18089, 18189, 18289, 18389, 18489, 18588, 18688,
+	18787, 18887, 18986, 19085, 19184, 19283, 19382, 19481,
+	19580, 19678, 19777, 19875, 19973, 20071, 20169, 20267,
+	20364, 20462, 20559, 20656, 20753, 20850, 20947, 21043,
+	21139, 21235, 21331, 21427, 21523, 21618, 21713, 21808,
+	21903, 21997, 22092, 22186, 22280, 22374, 22467, 22560,
+	22653, 22746, 22838, 22931, 23023, 23115, 23206, 23297,
+	23388, 23479, 23570, 23660, 23750, 23839, 23929, 24018,
+	24107, 24195, 24283, 24371, 24459, 24546, 24633, 24720,
+	24806, 24892, 24978, 25064, 25149, 25233, 25318, 25402,
+	25486, 25569, 25652, 25735, 25817, 25899, 25981, 26062,
+	26143, 26224, 26304, 26384, 26463, 26542, 26621, 26699,
+	26777, 26855, 26932, 27008, 27085, 27161, 27236, 27311,
+	27386, 27460, 27534, 27608, 27681, 27753, 27825, 27897,
+	27968, 28039, 28110, 28180, 28249, 28318, 28387, 28455,
+	28523, 28590, 28657, 28723, 28789, 28855, 28920, 28984,
+	29048, 29112, 29175, 29237, 29299, 29361, 29422, 29483,
+	29543, 29602, 29662, 29720, 29778, 29836, 29893, 29950,
+	30006, 30061, 30117, 30171, 30225, 30279, 30332, 30384,
+	30436, 30488, 30538, 30589, 30639, 30688, 30737, 30785,
+	30832, 30880, 30926, 30972, 31018, 31063, 31107, 31151,
+	31194, 31237, 31279, 31320, 31361, 31402, 31442, 31481,
+	31520, 31558, 31596, 31633, 31669, 31705, 31740, 31775,
+	31809, 31843, 31876, 31908, 31940, 31971, 32002, 32032,
+	32062, 32090, 32119, 32146, 32174, 32200, 32226, 32251,
+	32276, 32300, 32324, 32347, 32369, 32391, 32412, 32432,
+	32452, 32472, 32490, 32508, 32526, 32543, 32559, 32575,
+	32590, 32604, 32618, 32631, 32644, 32656, 32667, 32678,
+	32688, 32698, 32707, 32715, 32723, 32730, 32736, 32742,
+	32747, 32752, 32756, 32759, 32762, 32764, 32766, 32767,
+	32767,
+};
+#elif WINDOW_TYPE == WINDOW_BLACKMAN
+// Blackman
+PROGMEM_DECLARE(uint16_t, window_table[WINDOW_N_MAX / 2 + 1]) = {
+	    0,     0,     0,     1,     2,     3,     4,     5,
+	    7,     9,    11,    13,    16,    19,    22,    25,
+	   29,    32,    36,    40,    45,    49,    54,    59,
+	   64,    70,    76,    82,    88,    94,   101,   108,
+	  115,   123,   130,   138,   146,   155,   163,   172,
+	  181,   191,   200,   210,   221,   231,   242,   253,
+	  264,   275,   287,   299,   311,   324,   336,   349,
+	  363,   376,   390,   404,   419,   433,   448,   464,
+	  479,   495,   511,   528,   545,   562,   579,   597,
+	  615,   633,   651,   670,   690,   709,   729,   749,
+	  770,   790,   811,   833,   855,   877,   899,   922,
+	  945,   969,   993,  1017,  1041,  1066,  1091,  1117,
+	 1143,  1169,  1196,  1223,  1250,  1278,  1306,  1335,
+	 1364,  1393,  1423,  1453,  1483,  1514,  1545,  1577,
+	 1609,  1641,  1674,  1707,  1741,  1775,  1810,  1844,
+	 1880,  1915,  1952,  1988,  2025,  2062,  2100,  2139,
+	 2177,  2216,  2256,  2296,  2336,  2377,  2419,  2460,
+	 2503,  2545,  2589,  2632,  2676,  2721,  2766,  2811,
+	 2857,  2904,  2950,  2998,  3046,  3094,  3143,  3192,
+	 3242,  3292,  3342,  3394,  3445,  3497,  3550,  3603,
+	 3657,  3711,  3766,  3821,  3876,  3932,  3989,  4046,
+	 4104,  4162,  4220,  4279,  4339,  4399,  4460,  4521,
+	 4583,  4645,  4708,  4771,  4834,  4899,  4963,  5029,
+	 5094,  5161,  5227,  5295,  5362,  5431,  5500,  5569,
+	 5639,  5709,  5780,  5852,  5924,  5996,  6069,  6142,
+	 6216,  6291,  6366,  6441,  6517,  6594,  6671,  6749,
+	 6827,  6905,  6984,  7064,  7144,  7225,  7306,  7387,
+	 7469,  7552,  7635,  7719,  7803,  7887,  7972,  8058,
+	 8144,  8231,  8318,  8405,  8493,  8582,  8670,  8760,
+	 8850,  8940,  9031,  9122,  9214,  9306,  9399,  9492,
+	 9585,  9679,  9774,  9869,  9964, 10060, 10156, 10252,
+	10350, 10447, 10545, 10643, 10742, 10841, 10941, 11040,
+	11141, 11242, 11343, 11444, 11546, 11648, 11751, 11854,
+	11957, 12061, 12165, 12270, 12374, 12480, 12585, 12691,
+	12797, 12903, 13010, 13117, 13225, 13333, 13441, 13549,
+	13658, 13767, 13876, 13985, 14095, 14205, 14315, 14426,
+	14537, 14648, 14759, 14870, 14982, 15094, 15206, 15319,
+	15431, 15544, 15657, 15770, 15883, 15997, 16111, 16224,
+	16338, 16453, 16567, 16681, 16796, 16911, 17025, 17140,
+	17255, 17370, 17486, 17601, 17716, 17832, 17947, 18063,
+	18178, 18294, 18410, 18525, 18641, 18757, 18873, 18988,
+	19104, 19220, 19335, 19451, 19567, 19682, 19798, 19913,
+	20029, 20144, 20260, 20375, 20490, 20605, 20720, 20835,
+	20949, 21064, 21178, 21292, 21406, 21520, 21634, 21748,
+	21861, 21974, 22087, 22200, 22313, 22425, 22537, 22649,
+	22761, 22872, 22983, 23094, 23205, 23315, 23425, 23535,
+	23644, 23753, 23862, 23971, 24079, 24187, 24294, 24401,
+	24508, 24614, 24720, 24825, 24931, 25035, 25140, 25244,
+	25347, 25450, 25553, 25655, 25756, 25858, 25958, 26059,
+	26158, 26258, 26356, 26455, 26553, 26650, 26746, 26843,
+	26938, 27033, 27128, 27222, 27315, 27408, 27500, 27591,
+	27682, 27773, 27863, 27952, 28040, 28128, 28215, 28302,
+	28388, 28473, 28557, 28641, 28725, 28807, 28889, 28970,
+	29050, 29130, 29209, 29287, 29365, 29442, 29518, 29593,
+	29667, 29741, 29814, 29886, 29958, 30028, 30098, 30167,
+	30236, 30303, 30370, 30436, 30500, 30565, 30628, 30690,
+	30752, 30813, 30873, 30932, 30990, 31047, 31104, 31160,
+	31214, 31268, 31321, 31373, 31424, 31474, 31524, 31572,
+	31620, 31666, 31712, 31757, 31801, 31843, 31885, 31926,
+	31966, 32006, 32044, 32081, 32117, 32153, 32187, 32220,
+	32253, 32284, 32315, 32344, 32373, 32400, 32427, 32452,
+	32477, 32500, 32523, 32545, 32565, 32585, 32603, 32621,
+	32638, 32653, 32668, 32682, 32694, 32706, 32716, 32726,
+	32735, 32742, 32749, 32754, 32759, 32762, 32765, 32766,
+	32767,
+};
+#else
+#  error "Unknown WINDOW_TYPE"
+#endif
@@ -0,0 +1,72 @@
+/**
+ * \file
+ *
+ * \brief YIN difference function and period search
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <compiler.h>
+#include "yin.h"
+
+/**
+ * \brief Period of the first dip of \a d, Q8 lags, or 0 if there is none
+ *
+ * \param d Difference function, lags \a min_lag to \a max_lag used
+ * \param threshold Dip threshold of d over its mean from \a min_lag, Q8
+ */
+uint16_t yin_period(const uint32_t *d, uint8_t min_lag, uint8_t max_lag,
+		uint8_t threshold)
+{
+	uint32_t sum = 0;
+	uint32_t a;
+	uint32_t b;
+	uint32_t c;
+	int32_t num;
+	int32_t den;
+	int16_t offset = 0;
+	uint8_t tau;
+
+	for (tau = min_lag; tau <= max_lag; tau++) {
+		uint32_t v = d[tau] >> 7;
+
+		sum += v;
+		if (v * (tau - min_lag + 1) < (sum >> 8) * threshold) {
+			break;
+		}
+	}
+	if (tau <= min_lag || tau >= max_lag) {
+		return 0;
+	}
+	while (tau < max_lag - 1 && d[tau + 1] < d[tau]) {
+		tau++;
+	}
+
+	// Vertex of the parabola through the dip and its neighbours
+	a = d[tau - 1] >> 8;
+	b = d[tau] >> 8;
+	c = d[tau + 1] >> 8;
+	num = (int32_t)a - (int32_t)c;
+	den = (int32_t)a - 2 * (int32_t)b + (int32_t)c;
+	if (den > 0) {
+		offset = (int16_t)((num * 128) / den);
+		if (offset > 128) {
+			offset = 128;
+		} else if (offset < -128) {
+			offset = -128;
+		}
+	}
+	return ((uint16_t)tau << 8) + offset;
+}
+
+/**
+ * \brief \a rate / \a period in Hz, from a Q8 period
+ */
+pitch_hz_t yin_hz(uint16_t rate, uint16_t period)
+{
+	uint32_t q = ((uint32_t)rate << 16) / period;
+
+	return (q << 8) + (((((uint32_t)rate << 16) % period) << 8) / period);
+}
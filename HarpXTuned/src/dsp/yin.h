@@ -0,0 +1,33 @@
+/**
+ * \file
+ *
+ * \brief YIN difference function and period search
+ *
+ * d(tau) is kept as a leaky sum of (x[t] - x[t - tau])^2 / 16 per lag,
+ * updated one lag at a time with \ref yin_update(). \ref yin_period()
+ * finds the first dip of the cumulative mean normalised d below a
+ * threshold and refines it with a parabola; \ref yin_hz() turns the period
+ * into a frequency.
+ *
+ */
+
+#ifndef DSP_YIN_H
+#define DSP_YIN_H
+
+#include <compiler.h>
+#include "fixmath.h"
+#include "freq.h"
+
+/**
+ * \brief Leak one lag of d by 2^-\a leak and add the difference \a e
+ */
+static inline void yin_update(uint32_t *d, int16_t e, uint8_t leak)
+{
+	*d += ((uint32_t)fixmath_mul16(e, e) >> 4) - (*d >> leak);
+}
+
+uint16_t yin_period(const uint32_t *d, uint8_t min_lag, uint8_t max_lag,
+		uint8_t threshold);
+pitch_hz_t yin_hz(uint16_t rate, uint16_t period);
+
+#endif /* DSP_YIN_H */
@@ -0,0 +1,74 @@
+/**
+ * \file
+ *
+ * \brief Event system routing
+ *
+ */
+
+#include <asf.h>
+#include "capture.h"
+#include "evsys.h"
+#include "prof.h"
+#include "sync.h"
+#include "timebase.h"
+#include "tone.h"
+
+#if TONE_EVENT_CH == CAPTURE_EVENT_CH || TONE_EVENT_CH == CAPTURE_EVENT_CH_B \
+		|| TIMEBASE_EVENT_CH == CAPTURE_EVENT_CH \
+		|| TIMEBASE_EVENT_CH == CAPTURE_EVENT_CH_B \
+		|| TIMEBASE_EVENT_CH == TONE_EVENT_CH \
+		|| SYNC_EVENT_CH == CAPTURE_EVENT_CH \
+		|| SYNC_EVENT_CH == CAPTURE_EVENT_CH_B \
+		|| SYNC_EVENT_CH == TONE_EVENT_CH || SYNC_EVENT_CH == TIMEBASE_EVENT_CH \
+		|| TIMEBASE_CARRY_EVENT_CH == CAPTURE_EVENT_CH \
+		|| TIMEBASE_CARRY_EVENT_CH == CAPTURE_EVENT_CH_B \
+		|| TIMEBASE_CARRY_EVENT_CH == TONE_EVENT_CH \
+		|| TIMEBASE_CARRY_EVENT_CH == TIMEBASE_EVENT_CH \
+		|| TIMEBASE_CARRY_EVENT_CH == SYNC_EVENT_CH \
+		|| PROF_CARRY_EVENT_CH == CAPTURE_EVENT_CH \
+		|| PROF_CARRY_EVENT_CH == CAPTURE_EVENT_CH_B \
+		|| PROF_CARRY_EVENT_CH == TONE_EVENT_CH \
+		|| PROF_CARRY_EVENT_CH == TIMEBASE_EVENT_CH \
+		|| PROF_CARRY_EVENT_CH == SYNC_EVENT_CH \
+		|| PROF_CARRY_EVENT_CH == TIMEBASE_CARRY_EVENT_CH
+#  error "Event channels must not be shared"
+#endif
+
+//! \internal Channels routed, bit n for channel n
+static uint8_t evsys_routed;
+
+/**
+ * \brief Route \a source to event channel \a ch
+ *
+ * Switches the event system on with its first channel. A channel is
+ * routed by one user only; routing it again is only allowed with the
+ * same source.
+ */
+void evsys_route(uint8_t ch, EVSYS_CHMUX_t source)
+{
+	volatile uint8_t *mux = &EVSYS.CH0MUX + ch;
+
+	Assert(ch < EVSYS_CHANNELS);
+	Assert(!(evsys_routed & (1 << ch)) || *mux == source);
+
+	if (!evsys_routed) {
+		sysclk_enable_module(SYSCLK_PORT_GEN, SYSCLK_EVSYS);
+	}
+	evsys_routed |= 1 << ch;
+	*mux = source;
+}
+
+/**
+ * \brief Disconnect event channel \a ch, and the event system with the
+ * last one
+ */
+void evsys_release(uint8_t ch)
+{
+	Assert(ch < EVSYS_CHANNELS);
+
+	(&EVSYS.CH0MUX)[ch] = EVSYS_CHMUX_OFF_gc;
+	evsys_routed &= ~(1 << ch);
+	if (!evsys_routed) {
+		sysclk_disable_module(SYSCLK_PORT_GEN, SYSCLK_EVSYS);
+	}
+}
@@ -0,0 +1,38 @@
+/**
+ * \file
+ *
+ * \brief Event system routing
+ *
+ * The sampling paths are chained in hardware: a timer event starts each
+ * conversion and the conversion result triggers the DMA, so no interrupt
+ * runs per sample. The event channels are shared out here:
+ * - CAPTURE_EVENT_CH, TCC1 overflow to the ADC sweeps, and
+ *   CAPTURE_EVENT_CH_B, TCC1 compare A to ADCB in CAPTURE_ADC_DUAL_FAST
+ * - TONE_EVENT_CH, TCD0 overflow to the DACB conversions
+ * - TIMEBASE_EVENT_CH, the 1 MHz clock prescaler output to TCF0
+ * - SYNC_EVENT_CH, the \ref sync.h line of a chain slave to a TCF0 and
+ *   TCF1 capture
+ * - TIMEBASE_CARRY_EVENT_CH, TCF0 overflow to TCF1, and
+ *   PROF_CARRY_EVENT_CH, TCE1 overflow to TCD1, see \ref tc32.h
+ *
+ * Each user routes its channel with \ref evsys_route() and sets up its
+ * sink, the ADC, DAC or timer, with that channel number. The DMA is
+ * triggered by the ADC and DAC directly and needs no event channel.
+ *
+ */
+
+#ifndef EVSYS_H
+#define EVSYS_H
+
+#include <compiler.h>
+
+//! Event channels of the XMEGA A1
+#define EVSYS_CHANNELS          8
+
+//! Timer clock source counting the events of channel \a ch
+#define EVSYS_TC_CLKSEL(ch)     ((TC_CLKSEL_t)(TC_CLKSEL_EVCH0_gc + (ch)))
+
+void evsys_route(uint8_t ch, EVSYS_CHMUX_t source);
+void evsys_release(uint8_t ch);
+
+#endif /* EVSYS_H */
@@ -0,0 +1,42 @@
+/**
+ * \file
+ *
+ * \brief Capture to analysis block queue
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <asf.h>
+#include "frameq.h"
+
+struct frameq frameq;
+
+/**
+ * \brief Empty the queue and clear the overrun counter
+ *
+ * Only call while capture is stopped.
+ */
+void frameq_reset(void)
+{
+	frameq_ring_reset(&frameq.ring);
+	frameq.overruns = 0;
+}
+
+/**
+ * \brief Number of blocks dropped since the last reset
+ *
+ * The counter is written by the capture interrupt, so it is read until two
+ * reads agree instead of masking interrupts.
+ */
+uint16_t frameq_get_overruns(void)
+{
+	uint16_t count;
+
+	do {
+		count = frameq.overruns;
+	} while (count != frameq.overruns);
+
+	return count;
+}
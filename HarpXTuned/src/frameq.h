@@ -0,0 +1,125 @@
+/**
+ * \file
+ *
+ * \brief Capture to analysis block queue
+ *
+ * A \ref ring.h ring of FRAMEQ_SLOTS capture blocks. The capture
+ * interrupt fills the slot at the head while the main loop analyses the
+ * slot at the tail, neither of them masking interrupts.
+ *
+ * When the analysis falls behind and the queue is full, new blocks are
+ * dropped and counted in \ref frameq_get_overruns().
+ *
+ * Only the streaming engines read the frames of a block; the batch engines
+ * read their windows from the ring in place. Without streaming channels
+ * the blocks carry their stamps, positions and gate state alone, and each
+ * decimated sample is stored once, in the ring.
+ *
+ */
+
+#ifndef FRAMEQ_H
+#define FRAMEQ_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "ring.h"
+
+//! Number of queue slots, a power of two
+#ifndef FRAMEQ_SLOTS
+#  define FRAMEQ_SLOTS 4
+#endif
+
+#if (FRAMEQ_SLOTS & (FRAMEQ_SLOTS - 1)) || FRAMEQ_SLOTS < 2 \
+		|| FRAMEQ_SLOTS > 128
+#  error "FRAMEQ_SLOTS must be a power of two, 2 to 128"
+#endif
+
+//! The blocks carry their frames, for the streaming engines
+#define FRAMEQ_FRAMES           (PITCH_STREAM_CHANNELS != 0)
+//! Frames in each block, 0 without streaming channels
+#define FRAMEQ_BLOCK_FRAMES     (FRAMEQ_FRAMES ? CAPTURE_BLOCK_FRAMES : 0)
+
+//! One block of decimated frames
+typedef struct {
+	//! Frames of the block, oldest first
+	capture_frame_t frame[FRAMEQ_BLOCK_FRAMES];
+	//! \ref timebase_now() at the commit, just after the last frame
+	uint32_t time;
+	//! Ring position following the last frame of the block
+	uint16_t end_pos;
+	//! Channels open at the end of the block, see \ref gate.h
+	uint8_t active;
+	//! Channels with an onset since the previous queued block
+	uint8_t onset;
+} frameq_block_t;
+
+RING_DEFINE(frameq_ring, frameq_block_t, FRAMEQ_SLOTS)
+
+struct frameq {
+	struct frameq_ring ring;
+	//! Blocks dropped because the queue was full
+	volatile uint16_t overruns;
+};
+
+extern struct frameq frameq;
+
+void frameq_reset(void);
+
+//! \name Producer side, capture interrupt
+//@{
+
+/**
+ * \brief Slot to fill next, or NULL if the queue is full
+ *
+ * A full queue counts one overrun.
+ */
+static inline frameq_block_t *frameq_get_free(void)
+{
+	frameq_block_t *block = frameq_ring_get_free(&frameq.ring);
+
+	if (!block) {
+		frameq.overruns++;
+	}
+	return block;
+}
+
+/**
+ * \brief Hand the slot returned by \ref frameq_get_free() to the consumer
+ */
+static inline void frameq_commit(void)
+{
+	frameq_ring_commit(&frameq.ring);
+}
+//@}
+
+//! \name Consumer side, main loop
+//@{
+
+/**
+ * \brief Oldest filled slot, or NULL if the queue is empty
+ */
+static inline const frameq_block_t *frameq_peek(void)
+{
+	return frameq_ring_peek(&frameq.ring);
+}
+
+/**
+ * \brief Give the slot returned by \ref frameq_peek() back to the producer
+ */
+static inline void frameq_release(void)
+{
+	frameq_ring_release(&frameq.ring);
+}
+
+/**
+ * \brief Number of filled slots waiting for analysis
+ */
+static inline uint8_t frameq_get_fill(void)
+{
+	return frameq_ring_get_fill(&frameq.ring);
+}
+//@}
+
+uint16_t frameq_get_overruns(void);
+
+#endif /* FRAMEQ_H */
@@ -0,0 +1,234 @@
+/**
+ * \file
+ *
+ * \brief Per-channel noise gate and onset detector
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <asf.h>
+#include "gate.h"
+
+struct gate_channel gate_ch[CHANNELS];
+
+//! \internal Channels open after the last block
+static uint8_t gate_active;
+//! \internal Onsets not yet handed to a queued block
+static uint8_t gate_onsets;
+//! \internal Channels open since a pluck of their own
+static uint8_t gate_plucked;
+//! \internal Open channels left out as ringing with a louder one
+static uint8_t gate_sympathetic;
+//! \internal Onsets taken in the current window, the strongest of them
+//! and blocks left of the window
+static uint8_t gate_window;
+static uint16_t gate_window_p2p;
+static uint8_t gate_window_wait;
+
+/**
+ * \internal
+ * \brief Start a new block range
+ */
+static void gate_clear_range(struct gate_channel *gc)
+{
+	gc->min = INT16_MAX;
+	gc->max = INT16_MIN;
+}
+
+/**
+ * \brief Close every channel and clear the envelopes
+ *
+ * Also works out the levels of each channel from its noise floor. Call
+ * while the capture is stopped.
+ */
+void gate_reset(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		struct gate_channel *gc = &gate_ch[ch];
+		uint32_t open = (uint32_t)gc->floor * GATE_NOISE_RATIO;
+
+		gate_clear_range(gc);
+		gc->env = 0;
+		gc->hold = 0;
+		if (open < GATE_OPEN_LEVEL) {
+			open = GATE_OPEN_LEVEL;
+		} else if (open > UINT16_MAX) {
+			open = UINT16_MAX;
+		}
+		gc->open = open;
+		gc->close = open * GATE_CLOSE_LEVEL / GATE_OPEN_LEVEL;
+	}
+	gate_active = 0;
+	gate_onsets = 0;
+	gate_plucked = 0;
+	gate_sympathetic = 0;
+	gate_window = 0;
+	gate_window_wait = 0;
+}
+
+/**
+ * \brief Set the noise floor of channel \a ch, in samples peak-to-peak
+ *
+ * Takes effect at the next \ref gate_reset().
+ */
+void gate_set_floor(uint8_t ch, uint16_t floor)
+{
+	gate_ch[ch].floor = floor;
+}
+
+/**
+ * \internal
+ * \brief Tell the plucks from the strings ringing along
+ *
+ * \param onsets Onsets found in this block
+ * \param p2p Peak-to-peak values of this block
+ */
+static void gate_sympathy(uint8_t onsets, const uint16_t *p2p)
+{
+#if GATE_SYMPATHY_RATIO
+	uint16_t strongest = 0;
+	uint16_t loudest = 0;
+	uint8_t ch;
+
+	if (gate_window_wait) {
+		gate_window_wait--;
+	} else {
+		gate_window = 0;
+		gate_window_p2p = 0;
+	}
+	if (onsets) {
+		if (!gate_window_wait) {
+			gate_window_wait = GATE_SYMPATHY_BLOCKS;
+		}
+		for (ch = 0; ch < CHANNELS; ch++) {
+			if ((onsets & (1 << ch)) && p2p[ch] > strongest) {
+				strongest = p2p[ch];
+			}
+		}
+		if (strongest > gate_window_p2p) {
+			gate_window_p2p = strongest;
+		}
+		// The onsets of the window so far are judged again, by envelope
+		for (ch = 0; ch < CHANNELS; ch++) {
+			uint8_t bit = 1 << ch;
+			uint16_t level = (onsets & bit) ? p2p[ch] : gate_ch[ch].env;
+
+			if (!((onsets | gate_window) & bit)) {
+				continue;
+			}
+			if ((uint32_t)level * GATE_SYMPATHY_RATIO < gate_window_p2p) {
+				gate_onsets &= ~bit;
+				gate_plucked &= ~bit;
+				gate_window &= ~bit;
+			} else {
+				gate_plucked |= bit;
+				gate_window |= bit;
+			}
+		}
+	}
+
+	gate_plucked &= gate_active;
+	for (ch = 0; ch < CHANNELS; ch++) {
+		if ((gate_plucked & (1 << ch)) && gate_ch[ch].env > loudest) {
+			loudest = gate_ch[ch].env;
+		}
+	}
+	gate_sympathetic = 0;
+	for (ch = 0; ch < CHANNELS; ch++) {
+		uint8_t bit = 1 << ch;
+
+		if ((gate_active & ~gate_plucked & bit)
+				&& (uint32_t)gate_ch[ch].env * GATE_SYMPATHY_RATIO
+				<= loudest) {
+			gate_sympathetic |= bit;
+		}
+	}
+#else
+	UNUSED(onsets);
+	UNUSED(p2p);
+#endif
+}
+
+/**
+ * \brief Update the gates at the end of a block
+ *
+ * Called by the capture interrupt after the last \ref gate_frame() of the
+ * block.
+ *
+ * \return Mask of the open channels, bit n for channel n, without those
+ * only ringing along with a plucked one
+ */
+uint8_t gate_block(void)
+{
+	uint16_t p2ps[CHANNELS];
+	uint8_t onsets = 0;
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		struct gate_channel *gc = &gate_ch[ch];
+		uint8_t bit = 1 << ch;
+		uint16_t p2p = (uint16_t)((int32_t)gc->max - gc->min);
+		uint16_t env = gc->env;
+
+		gate_clear_range(gc);
+		p2ps[ch] = p2p;
+
+		if (p2p >= gc->open
+				&& (uint32_t)p2p > (uint32_t)env * GATE_ONSET_RATIO) {
+			onsets |= bit;
+		}
+
+		env -= env >> GATE_RELEASE_SHIFT;
+		if (p2p > env) {
+			env = p2p;
+		}
+		gc->env = env;
+
+		if (env >= gc->open) {
+			gate_active |= bit;
+			gc->hold = GATE_HOLD_BLOCKS;
+		} else if (env < gc->close && gc->hold && !--gc->hold) {
+			gate_active &= ~bit;
+		}
+	}
+	gate_onsets |= onsets;
+	gate_sympathy(onsets, p2ps);
+	return gate_active & ~gate_sympathetic;
+}
+
+/**
+ * \brief Onsets since the last call, bit n for channel n
+ *
+ * Onsets found while the frame queue was full are kept for the next block
+ * that is queued.
+ */
+uint8_t gate_take_onsets(void)
+{
+	uint8_t onsets = gate_onsets;
+
+	gate_onsets = 0;
+	return onsets;
+}
+
+/**
+ * \brief Channels open after the last block, bit n for channel n
+ *
+ * Includes the channels only ringing along, which are still sound.
+ */
+uint8_t gate_get_active(void)
+{
+	return gate_active;
+}
+
+/**
+ * \brief Open channels left out of the last block as ringing along with a
+ * louder plucked one, bit n for channel n
+ */
+uint8_t gate_get_sympathetic(void)
+{
+	return gate_sympathetic;
+}
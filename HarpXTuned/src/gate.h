@@ -0,0 +1,129 @@
+/**
+ * \file
+ *
+ * \brief Per-channel noise gate and onset detector
+ *
+ * The capture interrupt tracks the smallest and largest sample of every
+ * channel over a block with \ref gate_frame(). At the end of the block
+ * \ref gate_block() turns the peak-to-peak value into an envelope with
+ * instant attack and exponential release. A channel opens when the
+ * envelope reaches GATE_OPEN_LEVEL and closes once it has stayed below
+ * GATE_CLOSE_LEVEL for GATE_HOLD_BLOCKS blocks. A block whose peak-to-peak
+ * value exceeds GATE_ONSET_RATIO times the envelope before it marks an
+ * onset, i.e. a new pluck. On a channel with a noise floor from
+ * \ref gate_set_floor() both levels are raised to keep the open level
+ * GATE_NOISE_RATIO times above it.
+ *
+ * The pickups of neighbouring strings hear each other, and a pluck sets
+ * its octaves ringing on the other channels. Those channels either open
+ * with no onset of their own or with a much weaker one, so at the end of
+ * each block the channels are compared with one another: an onset weaker
+ * by GATE_SYMPATHY_RATIO than the strongest one within GATE_SYMPATHY_BLOCKS
+ * is no pluck, and an open channel without a pluck of its own is left
+ * out of the block mask while a plucked channel rings GATE_SYMPATHY_RATIO
+ * louder. The engines then skip it, saving its slice, rather than read
+ * the wrong string on it. It joins in again with a pluck of its own.
+ *
+ * The gate and onset masks travel with each block through the frame queue,
+ * so the engines skip closed channels and restart on an onset. Working on
+ * peak-to-peak values needs no DC tracking and costs two compares per
+ * sample.
+ *
+ */
+
+#ifndef GATE_H
+#define GATE_H
+
+#include <compiler.h>
+#include "capture.h"
+
+//! Envelope at which a channel opens, in samples peak-to-peak
+#ifndef GATE_OPEN_LEVEL
+#  define GATE_OPEN_LEVEL   (32U << CAPTURE_LOG2_SCALE)
+#endif
+
+//! Envelope below which a channel starts to close
+#ifndef GATE_CLOSE_LEVEL
+#  define GATE_CLOSE_LEVEL  (GATE_OPEN_LEVEL / 2)
+#endif
+
+//! Smallest ratio of the open level to a channel's noise floor
+#ifndef GATE_NOISE_RATIO
+#  define GATE_NOISE_RATIO  4
+#endif
+
+//! Blocks below GATE_CLOSE_LEVEL before a channel closes, 250 ms
+#ifndef GATE_HOLD_BLOCKS
+#  define GATE_HOLD_BLOCKS  (SAMPLERATE / 4 / CAPTURE_BLOCK_FRAMES)
+#endif
+
+//! Envelope release per block, env -= env / 2^GATE_RELEASE_SHIFT
+#ifndef GATE_RELEASE_SHIFT
+#  define GATE_RELEASE_SHIFT 5
+#endif
+
+//! Rise over the envelope that counts as an onset
+#ifndef GATE_ONSET_RATIO
+#  define GATE_ONSET_RATIO  2
+#endif
+
+//! Envelope ratio of a pluck over a sympathetic string, 0 for no rejection
+#ifndef GATE_SYMPATHY_RATIO
+#  define GATE_SYMPATHY_RATIO 4
+#endif
+
+//! Blocks in which onsets are compared with the strongest one, 20 ms
+#ifndef GATE_SYMPATHY_BLOCKS
+#  define GATE_SYMPATHY_BLOCKS \
+	((SAMPLERATE / 50 + CAPTURE_BLOCK_FRAMES - 1) / CAPTURE_BLOCK_FRAMES)
+#endif
+
+#if CHANNELS > 8
+#  error "The gate masks hold at most 8 channels"
+#endif
+
+//! Gate state of one channel
+struct gate_channel {
+	//! Sample range of the current block
+	int16_t min;
+	int16_t max;
+	//! Peak-to-peak envelope
+	uint16_t env;
+	//! Blocks left until the channel closes
+	uint16_t hold;
+	//! Largest peak-to-peak value of a block with the strings quiet
+	uint16_t floor;
+	//! Open and close levels, from the floor
+	uint16_t open;
+	uint16_t close;
+};
+
+extern struct gate_channel gate_ch[CHANNELS];
+
+/**
+ * \brief Track the sample range of one frame
+ */
+static inline void gate_frame(const capture_frame_t *frame)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		int16_t x = frame->ch[ch];
+
+		if (x < gate_ch[ch].min) {
+			gate_ch[ch].min = x;
+		}
+		if (x > gate_ch[ch].max) {
+			gate_ch[ch].max = x;
+		}
+	}
+}
+
+void gate_reset(void);
+void gate_set_floor(uint8_t ch, uint16_t floor);
+uint8_t gate_block(void);
+uint8_t gate_take_onsets(void);
+uint8_t gate_get_active(void);
+uint8_t gate_get_sympathetic(void);
+
+#endif /* GATE_H */
@@ -0,0 +1,364 @@
+/**
+ * \file
+ *
+ * \brief Glissando mode: onsets queued during a burst, analysed behind it
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "gliss.h"
+#include "harp.h"
+#include "pitch.h"
+#include "sched.h"
+#include "sdram.h"
+
+//! \internal Reference to the window of one onset
+struct gliss_entry {
+	//! Stamp of the block at the end of the window
+	uint32_t time;
+	//! Hop count at which the ring is written up to \c end_pos
+	uint16_t hop;
+	//! Ring position following the newest sample of the window
+	uint16_t end_pos;
+	uint8_t ch;
+};
+
+//! \internal Queue of entries in SDRAM, HUGEMEM_NULL without room for it
+static hugemem_ptr_t gliss_queue = HUGEMEM_NULL;
+//! \internal Free-running indices of the next entry queued and taken
+static uint8_t gliss_head;
+static uint8_t gliss_tail;
+//! \internal Index of the newest entry of each channel
+static uint8_t gliss_newest[CHANNELS];
+//! \internal The consume task hands the hops here
+static bool gliss_on;
+//! \internal A burst is under way, since its first onset
+static bool gliss_burst;
+//! \internal Hops since the mode came on, and that of the newest onset
+static uint16_t gliss_hops;
+static uint16_t gliss_onset_hop;
+//! \internal Strings read in the burst, and the error of each, Q8.8 cents
+static uint8_t gliss_seen[(HARP_STRINGS + 7) / 8];
+static notes_offset_t gliss_errors[HARP_STRINGS];
+//! \internal Entries of the burst that read silent, and that were dropped
+static uint8_t gliss_unread;
+static uint8_t gliss_dropped;
+//! \internal Number of the report shown, 0 for none, and of the last one
+static uint8_t gliss_report;
+static uint8_t gliss_reports;
+
+//! \internal SDRAM address of the entry of index \a i
+static hugemem_ptr_t gliss_slot(uint8_t i)
+{
+	return gliss_queue + (uint16_t)(i & (GLISS_SLOTS - 1))
+			* sizeof(struct gliss_entry);
+}
+
+//! \internal Count \a count up by one, saturating
+static void gliss_count(uint8_t *count)
+{
+	if (*count < UINT8_MAX) {
+		(*count)++;
+	}
+}
+
+/**
+ * \brief Reserve the onset queue
+ *
+ * Call after \ref capture_init(), whose rings come first in the arena.
+ * Without room, "gliss on" is refused.
+ */
+void gliss_init(void)
+{
+#if PITCH_BATCH_CHANNELS
+	gliss_queue = sdram_alloc((uint32_t)GLISS_SLOTS
+			* sizeof(struct gliss_entry));
+#endif
+}
+
+/**
+ * \brief Hand the capture hops to the queue instead of the batch jobs
+ *
+ * \retval false without batch channels or room for the queue
+ */
+bool gliss_start(void)
+{
+	if (gliss_queue == HUGEMEM_NULL) {
+		return false;
+	}
+	gliss_tail = gliss_head;
+	gliss_burst = false;
+	gliss_report = 0;
+	gliss_on = true;
+	return true;
+}
+
+/**
+ * \brief Go back to the live analysis, dropping what is still queued
+ */
+void gliss_stop(void)
+{
+	gliss_on = false;
+	gliss_report = 0;
+}
+
+/**
+ * \brief Whether the consume task hands the hops to \ref gliss_hop()
+ */
+bool gliss_is_on(void)
+{
+	return gliss_on;
+}
+
+/**
+ * \internal
+ * \brief Start a burst at its first onset, clearing the results
+ */
+static void gliss_begin(void)
+{
+	memset(gliss_seen, 0, sizeof(gliss_seen));
+	gliss_unread = 0;
+	gliss_dropped = 0;
+	gliss_report = 0;
+	gliss_burst = true;
+}
+
+/**
+ * \internal
+ * \brief End the window still building of channel \a ch, if any, at the
+ * hop of a new onset: \a end_pos and \a time
+ */
+static void gliss_cut(uint8_t ch, uint16_t end_pos, uint32_t time)
+{
+	uint8_t i = gliss_newest[ch];
+	struct gliss_entry e;
+
+	if ((uint8_t)(i - gliss_tail) >= (uint8_t)(gliss_head - gliss_tail)) {
+		return;
+	}
+	sdram_read(&e, gliss_slot(i), sizeof(e));
+	if (e.ch != ch || (int16_t)(e.hop - gliss_hops) <= 0) {
+		return;
+	}
+	e.hop = gliss_hops;
+	e.end_pos = end_pos;
+	e.time = time;
+	sdram_write(gliss_slot(i), &e, sizeof(e));
+}
+
+/**
+ * \brief Take the capture hops finished with a block, from the consume
+ * task
+ *
+ * \param hops    Hops finished, from \ref capture_hop_take()
+ * \param onset   Batch channels with an onset since the last call
+ * \param end_pos Ring position at the end of the newest hop
+ * \param time    Stamp of the block that finished it
+ */
+void gliss_hop(uint8_t hops, uint8_t onset, uint16_t end_pos, uint32_t time)
+{
+	struct gliss_entry e;
+	uint8_t ch;
+
+	gliss_hops += hops;
+	if (onset) {
+		if (!gliss_burst) {
+			gliss_begin();
+		}
+		gliss_onset_hop = gliss_hops;
+	}
+	for (ch = 0; onset; ch++, onset >>= 1) {
+		if (!(onset & 1)) {
+			continue;
+		}
+		gliss_cut(ch, end_pos, time);
+		if ((uint8_t)(gliss_head - gliss_tail) == GLISS_SLOTS) {
+			gliss_count(&gliss_dropped);
+			continue;
+		}
+		e.time = time + GLISS_DELAY_US;
+		e.hop = gliss_hops + GLISS_DELAY_HOPS;
+		e.end_pos = (end_pos + (uint16_t)GLISS_DELAY_HOPS * CAPTURE_HOP)
+				& (MAXBUFFER - 1);
+		e.ch = ch;
+		sdram_write(gliss_slot(gliss_head), &e, sizeof(e));
+		gliss_newest[ch] = gliss_head++;
+	}
+	sched_post(SCHED_GLISS);
+}
+
+/**
+ * \internal
+ * \brief Read the entry at the tail into \a e
+ *
+ * \retval false if the queue is empty or the entry not due yet
+ */
+static bool gliss_due(struct gliss_entry *e)
+{
+	if (gliss_tail == gliss_head) {
+		return false;
+	}
+	sdram_read(e, gliss_slot(gliss_tail), sizeof(*e));
+	return (int16_t)(gliss_hops - e->hop) >= 0;
+}
+
+/**
+ * \internal
+ * \brief Analyse the window of entry \a e and keep the error of its string
+ */
+static void gliss_take(const struct gliss_entry *e)
+{
+	struct pitch_reading *reading = &pitch_readings[e->ch];
+	notes_cents_t pitch;
+	uint8_t string;
+
+	pitch_retune(e->ch);
+	pitch_filter_reset(e->ch);
+	pitch_engines[e->ch]->update(e->ch, e->end_pos, e->time, 1U << e->ch);
+	if (!reading->freq) {
+		gliss_count(&gliss_unread);
+		return;
+	}
+	string = harp_nearest_string(e->ch, reading->freq);
+	pitch = notes_from_hz(reading->freq);
+	gliss_errors[string] = notes_offset(pitch, harp_string_pitch(string));
+	gliss_seen[string / 8] |= 1U << (string % 8);
+}
+
+/**
+ * \internal
+ * \brief Whether the error of string \a string is over GLISS_CENTS, with
+ * the error in \a error
+ */
+static bool gliss_out_of_tune(uint8_t string, notes_offset_t *error)
+{
+	if (!(gliss_seen[string / 8] & (1U << (string % 8)))) {
+		return false;
+	}
+	*error = gliss_errors[string];
+	return *error > NOTES_OFFSET(GLISS_CENTS)
+			|| *error < -NOTES_OFFSET(GLISS_CENTS);
+}
+
+/**
+ * \internal
+ * \brief End the burst: report it and clear the readings it left
+ */
+static void gliss_end(void)
+{
+	uint8_t ch;
+
+	gliss_burst = false;
+	if (!++gliss_reports) {
+		gliss_reports = 1;
+	}
+	gliss_report = gliss_reports;
+	for (ch = 0; ch < CHANNELS; ch++) {
+		if (PITCH_BATCH_CHANNELS & (1U << ch)) {
+			pitch_readings[ch].freq = 0;
+			pitch_readings[ch].level = 0;
+		}
+	}
+	gliss_dump();
+}
+
+/**
+ * \brief Analyse the next due entry, scheduler task
+ *
+ * Posted at every hop while the mode is on.
+ *
+ * \retval true while more entries are due
+ */
+bool gliss_run(void)
+{
+	struct gliss_entry e;
+
+	if (!gliss_on) {
+		return false;
+	}
+	while (gliss_due(&e)) {
+		gliss_tail++;
+		if ((uint16_t)(gliss_hops - e.hop) > GLISS_STALE_HOPS) {
+			gliss_count(&gliss_dropped);
+			continue;
+		}
+		gliss_take(&e);
+		return gliss_due(&e);
+	}
+	if (gliss_burst && gliss_tail == gliss_head
+			&& (uint16_t)(gliss_hops - gliss_onset_hop)
+			>= GLISS_QUIET_HOPS) {
+		gliss_end();
+	}
+	return false;
+}
+
+/**
+ * \brief Print the strings of the last burst more than GLISS_CENTS off on
+ * the stdio USART
+ */
+void gliss_dump(void)
+{
+	notes_offset_t error;
+	char name[NOTES_NAME_MAX + 1];
+	uint8_t strings = 0;
+	uint8_t out = 0;
+	uint8_t string;
+	uint16_t tenths;
+
+	if (!gliss_report) {
+		printf_P(PSTR("gliss no burst\r\n"));
+		return;
+	}
+	for (string = 0; string < HARP_STRINGS; string++) {
+		if (gliss_seen[string / 8] & (1U << (string % 8))) {
+			strings++;
+		}
+		if (gliss_out_of_tune(string, &error)) {
+			out++;
+		}
+	}
+	printf_P(PSTR("gliss %u strings, %u out of tune, %u unread,"
+			" %u dropped\r\n"), strings, out, gliss_unread, gliss_dropped);
+	for (string = 0; string < HARP_STRINGS; string++) {
+		if (!gliss_out_of_tune(string, &error)) {
+			continue;
+		}
+		notes_name(harp_string_note(string), name);
+		tenths = ((uint32_t)Abs(error) * 10 + 128) >> 8;
+		printf_P(PSTR("  string %u %s %c%u.%u cents\r\n"), string, name,
+				(error < 0) ? '-' : '+', tenths / 10, tenths % 10);
+	}
+}
+
+/**
+ * \brief Number of the burst report to show, 0 while there is none
+ *
+ * Changes with each burst that ends, and goes back to 0 as the next one
+ * starts or the mode goes off.
+ */
+uint8_t gliss_get_report(void)
+{
+	return gliss_report;
+}
+
+/**
+ * \brief String \a i of the report, from 0, in string order
+ *
+ * \param error Set to the error of the string, Q8.8 cents
+ *
+ * \return The string, HARP_STRINGS past the last one
+ */
+uint8_t gliss_report_string(uint8_t i, notes_offset_t *error)
+{
+	uint8_t string;
+
+	for (string = 0; string < HARP_STRINGS; string++) {
+		if (gliss_out_of_tune(string, error) && !i--) {
+			break;
+		}
+	}
+	return string;
+}
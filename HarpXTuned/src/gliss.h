@@ -0,0 +1,103 @@
+/**
+ * \file
+ *
+ * \brief Glissando mode: onsets queued during a burst, analysed behind it
+ *
+ * A glissando or a strum plucks strings faster than the batch jobs of the
+ * live analysis come round, so most strings of a burst never get a
+ * reading of their own. With "gliss on" on the \ref shell.h, the consume
+ * task hands the capture hops to \ref gliss_hop() instead of starting
+ * batch jobs, and each onset of a batch channel queues a reference to a
+ * window of the \ref capture.h ring: the channel, the ring position the
+ * window ends at and the hop count at which the ring has been written
+ * that far. The window ends GLISS_DELAY_HOPS after the onset hop, or at
+ * the next onset of the channel if that comes first, so each one holds
+ * the attack of one string. No samples are copied; the queue of
+ * GLISS_SLOTS entries is in the \ref sdram.h arena.
+ *
+ * The gliss task takes one due entry per slice, in order, and runs the
+ * engine of the channel on its window from a fresh retune, so the partial
+ * tracker does not carry over from the string before. The nearest string
+ * to the reading and the error off it are kept, the last one for a string
+ * plucked twice. An entry whose window the capture has written over by
+ * the time it is due, more than GLISS_STALE_HOPS late, is dropped, as is
+ * an onset that finds the queue full.
+ *
+ * Once the queue is empty and no onset has come for GLISS_QUIET_HOPS, the
+ * burst is over and the strings more than GLISS_CENTS off are printed
+ * \code
+	gliss 9 strings, 2 out of tune, 0 unread, 0 dropped
+	  string 18 C4 +12.4 cents
+	  string 21 F4 -8.1 cents
+\endcode
+ * and, with DISPLAY_LCD, listed on the \ref display.h panel until the
+ * next burst. "gliss dump" prints the last report again, "gliss off" goes
+ * back to the live analysis.
+ *
+ * Only batch channels, \ref pitch_fft.h, take part: the streaming engines
+ * only see each block once, as it goes by, and keep their live readings.
+ * Without batch channels "gliss on" is refused.
+ *
+ */
+
+#ifndef GLISS_H
+#define GLISS_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "display.h"
+#include "notes.h"
+#include "pitch_fft.h"
+
+//! Entries of the onset queue, a power of two up to 128
+#ifndef GLISS_SLOTS
+#  define GLISS_SLOTS           32
+#endif
+
+//! Hops a window goes on past its onset hop, one whole decimated window
+#ifndef GLISS_DELAY_HOPS
+#  define GLISS_DELAY_HOPS      (((PITCH_FFT_N << PITCH_FFT_LOG2_DECIM_MAX) \
+		+ CAPTURE_HOP - 1) / CAPTURE_HOP)
+#endif
+
+//! Hops without an onset that end a burst, about 1 s
+#ifndef GLISS_QUIET_HOPS
+#  define GLISS_QUIET_HOPS      (SAMPLERATE / CAPTURE_HOP)
+#endif
+
+//! Cents off its string at which a string is reported
+#ifndef GLISS_CENTS
+#  define GLISS_CENTS           DISPLAY_TUNE_CENTS
+#endif
+
+//! Hops an entry may be late before the capture writes over its window,
+//! one short of the ring less the longest window, for the hop in progress
+#define GLISS_STALE_HOPS        ((MAXBUFFER - ((PITCH_FFT_N + 2L \
+		+ PITCH_FFT_PV_HOP) << PITCH_FFT_LOG2_DECIM_MAX)) / CAPTURE_HOP - 1)
+
+//! Microseconds from an onset hop to the end of its window
+#define GLISS_DELAY_US \
+	((uint32_t)GLISS_DELAY_HOPS * CAPTURE_HOP * 1000000ULL / SAMPLERATE)
+
+#if GLISS_SLOTS > 128 || (GLISS_SLOTS & (GLISS_SLOTS - 1))
+#  error "GLISS_SLOTS must be a power of two up to 128"
+#endif
+#if PITCH_BATCH_CHANNELS && GLISS_STALE_HOPS < 1
+#  error "The ring leaves no time to analyse a queued window"
+#endif
+#if !GLISS_DELAY_HOPS || GLISS_DELAY_HOPS >= CAPTURE_RING_HOPS \
+		|| GLISS_QUIET_HOPS > 32767
+#  error "GLISS_DELAY_HOPS or GLISS_QUIET_HOPS out of range"
+#endif
+
+void gliss_init(void);
+bool gliss_start(void);
+void gliss_stop(void);
+bool gliss_is_on(void);
+void gliss_hop(uint8_t hops, uint8_t onset, uint16_t end_pos, uint32_t time);
+bool gliss_run(void);
+void gliss_dump(void);
+uint8_t gliss_get_report(void);
+uint8_t gliss_report_string(uint8_t i, notes_offset_t *error);
+
+#endif /* GLISS_H */
@@ -0,0 +1,454 @@
+/**
+ * \file
+ *
+ * \brief Harp string layout
+ *
+ */
+
+#include <asf.h>
+#include "calib.h"
+#include "harp.h"
+#include "tableload.h"
+
+//! \internal Reference of \ref harp_string_table
+#define HARP_TABLE_A4   PITCH_HZ(440)
+
+//! \internal ln(2) / 1200 / 2^NOTES_CENTS_SHIFT, Q32: a cent step as a
+//! natural log ratio
+#define HARP_CENT_Q32   155054L
+
+/**
+ * \internal
+ * \brief Open string frequencies, Q16.16 Hz
+ *
+ * Equal temperament, A4 = 440 Hz, all strings in C major with every pedal
+ * natural. The calibration of \ref harp_init() and the pedals are applied
+ * on top. A string table loaded with \ref tableload.h takes its place.
+ */
+static PROGMEM_DECLARE(uint32_t, harp_string_table[HARP_STRINGS]) = {
+	// C1 D1 E1 F1 G1 A1 B1
+	2143237UL, 2405702UL, 2700309UL, 2860878UL, 3211227UL, 3604480UL, 4045892UL,
+	// C2 D2 E2 F2 G2 A2 B2
+	4286473UL, 4811404UL, 5400618UL, 5721755UL, 6422453UL, 7208960UL, 8091784UL,
+	// C3 D3 E3 F3 G3 A3 B3
+	8572947UL, 9622807UL, 10801236UL, 11443511UL, 12844906UL, 14417920UL, 16183568UL,
+	// C4 D4 E4 F4 G4 A4 B4
+	17145893UL, 19245614UL, 21602472UL, 22887021UL, 25689813UL, 28835840UL, 32367136UL,
+	// C5 D5 E5 F5 G5 A5 B5
+	34291786UL, 38491228UL, 43204943UL, 45774043UL, 51379626UL, 57671680UL, 64734272UL,
+	// C6 D6 E6 F6 G6 A6 B6
+	68583572UL, 76982457UL, 86409886UL, 91548086UL, 102759252UL, 115343360UL, 129468544UL,
+	// C7 D7 E7 F7 G7
+	137167144UL, 153964914UL, 172819773UL, 183096171UL, 205518503UL,
+};
+
+const struct harp_group harp_unit_groups[HARP_UNITS * CHANNELS] =
+		HARP_UNIT_GROUPS;
+
+static const harp_candidates_t harp_default_candidates[CHANNELS] =
+		HARP_CHANNEL_CANDIDATES;
+//! \internal Candidate set of each channel, within its group
+static harp_candidates_t harp_candidate_sets[CHANNELS];
+
+//! \internal A4 reference, over HARP_TABLE_A4, Q16, and as a pitch
+static pitch_hz_t harp_a4 = HARP_TABLE_A4;
+static uint32_t harp_a4_ratio = 1UL << 16;
+static notes_cents_t harp_a4_pitch;
+//! \internal Temperament of C, D .. B, \ref notes_cents_t units
+static int16_t harp_temperament[7];
+//! \internal Cents of each string on top of the temperament
+static int8_t harp_offsets[HARP_STRINGS];
+//! \internal \ref harp_pedal of C, D .. B
+static int8_t harp_pedals[7];
+//! \internal Reference frequency of each string, see \ref harp_update()
+static pitch_hz_t harp_freqs[HARP_STRINGS];
+//! \internal Shift of every reference for the sample clock error
+static notes_cents_t harp_clock_pitch;
+
+#if HARP_STRINGS > 2 * CALIB_STRINGS_LOW
+#  error "String offsets exceed their calibration records"
+#endif
+
+/**
+ * \internal
+ * \brief Scale \a x by \a ratio, Q16, at most 2
+ */
+static uint32_t harp_scale(uint32_t x, uint32_t ratio)
+{
+	return (x >> 16) * ratio + (((x & 0xffff) * (ratio >> 1)) >> 15);
+}
+
+/**
+ * \internal
+ * \brief Frequency ratio of \a cents, \ref notes_cents_t units, Q16
+ *
+ * Third order series of exp(), within 0.2 cents up to 300 cents.
+ */
+static uint32_t harp_cents_ratio(int16_t cents)
+{
+	int32_t x = (cents * HARP_CENT_Q32) >> 16;
+	int32_t x2 = (x * x) >> 16;
+	int32_t x3 = (x2 * x) >> 16;
+
+	return (uint32_t)((1L << 16) + x + x2 / 2 + x3 / 6);
+}
+
+/**
+ * \internal
+ * \brief Open frequency of \a string, from the loaded string table if
+ * there is one
+ */
+static pitch_hz_t harp_table_freq(uint8_t string)
+{
+	flash_addr_t loaded = tableload_get(TABLELOAD_STRINGS);
+
+	if (loaded) {
+		return pgm_read_dword_far(loaded + 4 * string);
+	}
+	return pgm_read_dword(&harp_string_table[string]);
+}
+
+/**
+ * \internal
+ * \brief Equal temperament note of \a string with its pedal natural,
+ * from the loaded string table if there is one
+ */
+static uint8_t harp_table_note(uint8_t string)
+{
+	flash_addr_t loaded = tableload_get(TABLELOAD_STRINGS);
+
+	if (loaded) {
+		return pgm_read_byte_far(loaded + TABLELOAD_STRINGS_NOTES + string);
+	}
+	return PROGMEM_READ_BYTE(&notes_string_table[string]);
+}
+
+/**
+ * \internal
+ * \brief Offset of \a note in the HARP_TEMPERAMENT temperament, from the
+ * loaded temperaments if there are some
+ */
+static int16_t harp_table_temperament(uint8_t note)
+{
+	flash_addr_t loaded = tableload_get(TABLELOAD_TEMPERAMENTS);
+
+	if (loaded) {
+		return (int16_t)pgm_read_word_far(loaded
+				+ 2 * (12 * HARP_TEMPERAMENT + note % 12));
+	}
+	return notes_temperament(HARP_TEMPERAMENT, note);
+}
+
+/**
+ * \internal
+ * \brief Set the temperament from the \ref calib.h store, or the
+ * default one
+ */
+static void harp_load_temperament(void)
+{
+	int8_t temperament[7];
+	uint8_t i;
+
+	if (calib_read(CALIB_KEY_TEMPERAMENT, temperament,
+			sizeof(temperament))) {
+		for (i = 0; i < 7; i++) {
+			harp_temperament[i] = NOTES_CENTS(temperament[i]);
+		}
+	} else {
+		for (i = 0; i < 7; i++) {
+			harp_temperament[i] = harp_table_temperament(harp_table_note(i));
+		}
+	}
+}
+
+/**
+ * \internal
+ * \brief Work out the reference frequency of \a string
+ *
+ * The pedal adds an equal tempered semitone to the string as tuned, as
+ * the pedal disc of a real harp does.
+ */
+static void harp_update(uint8_t string)
+{
+	pitch_hz_t freq = harp_table_freq(string);
+	int16_t cents = harp_temperament[string % 7]
+			+ NOTES_CENTS(harp_offsets[string])
+			+ NOTES_CENTS(100 * harp_pedals[string % 7])
+			+ (int16_t)harp_clock_pitch;
+
+	if (harp_a4_ratio != 1UL << 16) {
+		freq = harp_scale(freq, harp_a4_ratio);
+	}
+	if (cents) {
+		freq = harp_scale(freq, harp_cents_ratio(cents));
+	}
+	harp_freqs[string] = freq;
+}
+
+/**
+ * \brief Load the A4 reference, temperament and string offsets from the
+ * \ref calib.h store
+ *
+ * Settings never stored keep the defaults: A4 = 440 Hz, the
+ * HARP_TEMPERAMENT temperament, no offsets. Also sets the
+ * HARP_CHANNEL_CANDIDATES candidates. Call before the engines are set up.
+ */
+void harp_init(void)
+{
+	pitch_hz_t a4;
+	uint8_t i;
+
+	for (i = 0; i < CHANNELS; i++) {
+		Assert(harp_groups[i].count <= HARP_GROUP_MAX);
+
+		harp_set_candidates(i, harp_default_candidates[i]);
+	}
+
+	if (calib_read(CALIB_KEY_A4, &a4, sizeof(a4))) {
+		harp_set_a4(a4);
+	}
+	harp_load_temperament();
+	calib_read(CALIB_KEY_STRINGS_LOW, harp_offsets, CALIB_STRINGS_LOW);
+	calib_read(CALIB_KEY_STRINGS_HIGH, &harp_offsets[CALIB_STRINGS_LOW],
+			HARP_STRINGS - CALIB_STRINGS_LOW);
+
+	for (i = 0; i < HARP_STRINGS; i++) {
+		harp_update(i);
+	}
+}
+
+/**
+ * \brief Work the references out again from the tables
+ *
+ * For a table loaded or cleared with \ref tableload.h. Call
+ * \ref pitch_retune() for every channel afterwards.
+ */
+void harp_reload(void)
+{
+	uint8_t i;
+
+	harp_load_temperament();
+	for (i = 0; i < HARP_STRINGS; i++) {
+		harp_update(i);
+	}
+}
+
+/**
+ * \brief Reference frequency of \a string, counted from the lowest
+ */
+pitch_hz_t harp_string_freq(uint8_t string)
+{
+	return harp_freqs[string];
+}
+
+/**
+ * \brief Reference pitch of \a string, as \ref harp_string_freq()
+ */
+notes_cents_t harp_string_pitch(uint8_t string)
+{
+	return notes_equal(harp_string_note(string))
+			+ harp_a4_pitch + harp_temperament[string % 7]
+			+ NOTES_CENTS(harp_offsets[string]) + harp_clock_pitch;
+}
+
+/**
+ * \brief Equal temperament note nearest \a freq, for chromatic mode
+ *
+ * Against the A4 reference and the sample clock, with no temperament.
+ *
+ * \param pitch Receives the pitch of the note, as \ref harp_string_pitch()
+ */
+uint8_t harp_nearest_note(pitch_hz_t freq, notes_cents_t *pitch)
+{
+	notes_cents_t shift = harp_a4_pitch + harp_clock_pitch;
+	uint8_t note = notes_nearest(notes_from_hz(freq) - shift);
+
+	*pitch = notes_equal(note) + shift;
+	return note;
+}
+
+/**
+ * \brief Equal temperament note \a string sounds with its pedal
+ */
+uint8_t harp_string_note(uint8_t string)
+{
+	return harp_table_note(string) + harp_pedals[string % 7];
+}
+
+/**
+ * \brief Pedal of pitch class \a pc, 0 to 6 for C to B
+ */
+enum harp_pedal harp_pedal(uint8_t pc)
+{
+	return (enum harp_pedal)harp_pedals[pc];
+}
+
+/**
+ * \brief Move the pedal of pitch class \a pc, 0 to 6 for C to B
+ *
+ * Updates the reference frequencies of the strings of \a pc only, one
+ * per octave. Call \ref pitch_retune_strings() with
+ * \ref harp_class_strings() afterwards.
+ */
+void harp_set_pedal(uint8_t pc, enum harp_pedal pedal)
+{
+	uint8_t string;
+
+	Assert(pc < 7);
+
+	harp_pedals[pc] = pedal;
+	for (string = pc; string < HARP_STRINGS; string += 7) {
+		harp_update(string);
+	}
+}
+
+/**
+ * \brief A4 reference
+ */
+pitch_hz_t harp_get_a4(void)
+{
+	return harp_a4;
+}
+
+/**
+ * \brief Move the A4 reference to \a a4
+ *
+ * Updates the reference frequencies of every string, without storing
+ * \a a4 in the \ref calib.h store. Call \ref pitch_retune() for every
+ * channel afterwards.
+ *
+ * \retval false if \a a4 is not within an octave of 440 Hz, and nothing
+ * changed
+ */
+bool harp_set_a4(pitch_hz_t a4)
+{
+	uint8_t string;
+
+	if (a4 < HARP_TABLE_A4 / 2 || a4 >= 2 * HARP_TABLE_A4) {
+		return false;
+	}
+	harp_a4 = a4;
+	harp_a4_ratio = a4 / (HARP_TABLE_A4 >> 16);
+	harp_a4_pitch = notes_from_hz(a4);
+	for (string = 0; string < HARP_STRINGS; string++) {
+		harp_update(string);
+	}
+	return true;
+}
+
+/**
+ * \brief Allow for a sample clock off by \a offset
+ *
+ * A clock fast by \a offset, in \ref notes_cents_t units, reads every
+ * pitch as much low, so every reference moves down with it. Call
+ * \ref pitch_retune() for every channel afterwards.
+ */
+void harp_set_clock_offset(notes_cents_t offset)
+{
+	uint8_t string;
+
+	harp_clock_pitch = -offset;
+	for (string = 0; string < HARP_STRINGS; string++) {
+		harp_update(string);
+	}
+}
+
+/**
+ * \brief Strings of pitch class \a pc in the group of channel \a ch
+ */
+harp_candidates_t harp_class_strings(uint8_t ch, uint8_t pc)
+{
+	harp_candidates_t set = 0;
+	uint8_t first = harp_groups[ch].first;
+	uint8_t i;
+
+	for (i = 0; i < harp_groups[ch].count; i++) {
+		if ((first + i) % 7 == pc) {
+			set |= 1U << i;
+		}
+	}
+	return set;
+}
+
+/**
+ * \brief Candidate string of channel \a ch closest to \a freq
+ */
+uint8_t harp_nearest_string(uint8_t ch, pitch_hz_t freq)
+{
+	harp_candidates_t set = harp_candidate_sets[ch];
+	uint8_t string = harp_groups[ch].first;
+
+	while (!(set & 1)) {
+		set >>= 1;
+		string++;
+	}
+
+	// Open frequencies rise with the string number
+	while (set >>= 1) {
+		uint8_t next = string + 1;
+		pitch_hz_t lo;
+		pitch_hz_t hi;
+
+		while (!(set & 1)) {
+			set >>= 1;
+			next++;
+		}
+		lo = harp_string_freq(string);
+		hi = harp_string_freq(next);
+		if (freq <= lo || (freq < hi && freq - lo < hi - freq)) {
+			break;
+		}
+		string = next;
+	}
+	return string;
+}
+
+/**
+ * \brief Candidate set of channel \a ch
+ */
+harp_candidates_t harp_candidates(uint8_t ch)
+{
+	return harp_candidate_sets[ch];
+}
+
+/**
+ * \brief Restrict the strings channel \a ch looks for to \a set
+ *
+ * Bits beyond the group are dropped and at least one string of the group
+ * must remain. Call \ref pitch_retune() afterwards.
+ */
+void harp_set_candidates(uint8_t ch, harp_candidates_t set)
+{
+	uint8_t count = harp_groups[ch].count;
+
+	if (count < HARP_GROUP_MAX) {
+		set &= (1U << count) - 1;
+	}
+	Assert(set);
+
+	harp_candidate_sets[ch] = set;
+}
+
+/**
+ * \brief Frequency range the engines search on channel \a ch
+ *
+ * From HARP_SEARCH_MARGIN cents below the lowest candidate to as far above
+ * the highest, room for a string that is well out of tune.
+ */
+void harp_search_range(uint8_t ch, pitch_hz_t *lo, pitch_hz_t *hi)
+{
+	harp_candidates_t set = harp_candidate_sets[ch];
+	uint8_t low = 0;
+	uint8_t high = HARP_GROUP_MAX - 1;
+
+	while (!(set & (1U << low))) {
+		low++;
+	}
+	while (!(set & (1U << high))) {
+		high--;
+	}
+	*lo = harp_scale(harp_string_freq(harp_groups[ch].first + low),
+			harp_cents_ratio(-NOTES_CENTS(HARP_SEARCH_MARGIN)));
+	*hi = harp_scale(harp_string_freq(harp_groups[ch].first + high),
+			harp_cents_ratio(NOTES_CENTS(HARP_SEARCH_MARGIN)));
+}
@@ -0,0 +1,143 @@
+/**
+ * \file
+ *
+ * \brief Harp string layout
+ *
+ * The 47 strings of a pedal harp, C1 to G7, and the group of strings each
+ * capture channel's pickup is wired to. Strings are counted from the
+ * lowest, C1 = 0.
+ *
+ * Reference frequencies follow the A4 reference, temperament and string
+ * offsets kept in the \ref calib.h store, and the pedal or lever of each
+ * pitch class. They are kept in a table that \ref harp_set_pedal() updates
+ * one pitch class at a time.
+ *
+ * Each channel also has a candidate set, the strings of its group the
+ * pitch engines look for. The engines search only around the candidates:
+ * the FFT scans the bins of \ref harp_search_range(), the Goertzel bank
+ * runs one bin per candidate and YIN updates only the lags of the range.
+ * After \ref harp_set_candidates() the engine must be told with
+ * \ref pitch_retune().
+ *
+ */
+
+#ifndef HARP_H
+#define HARP_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "chain.h"
+#include "notes.h"
+#include "dsp/freq.h"
+
+//! Number of strings
+#define HARP_STRINGS    47
+
+//! Pedal or lever position of a pitch class, semitones from natural
+enum harp_pedal {
+	HARP_FLAT = -1,
+	HARP_NATURAL = 0,
+	HARP_SHARP = 1,
+};
+
+//! Largest string group, one bit each in \ref harp_candidates_t
+#define HARP_GROUP_MAX  16
+
+//! Candidate strings of a channel, bit i for string first + i of its group
+typedef uint16_t harp_candidates_t;
+
+//! Strings picked up by one channel
+struct harp_group {
+	//! Lowest string of the group
+	uint8_t first;
+	//! Number of strings in the group
+	uint8_t count;
+};
+
+/**
+ * \brief String group of each channel, in channel order
+ *
+ * Default: two octaves per channel from C1, the top channel takes C7..G7.
+ */
+#ifndef HARP_CHANNEL_GROUPS
+#  define HARP_CHANNEL_GROUPS \
+	{ { 0, 14 }, { 14, 14 }, { 28, 14 }, { 42, 5 } }
+#endif
+
+//! Boards whose groups \ref HARP_UNIT_GROUPS lists
+#if CHAIN_ROLE == CHAIN_NONE
+#  define HARP_UNITS    1
+#else
+#  define HARP_UNITS    CHAIN_UNITS
+#endif
+
+/**
+ * \brief String groups of every \ref chain.h unit, CHANNELS per unit, in
+ * unit and then channel order
+ *
+ * A board reads its pickups with the groups of its CHAIN_UNIT, and the
+ * master places the answer of a slave with those of the unit it came
+ * from. Default: on a board of its own, \ref HARP_CHANNEL_GROUPS. A bus
+ * must list the pickups of each unit as wired.
+ */
+#ifndef HARP_UNIT_GROUPS
+#  if HARP_UNITS == 1
+#    define HARP_UNIT_GROUPS HARP_CHANNEL_GROUPS
+#  else
+#    error "A chain of boards needs HARP_UNIT_GROUPS, the groups of each unit"
+#  endif
+#endif
+
+/**
+ * \brief Candidate set of each channel, in channel order
+ *
+ * Default: every string of the group. Candidates outside the group are
+ * ignored.
+ */
+#ifndef HARP_CHANNEL_CANDIDATES
+#  define HARP_CHANNEL_CANDIDATES \
+	{ 0xffff, 0xffff, 0xffff, 0xffff }
+#endif
+
+//! Cents \ref harp_search_range() reaches beyond the outer candidates
+#ifndef HARP_SEARCH_MARGIN
+#  define HARP_SEARCH_MARGIN 150
+#endif
+
+#if HARP_SEARCH_MARGIN > 300
+#  error "HARP_SEARCH_MARGIN exceeds the cent ratio series"
+#endif
+
+/**
+ * \brief Default temperament, one of \ref notes_temperament
+ *
+ * Used until a temperament is stored in \ref calib.h.
+ */
+#ifndef HARP_TEMPERAMENT
+#  define HARP_TEMPERAMENT  NOTES_EQUAL
+#endif
+
+extern const struct harp_group harp_unit_groups[HARP_UNITS * CHANNELS];
+//! String group of each channel of this board, in channel order
+#define harp_groups             (&harp_unit_groups[CHAIN_UNIT * CHANNELS])
+//! Equal temperament note of each string, in harp_table.c
+extern PROGMEM_DECLARE(uint8_t, notes_string_table[HARP_STRINGS]);
+
+void harp_init(void);
+void harp_reload(void);
+pitch_hz_t harp_string_freq(uint8_t string);
+notes_cents_t harp_string_pitch(uint8_t string);
+uint8_t harp_string_note(uint8_t string);
+uint8_t harp_nearest_note(pitch_hz_t freq, notes_cents_t *pitch);
+enum harp_pedal harp_pedal(uint8_t pc);
+void harp_set_pedal(uint8_t pc, enum harp_pedal pedal);
+pitch_hz_t harp_get_a4(void);
+bool harp_set_a4(pitch_hz_t a4);
+void harp_set_clock_offset(notes_cents_t offset);
+harp_candidates_t harp_class_strings(uint8_t ch, uint8_t pc);
+uint8_t harp_nearest_string(uint8_t ch, pitch_hz_t freq);
+harp_candidates_t harp_candidates(uint8_t ch);
+void harp_set_candidates(uint8_t ch, harp_candidates_t set);
+void harp_search_range(uint8_t ch, pitch_hz_t *lo, pitch_hz_t *hi);
+
+#endif /* HARP_H */
@@ -0,0 +1,23 @@
+/**
+ * \file
+ *
+ * \brief String notes of harp.h
+ *
+ * Generated by tools/notes_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "harp.h"
+
+// Equal temperament note of each string, C1 to G7
+PROGMEM_DECLARE(uint8_t, notes_string_table[HARP_STRINGS]) = {
+	 24,  26,  28,  29,  31,  33,  35,
+	 36,  38,  40,  41,  43,  45,  47,
+	 48,  50,  52,  53,  55,  57,  59,
+	 60,  62,  64,  65,  67,  69,  71,
+	 72,  74,  76,  77,  79,  81,  83,
+	 84,  86,  88,  89,  91,  93,  95,
+	 96,  98, 100, 101, 103,
+};
@@ -0,0 +1,356 @@
+/**
+ * \file
+ *
+ * \brief Framed binary telemetry on the stdio USART
+ *
+ */
+
+#include <util/crc16.h>
+#include <asf.h>
+#include <conf_usart_serial.h>
+#include "cobs.h"
+#include "display.h"
+#include "harp.h"
+#include "hostlink.h"
+#include "notes.h"
+#include "pitch.h"
+#include "pitch_fft.h"
+#include "serial_tx.h"
+#include "timebase.h"
+
+//! \internal Largest frame before encoding, of the three types
+#define HOSTLINK_READINGS_SIZE  (2 + 4 + 16 * CHANNELS + 2)
+#define HOSTLINK_SAMPLES_SIZE   (2 + 6 + 2 * HOSTLINK_SAMPLES_PER_FRAME + 2)
+#define HOSTLINK_SNAPSHOT_SIZE \
+	(2 + 7 + 2 * CHANNELS * HOSTLINK_SNAPSHOT_FRAMES + 2)
+#define HOSTLINK_RAW_MAX \
+	Max(Max(HOSTLINK_READINGS_SIZE, HOSTLINK_SAMPLES_SIZE), \
+	HOSTLINK_SNAPSHOT_SIZE)
+//! \internal Largest frame encoded, with the COBS code and the 0
+#define HOSTLINK_FRAME_MAX      COBS_ENCODED_SIZE(HOSTLINK_RAW_MAX)
+
+#if HOSTLINK_RAW_MAX > COBS_RAW_MAX
+#  error "Frames must fit one COBS block"
+#endif
+
+//! \internal No channel streams samples
+#define HOSTLINK_RAW_OFF        0xff
+
+//! \internal Frame being built, and its length
+static uint8_t hostlink_raw[HOSTLINK_RAW_MAX];
+static uint8_t hostlink_len;
+//! \internal Next frame sequence number
+static uint8_t hostlink_seq;
+//! \internal The link is on
+static bool hostlink_active;
+//! \internal Task slices until the next readings frame
+static uint8_t hostlink_reading_wait;
+
+//! \internal Channel streaming samples, or HOSTLINK_RAW_OFF
+static uint8_t hostlink_raw_ch = HOSTLINK_RAW_OFF;
+//! \internal \ref capture_hops as last taken
+static uint8_t hostlink_hops_seen;
+//! \internal Ring frames captured and not yet sent, and where they end
+static uint16_t hostlink_pending;
+static uint16_t hostlink_end;
+//! \internal Ring frame number of the first one pending
+static uint32_t hostlink_frame;
+
+//! \internal Snapshot frames sent, or MAXBUFFER when none is running
+static uint16_t hostlink_snap = MAXBUFFER;
+//! \internal Ring position of the oldest frame of the snapshot
+static uint16_t hostlink_snap_start;
+
+//! \internal Append \a v to the frame
+static void hostlink_u8(uint8_t v)
+{
+	hostlink_raw[hostlink_len++] = v;
+}
+
+//! \internal Append \a v to the frame, little endian
+static void hostlink_u16(uint16_t v)
+{
+	hostlink_u8(v);
+	hostlink_u8(v >> 8);
+}
+
+//! \internal Append \a v to the frame, little endian
+static void hostlink_u32(uint32_t v)
+{
+	hostlink_u16(v);
+	hostlink_u16(v >> 16);
+}
+
+/**
+ * \internal
+ * \brief Start a frame of \a type
+ */
+static void hostlink_begin(enum hostlink_type type)
+{
+	hostlink_len = 0;
+	hostlink_u8(type);
+	hostlink_u8(hostlink_seq++);
+}
+
+/**
+ * \internal
+ * \brief Add the CRC, encode the frame and queue it whole
+ *
+ * \retval false if the ring had no room and the frame was dropped
+ */
+static bool hostlink_send(void)
+{
+	uint8_t out[HOSTLINK_FRAME_MAX];
+	uint16_t crc = 0xffff;
+	uint8_t i;
+
+	for (i = 0; i < hostlink_len; i++) {
+		crc = _crc_ccitt_update(crc, hostlink_raw[i]);
+	}
+	hostlink_u16(crc);
+	return serial_tx_write(out, cobs_encode(hostlink_raw, hostlink_len, out),
+			SERIAL_TX_DROP);
+}
+
+/**
+ * \internal
+ * \brief Send the readings of every channel
+ */
+static void hostlink_readings(void)
+{
+	uint8_t ch;
+
+	hostlink_begin(HOSTLINK_READINGS);
+	hostlink_u32(timebase_now());
+	for (ch = 0; ch < CHANNELS; ch++) {
+		const struct pitch_reading *reading = &pitch_readings[ch];
+		pitch_hz_t freq = reading->freq;
+		notes_offset_t error = 0;
+		uint8_t string = 0xff;
+		uint8_t flags = 0;
+		uint16_t inharm = 0;
+
+		if (freq) {
+			string = harp_nearest_string(ch, freq);
+			error = notes_offset(notes_from_hz(freq),
+					harp_string_pitch(string));
+			flags |= HOSTLINK_FLAG_PITCH;
+			if (error <= NOTES_OFFSET(DISPLAY_TUNE_CENTS)
+					&& error >= -NOTES_OFFSET(DISPLAY_TUNE_CENTS)) {
+				flags |= HOSTLINK_FLAG_TUNED;
+			}
+#if PITCH_FFT_CHANNELS && PITCH_FFT_PARTIALS
+			inharm = pitch_fft_inharmonicity(ch);
+#endif
+		}
+		hostlink_u32(freq);
+		hostlink_u16(error);
+		hostlink_u8(string);
+		hostlink_u8(flags);
+		hostlink_u16(reading->level);
+		hostlink_u16(inharm);
+		hostlink_u32(reading->time);
+	}
+	hostlink_send();
+}
+
+/**
+ * \internal
+ * \brief Send the oldest HOSTLINK_CHUNK pending frames of the selected
+ * channel, averaged
+ */
+static void hostlink_samples(void)
+{
+	struct capture_view view;
+	uint16_t end = (hostlink_end - hostlink_pending + HOSTLINK_CHUNK)
+			& (MAXBUFFER - 1);
+	int32_t sum = 0;
+	uint8_t left = 1U << HOSTLINK_LOG2_DECIM;
+	uint8_t span;
+
+	hostlink_begin(HOSTLINK_SAMPLES);
+	hostlink_u8(hostlink_raw_ch);
+	hostlink_u8(HOSTLINK_LOG2_DECIM);
+	hostlink_u32(hostlink_frame);
+
+	capture_view(hostlink_raw_ch, end, HOSTLINK_CHUNK, &view);
+	for (span = 0; span < 2; span++) {
+		hugemem_ptr_t from = view.addr[span];
+		uint16_t count = view.len[span];
+
+		while (count--) {
+			sum += (int16_t)hugemem_read16(from);
+			from += CAPTURE_POS_STRIDE;
+			if (!--left) {
+				hostlink_u16(sum >> HOSTLINK_LOG2_DECIM);
+				sum = 0;
+				left = 1U << HOSTLINK_LOG2_DECIM;
+			}
+		}
+	}
+	hostlink_pending -= HOSTLINK_CHUNK;
+	hostlink_frame += HOSTLINK_CHUNK;
+	hostlink_send();
+}
+
+/**
+ * \internal
+ * \brief Send the next HOSTLINK_SNAPSHOT_FRAMES frames of the snapshot
+ */
+static void hostlink_snapshot_frames(void)
+{
+	uint16_t pos = hostlink_snap_start + hostlink_snap;
+	uint8_t i;
+	uint8_t ch;
+
+	hostlink_begin(HOSTLINK_SNAPSHOT);
+	hostlink_u16(hostlink_snap);
+	hostlink_u16(MAXBUFFER);
+	hostlink_u16(SAMPLERATE);
+	hostlink_u8(CHANNELS);
+	for (i = 0; i < HOSTLINK_SNAPSHOT_FRAMES; i++, pos++) {
+		pos &= MAXBUFFER - 1;
+		for (ch = 0; ch < CHANNELS; ch++) {
+			hostlink_u16(hugemem_read16(capture_ring_addr(ch, pos)));
+		}
+	}
+	hostlink_snap += HOSTLINK_SNAPSHOT_FRAMES;
+	hostlink_send();
+}
+
+/**
+ * \internal
+ * \brief Let the last bytes at the old rate leave the USART
+ *
+ * The transmit ring empties a byte ahead of the shift register; one RTC
+ * tick covers two characters at 115200 baud with room to spare.
+ */
+static void hostlink_drain(void)
+{
+	uint32_t start;
+
+	serial_tx_flush();
+	start = rtc_get_time();
+	while (rtc_get_time() - start < 2);
+}
+
+/**
+ * \brief Switch the stdio USART to the link
+ */
+void hostlink_start(void)
+{
+	hostlink_drain();
+	usart_set_baudrate(USART_SERIAL, HOSTLINK_BAUDRATE, sysclk_get_per_hz());
+	hostlink_reading_wait = 0;
+	hostlink_active = true;
+}
+
+/**
+ * \brief Switch the stdio USART back to text
+ */
+void hostlink_stop(void)
+{
+	if (hostlink_snap < MAXBUFFER) {
+		hostlink_snap = MAXBUFFER;
+		capture_resume();
+	}
+	hostlink_drain();
+	usart_set_baudrate(USART_SERIAL, USART_SERIAL_BAUDRATE,
+			sysclk_get_per_hz());
+	hostlink_active = false;
+}
+
+/**
+ * \brief Whether the link is on
+ */
+bool hostlink_is_active(void)
+{
+	return hostlink_active;
+}
+
+/**
+ * \brief Stream the samples of channel \a ch, or of none if \a ch is
+ * CHANNELS or more
+ */
+void hostlink_set_samples(uint8_t ch)
+{
+	uint16_t end_pos;
+
+	hostlink_raw_ch = (ch < CHANNELS) ? ch : HOSTLINK_RAW_OFF;
+	// From the next hop on
+	capture_hop_take(&hostlink_hops_seen, &end_pos);
+	hostlink_pending = 0;
+	hostlink_frame = 0;
+}
+
+/**
+ * \brief Stop the capture and send the whole ring, if the link is on
+ */
+void hostlink_snapshot(void)
+{
+	if (!hostlink_active || hostlink_snap < MAXBUFFER) {
+		return;
+	}
+	capture_stop();
+	// The oldest frame is the next one the capture would have written
+	hostlink_snap_start = capture_write_pos;
+	hostlink_snap = 0;
+}
+
+/**
+ * \brief Send the frames due, scheduler task
+ *
+ * Samples frames go out while the ring has room for one, the readings
+ * every HOSTLINK_READING_PERIOD; a snapshot holds both back until it is
+ * through. When the link falls half a ring behind the capture, the
+ * oldest samples are skipped.
+ *
+ * \retval false always, one slice per period
+ */
+bool hostlink_run(void)
+{
+	uint16_t end_pos;
+	uint8_t hops;
+
+	if (!hostlink_active) {
+		return false;
+	}
+
+	if (hostlink_snap < MAXBUFFER) {
+		while (hostlink_snap < MAXBUFFER
+				&& serial_tx_get_free() >= HOSTLINK_FRAME_MAX) {
+			hostlink_snapshot_frames();
+		}
+		if (hostlink_snap == MAXBUFFER) {
+			hostlink_pending = 0;
+			capture_resume();
+		}
+		return false;
+	}
+
+	if (hostlink_raw_ch != HOSTLINK_RAW_OFF) {
+		hops = capture_hop_take(&hostlink_hops_seen, &end_pos);
+		if (hops) {
+			hostlink_pending += (uint16_t)hops * CAPTURE_HOP;
+			hostlink_end = end_pos;
+		}
+		if (hostlink_pending > MAXBUFFER / 2) {
+			uint16_t skip = (hostlink_pending - HOSTLINK_CHUNK)
+					& ~(HOSTLINK_CHUNK - 1);
+
+			hostlink_pending -= skip;
+			hostlink_frame += skip;
+		}
+		while (hostlink_pending >= HOSTLINK_CHUNK
+				&& serial_tx_get_free() >= HOSTLINK_FRAME_MAX) {
+			hostlink_samples();
+		}
+	}
+
+	if (!hostlink_reading_wait) {
+		hostlink_readings();
+		hostlink_reading_wait = HOSTLINK_READING_PERIOD / HOSTLINK_PERIOD;
+	}
+	hostlink_reading_wait--;
+	return false;
+}
@@ -0,0 +1,133 @@
+/**
+ * \file
+ *
+ * \brief Framed binary telemetry on the stdio USART
+ *
+ * For logging tuning sessions on a host. Shell command "link on" switches
+ * the USART to HOSTLINK_BAUDRATE and replaces the text readings with
+ * frames; "link off", sent at the new rate, switches back. Each frame is
+ * COBS encoded and ended by a 0 byte, so a host resynchronises at the
+ * next 0 after a lost byte, and carries
+ * \code
+	type    u8      enum hostlink_type
+	seq     u8      counts every frame, sent or dropped
+	payload
+	crc     u16     CRC-16/CCITT of type to payload, as _crc_ccitt_update()
+\endcode
+ * with every field little endian. Text still printed by commands arrives
+ * as frames that fail the CRC.
+ *
+ * A \ref HOSTLINK_READINGS frame goes out every HOSTLINK_READING_PERIOD:
+ * \code
+	time    u32     timebase_now(), microseconds
+	CHANNELS times:
+	freq    u32     Q16.16 Hz, 0 for no pitch
+	cents   s16     Q8.8 cents from the nearest string
+	string  u8      nearest string, 0xff for no pitch
+	flags   u8      HOSTLINK_FLAG_*
+	level   u16     engine level, the confidence the pitch has
+	inharm  u16     FFT partial tracker B, 1e-6 units, 0 if none
+	stamp   u32     timebase_now() of the newest sample the reading used
+\endcode
+ * so time - stamp is how old the reading is as it leaves.
+ * Shell command "stream raw <ch>" selects a channel whose ring samples
+ * are streamed as well, until "stream off", 2^HOSTLINK_LOG2_DECIM ring
+ * samples averaged into one, in \ref HOSTLINK_SAMPLES frames:
+ * \code
+	ch      u8
+	decim   u8      HOSTLINK_LOG2_DECIM
+	frame   u32     ring frame of the first sample, from the selection
+	samples s16 x HOSTLINK_SAMPLES_PER_FRAME
+\endcode
+ * A jump in frame shows samples dropped while the link was behind.
+ *
+ * Shell command "snapshot" takes a snapshot of the whole ring for replay
+ * through the pitch engines offline. The capture stops, so the ring holds
+ * still and the analysis runs dry, and all MAXBUFFER frames go out,
+ * oldest first, in \ref HOSTLINK_SNAPSHOT frames:
+ * \code
+	first   u16     index of the first frame, 0 to MAXBUFFER - 1
+	total   u16     MAXBUFFER
+	rate    u16     SAMPLERATE
+	chans   u8      CHANNELS
+	frames  s16 x CHANNELS x HOSTLINK_SNAPSHOT_FRAMES, frame by frame
+\endcode
+ * in ring units, with no readings in between. A snapshot frame that
+ * finds no room waits for it instead of being dropped. The capture then
+ * resumes with \ref capture_resume().
+ *
+ * Frames are queued whole, or dropped, on the \ref serial_tx.h ring; at
+ * 1 Mbaud draining it costs a data register empty interrupt per
+ * 10 us.
+ *
+ */
+
+#ifndef HOSTLINK_H
+#define HOSTLINK_H
+
+#include <compiler.h>
+#include "capture.h"
+
+//! USART rate while the link is on; 32 MHz / 32, exact
+#ifndef HOSTLINK_BAUDRATE
+#  define HOSTLINK_BAUDRATE     1000000UL
+#endif
+
+//! Task period in RTC ticks
+#ifndef HOSTLINK_PERIOD
+#  define HOSTLINK_PERIOD       2
+#endif
+
+//! Readings period in RTC ticks, about 32 Hz
+#ifndef HOSTLINK_READING_PERIOD
+#  define HOSTLINK_READING_PERIOD   32
+#endif
+
+//! log2 of the ring samples averaged per streamed sample
+#ifndef HOSTLINK_LOG2_DECIM
+#  define HOSTLINK_LOG2_DECIM   2
+#endif
+
+//! Streamed samples per frame
+#define HOSTLINK_SAMPLES_PER_FRAME  32
+
+//! Ring frames per snapshot frame
+#define HOSTLINK_SNAPSHOT_FRAMES    16
+
+//! Ring frames behind one samples frame
+#define HOSTLINK_CHUNK \
+	((uint16_t)HOSTLINK_SAMPLES_PER_FRAME << HOSTLINK_LOG2_DECIM)
+
+#if HOSTLINK_READING_PERIOD % HOSTLINK_PERIOD
+#  error "HOSTLINK_READING_PERIOD must be whole task periods"
+#endif
+#if HOSTLINK_CHUNK > MAXBUFFER / 4
+#  error "A samples frame must be well inside the ring"
+#endif
+#if MAXBUFFER % HOSTLINK_SNAPSHOT_FRAMES || SAMPLERATE > UINT16_MAX
+#  error "The snapshot must be whole frames of a 16-bit rate"
+#endif
+
+//! Frame types
+enum hostlink_type {
+	HOSTLINK_READINGS = 1,
+	HOSTLINK_SAMPLES = 2,
+	HOSTLINK_SNAPSHOT = 3,
+};
+
+//! \name Reading flags
+//@{
+//! The channel has a pitch
+#define HOSTLINK_FLAG_PITCH     (1 << 0)
+//! Within DISPLAY_TUNE_CENTS of the string
+#define HOSTLINK_FLAG_TUNED     (1 << 1)
+//@}
+
+void hostlink_start(void);
+void hostlink_stop(void);
+bool hostlink_is_active(void);
+void hostlink_set_samples(uint8_t ch);
+void hostlink_snapshot(void);
+bool hostlink_run(void);
+
+#endif /* HOSTLINK_H */
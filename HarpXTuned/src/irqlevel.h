@@ -0,0 +1,54 @@
+/**
+ * \file
+ *
+ * \brief Interrupt priority plan
+ *
+ * Every interrupt the firmware enables takes its PMIC level from here, by
+ * role, rather than from the driver default:
+ * - HI, the capture: the DMA half-buffer interrupt, or the sweep interrupt
+ *   in CAPTURE_MODE_SWEEP. It decimates a whole half-buffer and must be
+ *   through before the DMA fills the other half, whatever else is busy.
+ * - MED, the byte streams: the stdio and \ref chain.h USARTs, whose
+ *   receivers drop bytes if not served within a character, and the
+ *   \ref tone.h DAC feed, where a late sample is heard. The SPI devices
+ *   are polled and have no interrupt.
+ * - LO, housekeeping: the RTC of conf_rtc.h, the \ref timebase.h and
+ *   \ref prof.h counter overflows, the \ref sync.h edge capture and the
+ *   listening wake-up of the capture. They only have to run within
+ *   milliseconds, and are served round robin, so that none of them
+ *   starves under a busy vector of lower number.
+ *
+ * The sampling instants themselves come from TCC1 through the event
+ * system and no interrupt latency reaches them: a burst of telemetry only
+ * moves the decimation, which HI keeps well within its half-buffer.
+ *
+ */
+
+#ifndef IRQLEVEL_H
+#define IRQLEVEL_H
+
+#include <compiler.h>
+
+//! \name HI: the capture
+//@{
+#define IRQLEVEL_CAPTURE_DMA    DMA_CH_TRNINTLVL_HI_gc
+#define IRQLEVEL_CAPTURE_ADC    ADC_CH_INTLVL_HI_gc
+//@}
+
+//! \name MED: the byte streams
+//@{
+#define IRQLEVEL_USART          USART_INT_LVL_MED
+#define IRQLEVEL_TONE_DMA       DMA_CH_TRNINTLVL_MED_gc
+#define IRQLEVEL_TONE_TC        TC_INT_LVL_MED
+//@}
+
+//! \name LO: housekeeping; the RTC levels are set in conf_rtc.h
+//@{
+#define IRQLEVEL_TC             TC_INT_LVL_LO
+#define IRQLEVEL_LISTEN_ADC     ADC_CH_INTLVL_LO_gc
+//@}
+
+//! Scheduling within the levels
+#define IRQLEVEL_SCHEDULING     PMIC_SCH_ROUND_ROBIN
+
+#endif /* IRQLEVEL_H */
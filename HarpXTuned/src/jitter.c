@@ -0,0 +1,199 @@
+/**
+ * \file
+ *
+ * \brief Sampling jitter and missed sweeps of the capture path
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "capture.h"
+#include "evsys.h"
+#include "jitter.h"
+
+#ifdef CONFIG_JITTER
+
+//! \internal Entries per latency bin, halved together before one wraps
+static uint16_t jitter_bins[JITTER_BINS];
+//! \internal Entries since the last reset
+static uint32_t jitter_entries;
+//! \internal Sweeps missed since the last reset
+static uint32_t jitter_missed;
+//! \internal Least and largest entry latency in clocks
+static uint16_t jitter_min = UINT16_MAX;
+static uint16_t jitter_max;
+//! \internal JITTER_TC count at the last entry
+static uint16_t jitter_last;
+//! \internal Sweep triggers counted and not yet taken by an entry
+static int16_t jitter_lag;
+
+/**
+ * \brief Count the sweep triggers
+ *
+ * Call after \ref capture_init(), which routes CAPTURE_EVENT_CH.
+ */
+void jitter_init(void)
+{
+	tc_enable(&JITTER_TC);
+	tc_write_period(&JITTER_TC, 0xffff);
+	tc_write_clock_source(&JITTER_TC, EVSYS_TC_CLKSEL(CAPTURE_EVENT_CH));
+	jitter_reset();
+}
+
+/**
+ * \brief Take the triggers from here on, as the capture starts
+ *
+ * Call with TCC1 stopped.
+ */
+void jitter_restart(void)
+{
+	jitter_last = tc_read_count(&JITTER_TC);
+	jitter_lag = 0;
+}
+
+/**
+ * \brief One entry of the capture path, from the capture interrupt
+ *
+ * \param sweeps Sweep triggers behind the entry: 1 in sweep mode,
+ *        CAPTURE_BLOCK_SWEEPS in DMA mode
+ */
+void jitter_entry(uint16_t sweeps)
+{
+	uint16_t phase = tc_read_count(&TCC1);
+	uint16_t count = tc_read_count(&JITTER_TC);
+	uint32_t latency;
+	uint16_t clocks;
+	uint8_t bin;
+	uint8_t i;
+
+	jitter_lag += (int16_t)(count - jitter_last) - (int16_t)sweeps;
+	jitter_last = count;
+	while (jitter_lag >= (int16_t)sweeps) {
+		jitter_lag -= sweeps;
+		jitter_missed += sweeps;
+	}
+
+	// Triggers past the one expected to complete the entry, and the phase
+	latency = (uint32_t)Max(jitter_lag, 0) * PROFILE_SWEEP_PERIOD + phase;
+	clocks = (uint16_t)Min(latency, UINT16_MAX);
+	bin = Min(clocks >> JITTER_BIN_SHIFT, JITTER_BINS - 1);
+
+	if (jitter_bins[bin] == UINT16_MAX) {
+		for (i = 0; i < JITTER_BINS; i++) {
+			jitter_bins[i] >>= 1;
+		}
+	}
+	jitter_bins[bin]++;
+	jitter_entries++;
+	jitter_min = Min(jitter_min, clocks);
+	jitter_max = Max(jitter_max, clocks);
+}
+
+/**
+ * \brief Upper edge in clocks of the bin below which 99% of the entries
+ * fell, 0 before the first entry
+ */
+uint16_t jitter_get_p99(void)
+{
+	uint16_t bins[JITTER_BINS];
+	irqflags_t flags;
+	uint32_t total = 0;
+	uint32_t above = 0;
+	uint8_t i;
+
+	flags = cpu_irq_save();
+	memcpy(bins, jitter_bins, sizeof(bins));
+	cpu_irq_restore(flags);
+
+	for (i = 0; i < JITTER_BINS; i++) {
+		total += bins[i];
+	}
+	if (!total) {
+		return 0;
+	}
+	for (i = JITTER_BINS - 1; i > 0; i--) {
+		above += bins[i];
+		if (above * 100 > total) {
+			break;
+		}
+	}
+	return (uint16_t)(((uint32_t)i + 1) << JITTER_BIN_SHIFT) - 1;
+}
+
+/**
+ * \brief Largest entry latency in clocks
+ */
+uint16_t jitter_get_max(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t max = jitter_max;
+
+	cpu_irq_restore(flags);
+	return max;
+}
+
+/**
+ * \brief Sweeps missed since the last reset
+ */
+uint32_t jitter_get_missed(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint32_t missed = jitter_missed;
+
+	cpu_irq_restore(flags);
+	return missed;
+}
+
+/**
+ * \brief Clear the histogram and the sweeps missed
+ */
+void jitter_reset(void)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	memset(jitter_bins, 0, sizeof(jitter_bins));
+	jitter_entries = 0;
+	jitter_missed = 0;
+	jitter_min = UINT16_MAX;
+	jitter_max = 0;
+	cpu_irq_restore(flags);
+}
+
+/**
+ * \brief Print the entry latency and its histogram on the stdio USART
+ */
+void jitter_dump(void)
+{
+	irqflags_t flags;
+	uint32_t entries;
+	uint16_t count;
+	uint16_t min;
+	uint8_t i;
+
+	flags = cpu_irq_save();
+	entries = jitter_entries;
+	min = jitter_min;
+	cpu_irq_restore(flags);
+
+	if (!entries) {
+		printf_P(PSTR("jitter no entries\r\n"));
+		return;
+	}
+	printf_P(PSTR("jitter n %lu  min %u  p99 %u  max %u clocks"
+			"  missed %lu sweeps\r\n"),
+			(unsigned long)entries, min, jitter_get_p99(),
+			jitter_get_max(), (unsigned long)jitter_get_missed());
+	for (i = 0; i < JITTER_BINS; i++) {
+		flags = cpu_irq_save();
+		count = jitter_bins[i];
+		cpu_irq_restore(flags);
+		if (count) {
+			printf_P(PSTR("  %5u%S %u\r\n"), i << JITTER_BIN_SHIFT,
+					(i == JITTER_BINS - 1) ? PSTR("+") : PSTR(" "),
+					count);
+		}
+	}
+}
+
+#endif
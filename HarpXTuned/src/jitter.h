@@ -0,0 +1,74 @@
+/**
+ * \file
+ *
+ * \brief Sampling jitter and missed sweeps of the capture path
+ *
+ * Proof that the sampling is isochronous: at each entry of the capture
+ * path, the sweep interrupt in sweep mode and the completion of a DMA
+ * half in DMA mode, \ref jitter_entry() takes
+ * - the clocks since the sweep trigger that completed the entry, from the
+ *   TCC1 count within the sweep and the triggers since then, into a
+ *   histogram of JITTER_BINS bins of 2^JITTER_BIN_SHIFT clocks, the last
+ *   bin holding everything above;
+ * - the JITTER_TC count, which counts the sweep triggers themselves on
+ *   CAPTURE_EVENT_CH in hardware. Entries that lag the triggers by a
+ *   whole entry's worth of sweeps have lost one: in sweep mode the
+ *   results of a sweep were overwritten, in DMA mode a DMA half was
+ *   filled again before it was decimated. A late entry that still made it
+ *   only lags by part of one.
+ *
+ * \ref jitter_dump() prints the entries, the minimum, 99th percentile and
+ * maximum entry latency in peripheral clocks and the sweeps missed, with
+ * "profile dump" of \ref shell.h, and the \ref telemetry.h readings add
+ * a line when the maximum or the sweeps missed grow.
+ *
+ * The detector only exists when CONFIG_JITTER is defined; otherwise the
+ * calls are empty and nothing is linked.
+ *
+ */
+
+#ifndef JITTER_H
+#define JITTER_H
+
+#include <compiler.h>
+#include <tc.h>
+
+//! Counter of the sweep triggers, not to be used for anything else
+#define JITTER_TC               TCC0
+
+//! Bins of the entry latency histogram
+#ifndef JITTER_BINS
+#  define JITTER_BINS           32
+#endif
+
+//! log2 of the peripheral clocks per bin, 1 us at 32 MHz
+#ifndef JITTER_BIN_SHIFT
+#  define JITTER_BIN_SHIFT      5
+#endif
+
+#if JITTER_BINS > 255 || (JITTER_BINS << JITTER_BIN_SHIFT) > 65536L
+#  error "The jitter histogram must span at most the 16-bit TCC1 count"
+#endif
+
+#ifdef CONFIG_JITTER
+
+void jitter_init(void);
+void jitter_restart(void);
+void jitter_entry(uint16_t sweeps);
+uint16_t jitter_get_p99(void);
+uint16_t jitter_get_max(void);
+uint32_t jitter_get_missed(void);
+void jitter_reset(void);
+void jitter_dump(void);
+
+#else
+
+static inline void jitter_init(void) {}
+static inline void jitter_restart(void) {}
+static inline void jitter_entry(uint16_t sweeps) {}
+static inline void jitter_reset(void) {}
+static inline void jitter_dump(void) {}
+
+#endif
+
+#endif /* JITTER_H */
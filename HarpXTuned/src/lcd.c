@@ -0,0 +1,330 @@
+/**
+ * \file
+ *
+ * \brief SSD1306 OLED on the SPIC bus, with a framebuffer
+ *
+ */
+
+#include <asf.h>
+#include "lcd.h"
+#include "power.h"
+#ifdef CONFIG_HAVE_HUGEMEM
+#  include "sdram.h"
+#endif
+
+//! \internal \name SSD1306 commands
+//@{
+#define LCD_SET_COLUMNS         0x21
+#define LCD_SET_PAGES           0x22
+#define LCD_SET_CONTRAST        0x81
+#define LCD_DISPLAY_ON          0xaf
+//@}
+
+//! \internal Framebuffer bytes
+#define LCD_SIZE                (LCD_WIDTH * LCD_PAGES)
+
+//! \internal Framebuffer bytes sent per SPI burst
+#define LCD_CHUNK               32
+
+//! \internal Power-up sequence for a 128 x 64 module with a charge pump
+static PROGMEM_DECLARE(uint8_t, lcd_init_seq[]) = {
+	0xae,                   // display off
+	0xd5, 0x80,             // clock divide
+	0xa8, LCD_HEIGHT - 1,   // multiplex ratio
+	0xd3, 0x00,             // no display offset
+	0x40,                   // start line 0
+	0x8d, 0x14,             // charge pump on
+	0x20, 0x00,             // horizontal addressing
+	0xa1,                   // column 127 on SEG0
+	0xc8,                   // COM scan from the bottom
+	0xda, 0x12,             // alternative COM pins
+	0x81, LCD_CONTRAST,     // contrast
+	0xd9, 0xf1,             // precharge
+	0xdb, 0x40,             // VCOMH level
+	0xa4,                   // show the memory
+	0xa6,                   // not inverted
+};
+
+//! \internal 5 x 7 glyphs of " #+-0123456789ABCDEFG", a byte per column
+static PROGMEM_DECLARE(uint8_t, lcd_font[][5]) = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x14, 0x7f, 0x14, 0x7f, 0x14 },
+	{ 0x08, 0x08, 0x3e, 0x08, 0x08 },
+	{ 0x08, 0x08, 0x08, 0x08, 0x08 },
+	{ 0x3e, 0x51, 0x49, 0x45, 0x3e },
+	{ 0x00, 0x42, 0x7f, 0x40, 0x00 },
+	{ 0x42, 0x61, 0x51, 0x49, 0x46 },
+	{ 0x21, 0x41, 0x45, 0x4b, 0x31 },
+	{ 0x18, 0x14, 0x12, 0x7f, 0x10 },
+	{ 0x27, 0x45, 0x45, 0x45, 0x39 },
+	{ 0x3c, 0x4a, 0x49, 0x49, 0x30 },
+	{ 0x01, 0x71, 0x09, 0x05, 0x03 },
+	{ 0x36, 0x49, 0x49, 0x49, 0x36 },
+	{ 0x06, 0x49, 0x49, 0x29, 0x1e },
+	{ 0x7e, 0x11, 0x11, 0x11, 0x7e },
+	{ 0x7f, 0x49, 0x49, 0x49, 0x36 },
+	{ 0x3e, 0x41, 0x41, 0x41, 0x22 },
+	{ 0x7f, 0x41, 0x41, 0x22, 0x1c },
+	{ 0x7f, 0x49, 0x49, 0x49, 0x41 },
+	{ 0x7f, 0x09, 0x09, 0x09, 0x01 },
+	{ 0x3e, 0x41, 0x49, 0x49, 0x7a },
+};
+
+static struct spi_device lcd_device = {
+	.id = LCD_CS,
+};
+
+#ifdef CONFIG_HAVE_HUGEMEM
+static hugemem_ptr_t lcd_fb;
+#else
+static uint8_t lcd_fb[LCD_SIZE];
+#endif
+
+//! \internal First and last column of each page written since its flush;
+//! clean while the first is past the last
+static uint8_t lcd_dirty_lo[LCD_PAGES];
+static uint8_t lcd_dirty_hi[LCD_PAGES];
+
+//! \internal Page \ref lcd_flush() looks at first
+static uint8_t lcd_next_page;
+
+/**
+ * \internal
+ * \brief Framebuffer byte \a i
+ */
+static inline uint8_t lcd_fb_read(uint16_t i)
+{
+#ifdef CONFIG_HAVE_HUGEMEM
+	return hugemem_read8(lcd_fb + i);
+#else
+	return lcd_fb[i];
+#endif
+}
+
+/**
+ * \internal
+ * \brief Set framebuffer byte \a i to \a bits
+ */
+static inline void lcd_fb_write(uint16_t i, uint8_t bits)
+{
+#ifdef CONFIG_HAVE_HUGEMEM
+	hugemem_write8(lcd_fb + i, bits);
+#else
+	lcd_fb[i] = bits;
+#endif
+}
+
+/**
+ * \internal
+ * \brief Start the SPIC clock and select the panel
+ */
+static void lcd_select(void)
+{
+	power_get(POWER_SPIC);
+	spi_select_device(LCD_SPI, &lcd_device);
+}
+
+/**
+ * \internal
+ * \brief Deselect the panel and let the SPIC clock go
+ */
+static void lcd_deselect(void)
+{
+	spi_deselect_device(LCD_SPI, &lcd_device);
+	power_put(POWER_SPIC);
+}
+
+/**
+ * \internal
+ * \brief Send \a len command bytes from \a cmd
+ */
+static void lcd_command(const uint8_t *cmd, size_t len)
+{
+	gpio_set_pin_low(LCD_DC);
+	lcd_select();
+	spi_write_packet(LCD_SPI, cmd, len);
+	lcd_deselect();
+}
+
+/**
+ * \brief Set up the panel and clear it
+ *
+ * Call after \ref sdram_init(). The panel is write only, so a missing one
+ * goes unnoticed.
+ *
+ * \retval false if there is no room for the framebuffer
+ */
+bool lcd_init(void)
+{
+	uint8_t cmd[sizeof(lcd_init_seq)];
+	uint16_t i;
+	uint8_t page;
+
+#ifdef CONFIG_HAVE_HUGEMEM
+	lcd_fb = sdram_alloc(LCD_SIZE);
+	if (lcd_fb == HUGEMEM_NULL) {
+		return false;
+	}
+#endif
+	for (i = 0; i < LCD_SIZE; i++) {
+		lcd_fb_write(i, 0);
+	}
+	for (page = 0; page < LCD_PAGES; page++) {
+		lcd_dirty_lo[page] = 0;
+		lcd_dirty_hi[page] = LCD_WIDTH - 1;
+	}
+
+	ioport_configure_pin(DATAFLASH_SPI_SS, IOPORT_DIR_OUTPUT
+			| IOPORT_INIT_HIGH);
+	ioport_configure_pin(LCD_CS, IOPORT_DIR_OUTPUT | IOPORT_INIT_HIGH);
+	ioport_configure_pin(LCD_DC, IOPORT_DIR_OUTPUT | IOPORT_INIT_LOW);
+	// The clock runs only while the panel is selected from then on
+	power_get(POWER_SPIC);
+	spi_master_init(LCD_SPI);
+	spi_master_setup_device(LCD_SPI, &lcd_device, SPI_MODE_0,
+			LCD_BAUDRATE, 0);
+	spi_enable(LCD_SPI);
+	power_put(POWER_SPIC);
+
+	for (i = 0; i < sizeof(cmd); i++) {
+		cmd[i] = PROGMEM_READ_BYTE(&lcd_init_seq[i]);
+	}
+	lcd_command(cmd, sizeof(cmd));
+
+	// Send the cleared framebuffer before the panel shows its power-up RAM
+	while (lcd_flush());
+	cmd[0] = LCD_DISPLAY_ON;
+	lcd_command(cmd, 1);
+	return true;
+}
+
+/**
+ * \brief Set the segment current to \a contrast, LCD_CONTRAST at power-up
+ *
+ * Call between flushes; each page flushed sets its own address again.
+ */
+void lcd_set_contrast(uint8_t contrast)
+{
+	uint8_t cmd[2];
+
+	cmd[0] = LCD_SET_CONTRAST;
+	cmd[1] = contrast;
+	lcd_command(cmd, sizeof(cmd));
+}
+
+/**
+ * \brief Set column \a col of page \a page to \a bits, top row in bit 0
+ *
+ * Only a change of value makes the column dirty.
+ */
+void lcd_put(uint8_t page, uint8_t col, uint8_t bits)
+{
+	uint16_t i = (uint16_t)page * LCD_WIDTH + col;
+
+	Assert(page < LCD_PAGES && col < LCD_WIDTH);
+
+	if (lcd_fb_read(i) == bits) {
+		return;
+	}
+	lcd_fb_write(i, bits);
+	if (col < lcd_dirty_lo[page]) {
+		lcd_dirty_lo[page] = col;
+	}
+	if (col > lcd_dirty_hi[page]) {
+		lcd_dirty_hi[page] = col;
+	}
+}
+
+/**
+ * \brief Write \a s into page \a page from column \a col, clipped
+ *
+ * Characters without a glyph show as spaces.
+ *
+ * \return The column after the text
+ */
+uint8_t lcd_text(uint8_t page, uint8_t col, const char *s)
+{
+	for (; *s && col + LCD_CHAR_WIDTH <= LCD_WIDTH; s++) {
+		char c = *s;
+		uint8_t glyph = 0;
+		uint8_t i;
+
+		if (c == '#') {
+			glyph = 1;
+		} else if (c == '+') {
+			glyph = 2;
+		} else if (c == '-') {
+			glyph = 3;
+		} else if (c >= '0' && c <= '9') {
+			glyph = 4 + c - '0';
+		} else if (c >= 'A' && c <= 'G') {
+			glyph = 14 + c - 'A';
+		}
+		for (i = 0; i < 5; i++) {
+			lcd_put(page, col++, PROGMEM_READ_BYTE(&lcd_font[glyph][i]));
+		}
+		lcd_put(page, col++, 0);
+	}
+	return col;
+}
+
+/**
+ * \brief Send the dirty span of the next dirty page
+ *
+ * The pages are taken round robin, so one being redrawn all the time
+ * cannot hold up the others.
+ *
+ * \retval true if more pages are dirty
+ * \retval false if the panel is up to date
+ */
+bool lcd_flush(void)
+{
+	uint8_t left = LCD_PAGES;
+	uint8_t page = lcd_next_page;
+	uint8_t cmd[6];
+	uint8_t buf[LCD_CHUNK];
+	uint16_t i;
+	uint16_t end;
+
+	while (lcd_dirty_lo[page] > lcd_dirty_hi[page]) {
+		page = (page + 1) % LCD_PAGES;
+		if (!--left) {
+			return false;
+		}
+	}
+
+	cmd[0] = LCD_SET_COLUMNS;
+	cmd[1] = lcd_dirty_lo[page];
+	cmd[2] = lcd_dirty_hi[page];
+	cmd[3] = LCD_SET_PAGES;
+	cmd[4] = page;
+	cmd[5] = page;
+	lcd_command(cmd, sizeof(cmd));
+
+	i = (uint16_t)page * LCD_WIDTH + lcd_dirty_lo[page];
+	end = (uint16_t)page * LCD_WIDTH + lcd_dirty_hi[page] + 1;
+	lcd_dirty_lo[page] = LCD_WIDTH;
+	lcd_dirty_hi[page] = 0;
+
+	gpio_set_pin_high(LCD_DC);
+	lcd_select();
+	while (i < end) {
+		uint8_t n = (end - i > LCD_CHUNK) ? LCD_CHUNK : end - i;
+		uint8_t j;
+
+		for (j = 0; j < n; j++) {
+			buf[j] = lcd_fb_read(i++);
+		}
+		spi_write_packet(LCD_SPI, buf, n);
+	}
+	lcd_deselect();
+
+	lcd_next_page = (page + 1) % LCD_PAGES;
+	for (left = LCD_PAGES; left; left--) {
+		if (lcd_dirty_lo[page] <= lcd_dirty_hi[page]) {
+			return true;
+		}
+		page = (page + 1) % LCD_PAGES;
+	}
+	return false;
+}
@@ -0,0 +1,61 @@
+/**
+ * \file
+ *
+ * \brief SSD1306 OLED on the SPIC bus, with a framebuffer
+ *
+ * A 128 x 64 monochrome SSD1306 panel in 4-wire SPI mode, sharing SPIC
+ * with the DataFlash on a chip select of its own, plus a data/command
+ * pin. Like the DataFlash it holds the \ref power.h SPIC clock only while
+ * selected. The panel memory is in pages of 8 pixel rows, one byte per column
+ * with the top row in bit 0, and so is the framebuffer: in the
+ * \ref sdram.h arena when the build has CONFIG_HAVE_HUGEMEM, in SRAM
+ * otherwise.
+ *
+ * Drawing only changes the framebuffer. Each page keeps the span of
+ * columns written with new values since it was last sent, and
+ * \ref lcd_flush() sends the span of one page per call, in one
+ * \ref spi_write_packet() burst after setting the panel's address
+ * window. A moving needle or a changed digit costs a handful of bytes on
+ * the bus instead of the 1 KiB of a full redraw.
+ *
+ */
+
+#ifndef LCD_H
+#define LCD_H
+
+#include <compiler.h>
+#include <board.h>
+#include "dataflash.h"
+
+//! SPI module of the panel, shared with the DataFlash
+#define LCD_SPI                 DATAFLASH_SPI
+//! Chip select, active low
+#define LCD_CS                  IOPORT_CREATE_PIN(PORTC, 0)
+//! Data/command select, high for data
+#define LCD_DC                  IOPORT_CREATE_PIN(PORTC, 1)
+
+//! SPI clock in Hz, the SSD1306 takes up to 10 MHz
+#ifndef LCD_BAUDRATE
+#  define LCD_BAUDRATE          DATAFLASH_BAUDRATE
+#endif
+
+//! \name Panel geometry
+//@{
+#define LCD_WIDTH               128
+#define LCD_PAGES               8
+#define LCD_HEIGHT              (8 * LCD_PAGES)
+//@}
+
+//! Contrast set by \ref lcd_init()
+#define LCD_CONTRAST            0xcf
+
+//! Columns of one character of \ref lcd_text(), 5 x 7 glyph and a gap
+#define LCD_CHAR_WIDTH          6
+
+bool lcd_init(void);
+void lcd_set_contrast(uint8_t contrast);
+void lcd_put(uint8_t page, uint8_t col, uint8_t bits);
+uint8_t lcd_text(uint8_t page, uint8_t col, const char *s);
+bool lcd_flush(void);
+
+#endif /* LCD_H */
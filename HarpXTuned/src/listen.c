@@ -0,0 +1,107 @@
+/**
+ * \file
+ *
+ * \brief Standby listening between plucks
+ *
+ */
+
+#include <asf.h>
+#include "capture.h"
+#include "frameq.h"
+#include "gate.h"
+#include "listen.h"
+#include "record.h"
+#include "sched.h"
+
+#if LISTEN_QUIET
+
+//! \internal Polls with every gate closed
+static uint16_t listen_quiet;
+
+#endif
+
+/**
+ * \brief Enter or leave standby, scheduler task
+ *
+ * Posted by the capture when a pickup is heard as well as released every
+ * LISTEN_PERIOD. The capture restarts once the queue has drained, so the
+ * queue and the engines start afresh as after a snapshot.
+ *
+ * \retval true while a restart waits for the queue
+ * \retval false otherwise
+ */
+bool listen_run(void)
+{
+#if LISTEN_QUIET
+	switch (capture_get_state()) {
+	case CAPTURE_HEARD:
+		if (frameq_peek()) {
+			return true;
+		}
+		capture_stop();
+		capture_resume();
+		sched_set_alarm(false);
+		listen_quiet = 0;
+		break;
+
+	case CAPTURE_RUNNING:
+		if (gate_get_active() || record_get_state() == RECORD_RUNNING) {
+			listen_quiet = 0;
+		} else if (++listen_quiet >= LISTEN_QUIET / LISTEN_PERIOD) {
+			capture_listen();
+			sched_set_alarm(true);
+		}
+		break;
+
+	default:
+		break;
+	}
+#endif
+	return false;
+}
+
+/**
+ * \brief Stop the capture, running or listening, for a job that needs the
+ * ADCs or the DMA to itself
+ *
+ * Not from interrupts.
+ *
+ * \return The state to hand to \ref listen_restore() afterwards
+ */
+enum capture_state listen_suspend(void)
+{
+	enum capture_state state = capture_get_state();
+
+	capture_stop();
+	sched_set_alarm(false);
+	return state;
+}
+
+/**
+ * \brief Bring the capture back to \a state after \ref listen_suspend()
+ *
+ * A capture that listened listens again, with the RTC alarm; one that ran
+ * or had just been heard carries on with the next hop.
+ */
+void listen_restore(enum capture_state state)
+{
+	switch (state) {
+#if LISTEN_QUIET
+	case CAPTURE_LISTENING:
+		capture_listen();
+		sched_set_alarm(true);
+		break;
+#endif
+
+	case CAPTURE_RUNNING:
+	case CAPTURE_HEARD:
+		capture_resume();
+#if LISTEN_QUIET
+		listen_quiet = 0;
+#endif
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,47 @@
+/**
+ * \file
+ *
+ * \brief Standby listening between plucks
+ *
+ * Once every channel's gate has stayed closed for LISTEN_QUIET, the listen
+ * task hands the ADCs to \ref capture_listen(): the capture interrupt and
+ * the analysis stop, and the scheduler sleeps from one RTC alarm to the
+ * next periodic release. A pluck that rises above the gate's open level
+ * raises an ADC compare interrupt, which posts the task to restart the
+ * capture within a few RTC ticks. The gates start closed, so the first
+ * block is an onset and the FFT engine runs at the end of that first hop.
+ *
+ * No standby is entered while a \ref record.h recording runs, and only in
+ * CAPTURE_MODE_DMA, where the ADC channel vectors are free.
+ *
+ */
+
+#ifndef LISTEN_H
+#define LISTEN_H
+
+#include <compiler.h>
+#include "capture.h"
+
+//! Poll period of the gates in RTC ticks, 4 Hz
+#ifndef LISTEN_PERIOD
+#  define LISTEN_PERIOD         256
+#endif
+
+//! RTC ticks of silence before standby, 10 s; 0 never enters it
+#ifndef LISTEN_QUIET
+#  if CAPTURE_MODE == CAPTURE_MODE_DMA
+#    define LISTEN_QUIET        10240
+#  else
+#    define LISTEN_QUIET        0
+#  endif
+#endif
+
+#if LISTEN_QUIET && CAPTURE_MODE != CAPTURE_MODE_DMA
+#  error "Listening needs CAPTURE_MODE_DMA"
+#endif
+
+bool listen_run(void);
+enum capture_state listen_suspend(void);
+void listen_restore(enum capture_state state);
+
+#endif /* LISTEN_H */
@@ -0,0 +1,264 @@
+/**
+ * \file
+ *
+ * \brief DAC to ADC loopback test of the whole tuning path
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "capture.h"
+#include "harp.h"
+#include "loopback.h"
+#include "notes.h"
+#include "pitch.h"
+#include "timebase.h"
+#include "tone.h"
+
+//! \internal Steps of a run
+enum loopback_step {
+	//! No run
+	LOOPBACK_IDLE,
+	//! Waiting for the channel to fall silent before a burst
+	LOOPBACK_QUIET,
+	//! A burst plays, the readings are watched for its lock
+	LOOPBACK_PLAYING,
+	//! The burst locked, or ran out of time with loopback_first 0
+	LOOPBACK_DONE,
+};
+
+//! \internal Sums over the bursts of a run
+struct loopback_totals {
+	uint32_t min_us;
+	uint32_t max_us;
+	uint32_t sum_us;
+	//! Largest mean error of a burst, Q8.8 cents
+	notes_offset_t worst;
+	uint8_t locked;
+};
+
+//! \internal Step of the run
+static enum loopback_step loopback_step;
+//! \internal Burst playing or next, from 0
+static uint8_t loopback_burst;
+//! \internal String and pitch of the burst
+static uint8_t loopback_string;
+static notes_cents_t loopback_target;
+//! \internal timebase_now() at the start of the burst or of the silence
+static uint32_t loopback_since;
+//! \internal timebase_now() of the first reading of the current run
+static uint32_t loopback_first;
+//! \internal Readings, or silent releases, in a row
+static uint8_t loopback_count;
+//! \internal Sum of the errors of the readings in a row
+static int32_t loopback_sum;
+static struct loopback_totals loopback_totals;
+
+/**
+ * \internal
+ * \brief String of burst \a burst, spread evenly over the group of
+ * LOOPBACK_CH
+ */
+static uint8_t loopback_pick(uint8_t burst)
+{
+	const struct harp_group *group = &harp_groups[LOOPBACK_CH];
+
+#if LOOPBACK_BURSTS == 1
+	UNUSED(burst);
+	return group->first + group->count / 2;
+#else
+	return group->first + (uint8_t)((uint16_t)burst * (group->count - 1)
+			/ (LOOPBACK_BURSTS - 1));
+#endif
+}
+
+//! \internal Print \a offset, Q8.8 cents, as signed tenths of a cent
+static void loopback_print_cents(notes_offset_t offset)
+{
+	uint16_t tenths = ((uint32_t)Abs(offset) * 10 + 128) >> 8;
+
+	printf_P(PSTR("%c%u.%u cents"), (offset < 0) ? '-' : '+',
+			tenths / 10, tenths % 10);
+}
+
+/**
+ * \brief Start a run
+ *
+ * \retval false the capture is not running, or a run or a tone already is
+ */
+bool loopback_start(void)
+{
+	if (loopback_step != LOOPBACK_IDLE || tone_is_playing()
+			|| capture_get_state() != CAPTURE_RUNNING) {
+		return false;
+	}
+	loopback_totals.min_us = UINT32_MAX;
+	loopback_totals.max_us = 0;
+	loopback_totals.sum_us = 0;
+	loopback_totals.worst = 0;
+	loopback_totals.locked = 0;
+	loopback_burst = 0;
+	loopback_count = 0;
+	loopback_since = timebase_now();
+	loopback_step = LOOPBACK_QUIET;
+	return true;
+}
+
+/**
+ * \brief Stop a run and its tone
+ */
+void loopback_stop(void)
+{
+	if (loopback_step == LOOPBACK_IDLE) {
+		return;
+	}
+	tone_stop();
+	loopback_step = LOOPBACK_IDLE;
+}
+
+/**
+ * \brief Take the new reading of channel \a ch, from \ref pitch_filter()
+ *
+ * Stamped here rather than at the next task release, to time the lock to
+ * the slice of the engine that found it.
+ */
+void loopback_reading(uint8_t ch)
+{
+	pitch_hz_t freq = pitch_readings[ch].freq;
+	notes_offset_t offset;
+
+	if (loopback_step != LOOPBACK_PLAYING || ch != LOOPBACK_CH) {
+		return;
+	}
+	if (!freq) {
+		loopback_count = 0;
+		return;
+	}
+	offset = notes_offset(notes_from_hz(freq), loopback_target);
+	if (offset > NOTES_OFFSET(LOOPBACK_WINDOW)
+			|| offset < -NOTES_OFFSET(LOOPBACK_WINDOW)) {
+		loopback_count = 0;
+		return;
+	}
+	if (!loopback_count) {
+		loopback_first = timebase_now();
+		loopback_sum = 0;
+	}
+	loopback_sum += offset;
+	if (++loopback_count == LOOPBACK_STABLE) {
+		loopback_step = LOOPBACK_DONE;
+	}
+}
+
+/**
+ * \internal
+ * \brief Start the next burst
+ */
+static void loopback_play(void)
+{
+	pitch_hz_t freq;
+
+	loopback_string = loopback_pick(loopback_burst);
+	freq = harp_string_freq(loopback_string);
+	loopback_target = notes_from_hz(freq);
+	loopback_count = 0;
+	tone_start(freq);
+	loopback_since = timebase_now();
+	loopback_step = LOOPBACK_PLAYING;
+}
+
+/**
+ * \internal
+ * \brief Report the burst that ended at \a now and go on to the next
+ */
+static void loopback_finish(uint32_t now)
+{
+	struct loopback_totals *t = &loopback_totals;
+	pitch_hz_t freq = harp_string_freq(loopback_string);
+	uint32_t us;
+	notes_offset_t error;
+	bool pass;
+
+	tone_stop();
+	printf_P(PSTR("loopback string %u %lu Hz: "), loopback_string,
+			(unsigned long)(freq >> 16));
+	if (loopback_step == LOOPBACK_DONE) {
+		us = loopback_first - loopback_since;
+		error = (notes_offset_t)(loopback_sum / LOOPBACK_STABLE);
+		printf_P(PSTR("%lu us "), (unsigned long)us);
+		loopback_print_cents(error);
+		printf_P(PSTR("\r\n"));
+
+		t->min_us = Min(t->min_us, us);
+		t->max_us = Max(t->max_us, us);
+		t->sum_us += us;
+		t->worst = Max(t->worst, (notes_offset_t)Abs(error));
+		t->locked++;
+	} else {
+		printf_P(PSTR("no lock\r\n"));
+	}
+
+	loopback_count = 0;
+	loopback_since = now;
+	loopback_step = LOOPBACK_QUIET;
+	if (++loopback_burst < LOOPBACK_BURSTS) {
+		return;
+	}
+
+	loopback_step = LOOPBACK_IDLE;
+	pass = t->locked == LOOPBACK_BURSTS && t->max_us <= LOOPBACK_MAX_US
+			&& t->worst <= NOTES_OFFSET(LOOPBACK_MAX_CENTS);
+	if (!t->locked) {
+		printf_P(PSTR("loopback %u bursts, none locked: FAIL\r\n"),
+				LOOPBACK_BURSTS);
+		return;
+	}
+	printf_P(PSTR("loopback %u bursts, min %lu avg %lu max %lu us, worst "),
+			LOOPBACK_BURSTS, (unsigned long)t->min_us,
+			(unsigned long)(t->sum_us / t->locked),
+			(unsigned long)t->max_us);
+	loopback_print_cents(t->worst);
+	printf_P(PSTR(": %S\r\n"), pass ? PSTR("ok") : PSTR("FAIL"));
+}
+
+/**
+ * \brief Step the run, scheduler task
+ *
+ * Released every LOOPBACK_PERIOD; does nothing without a run.
+ *
+ * \retval false always
+ */
+bool loopback_run(void)
+{
+	uint32_t now = timebase_now();
+
+	switch (loopback_step) {
+	case LOOPBACK_IDLE:
+		break;
+
+	case LOOPBACK_QUIET:
+		if (pitch_readings[LOOPBACK_CH].freq) {
+			loopback_count = 0;
+		} else if (++loopback_count == LOOPBACK_STABLE) {
+			loopback_play();
+			break;
+		}
+		if (now - loopback_since > LOOPBACK_TIMEOUT) {
+			printf_P(PSTR("loopback channel %u not silent: FAIL\r\n"),
+					LOOPBACK_CH);
+			loopback_step = LOOPBACK_IDLE;
+		}
+		break;
+
+	case LOOPBACK_PLAYING:
+		if (now - loopback_since > LOOPBACK_TIMEOUT) {
+			loopback_finish(now);
+		}
+		break;
+
+	case LOOPBACK_DONE:
+		loopback_finish(now);
+		break;
+	}
+	return false;
+}
@@ -0,0 +1,92 @@
+/**
+ * \file
+ *
+ * \brief DAC to ADC loopback test of the whole tuning path
+ *
+ * With the speaker output, DACB channel 0 on PB2, wired through a divider
+ * to the pickup input of channel LOOPBACK_CH, "loopback" on the
+ * \ref shell.h plays LOOPBACK_BURSTS \ref tone.h bursts at strings spread
+ * over the group of that channel and times each one on the
+ * \ref timebase.h clock, from the start of the tone to the first of
+ * LOOPBACK_STABLE readings in a row within LOOPBACK_WINDOW cents of it, as
+ * the pitch engine hands them to \ref pitch_filter(). That is the whole
+ * path a string takes: ADC, decimator, gate, engine and filter. Each burst
+ * prints
+ * \code
+	loopback string 18 261 Hz: 84213 us -0.4 cents
+\endcode
+ * with the mean error of the stable readings, or "no lock" after
+ * LOOPBACK_TIMEOUT, and the run ends with the latency and the worst error
+ * over all bursts against LOOPBACK_MAX_US and LOOPBACK_MAX_CENTS:
+ * \code
+	loopback 4 bursts, min 61022 avg 80311 max 98805 us, worst 0.7 cents: ok
+\endcode
+ * so one line tells whether a build tunes as fast and as well as the
+ * last. Before each burst the channel must read silence at LOOPBACK_STABLE
+ * releases in a row of the loopback task, so that no burst is timed from
+ * a lock the last one left. "loopback off" stops a run.
+ *
+ * The capture must be running. The speaker amplifier shares PQ3 with the
+ * DataFlash chip select, so the tone mutes while a recording writes; do
+ * not record during a run.
+ *
+ */
+
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+#include <compiler.h>
+#include "capture.h"
+
+//! Channel whose pickup input the speaker output is wired to
+#ifndef LOOPBACK_CH
+#  define LOOPBACK_CH           0
+#endif
+
+//! Bursts of a run, spread over the strings of LOOPBACK_CH
+#ifndef LOOPBACK_BURSTS
+#  define LOOPBACK_BURSTS       4
+#endif
+
+//! Readings in a row that make a lock, or task releases a silence
+#ifndef LOOPBACK_STABLE
+#  define LOOPBACK_STABLE       4
+#endif
+
+//! Cents from the tone of a reading that counts towards a lock
+#ifndef LOOPBACK_WINDOW
+#  define LOOPBACK_WINDOW       5
+#endif
+
+//! Release period of the loopback task in RTC ticks
+#ifndef LOOPBACK_PERIOD
+#  define LOOPBACK_PERIOD       16
+#endif
+
+//! Microseconds a burst is given to lock, and the channel to fall silent
+#ifndef LOOPBACK_TIMEOUT
+#  define LOOPBACK_TIMEOUT      2000000UL
+#endif
+
+//! \name Pass marks of a run
+//@{
+//! Longest latency of a burst in microseconds
+#ifndef LOOPBACK_MAX_US
+#  define LOOPBACK_MAX_US       250000UL
+#endif
+//! Largest mean error of a burst in cents
+#ifndef LOOPBACK_MAX_CENTS
+#  define LOOPBACK_MAX_CENTS    1
+#endif
+//@}
+
+#if LOOPBACK_CH >= CHANNELS || !LOOPBACK_BURSTS || LOOPBACK_STABLE > 255
+#  error "LOOPBACK_CH must be a channel and the run at least one burst"
+#endif
+
+bool loopback_start(void);
+void loopback_stop(void);
+void loopback_reading(uint8_t ch);
+bool loopback_run(void);
+
+#endif /* LOOPBACK_H */
@@ -10,61 +10,279 @@
  * Atmel Software Framework (ASF).
  */
 #include <asf.h>
+#include "auxadc.h"
+#include "baseline.h"
+#include "calib.h"
+#include "chain.h"
+#include "harp.h"
+#include "irqlevel.h"
+#include "sdram.h"
+#include "capture.h"
+#include "frameq.h"
+#include "gliss.h"
+#include "pitch.h"
+#include "pitch_fft.h"
+#include "selfcheck.h"
+#include "prof.h"
+#include "jitter.h"
+#include "sched.h"
+#include "display.h"
+#include "telemetry.h"
+#include "hostlink.h"
+#include "serial_rx.h"
+#include "serial_tx.h"
+#include "record.h"
+#include "pedal.h"
+#include "listen.h"
+#include "loopback.h"
+#include "shell.h"
+#include "predict.h"
+#include "stats.h"
+#include "tableload.h"
+#include "sync.h"
+#include "tempcomp.h"
+#include "tone.h"
+#include "timebase.h"
 
-#define MAXBUFFER 2048
-#define CHANNELS 4
-#define SAMPLERATE 48000
-#define OVERSAMPLING 4
+#if PITCH_BATCH_CHANNELS
+//! Capture hops taken so far, frames since the last batch job and
+//! channels open and onsets during them
+static uint8_t analysis_hops_seen;
+static uint16_t analysis_hop;
+static uint8_t analysis_hop_active;
+static uint8_t analysis_hop_onset;
+//! A batch job is due or running, and the channel it works on next
+static bool analysis_batch;
+static uint8_t analysis_batch_ch;
+//! Ring position, stamp and open channels of the current batch job
+static uint16_t analysis_end_pos;
+static uint32_t analysis_time;
+static uint8_t analysis_active;
+#endif
+#if PITCH_STREAM_CHANNELS
+//! Block the streaming engines are fed, held in the queue until done,
+//! and the channel fed next
+static const frameq_block_t *analysis_block;
+static uint8_t analysis_ch;
+#endif
 
-int16_t buf[CHANNELS][MAXBUFFER];
-volatile Bool railFull = false;
+/*
+ * Take the next block off the frame queue. Posted by the capture
+ * interrupt for every block and by the analysis task when it is done
+ * with one. The streaming engines are handed the block itself, and it
+ * waits in the queue for them. The batch engines only need the capture
+ * hops and which channels are open, and read their windows from the ring;
+ * without streaming channels the blocks are released right away. An
+ * onset brings the next batch job forward to the end of the capture hop,
+ * so a pluck reads within one hop, also straight out of standby
+ * listening. In the \ref gliss.h mode the hops and onsets go to its
+ * queue instead.
+ */
+static bool consume_run(void)
+{
+	const frameq_block_t *block = frameq_peek();
+#if PITCH_BATCH_CHANNELS
+	uint16_t end_pos;
+	uint8_t hops;
+#endif
 
-volatile curChannel=0;
-volatile writePos=0;
-volatile overSamplePos=0;
- 
+	if (!block)
+	{
+		return false;
+	}
+#if PITCH_STREAM_CHANNELS
+	if (analysis_block)
+	{
+		return false;
+	}
+#endif
+#if PITCH_BATCH_CHANNELS
+	// Channels open at any time during the hop
+	analysis_hop_active |= block->active;
+	analysis_hop_onset |= block->onset;
+	hops = capture_hop_take(&analysis_hops_seen, &end_pos);
+	analysis_hop += CAPTURE_HOP * hops;
+	if (gliss_is_on())
+	{
+		// The onsets are queued and analysed behind the burst instead
+		if (hops)
+		{
+			gliss_hop(hops, analysis_hop_onset & PITCH_BATCH_CHANNELS,
+					end_pos, block->time);
+			analysis_hop = 0;
+			analysis_hop_active = 0;
+			analysis_hop_onset = 0;
+		}
+	}
+	else if (analysis_hop >= PITCH_FFT_HOP
+			|| (analysis_hop && analysis_hop_onset))
+	{
+		// A hop that ends while the last job still runs is skipped
+		if (!analysis_batch)
+		{
+			// Blocks still queued behind this one only make it early
+			analysis_end_pos = end_pos;
+			analysis_time = block->time;
+			analysis_active = analysis_hop_active;
+			analysis_batch = true;
+			sched_post(SCHED_ANALYSIS);
+		}
+		else
+		{
+			sched_miss(SCHED_ANALYSIS);
+		}
+		analysis_hop = 0;
+		analysis_hop_active = 0;
+		analysis_hop_onset = 0;
+	}
+#endif
+#if PITCH_STREAM_CHANNELS
+	analysis_block = block;
+	sched_post(SCHED_ANALYSIS);
+	return false;
+#else
+	frameq_release();
+	return frameq_peek() != NULL;
+#endif
+}
 
-// HFSampleLoop speed is SAMPLERATE*OVERSAMPLING*CHANNELS
-// i.e. $> 48000*8*4=1536000 = 1.536Mhz
-void HFSampleLoop() // this will sample the stuff, when the whole mux has been done it will set a flag so the data can be evaluated
+/*
+ * Run the pitch engine of one channel per slice, so a slow channel does
+ * not hold up the display and telemetry tasks. With both kinds of engine
+ * the two jobs are apart: a block waiting for the streaming channels
+ * goes first, and the batch job takes the slices in between, so the
+ * queue only has to cover one batch slice rather than a whole job.
+ */
+static bool analysis_run(void)
 {
-	int16_t result=0;
-	
-	// rad adc
-	// result=
-	if (overSamplePos==0)
-		buf[curChannel][writePos]=result;
-	else
-		buf[curChannel][writePos]+=result;
-	curChannel++;
-	
-	// data read, initiate new read on adc with next channel
-	// restart
-	if (curChannel==CHANNELS)
+	const struct pitch_engine *engine;
+
+#if PITCH_STREAM_CHANNELS
+	if (analysis_block)
+	{
+		engine = pitch_engines[analysis_ch];
+		if (engine->feed)
+		{
+			engine->feed(analysis_block, analysis_ch);
+		}
+		if (++analysis_ch < CHANNELS)
+		{
+			return true;
+		}
+		analysis_ch = 0;
+		analysis_block = NULL;
+		frameq_release();
+		sched_post(SCHED_CONSUME);
+#if PITCH_BATCH_CHANNELS
+		return analysis_batch;
+#else
+		return false;
+#endif
+	}
+#endif
+#if PITCH_BATCH_CHANNELS
+	if (analysis_batch)
 	{
-		curChannel=0;
-		overSamplePos++;
-		if (overSamplePos==OVERSAMPLING)
+		engine = pitch_engines[analysis_batch_ch];
+		if (engine->update)
+		{
+			engine->update(analysis_batch_ch, analysis_end_pos,
+					analysis_time, analysis_active);
+		}
+		if (++analysis_batch_ch < CHANNELS)
 		{
-			overSamplePos=0;
-			railFull = true;
-			writePos++;
-			if (writePos>=MAXBUFFER)
-				writePos=0;
+			return true;
 		}
-	}		
+		analysis_batch_ch = 0;
+		analysis_batch = false;
+	}
+#endif
+	return false;
 }
 
+//! Slice budget in microseconds, half the span of the frame queue
+#define MAIN_BUDGET_US \
+	(FRAMEQ_SLOTS * CAPTURE_BLOCK_FRAMES * 1000000UL / SAMPLERATE / 2)
+//! Analysis slice budget, one channel's share of its job period. With
+//! both kinds of engine a batch slice holds up the blocks behind it, and
+//! gets the slice budget; the queue must be deep enough for an FFT.
+#if PITCH_STREAM_CHANNELS && PITCH_BATCH_CHANNELS
+#  define MAIN_ANALYSIS_BUDGET_US MAIN_BUDGET_US
+#elif PITCH_STREAM_CHANNELS
+#  define MAIN_ANALYSIS_BUDGET_US \
+	(CAPTURE_BLOCK_FRAMES * 1000000UL / SAMPLERATE / CHANNELS)
+#else
+#  define MAIN_ANALYSIS_BUDGET_US \
+	(PITCH_FFT_HOP * 1000000UL / SAMPLERATE / CHANNELS)
+#endif
+
+#if MAIN_BUDGET_US > UINT16_MAX || MAIN_ANALYSIS_BUDGET_US > UINT16_MAX
+#  error "Slice budgets out of range"
+#endif
+
+//! Tasks, in \ref sched_task_id order; the shell prints whole dumps
+static const struct sched_task main_tasks[SCHED_TASKS] = {
+	{ consume_run, 0, MAIN_BUDGET_US },
+	{ analysis_run, 0, MAIN_ANALYSIS_BUDGET_US },
+	{ record_run, RECORD_PERIOD, MAIN_BUDGET_US },
+	{ display_run, DISPLAY_PERIOD, MAIN_BUDGET_US },
+	{ telemetry_run, TELEMETRY_LINE_PERIOD, MAIN_BUDGET_US },
+	{ hostlink_run, HOSTLINK_PERIOD, MAIN_BUDGET_US },
+	{ chain_run, CHAIN_TASK_PERIOD, MAIN_BUDGET_US },
+	{ sync_run, 0, MAIN_BUDGET_US },
+	{ pedal_run, PEDAL_PERIOD, MAIN_BUDGET_US },
+	{ listen_run, LISTEN_PERIOD, MAIN_BUDGET_US },
+	{ tempcomp_run, TEMPCOMP_PERIOD, MAIN_BUDGET_US },
+	{ selfcheck_run, SELFCHECK_TICKS, MAIN_BUDGET_US },
+	{ tableload_run, 0, 0 },
+	{ loopback_run, LOOPBACK_PERIOD, MAIN_BUDGET_US },
+	{ gliss_run, 0, MAIN_ANALYSIS_BUDGET_US },
+	{ shell_run, 0, 0 },
+};
 
 int main (void)
 {
+	// 32 kHz reference of the DFLL and the RTC, needed before sysclk_init()
+	osc_enable(OSC_ID_RC32KHZ);
+	osc_wait_ready(OSC_ID_RC32KHZ);
+	sysclk_init();
 	board_init();
+	pmic_init();
+	pmic_set_scheduling(IRQLEVEL_SCHEDULING);
+	sleepmgr_init();
+	rtc_init();
+	timebase_init();
+	sync_init();
 
-	uint32_t clk = F_CPU/SAMPLERATE/OVERSAMPLING/CHANNELS;
-	tc_set_resolution(&TCC1,clk);
-	tc_set_overflow_interrupt_callback(&TCC1, HFSampleLoop);
-	while(1)
+	sdram_init();
+	tableload_init();
+	harp_init();
+	auxadc_init();
+	tempcomp_init();
+	pitch_init();
+	if (!capture_init())
 	{
-		// check for data to show
+		while(1);
 	}
+	gliss_init();
+	stats_init();
+	predict_reset();
+	tone_init();
+	cpu_irq_enable();
+	serial_tx_init();
+	serial_rx_init();
+	chain_init();
+	display_init();
+	baseline_init();
+	prof_init();
+	jitter_init();
+
+	// The DataFlash, the panel and the rate check wait for their first
+	// use, so the capture starts without them. The calibration log is read
+	// above, as the offsets and the baseline are needed from the first
+	// reading on.
+	sched_init(main_tasks);
+	capture_start();
+	selfcheck_start();
+	sched_run();
 }
@@ -0,0 +1,108 @@
+/**
+ * \file
+ *
+ * \brief Notes, cents and temperaments
+ *
+ */
+
+#include <compiler.h>
+#include "dsp/log2.h"
+#include "notes.h"
+
+//! \internal Pitch of 1 Hz, -1200 * 2^NOTES_CENTS_SHIFT * log2(440)
+#define NOTES_1HZ       (-168602L)
+
+//! \internal Letter of each pitch class, and the ones that are sharps
+static PROGMEM_DECLARE(char, notes_letters[12]) = "CCDDEFFGGAAB";
+#define NOTES_SHARPS    0x054a
+
+/**
+ * \brief Pitch of \a freq
+ *
+ * \param freq Frequency, not 0
+ */
+notes_cents_t notes_from_hz(pitch_hz_t freq)
+{
+#if NOTES_LOG2 == NOTES_LOG2_POLY
+	Assert(freq);
+
+	// log2 of the frequency in Hz, Q16.16
+	log2_t l = log2_fix(freq) - 16 * LOG2_ONE;
+
+	return NOTES_1HZ + (l >> 16) * NOTES_CENTS(1200)
+			+ (((uint32_t)(l & 0xffff) * NOTES_CENTS(1200)) >> 16);
+#else
+	int8_t octave = 15;
+	uint8_t step;
+	uint8_t frac;
+	uint16_t lo;
+	uint16_t hi;
+
+	Assert(freq);
+
+	// Normalise to 1.x * 2^31, a byte at a time first
+	while (!(freq >> 24)) {
+		freq <<= 8;
+		octave -= 8;
+	}
+	while (!(freq >> 31)) {
+		freq <<= 1;
+		octave--;
+	}
+
+	// Interpolate between the table entries around the 1.x
+	step = (freq >> (31 - NOTES_LOG2_BITS)) & (NOTES_LOG2_STEPS - 1);
+	frac = freq >> (23 - NOTES_LOG2_BITS);
+	lo = PROGMEM_READ_WORD(&notes_log2_table[step]);
+	hi = PROGMEM_READ_WORD(&notes_log2_table[step + 1]);
+
+	return NOTES_1HZ + (int32_t)octave * NOTES_CENTS(1200) + lo
+			+ (((uint32_t)(hi - lo) * frac) >> 8);
+#endif
+}
+
+/**
+ * \brief Equal temperament note nearest to \a pitch
+ */
+uint8_t notes_nearest(notes_cents_t pitch)
+{
+	int32_t note = pitch + NOTES_CENTS(100 * NOTES_A4 + 50);
+
+	if (note < 0) {
+		return 0;
+	}
+	note /= NOTES_CENTS(100);
+	return (note > 127) ? 127 : note;
+}
+
+/**
+ * \brief Offset of \a note from equal temperament in \a temperament
+ */
+int16_t notes_temperament(enum notes_temperament temperament, uint8_t note)
+{
+	Assert(temperament < NOTES_TEMPERAMENTS);
+
+	return PROGMEM_READ_WORD(&notes_temperament_table[temperament][note % 12]);
+}
+
+/**
+ * \brief Write the name of \a note, e.g. "A4" or "C#2"
+ *
+ * \param name Buffer of NOTES_NAME_MAX bytes
+ */
+void notes_name(uint8_t note, char *name)
+{
+	uint8_t pc = note % 12;
+	int8_t octave = note / 12 - 1;
+
+	*name++ = PROGMEM_READ_BYTE(&notes_letters[pc]);
+	if (NOTES_SHARPS & (1 << pc)) {
+		*name++ = '#';
+	}
+	if (octave < 0) {
+		*name++ = '-';
+		octave = -octave;
+	}
+	*name++ = '0' + octave;
+	*name = '\0';
+}
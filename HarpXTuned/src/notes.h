@@ -0,0 +1,112 @@
+/**
+ * \file
+ *
+ * \brief Notes, cents and temperaments
+ *
+ * Pitches are kept as \ref notes_cents_t, cents from A4 = 440 Hz in steps
+ * of 2^-NOTES_CENTS_SHIFT cent, where comparing a reading with a target
+ * is a subtraction; \ref notes_offset() gives the difference as Q8.8
+ * cents. \ref notes_from_hz() converts a frequency with a normalising
+ * shift and, as selected with NOTES_LOG2, either one interpolated lookup
+ * in a log2 table or the \ref log2.h polynomial. Equal temperament notes
+ * are whole multiples of 100 cents.
+ *
+ * The tables live in program memory, in notes_table.c, which is
+ * generated by tools/notes_table.py.
+ *
+ */
+
+#ifndef NOTES_H
+#define NOTES_H
+
+#include <compiler.h>
+#include <progmem.h>
+#include "dsp/freq.h"
+
+//! Fraction bits of \ref notes_cents_t
+#define NOTES_CENTS_SHIFT       4
+
+//! log2 of the log2 table steps per octave, must match notes_table.c
+#define NOTES_LOG2_BITS         6
+#define NOTES_LOG2_STEPS        (1 << NOTES_LOG2_BITS)
+
+//! \name notes_from_hz() methods
+//@{
+//! Interpolated log2 table, the faster
+#define NOTES_LOG2_TABLE        0
+//! \ref log2_fix(), leaves the log2 table out
+#define NOTES_LOG2_POLY         1
+//@}
+
+#ifndef NOTES_LOG2
+#  define NOTES_LOG2 NOTES_LOG2_TABLE
+#endif
+
+//! Note number of A4, MIDI numbering
+#define NOTES_A4                69
+
+//! Pitch in cents from A4, 2^-NOTES_CENTS_SHIFT cent per unit
+typedef int32_t notes_cents_t;
+
+//! Convert a whole number of cents to \ref notes_cents_t
+#define NOTES_CENTS(c)          ((notes_cents_t)(c) << NOTES_CENTS_SHIFT)
+
+//! Difference of two pitches in cents, Q8.8
+typedef int16_t notes_offset_t;
+
+//! Convert a whole number of cents to \ref notes_offset_t
+#define NOTES_OFFSET(c)         ((notes_offset_t)((c) << 8))
+
+//! Temperaments of notes_temperament_table, each with A at 0
+enum notes_temperament {
+	NOTES_EQUAL,
+	NOTES_PYTHAGOREAN,
+	//! 5-limit just intonation on C
+	NOTES_JUST,
+	//! Quarter-comma meantone, Eb to G#
+	NOTES_MEANTONE,
+	NOTES_WERCKMEISTER,
+	NOTES_VALLOTTI,
+	NOTES_TEMPERAMENTS
+};
+
+//! 1200 * 2^NOTES_CENTS_SHIFT * log2(1 + i / NOTES_LOG2_STEPS)
+extern PROGMEM_DECLARE(uint16_t, notes_log2_table[NOTES_LOG2_STEPS + 1]);
+//! Offsets from equal temperament of each \ref notes_temperament, C to B
+extern PROGMEM_DECLARE(int16_t,
+		notes_temperament_table[NOTES_TEMPERAMENTS][12]);
+
+//! Longest note name from \ref notes_name(), with the terminator
+#define NOTES_NAME_MAX          5
+
+/**
+ * \brief Pitch of equal temperament note \a note
+ */
+static inline notes_cents_t notes_equal(uint8_t note)
+{
+	return NOTES_CENTS(100 * ((int16_t)note - NOTES_A4));
+}
+
+/**
+ * \brief Cents from \a target to \a pitch, saturated to +-128 cents
+ */
+static inline notes_offset_t notes_offset(notes_cents_t pitch,
+		notes_cents_t target)
+{
+	notes_cents_t diff = pitch - target;
+
+	if (diff > (INT16_MAX >> (8 - NOTES_CENTS_SHIFT))) {
+		return INT16_MAX;
+	} else if (diff < (INT16_MIN >> (8 - NOTES_CENTS_SHIFT))) {
+		return INT16_MIN;
+	}
+	return (notes_offset_t)diff << (8 - NOTES_CENTS_SHIFT);
+}
+
+notes_cents_t notes_from_hz(pitch_hz_t freq);
+uint8_t notes_nearest(notes_cents_t pitch);
+int16_t notes_temperament(enum notes_temperament temperament,
+		uint8_t note);
+void notes_name(uint8_t note, char *name);
+
+#endif /* NOTES_H */
@@ -0,0 +1,41 @@
+/**
+ * \file
+ *
+ * \brief Note and cents tables of notes.h
+ *
+ * Generated by tools/notes_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "notes.h"
+
+// 1200 * 2^NOTES_CENTS_SHIFT * log2(1 + i / NOTES_LOG2_STEPS)
+PROGMEM_DECLARE(uint16_t, notes_log2_table[NOTES_LOG2_STEPS + 1]) = {
+	    0,   429,   852,  1269,  1679,  2084,  2482,  2875,
+	 3263,  3645,  4022,  4393,  4760,  5122,  5480,  5833,
+	 6181,  6525,  6865,  7201,  7532,  7860,  8184,  8505,
+	 8821,  9134,  9444,  9750, 10052, 10352, 10648, 10941,
+	11231, 11518, 11802, 12084, 12362, 12638, 12911, 13181,
+	13448, 13714, 13976, 14236, 14494, 14749, 15002, 15253,
+	15501, 15747, 15991, 16233, 16473, 16711, 16947, 17181,
+	17412, 17642, 17870, 18096, 18321, 18543, 18764, 18983,
+	19200,
+};
+
+// Cents from equal temperament, 2^-NOTES_CENTS_SHIFT, C to B
+PROGMEM_DECLARE(int16_t, notes_temperament_table[NOTES_TEMPERAMENTS][12]) = {
+	// equal
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+	// pythagorean
+	{ -94, 125, -31, -188, 31, -125, 94, -63, 156, 0, -156, 63 },
+	// just
+	{ 250, 438, 313, 501, 31, 219, 94, 282, 469, 0, 532, 63 },
+	// meantone
+	{ 164, -219, 55, 328, -55, 219, -164, 109, -274, 0, 274, -109 },
+	// werckmeister
+	{ 188, 31, 63, 94, 31, 156, 0, 125, 63, 0, 125, 63 },
+	// vallotti
+	{ 94, 0, 31, 63, -31, 125, -31, 63, 31, 0, 94, -63 },
+};
@@ -0,0 +1,77 @@
+/**
+ * \file
+ *
+ * \brief Pedal and lever entry
+ *
+ */
+
+#include <asf.h>
+#include "harp.h"
+#include "pedal.h"
+#include "pitch.h"
+
+//! \internal Button of each pedal, C to B
+static const port_pin_t pedal_buttons[7] = {
+	GPIO_PUSH_BUTTON_0, GPIO_PUSH_BUTTON_1, GPIO_PUSH_BUTTON_2,
+	GPIO_PUSH_BUTTON_3, GPIO_PUSH_BUTTON_4, GPIO_PUSH_BUTTON_5,
+	GPIO_PUSH_BUTTON_6,
+};
+
+//! \internal Buttons down on the last poll, bit per pedal
+static uint8_t pedal_last;
+//! \internal Buttons down after debouncing
+static uint8_t pedal_down;
+
+/**
+ * \brief Move the pedal of pitch class \a pc, 0 to 6 for C to B
+ *
+ * Retunes the strings of \a pc on every channel, between two analysis
+ * slices.
+ */
+void pedal_set(uint8_t pc, enum harp_pedal pedal)
+{
+	uint8_t ch;
+
+	if (harp_pedal(pc) == pedal) {
+		return;
+	}
+	harp_set_pedal(pc, pedal);
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_retune_strings(ch, harp_class_strings(ch, pc));
+	}
+}
+
+/**
+ * \brief Poll the pedal buttons, scheduler task
+ *
+ * \retval false always, one slice per poll
+ */
+bool pedal_run(void)
+{
+	uint8_t now = 0;
+	uint8_t pressed;
+	uint8_t pc;
+
+	// The buttons pull their pins low
+	for (pc = 0; pc < 7; pc++) {
+		if (gpio_pin_is_low(pedal_buttons[pc])) {
+			now |= 1 << pc;
+		}
+	}
+	if (now != pedal_last) {
+		pedal_last = now;
+		return false;
+	}
+	pressed = now & ~pedal_down;
+	pedal_down = now;
+
+	for (pc = 0; pc < 7; pc++) {
+		enum harp_pedal pedal = harp_pedal(pc);
+
+		if (pressed & (1 << pc)) {
+			pedal_set(pc, (pedal == HARP_SHARP) ? HARP_FLAT
+					: (enum harp_pedal)(pedal + 1));
+		}
+	}
+	return false;
+}
@@ -0,0 +1,32 @@
+/**
+ * \file
+ *
+ * \brief Pedal and lever entry
+ *
+ * The pedals of C, D .. B are worked with board buttons 0 to 6, or set
+ * from the stdio USART, see \ref shell.h. Every press moves the pedal
+ * of its button one notch, flat to natural to sharp and round to flat
+ * again; a lever harp uses natural and sharp only. A button must read the
+ * same on two polls in a row to count.
+ *
+ * A pedal change updates the strings of its pitch class and nothing else,
+ * in \ref harp.h and in the pitch engine, so the display carries on
+ * without a pause.
+ *
+ */
+
+#ifndef PEDAL_H
+#define PEDAL_H
+
+#include <compiler.h>
+#include "harp.h"
+
+//! Button poll period in RTC ticks, about 50 Hz
+#ifndef PEDAL_PERIOD
+#  define PEDAL_PERIOD  20
+#endif
+
+void pedal_set(uint8_t pc, enum harp_pedal pedal);
+bool pedal_run(void);
+
+#endif /* PEDAL_H */
@@ -0,0 +1,236 @@
+/**
+ * \file
+ *
+ * \brief Pitch readings shared by the analysis engines
+ *
+ */
+
+#include <asf.h>
+#include <preprocessor.h>
+#include "cv.h"
+#include "loopback.h"
+#include "pitch.h"
+#include "pitch_fft.h"
+#include "pitch_goertzel.h"
+#include "pitch_yin.h"
+#include "predict.h"
+#include "stats.h"
+
+/**
+ * \internal
+ * \brief Engine of channel \a ch
+ *
+ * The masks are constant, so only the engine picked is referenced.
+ */
+#define PITCH_ENGINE_OF(ch) \
+	((PITCH_GOERTZEL_CHANNELS & (1U << (ch))) ? &pitch_goertzel_engine \
+	: (PITCH_YIN_CHANNELS & (1U << (ch))) ? &pitch_yin_engine \
+	: &pitch_fft_engine)
+
+//! \internal Table entry of channel \a n, for MREPEAT
+#define PITCH_ENGINE_ENTRY(n, unused) PITCH_ENGINE_OF(n),
+
+//! \internal Filter state of one channel
+struct pitch_filter_state {
+	//! Filtered pitch, 0 to start over on the next estimate
+	pitch_hz_t freq;
+	//! Its variance, in 1/256 of a gate level estimate
+	uint16_t var;
+};
+
+struct pitch_reading pitch_readings[CHANNELS];
+
+const struct pitch_engine *const pitch_engines[CHANNELS] = {
+	MREPEAT(CHANNELS, PITCH_ENGINE_ENTRY, ~)
+};
+
+#if PITCH_FILTER
+static struct pitch_filter_state pitch_filter_states[CHANNELS];
+#endif
+
+//! \internal Channels in chromatic mode, bit n for channel n
+static uint8_t pitch_chromatic;
+
+/**
+ * \internal
+ * \brief Variance of an estimate at \a level
+ */
+static uint16_t pitch_filter_noise(uint8_t ch, uint16_t level)
+{
+	uint16_t var = ((uint32_t)pitch_engines[ch]->min_level << 8)
+			/ Max(level, 1);
+
+	return Max(var, 1);
+}
+
+/**
+ * \internal
+ * \brief Take the new estimate of channel \a ch into the filtered pitch
+ */
+static void pitch_filter_take(uint8_t ch)
+{
+#if PITCH_FILTER
+	struct pitch_filter_state *state = &pitch_filter_states[ch];
+	struct pitch_reading *reading = &pitch_readings[ch];
+	uint16_t noise;
+	uint16_t gain;
+	int32_t diff;
+
+	if (!reading->freq) {
+		state->freq = 0;
+		return;
+	}
+	noise = pitch_filter_noise(ch, reading->level);
+	diff = (int32_t)(reading->freq - state->freq);
+	if (!state->freq || (uint32_t)Abs(diff)
+			> (state->freq >> PITCH_FILTER_LOG2_JUMP)) {
+		state->freq = reading->freq;
+		state->var = noise;
+		return;
+	}
+
+	// Gain var / (var + noise), Q8
+	state->var += PITCH_FILTER_DRIFT;
+	gain = ((uint32_t)state->var << 8) / (state->var + noise);
+	state->freq += (diff * gain) / 256;
+	state->var = ((uint32_t)state->var * (256 - gain)) >> 8;
+	reading->freq = state->freq;
+#else
+	UNUSED(ch);
+#endif
+}
+
+/**
+ * \brief Take the new estimate in the \ref pitch_readings entry of
+ * channel \a ch into the filtered pitch
+ *
+ * Call from the engine each time it has set the entry. The entry is left
+ * with the filtered pitch, and handed to the \ref loopback.h test, the
+ * \ref stats.h histograms, the \ref predict.h order and the \ref cv.h
+ * output.
+ */
+void pitch_filter(uint8_t ch)
+{
+	pitch_filter_take(ch);
+	loopback_reading(ch);
+	stats_reading(ch);
+	predict_reading(ch);
+	cv_reading(ch);
+}
+
+/**
+ * \brief Have the next estimate of channel \a ch start the filter over
+ *
+ * Call when the engine drops what it had of a channel, at an onset say.
+ */
+void pitch_filter_reset(uint8_t ch)
+{
+#if PITCH_FILTER
+	pitch_filter_states[ch].freq = 0;
+#else
+	UNUSED(ch);
+#endif
+}
+
+/**
+ * \brief Set up the engine of every channel
+ *
+ * Call after \ref harp_init(). An engine shared by several channels is
+ * set up once.
+ */
+void pitch_init(void)
+{
+	uint8_t ch;
+	uint8_t prev;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		for (prev = 0; prev < ch; prev++) {
+			if (pitch_engines[prev] == pitch_engines[ch]) {
+				break;
+			}
+		}
+		if (prev == ch) {
+			pitch_engines[ch]->init();
+		}
+	}
+}
+
+/**
+ * \brief Have the pitch engine follow the strings of channel \a ch
+ *
+ * Call after the candidates or reference frequencies of the channel have
+ * changed, between two analysis slices.
+ */
+void pitch_retune(uint8_t ch)
+{
+	pitch_engines[ch]->retune(ch);
+}
+
+/**
+ * \brief Have the pitch engine follow a change of some strings of channel
+ * \a ch
+ *
+ * Cheaper than \ref pitch_retune() when only the reference frequencies of
+ * a few strings have moved, after \ref harp_set_pedal() say.
+ *
+ * \param strings Strings of the group that changed
+ */
+void pitch_retune_strings(uint8_t ch, harp_candidates_t strings)
+{
+	const struct pitch_engine *engine = pitch_engines[ch];
+
+	if (engine->retune_strings) {
+		engine->retune_strings(ch, strings);
+	} else if (strings) {
+		// Only the search range depends on the strings
+		engine->retune(ch);
+	}
+}
+
+/**
+ * \brief Tell the engine of channel \a ch the string likely to be plucked
+ * next
+ *
+ * An engine that keeps state around one string, and has the entry, sets
+ * it up for this one at the next onset.
+ *
+ * \param string String of the group, HARP_GROUP_MAX for none
+ */
+void pitch_prewarm(uint8_t ch, uint8_t string)
+{
+	const struct pitch_engine *engine = pitch_engines[ch];
+
+	if (engine->prewarm) {
+		engine->prewarm(ch, string);
+	}
+}
+
+/**
+ * \brief Put channel \a ch in chromatic mode, or back in harp mode
+ *
+ * Takes effect between two analysis slices, and starts the filter over.
+ *
+ * \retval false if the engine of the channel has no chromatic mode
+ */
+bool pitch_set_chromatic(uint8_t ch, bool on)
+{
+	if (on && !pitch_engines[ch]->chromatic) {
+		return false;
+	}
+	if (on) {
+		pitch_chromatic |= 1U << ch;
+	} else {
+		pitch_chromatic &= ~(1U << ch);
+	}
+	pitch_retune(ch);
+	pitch_filter_reset(ch);
+	return true;
+}
+
+/**
+ * \brief Whether channel \a ch is in chromatic mode
+ */
+bool pitch_is_chromatic(uint8_t ch)
+{
+	return pitch_chromatic & (1U << ch);
+}
@@ -0,0 +1,111 @@
+/**
+ * \file
+ *
+ * \brief Pitch readings shared by the analysis engines
+ *
+ * Each engine offers itself as a \ref pitch_engine, and \ref pitch_engines
+ * gives the one of every channel, from the PITCH_*_CHANNELS masks of
+ * conf_profile.h. Streaming engines are fed every capture block of their
+ * channels; batch engines read their windows from the ring every
+ * PITCH_FFT_HOP frames, or at the end of the hop of an onset. Either way
+ * the result lands in \ref pitch_readings. Only the engines a build names
+ * are referenced, so the linker drops the others.
+ *
+ * With PITCH_FILTER set, each engine passes its estimates through a one
+ * dimensional Kalman filter per channel before they reach
+ * \ref pitch_readings:
+ * - the variance of an estimate is taken as 256 at the gate level of the
+ *   engine and falls as 1 / level, so loud readings weigh more;
+ * - PITCH_FILTER_DRIFT is added to the variance of the filtered pitch on
+ *   every estimate, which sets how fast it follows a string being tuned;
+ * - silence, a restart of the engine, or an estimate away from the filtered
+ *   pitch by more than 2^-PITCH_FILTER_LOG2_JUMP of it, about 27 cents,
+ *   restarts the filter on that estimate, so a new note shows at once and
+ *   the next few estimates home in on it.
+ *
+ * The filter works in integers with one division per estimate.
+ *
+ * A channel is in harp mode, searching around the strings of its
+ * \ref harp.h candidates, or with \ref pitch_set_chromatic() in chromatic
+ * mode, the whole range for any instrument, if its engine can. The
+ * display and the readings then show the nearest equal temperament note
+ * against the A4 reference.
+ *
+ */
+
+#ifndef PITCH_H
+#define PITCH_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "frameq.h"
+#include "harp.h"
+#include "dsp/freq.h"
+
+// The PITCH_ENGINE_* values and the channel masks live in conf_profile.h
+#ifndef PITCH_ENGINE
+#  define PITCH_ENGINE PITCH_ENGINE_FFT
+#endif
+
+//! Smooth the estimates of the engines
+#ifndef PITCH_FILTER
+#  define PITCH_FILTER 1
+#endif
+
+//! Variance added per estimate, in 1/256 of a gate level estimate
+#ifndef PITCH_FILTER_DRIFT
+#  define PITCH_FILTER_DRIFT 16
+#endif
+
+//! log2 of the inverse of the relative jump taken as a new note
+#ifndef PITCH_FILTER_LOG2_JUMP
+#  define PITCH_FILTER_LOG2_JUMP 6
+#endif
+
+//! Latest result of one channel
+struct pitch_reading {
+	//! Fundamental, 0 if no pitch was found
+	pitch_hz_t freq;
+	//! Peak level in engine units, for gating the display
+	uint16_t level;
+	//! \ref timebase_now() stamp of the block with the newest sample used
+	uint32_t time;
+};
+
+//! Entry points of one pitch engine
+struct pitch_engine {
+	//! Set up every channel, once at startup
+	void (*init)(void);
+	//! Streaming: take capture block \a block of channel \a ch, or NULL
+	void (*feed)(const frameq_block_t *block, uint8_t ch);
+	/**
+	 * Batch: analyse the ring of channel \a ch up to \a end_pos, stamped
+	 * \a time, silent unless in \a active; or NULL
+	 */
+	void (*update)(uint8_t ch, uint16_t end_pos, uint32_t time,
+			uint8_t active);
+	//! Follow the strings of channel \a ch
+	void (*retune)(uint8_t ch);
+	//! Follow a change of some strings, or NULL to retune
+	void (*retune_strings)(uint8_t ch, harp_candidates_t strings);
+	//! Expect string \a string of the group at the next onset, or NULL
+	void (*prewarm)(uint8_t ch, uint8_t string);
+	//! Smallest level reported as a pitch
+	uint16_t min_level;
+	//! Offers chromatic mode
+	bool chromatic;
+};
+
+extern struct pitch_reading pitch_readings[CHANNELS];
+extern const struct pitch_engine *const pitch_engines[CHANNELS];
+
+void pitch_init(void);
+void pitch_filter(uint8_t ch);
+void pitch_filter_reset(uint8_t ch);
+void pitch_retune(uint8_t ch);
+void pitch_retune_strings(uint8_t ch, harp_candidates_t strings);
+void pitch_prewarm(uint8_t ch, uint8_t string);
+bool pitch_set_chromatic(uint8_t ch, bool on);
+bool pitch_is_chromatic(uint8_t ch);
+
+#endif /* PITCH_H */
@@ -0,0 +1,734 @@
+/**
+ * \file
+ *
+ * \brief FFT pitch engine
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <asf.h>
+#include "capture.h"
+#include "pitch_fft.h"
+#include "scratch.h"
+#include "dsp/window.h"
+
+//! \internal Packed real samples, then FFT work area, in the scratch arena
+//! for one \ref pitch_fft_update()
+static fft_complex_t *pitch_fft_buf;
+//! \internal Magnitude spectrum, likewise
+static uint16_t *pitch_fft_mag;
+
+//! \internal Bins searched on one channel
+struct pitch_fft_range {
+	uint16_t lo;
+	uint16_t hi;
+	//! Partials summed, 1 to pick the plain peak
+	uint8_t harmonics;
+	//! log2 of the frames decimated into one transform sample
+	uint8_t log2_decim;
+};
+
+//! \internal Search range of each channel
+static struct pitch_fft_range pitch_fft_ranges[CHANNELS];
+
+#if PITCH_FFT_PARTIALS
+//! \internal Partial tracker of one channel
+struct pitch_fft_track {
+	//! Fitted fundamental of the last frame, Q8 bins, 0 if not tracking
+	uint32_t f0;
+	//! Position of each partial in the last frame, Q8 bins
+	uint32_t pos[PITCH_FFT_PARTIALS];
+	//! Inharmonicity of the last fit, B in millionths
+	uint16_t inharmonicity;
+};
+
+//! \internal Partial tracker of each channel
+static struct pitch_fft_track pitch_fft_tracks[CHANNELS];
+
+//! \internal Closest partials tracked, Q8 bins: the main lobes of two
+//! neighbours touch
+#define PITCH_FFT_TRACK_SPACING ((2L * WINDOW_LOBE) << 8)
+#endif
+
+//! \internal Subharmonic sum fundamentals per bin, the most partials
+#define PITCH_FFT_SHS_STEPS     PITCH_FFT_SHS_HARMONICS
+
+/**
+ * \internal
+ * \brief Ring position \a n samples before \a pos
+ */
+static uint16_t pitch_fft_back(uint16_t pos, uint16_t n)
+{
+	return ring_distance(n, pos, MAXBUFFER);
+}
+
+/**
+ * \internal
+ * \brief Width of a bin of channel \a ch in Hz, Q24.8
+ */
+static uint32_t pitch_fft_width(uint8_t ch)
+{
+	return PITCH_FFT_BIN_WIDTH >> pitch_fft_ranges[ch].log2_decim;
+}
+
+/**
+ * \internal
+ * \brief Read the 2^\a log2_n samples of channel \a ch before \a end_pos
+ * into \a s, decimated by 2^\a log2_decim
+ *
+ * A second order CIC decimator, at unity gain, over 2^\a log2_n + 2
+ * decimated samples; the first two only fill the combs.
+ *
+ * \return Sum of the samples
+ */
+static int32_t pitch_fft_fetch(uint8_t ch, uint16_t end_pos,
+		uint8_t log2_decim, uint8_t log2_n, int16_t *s)
+{
+	struct capture_view view;
+	uint32_t i1 = 0;
+	uint32_t i2 = 0;
+	uint32_t c1 = 0;
+	uint32_t c2 = 0;
+	int32_t sum = 0;
+	uint8_t left = 1U << log2_decim;
+	int8_t skip = -2;
+	uint8_t span;
+
+	if (!log2_decim) {
+		capture_view(ch, end_pos, 1U << log2_n, &view);
+		return capture_view_read(&view, s);
+	}
+	capture_view(ch, end_pos, ((1U << log2_n) + 2) << log2_decim, &view);
+	for (span = 0; span < 2; span++) {
+		hugemem_ptr_t from = view.addr[span];
+		uint16_t count = view.len[span];
+
+		while (count--) {
+			i1 += (uint32_t)(int32_t)hugemem_read16(from);
+			i2 += i1;
+			from += CAPTURE_POS_STRIDE;
+			if (!--left) {
+				uint32_t d1 = i2 - c1;
+				int16_t y = (int16_t)((int32_t)(d1 - c2)
+						>> (2 * log2_decim));
+
+				c1 = i2;
+				c2 = d1;
+				left = 1U << log2_decim;
+				if (skip < 0) {
+					skip++;
+					continue;
+				}
+				*s++ = y;
+				sum += y;
+			}
+		}
+	}
+	return sum;
+}
+
+/**
+ * \internal
+ * \brief Load, de-mean and window the PITCH_FFT_N samples of channel \a ch
+ * before \a end_pos
+ */
+static void pitch_fft_load(uint8_t ch, uint16_t end_pos)
+{
+	int16_t *s = (int16_t *)pitch_fft_buf;
+	int32_t sum = pitch_fft_fetch(ch, end_pos,
+			pitch_fft_ranges[ch].log2_decim, PITCH_FFT_LOG2_N, s);
+
+	window_apply(s, PITCH_FFT_LOG2_N, (int16_t)(sum >> PITCH_FFT_LOG2_N),
+			PITCH_FFT_INPUT_SHIFT);
+}
+
+/**
+ * \internal
+ * \brief Move \a k to the strongest of bin \a k and its neighbours
+ *
+ * \return The magnitude of that bin
+ */
+static uint16_t pitch_fft_local(uint16_t *k)
+{
+	uint16_t b = *k;
+
+	if (pitch_fft_mag[b - 1] > pitch_fft_mag[*k]) {
+		*k = b - 1;
+	}
+	if (pitch_fft_mag[b + 1] > pitch_fft_mag[*k]) {
+		*k = b + 1;
+	}
+	return pitch_fft_mag[*k];
+}
+
+/**
+ * \internal
+ * \brief Bin nearest partial \a h of fundamental \a f, PITCH_FFT_SHS_STEPS
+ * units per bin
+ */
+static uint16_t pitch_fft_partial(uint16_t f, uint8_t h)
+{
+	return ((uint32_t)h * f + PITCH_FFT_SHS_STEPS / 2) / PITCH_FFT_SHS_STEPS;
+}
+
+/**
+ * \internal
+ * \brief Subharmonic sum of fundamental \a f over \a harmonics partials
+ *
+ * \param f Fundamental, PITCH_FFT_SHS_STEPS units per bin, so that every
+ * partial summed is within half a bin of its nearest bin
+ */
+static uint32_t pitch_fft_shs(uint16_t f, uint8_t harmonics)
+{
+	uint32_t sum = 0;
+	uint8_t h;
+
+	for (h = 1; h <= harmonics; h++) {
+		uint16_t b = pitch_fft_partial(f, h);
+
+		if (b > PITCH_FFT_N / 2 - 2) {
+			break;
+		}
+		sum += pitch_fft_mag[b];
+	}
+	return sum;
+}
+
+/**
+ * \internal
+ * \brief Frequency of position \a pos, Q16 bins of \a width
+ */
+static pitch_hz_t pitch_fft_hz(uint32_t pos, uint32_t width)
+{
+	return (pos >> 8) * width + (((pos & 0xff) * width) >> 8);
+}
+
+/**
+ * \internal
+ * \brief Find the fundamental in \a range and refine it to a frequency
+ *
+ * \param partial Receives the partial the frequency was taken from
+ *
+ * \return The bin of that partial
+ */
+static uint16_t pitch_fft_peak(struct pitch_reading *reading,
+		const struct pitch_fft_range *range, uint8_t *partial)
+{
+	uint16_t peak = range->lo;
+	uint16_t k;
+
+	*partial = 1;
+	if (range->harmonics > 1) {
+		uint16_t fundamental = range->lo * PITCH_FFT_SHS_STEPS;
+		uint32_t best = 0;
+		uint16_t f;
+		uint8_t h;
+
+		for (f = fundamental; f <= range->hi * PITCH_FFT_SHS_STEPS; f++) {
+			uint32_t sum = pitch_fft_shs(f, range->harmonics);
+
+			if (sum > best) {
+				best = sum;
+				fundamental = f;
+			}
+		}
+
+		// Refine on the strongest partial, h times the resolution
+		peak = pitch_fft_partial(fundamental, 1);
+		pitch_fft_local(&peak);
+		for (h = 2; h <= range->harmonics; h++) {
+			k = pitch_fft_partial(fundamental, h);
+			if (k > PITCH_FFT_N / 2 - 2) {
+				break;
+			}
+			if (pitch_fft_local(&k) > pitch_fft_mag[peak]) {
+				peak = k;
+				*partial = h;
+			}
+		}
+	} else {
+		for (k = range->lo + 1; k <= range->hi; k++) {
+			if (pitch_fft_mag[k] > pitch_fft_mag[peak]) {
+				peak = k;
+			}
+		}
+	}
+
+	reading->level = pitch_fft_mag[peak];
+	if (reading->level < PITCH_FFT_MIN_LEVEL) {
+		reading->freq = 0;
+		return peak;
+	}
+
+	reading->freq = (uint32_t)(((int32_t)peak << 8)
+			+ fft_vertex(pitch_fft_mag, peak))
+			* (PITCH_FFT_BIN_WIDTH >> range->log2_decim) / *partial;
+	return peak;
+}
+
+#if PITCH_FFT_PV
+/**
+ * \internal
+ * \brief Phase of bin \a k of the PITCH_FFT_N samples \a s, 65536 being a
+ * full turn
+ *
+ * The one bin of the windowed transform, worked out directly. The window
+ * leaves no DC in bins from WINDOW_LOBE up, so the samples are taken as
+ * they are.
+ */
+static uint16_t pitch_fft_phase(const int16_t *s, uint16_t k)
+{
+	uint16_t step = k << (FFT_LOG2_N_MAX - PITCH_FFT_LOG2_N);
+	uint16_t a = 0;
+	int32_t re = 0;
+	int32_t im = 0;
+	uint16_t i;
+
+	for (i = 0; i < PITCH_FFT_N; i++) {
+		int16_t v = fixmath_q15_mul(s[i],
+				window_coef(i, PITCH_FFT_LOG2_N));
+
+		// e^(-j 2 pi k i / N), the sine a quarter turn on
+		re += fixmath_mul16(v, fft_cos(a)) >> 8;
+		im -= fixmath_mul16(v,
+				fft_cos((a - FFT_N_MAX / 4) & (FFT_N_MAX - 1))) >> 8;
+		a = (a + step) & (FFT_N_MAX - 1);
+	}
+	return fft_phase(re, im);
+}
+
+/**
+ * \internal
+ * \brief Refine the peak at bin \a k by its phase advance
+ *
+ * The phase of a partial at f bins advances by f PITCH_FFT_PV_HOP /
+ * PITCH_FFT_N turns from the frame PITCH_FFT_PV_HOP transform samples
+ * earlier to the one ending at \a end_pos. The whole turns come from the
+ * parabola estimate \a pos, which must be within PITCH_FFT_N /
+ * PITCH_FFT_PV_HOP / 2 bins. Both frames are read again, the spectrum
+ * in \ref pitch_fft_buf is not needed any more.
+ *
+ * \param pos Parabola estimate, Q8 bins
+ *
+ * \return The refined position, Q16 bins, or \a pos if they disagree
+ */
+static uint32_t pitch_fft_pv(uint8_t ch, uint16_t end_pos, uint16_t k,
+		uint32_t pos)
+{
+	uint8_t log2_decim = pitch_fft_ranges[ch].log2_decim;
+	int16_t *s = (int16_t *)pitch_fft_buf;
+	uint16_t turn;
+	int32_t m;
+	uint32_t fine;
+
+	pitch_fft_fetch(ch, pitch_fft_back(end_pos,
+			PITCH_FFT_PV_HOP << log2_decim), log2_decim,
+			PITCH_FFT_LOG2_N, s);
+	turn = -pitch_fft_phase(s, k);
+	pitch_fft_fetch(ch, end_pos, log2_decim, PITCH_FFT_LOG2_N, s);
+	turn += pitch_fft_phase(s, k);
+	// Whole turns, rounded from the Q8 turns of the estimate
+	m = ((int32_t)(pos >> PITCH_FFT_PV_SHIFT) - (turn >> 8) + 128) >> 8;
+
+	if (m < 0) {
+		return pos << 8;
+	}
+	fine = (((uint32_t)m << 16) + turn) << PITCH_FFT_PV_SHIFT;
+	if (fine > (pos << 8) + 0x10000UL || fine + 0x10000UL < (pos << 8)) {
+		return pos << 8;
+	}
+	return fine;
+}
+#endif
+
+#if PITCH_FFT_PARTIALS
+/**
+ * \internal
+ * \brief Follow the partials of channel \a ch into the new spectrum
+ *
+ * Each partial is refined at the strongest bin near its last position
+ * and fitted by least squares, y_n = f_n / n against x_n = n^2: f0 is the
+ * intercept and B twice the slope over f0. Partials too weak for the fit
+ * move to where the fit puts them.
+ *
+ * \retval true if \a reading holds the fitted fundamental
+ * \retval false if the partials are lost, \a reading is left alone
+ */
+static bool pitch_fft_follow(uint8_t ch, struct pitch_reading *reading)
+{
+	struct pitch_fft_track *track = &pitch_fft_tracks[ch];
+	const struct pitch_fft_range *range = &pitch_fft_ranges[ch];
+	uint16_t width = track->f0 >> 9;
+	uint16_t level = 0;
+	int32_t s = 0;
+	int32_t sx = 0;
+	int32_t sxx = 0;
+	int32_t sy = 0;
+	int32_t sxy = 0;
+	int32_t den;
+	int32_t slope = 0;
+	int32_t f0;
+	uint8_t found = 0;
+	uint8_t n;
+
+	// No further than half way to the next partial
+	if (width > PITCH_FFT_TRACK_BINS) {
+		width = PITCH_FFT_TRACK_BINS;
+	} else if (width < 1) {
+		width = 1;
+	}
+
+	for (n = 1; n <= PITCH_FFT_PARTIALS; n++) {
+		uint16_t k = (track->pos[n - 1] + 128) >> 8;
+		uint16_t peak;
+		uint16_t i;
+		int32_t x = (int32_t)n * n;
+		int32_t y;
+
+		if (k < width + 1 || k + width > PITCH_FFT_N / 2 - 2) {
+			continue;
+		}
+		peak = k - width;
+		for (i = peak + 1; i <= k + width; i++) {
+			if (pitch_fft_mag[i] > pitch_fft_mag[peak]) {
+				peak = i;
+			}
+		}
+		if (pitch_fft_mag[peak] > level) {
+			level = pitch_fft_mag[peak];
+		}
+		if (pitch_fft_mag[peak] < PITCH_FFT_PARTIAL_LEVEL) {
+			continue;
+		}
+		track->pos[n - 1] = ((int32_t)peak << 8)
+				+ fft_vertex(pitch_fft_mag, peak);
+		found |= 1 << (n - 1);
+
+		y = track->pos[n - 1] / n;
+		s++;
+		sx += x;
+		sxx += x * x;
+		sy += y;
+		sxy += x * y;
+	}
+	if (level < PITCH_FFT_MIN_LEVEL || !s) {
+		track->f0 = 0;
+		return false;
+	}
+
+	den = s * sxx - sx * sx;
+	if (den) {
+		f0 = (sy * sxx - sx * sxy) / den;
+		slope = s * sxy - sx * sy;
+	} else {
+		f0 = sy;
+	}
+	if (f0 < ((int32_t)range->lo << 8) || f0 > ((int32_t)range->hi << 8)
+			|| f0 < PITCH_FFT_TRACK_SPACING) {
+		track->f0 = 0;
+		return false;
+	}
+
+	track->f0 = f0;
+	track->inharmonicity = 0;
+	if (slope > 0) {
+		// B = 2 slope / f0, the slope being over den
+		uint32_t b = (uint32_t)(((int64_t)slope * 2000000L)
+				/ ((int64_t)f0 * den));
+
+		track->inharmonicity = (b > UINT16_MAX) ? UINT16_MAX : (uint16_t)b;
+	}
+	for (n = 1; n <= PITCH_FFT_PARTIALS; n++) {
+		if (!(found & (1 << (n - 1)))) {
+			track->pos[n - 1] = n * (f0 + (den
+					? slope * (int32_t)(n * n) / den : 0));
+		}
+	}
+
+	reading->level = level;
+	reading->freq = (uint32_t)f0 * pitch_fft_width(ch);
+	return true;
+}
+
+/**
+ * \internal
+ * \brief Start tracking the partials of the pitch in \a reading
+ *
+ * \retval false if the partials are too close to tell apart
+ */
+static bool pitch_fft_lock(uint8_t ch, const struct pitch_reading *reading)
+{
+	struct pitch_fft_track *track = &pitch_fft_tracks[ch];
+	uint32_t f0 = reading->freq / pitch_fft_width(ch);
+	uint8_t n;
+
+	if (f0 < PITCH_FFT_TRACK_SPACING) {
+		return false;
+	}
+	track->f0 = f0;
+	for (n = 1; n <= PITCH_FFT_PARTIALS; n++) {
+		track->pos[n - 1] = n * f0;
+	}
+	return true;
+}
+
+/**
+ * \brief Inharmonicity B of the string on channel \a ch, in millionths
+ *
+ * 0 while the channel tracks no partials or they fit no B.
+ */
+uint16_t pitch_fft_inharmonicity(uint8_t ch)
+{
+	return pitch_fft_tracks[ch].f0 ? pitch_fft_tracks[ch].inharmonicity : 0;
+}
+#endif
+
+/**
+ * \brief Set the search range of every channel
+ */
+void pitch_fft_init(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_fft_retune(ch);
+	}
+}
+
+/**
+ * \internal
+ * \brief Set the bins of \a range to \a lo to \a hi, summing
+ * \a harmonics partials
+ *
+ * The channel is decimated as far as its highest partial searched allows,
+ * up to 2^PITCH_FFT_LOG2_DECIM_MAX. No range starts below 2 WINDOW_LOBE
+ * bins: there the partials of every subharmonic fall into the lobes of
+ * those of the fundamental, and the lowest sums the most.
+ */
+static void pitch_fft_set_range(struct pitch_fft_range *range, pitch_hz_t lo,
+		pitch_hz_t hi, uint8_t harmonics)
+{
+	uint8_t partials;
+	uint32_t width;
+	uint16_t min;
+
+	range->harmonics = harmonics;
+
+	// Top partial, Hz, against the band of the rate one step down
+	partials = range->harmonics;
+	if (partials < PITCH_FFT_PARTIALS) {
+		partials = PITCH_FFT_PARTIALS;
+	}
+	range->log2_decim = 0;
+	while (range->log2_decim < PITCH_FFT_LOG2_DECIM_MAX
+			&& (hi >> 16) * partials < ((uint32_t)SAMPLERATE
+			>> (range->log2_decim + 2 + PITCH_FFT_DECIM_BAND_SHIFT))) {
+		range->log2_decim++;
+	}
+	width = PITCH_FFT_BIN_WIDTH >> range->log2_decim;
+	min = (uint16_t)(((uint32_t)PITCH_FFT_MIN_HZ * 256 + width - 1)
+			/ width);
+
+	// Q16.16 Hz over the Q24.8 bin width, keeping a neighbour either side
+	range->lo = (lo >> 8) / width;
+	range->hi = ((hi >> 8) + width - 1) / width;
+	if (range->lo < min) {
+		range->lo = min;
+	}
+	if (range->lo < 2 * WINDOW_LOBE) {
+		range->lo = 2 * WINDOW_LOBE;
+	}
+	if (range->hi > PITCH_FFT_N / 2 - 2) {
+		range->hi = PITCH_FFT_N / 2 - 2;
+	}
+	if (range->lo > range->hi) {
+		range->lo = range->hi;
+	}
+}
+
+/**
+ * \brief Set the bins searched on channel \a ch from its candidates
+ *
+ * The transform itself is always complete, only the peak search narrows.
+ * A range reaching below PITCH_FFT_SHS_HZ turns on subharmonic summation.
+ * In chromatic mode the range is that of the last coarse pass, from the
+ * whole chromatic range until the first.
+ */
+void pitch_fft_retune(uint8_t ch)
+{
+	uint8_t harmonics;
+	pitch_hz_t lo;
+	pitch_hz_t hi;
+
+	if (pitch_is_chromatic(ch)) {
+		lo = PITCH_HZ(PITCH_FFT_MIN_HZ);
+		hi = PITCH_HZ(PITCH_FFT_CHROMATIC_MAX_HZ);
+	} else {
+		harp_search_range(ch, &lo, &hi);
+	}
+	harmonics = (lo < PITCH_HZ(PITCH_FFT_SHS_HZ))
+			? PITCH_FFT_SHS_HARMONICS : 1;
+	pitch_fft_set_range(&pitch_fft_ranges[ch], lo, hi, harmonics);
+#if PITCH_FFT_PARTIALS
+	pitch_fft_tracks[ch].f0 = 0;
+#endif
+}
+
+#if PITCH_FFT_CHROMATIC
+/**
+ * \internal
+ * \brief Coarse pass of chromatic mode, setting the fine search range of
+ * channel \a ch
+ *
+ * The PITCH_FFT_COARSE_N samples before \a end_pos, decimated by
+ * 2^PITCH_FFT_COARSE_LOG2_DECIM, are transformed into the buffers of the
+ * fine pass. Its strongest peak, at a coarse bin or so, is one of the
+ * first PITCH_FFT_SHS_HARMONICS partials, which puts the fundamental in
+ * the octaves from that many times below it. The subharmonic sum of the
+ * fine pass picks it out; at the coarse resolution, the partials of a
+ * low fundamental would fall into the lobes of one another. The search
+ * starts from the first bin: a bass string may have no partial above
+ * the lobe of the window around DC. A peak within WINDOW_LOBE bins of DC
+ * may have spread from a lower partial, and puts the fundamental
+ * anywhere from PITCH_FFT_MIN_HZ, down to the floor of
+ * \ref pitch_fft_set_range().
+ *
+ * \retval false if the channel is silent, \a reading says so
+ */
+static bool pitch_fft_coarse(uint8_t ch, uint16_t end_pos,
+		struct pitch_reading *reading)
+{
+	int16_t *s = (int16_t *)pitch_fft_buf;
+	uint16_t peak = 1;
+	pitch_hz_t lo;
+	pitch_hz_t hi;
+	int32_t sum;
+	uint16_t k;
+
+	sum = pitch_fft_fetch(ch, end_pos, PITCH_FFT_COARSE_LOG2_DECIM,
+			PITCH_FFT_COARSE_LOG2_N, s);
+	window_apply(s, PITCH_FFT_COARSE_LOG2_N,
+			(int16_t)(sum >> PITCH_FFT_COARSE_LOG2_N),
+			PITCH_FFT_INPUT_SHIFT);
+	fft_real_mag(pitch_fft_buf, pitch_fft_mag, PITCH_FFT_COARSE_LOG2_N);
+
+	// The mean is gone, so the bass partials stand in the lobe around DC
+	for (k = 2; k < PITCH_FFT_COARSE_N / 2 - 1; k++) {
+		if (pitch_fft_mag[k] > pitch_fft_mag[peak]) {
+			peak = k;
+		}
+	}
+	if (pitch_fft_mag[peak] < PITCH_FFT_MIN_LEVEL) {
+		reading->freq = 0;
+		reading->level = pitch_fft_mag[peak];
+		return false;
+	}
+
+	// Q16.16 Hz, a bin below the peak over the partials to a bin above
+	lo = ((pitch_hz_t)(peak - 1) * PITCH_FFT_COARSE_WIDTH << 8)
+			/ PITCH_FFT_SHS_HARMONICS;
+	hi = (pitch_hz_t)(peak + 1) * PITCH_FFT_COARSE_WIDTH << 8;
+	// A peak within the lobe may be leakage of a lower one, search down
+	if (peak <= WINDOW_LOBE) {
+		lo = 0;
+	}
+	pitch_fft_set_range(&pitch_fft_ranges[ch],
+			Max(lo, PITCH_HZ(PITCH_FFT_MIN_HZ)),
+			Min(hi, PITCH_HZ(PITCH_FFT_CHROMATIC_MAX_HZ)),
+			PITCH_FFT_SHS_HARMONICS);
+	return true;
+}
+#endif
+
+/**
+ * \internal
+ * \brief Estimate the pitch of channel \a ch into its \ref pitch_readings
+ * entry, as in \ref pitch_fft_update()
+ */
+static void pitch_fft_measure(uint8_t ch, uint16_t end_pos, uint32_t time,
+		uint8_t active)
+{
+	struct pitch_reading *reading = &pitch_readings[ch];
+	bool transformed = false;
+	uint8_t partial;
+	uint16_t peak;
+
+	reading->time = time;
+	if (!(active & (1 << ch))) {
+#if PITCH_FFT_PARTIALS
+		pitch_fft_tracks[ch].f0 = 0;
+#endif
+		reading->freq = 0;
+		reading->level = 0;
+		return;
+	}
+	pitch_fft_buf = scratch_alloc(PITCH_FFT_N / 2 * sizeof(fft_complex_t));
+	pitch_fft_mag = scratch_alloc(PITCH_FFT_N / 2 * sizeof(uint16_t));
+#if PITCH_FFT_PARTIALS
+	if (pitch_fft_tracks[ch].f0) {
+		pitch_fft_load(ch, end_pos);
+		fft_real_mag(pitch_fft_buf, pitch_fft_mag, PITCH_FFT_LOG2_N);
+		if (pitch_fft_follow(ch, reading)) {
+			return;
+		}
+		transformed = true;
+	}
+#endif
+#if PITCH_FFT_CHROMATIC
+	// The octave first, then the fine transform searched around it
+	if (pitch_is_chromatic(ch)) {
+		if (!pitch_fft_coarse(ch, end_pos, reading)) {
+			return;
+		}
+		transformed = false;
+	}
+#endif
+	if (!transformed) {
+		pitch_fft_load(ch, end_pos);
+		fft_real_mag(pitch_fft_buf, pitch_fft_mag, PITCH_FFT_LOG2_N);
+	}
+	peak = pitch_fft_peak(reading, &pitch_fft_ranges[ch], &partial);
+	if (!reading->freq) {
+		return;
+	}
+#if PITCH_FFT_PARTIALS
+	if (pitch_fft_lock(ch, reading) && pitch_fft_follow(ch, reading)) {
+		return;
+	}
+#endif
+#if PITCH_FFT_PV
+	if (peak >= WINDOW_LOBE) {
+		uint32_t pos = ((uint32_t)peak << 8)
+				+ fft_vertex(pitch_fft_mag, peak);
+
+		reading->freq = pitch_fft_hz(pitch_fft_pv(ch, end_pos, peak, pos),
+				pitch_fft_width(ch)) / partial;
+	}
+#endif
+}
+
+/**
+ * \brief Update the \ref pitch_readings entry of channel \a ch
+ *
+ * \param ch      Channel to analyse
+ * \param end_pos Ring position following the newest sample to analyse
+ * \param time    Stamp of the block that ends at \a end_pos
+ * \param active  Open channels; a closed channel reads as silent
+ */
+void pitch_fft_update(uint8_t ch, uint16_t end_pos, uint32_t time,
+		uint8_t active)
+{
+	pitch_fft_measure(ch, end_pos, time, active);
+	pitch_filter(ch);
+}
+
+//! The FFT, a batch engine
+const struct pitch_engine pitch_fft_engine = {
+	.init = pitch_fft_init,
+	.update = pitch_fft_update,
+	.retune = pitch_fft_retune,
+	.min_level = PITCH_FFT_MIN_LEVEL,
+	.chromatic = PITCH_FFT_CHROMATIC,
+};
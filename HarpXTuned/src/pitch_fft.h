@@ -0,0 +1,225 @@
+/**
+ * \file
+ *
+ * \brief FFT pitch engine
+ *
+ * Every channel's newest PITCH_FFT_N samples are read from the SDRAM ring,
+ * stripped of DC, windowed with the \ref window.h window, Hann by default,
+ * and transformed with the Q15 real FFT. The strongest bin of the
+ * channel's \ref harp_search_range(), and above PITCH_FFT_MIN_HZ, is
+ * refined by parabolic interpolation over its neighbours and stored in
+ * \ref pitch_readings.
+ *
+ * The wound bass strings have a weak fundamental that plain peak picking
+ * would miss for the second partial. A channel whose search range reaches
+ * below PITCH_FFT_SHS_HZ instead picks the bin with the largest
+ * subharmonic sum, the magnitude of the bin plus those of its next
+ * PITCH_FFT_SHS_HARMONICS - 1 partials, from the same spectrum. The
+ * strongest of those partials is then refined and divided down.
+ *
+ * With PITCH_FFT_PARTIALS set, as in the precision profile, a channel that
+ * has found a pitch tracks its first PITCH_FFT_PARTIALS partials from frame
+ * to frame instead: each is looked for within PITCH_FFT_TRACK_BINS of
+ * where it was, and the positions are fitted to the stiff string series
+ * f_n = n f0 (1 + B n^2 / 2). The reading is f0, the fundamental with the
+ * inharmonicity B taken out, and B is kept for
+ * \ref pitch_fft_inharmonicity(). The channel goes back to the full
+ * search once its partials fade or leave the search range. Partials
+ * closer than the width of the window's main lobe are not tracked, their
+ * lobes overlap.
+ *
+ * With PITCH_FFT_PV set, a peak that is not tracked, such as a bass
+ * string's, is refined phase vocoder fashion: the bin is worked out
+ * again, directly, for the frame PITCH_FFT_PV_HOP samples earlier in the
+ * ring, and the phase advance between the two gives the frequency to a
+ * small fraction of a bin, with no zero padding and no second transform.
+ *
+ * With PITCH_FFT_LOG2_DECIM_MAX set, as in the precision profile, every
+ * channel runs at the lowest rate 2^-n SAMPLERATE that keeps its top
+ * partial searched below a quarter of the rate, as worked out from its
+ * candidates. The frames are decimated by a second order CIC on the way
+ * out of the ring, so a bass channel's PITCH_FFT_N points span 2^n times
+ * the time, in the same ring, at 2^-n times the bin width.
+ *
+ * With PITCH_FFT_CHROMATIC set, a channel in the chromatic mode of
+ * \ref pitch_set_chromatic() has no strings to search around. Each frame
+ * first takes a coarse transform of PITCH_FFT_COARSE_N points, decimated
+ * by 2^PITCH_FFT_COARSE_LOG2_DECIM on the way out of the ring. Its
+ * strongest peak is one of the first PITCH_FFT_SHS_HARMONICS partials,
+ * which narrows the fundamental, anywhere from PITCH_FFT_MIN_HZ to
+ * PITCH_FFT_CHROMATIC_MAX_HZ, to the octaves under it; a peak in the
+ * lowest coarse bins, within the lobe of the window around DC, only
+ * bounds it from above. The fine transform then picks it by subharmonic
+ * summation in that range only, decimated for it as a harp channel would
+ * be, so the lowest note read is 2 WINDOW_LOBE bins of the fine
+ * transform at that rate: PITCH_FFT_MIN_HZ in the precision profile,
+ * 39 Hz in the mixed one and 313 Hz in the fast tune one, see bench/.
+ * The coarse pass costs about a quarter of the fine one, and none while
+ * the partials are tracked.
+ *
+ */
+
+#ifndef PITCH_FFT_H
+#define PITCH_FFT_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "harp.h"
+#include "pitch.h"
+#include "dsp/fft.h"
+
+//! Transform size, log2
+#ifndef PITCH_FFT_LOG2_N
+#  define PITCH_FFT_LOG2_N 9
+#endif
+#define PITCH_FFT_N         (1U << PITCH_FFT_LOG2_N)
+
+//! \ref scratch.h bytes of one channel: the packed samples and FFT work
+//! area, and the magnitudes
+#define PITCH_FFT_SCRATCH   (PITCH_FFT_N / 2 * (4U + 2U))
+
+//! Lowest fundamental searched for
+#ifndef PITCH_FFT_MIN_HZ
+#  define PITCH_FFT_MIN_HZ 25
+#endif
+
+//! Channels searching below this many Hz use subharmonic summation
+#ifndef PITCH_FFT_SHS_HZ
+#  define PITCH_FFT_SHS_HZ 110
+#endif
+
+//! Partials in the subharmonic sum, 1 to turn it off
+#ifndef PITCH_FFT_SHS_HARMONICS
+#  define PITCH_FFT_SHS_HARMONICS 4
+#endif
+
+//! Partials tracked and fitted per channel, 0 for none
+#ifndef PITCH_FFT_PARTIALS
+#  define PITCH_FFT_PARTIALS 0
+#endif
+
+//! Bins a tracked partial may move between two frames
+#ifndef PITCH_FFT_TRACK_BINS
+#  define PITCH_FFT_TRACK_BINS 2
+#endif
+
+//! Smallest magnitude of a tracked partial taken into the fit
+#ifndef PITCH_FFT_PARTIAL_LEVEL
+#  define PITCH_FFT_PARTIAL_LEVEL (PITCH_FFT_MIN_LEVEL / 4)
+#endif
+
+//! Refine untracked peaks by their phase advance, 0 to turn it off
+#ifndef PITCH_FFT_PV
+#  define PITCH_FFT_PV 1
+#endif
+
+//! Hop of the phase vocoder, log2 of samples, at most PITCH_FFT_LOG2_N
+#ifndef PITCH_FFT_PV_LOG2_HOP
+#  define PITCH_FFT_PV_LOG2_HOP (PITCH_FFT_LOG2_N - 1)
+#endif
+#define PITCH_FFT_PV_HOP    (1U << PITCH_FFT_PV_LOG2_HOP)
+//! log2 of PITCH_FFT_N over PITCH_FFT_PV_HOP
+#define PITCH_FFT_PV_SHIFT  (PITCH_FFT_LOG2_N - PITCH_FFT_PV_LOG2_HOP)
+
+//! Largest extra decimation of a channel, log2, 0 for one rate
+#ifndef PITCH_FFT_LOG2_DECIM_MAX
+#  define PITCH_FFT_LOG2_DECIM_MAX 0
+#endif
+
+//! A channel's top partial searched stays below its rate over
+//! 2^(PITCH_FFT_DECIM_BAND_SHIFT + 1), clear of the decimator droop
+#define PITCH_FFT_DECIM_BAND_SHIFT 1
+
+//! Search the whole range in chromatic mode, 0 to leave it out
+#ifndef PITCH_FFT_CHROMATIC
+#  define PITCH_FFT_CHROMATIC 1
+#endif
+
+//! Highest fundamental searched in chromatic mode
+#ifndef PITCH_FFT_CHROMATIC_MAX_HZ
+#  define PITCH_FFT_CHROMATIC_MAX_HZ 2100
+#endif
+
+//! Coarse transform of chromatic mode, log2 of its size
+#ifndef PITCH_FFT_COARSE_LOG2_N
+#  define PITCH_FFT_COARSE_LOG2_N (PITCH_FFT_LOG2_N - 2)
+#endif
+#define PITCH_FFT_COARSE_N  (1U << PITCH_FFT_COARSE_LOG2_N)
+
+//! Decimation of the coarse transform, log2
+#ifndef PITCH_FFT_COARSE_LOG2_DECIM
+#  define PITCH_FFT_COARSE_LOG2_DECIM 1
+#endif
+
+//! Width of one coarse bin in Hz, Q24.8
+#define PITCH_FFT_COARSE_WIDTH (((uint32_t)SAMPLERATE * 256 \
+		>> PITCH_FFT_COARSE_LOG2_DECIM) / PITCH_FFT_COARSE_N)
+
+//! Smallest peak magnitude reported as a pitch
+#ifndef PITCH_FFT_MIN_LEVEL
+#  define PITCH_FFT_MIN_LEVEL 64
+#endif
+
+//! Left shift taking the decimated samples to full Q15 scale
+#ifndef PITCH_FFT_INPUT_SHIFT
+#  define PITCH_FFT_INPUT_SHIFT (4 - CAPTURE_LOG2_SCALE)
+#endif
+
+//! Frames between two updates, whole \ref capture.h hops
+#ifndef PITCH_FFT_HOP
+#  define PITCH_FFT_HOP (8 * CAPTURE_HOP)
+#endif
+
+//! Width of one bin in Hz, Q24.8
+#define PITCH_FFT_BIN_WIDTH ((uint32_t)SAMPLERATE * 256 / PITCH_FFT_N)
+
+#if PITCH_FFT_HOP % CAPTURE_HOP
+#  error "PITCH_FFT_HOP must be whole capture hops"
+#endif
+#if PITCH_FFT_PV_LOG2_HOP > PITCH_FFT_LOG2_N
+#  error "PITCH_FFT_PV_HOP must not exceed PITCH_FFT_N"
+#endif
+#if PITCH_FFT_LOG2_DECIM_MAX > 4
+#  error "PITCH_FFT_LOG2_DECIM_MAX exceeds the decimator"
+#endif
+#if ((PITCH_FFT_N + 2L + PITCH_FFT_PV_HOP) << PITCH_FFT_LOG2_DECIM_MAX) \
+		+ PITCH_FFT_HOP > MAXBUFFER
+#  error "The decimated windows must stay in MAXBUFFER for a hop"
+#endif
+#if PITCH_FFT_CHROMATIC && (PITCH_FFT_COARSE_LOG2_DECIM > 4 \
+		|| PITCH_FFT_COARSE_LOG2_N > PITCH_FFT_LOG2_N \
+		|| (4L * PITCH_FFT_CHROMATIC_MAX_HZ \
+		> (SAMPLERATE >> PITCH_FFT_COARSE_LOG2_DECIM)))
+#  error "The coarse transform must fit the decimator and the buffers," \
+		" with PITCH_FFT_CHROMATIC_MAX_HZ below half its band"
+#endif
+#if PITCH_FFT_CHROMATIC && ((2L * PITCH_FFT_SHS_HARMONICS * PITCH_FFT_MIN_HZ \
+		* PITCH_FFT_COARSE_N) << PITCH_FFT_COARSE_LOG2_DECIM) < SAMPLERATE
+#  error "The top partial summed of PITCH_FFT_MIN_HZ must reach the first" \
+		" coarse bin"
+#endif
+#if PITCH_FFT_CHROMATIC && (((PITCH_FFT_COARSE_N + 2L) \
+		<< PITCH_FFT_COARSE_LOG2_DECIM) + PITCH_FFT_HOP > MAXBUFFER)
+#  error "The coarse window must stay in MAXBUFFER for a hop"
+#endif
+#if PITCH_FFT_PARTIALS > 6
+#  error "The partial fit sums exceed 32 bits beyond 6 partials"
+#endif
+#if PITCH_FFT_LOG2_N > FFT_LOG2_N_MAX
+#  error "PITCH_FFT_LOG2_N exceeds the twiddle table"
+#endif
+#if PITCH_FFT_N > MAXBUFFER
+#  error "PITCH_FFT_N must not exceed MAXBUFFER"
+#endif
+
+extern const struct pitch_engine pitch_fft_engine;
+
+void pitch_fft_init(void);
+void pitch_fft_retune(uint8_t ch);
+void pitch_fft_update(uint8_t ch, uint16_t end_pos, uint32_t time,
+		uint8_t active);
+#if PITCH_FFT_PARTIALS
+uint16_t pitch_fft_inharmonicity(uint8_t ch);
+#endif
+
+#endif /* PITCH_FFT_H */
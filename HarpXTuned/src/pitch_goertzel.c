@@ -0,0 +1,378 @@
+/**
+ * \file
+ *
+ * \brief Goertzel filter bank pitch engine
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <string.h>
+#include <asf.h>
+#include "dsp/goertzel.h"
+#include "pitch.h"
+#include "pitch_goertzel.h"
+
+//! \internal Bank state of one channel
+struct goertzel_channel {
+	//! Boxcar decimator sum and frame count
+	int32_t acc;
+	uint8_t acc_count;
+	//! Decimated samples in the current block
+	uint16_t count;
+	//! String bins, the candidates
+	uint8_t bins;
+	//! String bin the side bins are placed around
+	uint8_t track;
+	//! String bin the second pair is placed around, HARP_GROUP_MAX for none
+	uint8_t ahead;
+	//! String of the group expected at the next onset, or HARP_GROUP_MAX
+	uint8_t next;
+	//! The second pair is to be placed around \c next at the next block
+	bool pending;
+	//! String of the group of each string bin
+	uint8_t string[PITCH_GOERTZEL_MAX_STRINGS];
+	//! String bins, the lower and the upper side bin, then the second pair
+	struct goertzel_bin bin[PITCH_GOERTZEL_MAX_BINS];
+};
+
+static const struct pitch_goertzel_rate goertzel_rates[CHANNELS] =
+		PITCH_GOERTZEL_RATES;
+
+static struct goertzel_channel goertzel_ch[CHANNELS];
+
+//! \internal Channels open in the last block fed
+static uint8_t goertzel_active;
+
+/**
+ * \internal
+ * \brief Phase step of \a freq at the decimated rate of channel \a ch
+ */
+static uint16_t goertzel_phase(uint8_t ch, pitch_hz_t freq)
+{
+	return freq / (SAMPLERATE >> goertzel_rates[ch].log2_decim);
+}
+
+/**
+ * \internal
+ * \brief Place the pair of side bins at \a side half a bin around string
+ * bin \a i, starting afresh
+ */
+static void goertzel_side(uint8_t ch, struct goertzel_bin *side, uint8_t i)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	uint16_t phase = goertzel_phase(ch,
+			harp_string_freq(harp_groups[ch].first + gc->string[i]));
+	uint16_t half = 0x8000U / goertzel_rates[ch].block;
+
+	goertzel_bin_set(&side[0], phase - half);
+	goertzel_bin_set(&side[1], phase + half);
+}
+
+/**
+ * \internal
+ * \brief Place the second pair around the string expected next, unless
+ * it has no bin or the first pair is there
+ */
+static void goertzel_ahead(uint8_t ch)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	uint8_t i;
+
+	gc->ahead = HARP_GROUP_MAX;
+	for (i = 0; i < gc->bins; i++) {
+		if (gc->string[i] == gc->next && i != gc->track) {
+			gc->ahead = i;
+			goertzel_side(ch, &gc->bin[gc->bins + 2], i);
+			break;
+		}
+	}
+}
+
+/**
+ * \internal
+ * \brief Start a block of channel \a ch, placing the second pair if it is
+ * pending
+ *
+ * The pair only moves between blocks, so it always runs whole ones, like
+ * the string bins it is read against.
+ */
+static void goertzel_block_start(uint8_t ch)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+
+	if (gc->pending) {
+		gc->pending = false;
+		goertzel_ahead(ch);
+	}
+}
+
+/**
+ * \internal
+ * \brief Place the side bins half a bin around string bin \a track
+ */
+static void goertzel_track(uint8_t ch, uint8_t track)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+
+	gc->track = track;
+	goertzel_side(ch, &gc->bin[gc->bins], track);
+	if (gc->ahead == track) {
+		gc->ahead = HARP_GROUP_MAX;
+	}
+}
+
+/**
+ * \internal
+ * \brief Swap the two pairs, so the first is around the string of the
+ * second and the second around the string the first was on
+ */
+static void goertzel_swap(struct goertzel_channel *gc)
+{
+	struct goertzel_bin side[2];
+	uint8_t track = gc->track;
+
+	memcpy(side, &gc->bin[gc->bins], sizeof(side));
+	memcpy(&gc->bin[gc->bins], &gc->bin[gc->bins + 2], sizeof(side));
+	memcpy(&gc->bin[gc->bins + 2], side, sizeof(side));
+	gc->track = gc->ahead;
+	gc->ahead = track;
+}
+
+/**
+ * \internal
+ * \brief Turn the finished block of channel \a ch into a reading
+ */
+static void goertzel_readout(uint8_t ch)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	struct pitch_reading *reading = &pitch_readings[ch];
+	const struct pitch_goertzel_rate *rate = &goertzel_rates[ch];
+	uint8_t n = gc->bins;
+	uint32_t best_mag = 0;
+	uint32_t lo;
+	uint32_t hi;
+	uint32_t mag;
+	uint8_t best = 0;
+	uint8_t i;
+	int16_t offset;
+	pitch_hz_t spacing;
+
+	for (i = 0; i < n; i++) {
+		mag = goertzel_mag(&gc->bin[i]);
+		if (mag > best_mag) {
+			best_mag = mag;
+			best = i;
+		}
+	}
+	lo = goertzel_mag(&gc->bin[n]);
+	hi = goertzel_mag(&gc->bin[n + 1]);
+	if (gc->ahead < n) {
+		if (best == gc->ahead) {
+			lo = goertzel_mag(&gc->bin[n + 2]);
+			hi = goertzel_mag(&gc->bin[n + 3]);
+			goertzel_swap(gc);
+		} else {
+			goertzel_clear(&gc->bin[n + 2]);
+			goertzel_clear(&gc->bin[n + 3]);
+		}
+	}
+
+	// Back to the amplitude of a single frame
+	mag = best_mag / (((uint32_t)rate->block << rate->log2_decim) >> 1);
+	reading->level = (mag > UINT16_MAX) ? UINT16_MAX : (uint16_t)mag;
+
+	if (reading->level < PITCH_GOERTZEL_MIN_LEVEL) {
+		reading->freq = 0;
+		return;
+	}
+	if (best != gc->track) {
+		// Side bins were elsewhere, refine from the next block on
+		reading->freq = 0;
+		goertzel_track(ch, best);
+		return;
+	}
+
+	// Parabola through the side bins and the string bin, Q8 half bins
+	offset = goertzel_vertex(lo, best_mag, hi);
+
+	spacing = ((pitch_hz_t)(SAMPLERATE >> rate->log2_decim) << 16)
+			/ (2 * rate->block);
+	reading->freq = harp_string_freq(harp_groups[ch].first + gc->string[best])
+			+ (((int32_t)offset * (int32_t)spacing) >> 8);
+}
+
+/**
+ * \internal
+ * \brief Drop the partial block of channel \a ch and start a new one
+ */
+static void goertzel_restart(uint8_t ch)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	uint8_t i;
+
+	gc->acc = 0;
+	gc->acc_count = 0;
+	gc->count = 0;
+	for (i = 0; i < gc->bins + 4; i++) {
+		goertzel_clear(&gc->bin[i]);
+	}
+	goertzel_block_start(ch);
+	pitch_filter_reset(ch);
+}
+
+/**
+ * \brief Program the bank of every channel from its candidates
+ */
+void pitch_goertzel_init(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		goertzel_ch[ch].next = HARP_GROUP_MAX;
+		goertzel_ch[ch].pending = false;
+		pitch_goertzel_retune(ch);
+	}
+	goertzel_active = 0;
+}
+
+/**
+ * \brief Program the bank of channel \a ch from its candidates
+ *
+ * The partial block is dropped, the next one starts afresh.
+ */
+void pitch_goertzel_retune(uint8_t ch)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	harp_candidates_t set = harp_candidates(ch);
+	uint8_t i;
+
+	gc->acc = 0;
+	gc->acc_count = 0;
+	gc->count = 0;
+	gc->bins = 0;
+	for (i = 0; set; i++, set >>= 1) {
+		if (!(set & 1)) {
+			continue;
+		}
+		Assert(gc->bins < PITCH_GOERTZEL_MAX_STRINGS);
+
+		gc->string[gc->bins] = i;
+		goertzel_bin_set(&gc->bin[gc->bins], goertzel_phase(ch,
+				harp_string_freq(harp_groups[ch].first + i)));
+		gc->bins++;
+	}
+	goertzel_track(ch, 0);
+	gc->pending = false;
+	goertzel_ahead(ch);
+}
+
+/**
+ * \brief Move the bins of \a strings of channel \a ch to their reference
+ *
+ * Only the bins named are reprogrammed, and the side bins if they track
+ * one of them, so the block goes on. The moved bins start afresh and read
+ * low until the block ends. A second pair around one of them is dropped
+ * and placed again at the next block.
+ */
+void pitch_goertzel_retune_strings(uint8_t ch, harp_candidates_t strings)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	uint8_t i;
+
+	for (i = 0; i < gc->bins; i++) {
+		if (!(strings & (1U << gc->string[i]))) {
+			continue;
+		}
+		goertzel_bin_set(&gc->bin[i], goertzel_phase(ch,
+				harp_string_freq(harp_groups[ch].first + gc->string[i])));
+		if (i == gc->track) {
+			goertzel_track(ch, i);
+		} else if (i == gc->ahead) {
+			gc->ahead = HARP_GROUP_MAX;
+			gc->pending = true;
+		}
+	}
+}
+
+/**
+ * \brief Expect string \a string of the group of channel \a ch at the
+ * next onset, HARP_GROUP_MAX for none
+ *
+ * The side bins stay around the string ringing now, which is plucked
+ * again more often than not, and the second pair goes to \a string from
+ * the next block of the channel on.
+ */
+void pitch_goertzel_prewarm(uint8_t ch, uint8_t string)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+
+	if (string == gc->next) {
+		return;
+	}
+	gc->next = string;
+	gc->pending = true;
+}
+
+/**
+ * \brief Run the bank of channel \a ch over one capture block
+ *
+ * A channel the gate has closed is skipped and reads as silent. One that
+ * opens again or sees an onset drops its partial block, so a reading never
+ * mixes two plucks.
+ */
+void pitch_goertzel_feed(const frameq_block_t *block, uint8_t ch)
+{
+	struct goertzel_channel *gc = &goertzel_ch[ch];
+	uint8_t bit = 1 << ch;
+	uint8_t bins;
+	uint8_t frame;
+	uint8_t i;
+
+	if (!(block->active & bit)) {
+		goertzel_active &= ~bit;
+		pitch_readings[ch].freq = 0;
+		pitch_readings[ch].level = 0;
+		pitch_readings[ch].time = block->time;
+		return;
+	}
+	if (!(goertzel_active & bit) || (block->onset & bit)) {
+		goertzel_restart(ch);
+	}
+	goertzel_active |= bit;
+
+	// The second pair only comes and goes between blocks
+	bins = gc->bins + ((gc->ahead < gc->bins) ? 4 : 2);
+	for (frame = 0; frame < FRAMEQ_BLOCK_FRAMES; frame++) {
+		gc->acc += block->frame[frame].ch[ch];
+		if (++gc->acc_count < (1U << goertzel_rates[ch].log2_decim)) {
+			continue;
+		}
+
+		for (i = 0; i < bins; i++) {
+			goertzel_step(&gc->bin[i], gc->acc);
+		}
+		gc->acc = 0;
+		gc->acc_count = 0;
+
+		if (++gc->count == goertzel_rates[ch].block) {
+			gc->count = 0;
+			goertzel_readout(ch);
+			pitch_readings[ch].time = block->time;
+			pitch_filter(ch);
+			goertzel_block_start(ch);
+			bins = gc->bins + ((gc->ahead < gc->bins) ? 4 : 2);
+		}
+	}
+}
+
+//! The Goertzel bank, a streaming engine
+const struct pitch_engine pitch_goertzel_engine = {
+	.init = pitch_goertzel_init,
+	.feed = pitch_goertzel_feed,
+	.retune = pitch_goertzel_retune,
+	.retune_strings = pitch_goertzel_retune_strings,
+	.prewarm = pitch_goertzel_prewarm,
+	.min_level = PITCH_GOERTZEL_MIN_LEVEL,
+};
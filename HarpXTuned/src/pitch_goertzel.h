@@ -0,0 +1,78 @@
+/**
+ * \file
+ *
+ * \brief Goertzel filter bank pitch engine
+ *
+ * Instead of a whole spectrum, each channel evaluates one Goertzel bin per
+ * candidate string of its \ref harp_groups entry, plus two side bins half
+ * a bin below and above the string that was loudest in the previous block.
+ * Narrowing the \ref harp_candidates() cuts the work in proportion.
+ *
+ * Samples are fed frame by frame from the capture queue, so the cost is
+ * spread evenly over time instead of arriving in one batch. Each channel
+ * first sums 2^log2_decim frames, a boxcar decimator that brings the rate
+ * down to a few times the top string of its group, then runs every bin on
+ * the decimated sample. After \c block decimated samples the loudest string
+ * bin is reported; the side bins refine its frequency by parabolic
+ * interpolation.
+ *
+ * A block whose loudest string is not the one the side bins were around
+ * reads silent and moves them. A second pair waits around the string that
+ * \ref predict.h expects next, so a pluck of it reads from its first
+ * block while one of the string just tuned still does too; the two pairs
+ * swap when it comes. A new guess moves the pair at the next block of
+ * the channel, so it is only ever read over a whole block. It costs two
+ * more bins per sample while there is a guess.
+ *
+ */
+
+#ifndef PITCH_GOERTZEL_H
+#define PITCH_GOERTZEL_H
+
+#include <compiler.h>
+#include "frameq.h"
+#include "harp.h"
+
+//! Upper bound on the strings of one channel group
+#ifndef PITCH_GOERTZEL_MAX_STRINGS
+#  define PITCH_GOERTZEL_MAX_STRINGS 14
+#endif
+
+//! Bins of one channel, the strings and two pairs of side bins
+#define PITCH_GOERTZEL_MAX_BINS (PITCH_GOERTZEL_MAX_STRINGS + 4)
+
+//! Smallest bin magnitude reported as a pitch
+#ifndef PITCH_GOERTZEL_MIN_LEVEL
+#  define PITCH_GOERTZEL_MIN_LEVEL 64
+#endif
+
+//! Decimation and block length of one channel
+struct pitch_goertzel_rate {
+	//! log2 of the frames summed per decimated sample
+	uint8_t log2_decim;
+	//! Decimated samples per reading
+	uint16_t block;
+};
+
+/**
+ * \brief Rate of each channel, in channel order
+ *
+ * Matches the default \ref HARP_CHANNEL_GROUPS at 40 kHz: 625 Hz,
+ * 1.25 kHz, 5 kHz and 10 kHz, with blocks giving a bin width of about 6%
+ * of the lowest string of the group, and 9% of C1 in the bass, whose
+ * block would otherwise take half a second.
+ */
+#ifndef PITCH_GOERTZEL_RATES
+#  define PITCH_GOERTZEL_RATES \
+	{ { 6, 213 }, { 5, 160 }, { 3, 160 }, { 2, 80 } }
+#endif
+
+extern const struct pitch_engine pitch_goertzel_engine;
+
+void pitch_goertzel_init(void);
+void pitch_goertzel_retune(uint8_t ch);
+void pitch_goertzel_retune_strings(uint8_t ch, harp_candidates_t strings);
+void pitch_goertzel_prewarm(uint8_t ch, uint8_t string);
+void pitch_goertzel_feed(const frameq_block_t *block, uint8_t ch);
+
+#endif /* PITCH_GOERTZEL_H */
@@ -0,0 +1,258 @@
+/**
+ * \file
+ *
+ * \brief Streaming YIN pitch tracker
+ *
+ */
+
+#include <conf_profile.h>
+PROFILE_HOT_FILE
+
+#include <string.h>
+#include <asf.h>
+#include "dsp/yin.h"
+#include "pitch_yin.h"
+
+//! \internal Largest leak shift, keeps d(tau) within 32 bits
+#define YIN_MAX_LEAK    6
+
+//! \internal Tracker state of one channel
+struct yin_channel {
+	//! Boxcar decimator sum and frame count
+	int32_t acc;
+	uint8_t acc_count;
+	//! Decimated samples, newest at pos - 1
+	int16_t hist[PITCH_YIN_HISTORY];
+	uint8_t pos;
+	//! Lags kept, from the candidates
+	uint8_t min_lag;
+	uint8_t max_lag;
+	//! Next lag to update
+	uint8_t cursor;
+	//! Leak shift k
+	uint8_t leak;
+	//! Largest |x| since the last evaluation
+	uint16_t peak;
+	//! Difference function, index 0 unused
+	uint32_t d[PITCH_YIN_MAX_LAG + 1];
+};
+
+static const struct pitch_yin_rate yin_rates[CHANNELS] = PITCH_YIN_RATES;
+
+static struct yin_channel yin_ch[CHANNELS];
+
+//! \internal Channels open in the last block fed
+static uint8_t yin_active;
+
+/**
+ * \internal
+ * \brief Leak shift giving a window of PITCH_YIN_PERIODS periods of \a tau
+ *
+ * Every lag is updated once per sweep over the lags kept,
+ * PITCH_YIN_LAGS_PER_STEP a sample, so the window is 2^k sweeps long.
+ */
+static uint8_t yin_leak(uint8_t ch, uint8_t tau)
+{
+	const struct yin_channel *yc = &yin_ch[ch];
+	uint8_t sweep = (yc->max_lag - yc->min_lag + PITCH_YIN_LAGS_PER_STEP)
+			/ PITCH_YIN_LAGS_PER_STEP;
+	uint16_t target = (uint16_t)PITCH_YIN_PERIODS * tau / sweep;
+	uint8_t k = 1;
+
+	while (k < YIN_MAX_LEAK && (2U << k) <= target) {
+		k++;
+	}
+	return k;
+}
+
+/**
+ * \internal
+ * \brief Look for a period once every lag has been updated
+ */
+static void yin_evaluate(uint8_t ch)
+{
+	struct yin_channel *yc = &yin_ch[ch];
+	struct pitch_reading *reading = &pitch_readings[ch];
+	uint16_t period;
+
+	reading->level = yc->peak;
+	yc->peak = 0;
+	if (reading->level < PITCH_YIN_MIN_LEVEL) {
+		reading->freq = 0;
+		return;
+	}
+
+	period = yin_period(yc->d, yc->min_lag, yc->max_lag,
+			PITCH_YIN_THRESHOLD);
+	if (!period) {
+		reading->freq = 0;
+		return;
+	}
+	reading->freq = yin_hz(SAMPLERATE >> yin_rates[ch].log2_decim, period);
+
+	yc->leak = yin_leak(ch, (period + 128) >> 8);
+}
+
+/**
+ * \internal
+ * \brief Take one decimated sample and update the next few lags
+ *
+ * \retval true if the sweep over the lags ended and the reading is new
+ */
+static bool yin_push(uint8_t ch, int16_t x)
+{
+	struct yin_channel *yc = &yin_ch[ch];
+	uint8_t max_lag = yc->max_lag;
+	bool done = false;
+	uint8_t i;
+
+	yc->hist[yc->pos] = x;
+	if (x < 0) {
+		x = -x;
+	}
+	if ((uint16_t)x > yc->peak) {
+		yc->peak = x;
+	}
+
+	for (i = 0; i < PITCH_YIN_LAGS_PER_STEP; i++) {
+		uint8_t tau = yc->cursor;
+		int16_t e = yc->hist[yc->pos]
+				- yc->hist[(uint8_t)(yc->pos - tau) & (PITCH_YIN_HISTORY - 1)];
+
+		yin_update(&yc->d[tau], e, yc->leak);
+
+		if (++yc->cursor > max_lag) {
+			yc->cursor = yc->min_lag;
+			yin_evaluate(ch);
+			done = true;
+			break;
+		}
+	}
+
+	yc->pos = (yc->pos + 1) & (PITCH_YIN_HISTORY - 1);
+	return done;
+}
+
+/**
+ * \internal
+ * \brief Forget the difference function of channel \a ch
+ *
+ * The history and the leak are kept; the first sweep after a restart
+ * rebuilds d(tau) from the new note only.
+ */
+static void yin_restart(uint8_t ch)
+{
+	struct yin_channel *yc = &yin_ch[ch];
+
+	yc->acc = 0;
+	yc->acc_count = 0;
+	yc->cursor = yc->min_lag;
+	yc->peak = 0;
+	memset(yc->d, 0, sizeof(yc->d));
+	pitch_filter_reset(ch);
+}
+
+/**
+ * \brief Reset the trackers of every channel
+ */
+void pitch_yin_init(void)
+{
+	uint8_t ch;
+
+	memset(yin_ch, 0, sizeof(yin_ch));
+	for (ch = 0; ch < CHANNELS; ch++) {
+		Assert(yin_rates[ch].max_lag <= PITCH_YIN_MAX_LAG);
+
+		pitch_yin_retune(ch);
+	}
+	yin_active = 0;
+}
+
+/**
+ * \brief Set the lags of channel \a ch from its candidates
+ *
+ * If the lags change the difference function starts over, the history is
+ * kept either way.
+ */
+void pitch_yin_retune(uint8_t ch)
+{
+	struct yin_channel *yc = &yin_ch[ch];
+	// Decimated rate, Q16.16 Hz
+	uint32_t rate = (uint32_t)(SAMPLERATE >> yin_rates[ch].log2_decim) << 16;
+	pitch_hz_t lo;
+	pitch_hz_t hi;
+	uint32_t lag;
+	uint8_t min_lag;
+	uint8_t max_lag;
+
+	harp_search_range(ch, &lo, &hi);
+
+	// Room for the neighbours of the dip above the longest period
+	lag = rate / lo + 2;
+	max_lag = (lag > yin_rates[ch].max_lag) ? yin_rates[ch].max_lag
+			: (uint8_t)lag;
+	lag = rate / hi / 2;
+	if (lag > max_lag / 2) {
+		lag = max_lag / 2;
+	}
+	min_lag = lag ? (uint8_t)lag : 1;
+
+	if (min_lag == yc->min_lag && max_lag == yc->max_lag) {
+		return;
+	}
+	yc->min_lag = min_lag;
+	yc->max_lag = max_lag;
+	yin_restart(ch);
+	yc->leak = yin_leak(ch, max_lag);
+}
+
+/**
+ * \brief Run the tracker of channel \a ch over one capture block
+ *
+ * A channel the gate has closed is skipped and reads as silent; one that
+ * opens again or sees an onset restarts its difference function.
+ */
+void pitch_yin_feed(const frameq_block_t *block, uint8_t ch)
+{
+	struct yin_channel *yc = &yin_ch[ch];
+	uint8_t log2_decim = yin_rates[ch].log2_decim;
+	uint8_t bit = 1 << ch;
+	uint8_t frame;
+
+	if (!(block->active & bit)) {
+		yin_active &= ~bit;
+		pitch_readings[ch].freq = 0;
+		pitch_readings[ch].level = 0;
+		pitch_readings[ch].time = block->time;
+		return;
+	}
+	if (!(yin_active & bit) || (block->onset & bit)) {
+		yin_restart(ch);
+	}
+	yin_active |= bit;
+
+	for (frame = 0; frame < FRAMEQ_BLOCK_FRAMES; frame++) {
+		yc->acc += block->frame[frame].ch[ch];
+		if (++yc->acc_count < (1U << log2_decim)) {
+			continue;
+		}
+
+		// Back to the scale of 4x at unity gain, so e^2 fits for any
+		// profile
+		if (yin_push(ch, (int16_t)(yc->acc
+				>> (log2_decim + CAPTURE_LOG2_SCALE - 2)))) {
+			pitch_readings[ch].time = block->time;
+			pitch_filter(ch);
+		}
+		yc->acc = 0;
+		yc->acc_count = 0;
+	}
+}
+
+//! The YIN tracker, a streaming engine
+const struct pitch_engine pitch_yin_engine = {
+	.init = pitch_yin_init,
+	.feed = pitch_yin_feed,
+	.retune = pitch_yin_retune,
+	.min_level = PITCH_YIN_MIN_LEVEL,
+};
@@ -0,0 +1,91 @@
+/**
+ * \file
+ *
+ * \brief Streaming YIN pitch tracker
+ *
+ * Each channel keeps the YIN difference function d(tau) for every lag up
+ * to its max_lag as a leaky sum, d = d - d / 2^k + (x[t] - x[t - tau])^2.
+ * Every decimated sample updates the next PITCH_YIN_LAGS_PER_STEP lags, so
+ * the cost per sample is fixed and small. After a full sweep over the lags
+ * the first dip of the cumulative mean normalised difference below
+ * PITCH_YIN_THRESHOLD gives the period. Parabolic interpolation over d
+ * refines it.
+ *
+ * The leak k is set from the last period found, so the window spans about
+ * PITCH_YIN_PERIODS periods. Treble strings settle within milliseconds,
+ * bass strings average over a longer window.
+ *
+ * Only the lags of the channel's \ref harp_search_range() are kept, from
+ * half the period of its top end, so the dip of d is seen with the rise
+ * before it, to the period of its bottom end. The cumulative mean is taken
+ * over those lags only. A narrow candidate set makes for short sweeps and
+ * readings that come sooner.
+ *
+ */
+
+#ifndef PITCH_YIN_H
+#define PITCH_YIN_H
+
+#include <compiler.h>
+#include "frameq.h"
+#include "harp.h"
+#include "pitch.h"
+
+//! Largest lag of any channel
+#ifndef PITCH_YIN_MAX_LAG
+#  define PITCH_YIN_MAX_LAG 96
+#endif
+
+//! Sample history per channel, a power of two above PITCH_YIN_MAX_LAG
+#define PITCH_YIN_HISTORY 128
+
+//! Lags updated per decimated sample
+#ifndef PITCH_YIN_LAGS_PER_STEP
+#  define PITCH_YIN_LAGS_PER_STEP 4
+#endif
+
+//! Dip threshold of the normalised difference, Q8
+#ifndef PITCH_YIN_THRESHOLD
+#  define PITCH_YIN_THRESHOLD 38
+#endif
+
+//! Periods spanned by the leaky window
+#ifndef PITCH_YIN_PERIODS
+#  define PITCH_YIN_PERIODS 4
+#endif
+
+//! Smallest sample peak reported as a pitch
+#ifndef PITCH_YIN_MIN_LEVEL
+#  define PITCH_YIN_MIN_LEVEL 64
+#endif
+
+#if PITCH_YIN_MAX_LAG >= PITCH_YIN_HISTORY
+#  error "PITCH_YIN_HISTORY must exceed PITCH_YIN_MAX_LAG"
+#endif
+
+//! Decimation and lag range of one channel
+struct pitch_yin_rate {
+	//! log2 of the frames averaged per decimated sample
+	uint8_t log2_decim;
+	//! Longest period ever searched, in decimated samples
+	uint8_t max_lag;
+};
+
+/**
+ * \brief Rate of each channel, in channel order
+ *
+ * Matches the default \ref HARP_CHANNEL_GROUPS at 40 kHz: 2.5, 5, 10 and
+ * 20 kHz, each lag range covering the lowest string of the group.
+ */
+#ifndef PITCH_YIN_RATES
+#  define PITCH_YIN_RATES \
+	{ { 4, 96 }, { 3, 52 }, { 2, 28 }, { 1, 16 } }
+#endif
+
+extern const struct pitch_engine pitch_yin_engine;
+
+void pitch_yin_init(void);
+void pitch_yin_retune(uint8_t ch);
+void pitch_yin_feed(const frameq_block_t *block, uint8_t ch);
+
+#endif /* PITCH_YIN_H */
@@ -0,0 +1,56 @@
+/**
+ * \file
+ *
+ * \brief Clock gating of the peripherals that idle between uses
+ *
+ */
+
+#include <asf.h>
+#include "power.h"
+
+//! \internal Clock of a gated peripheral
+struct power_clock {
+	//! \ref sysclk_port_id
+	uint8_t port;
+	//! Power reduction bit on that port
+	uint8_t id;
+};
+
+//! \internal Clock of each module, in \ref power_module order
+static const struct power_clock power_clocks[POWER_MODULES] = {
+	{ SYSCLK_PORT_C, SYSCLK_SPI },
+	{ SYSCLK_PORT_D, SYSCLK_TC0 },
+};
+
+//! \internal Users of each module
+static uint8_t power_users[POWER_MODULES];
+
+/**
+ * \brief Start the clock of \a module, unless another user has
+ *
+ * Not from interrupts.
+ */
+void power_get(enum power_module module)
+{
+	Assert(power_users[module] < 0xff);
+
+	if (!power_users[module]++) {
+		sysclk_enable_module((enum sysclk_port_id)
+				power_clocks[module].port, power_clocks[module].id);
+	}
+	sleepmgr_lock_mode(SLEEPMGR_IDLE);
+}
+
+/**
+ * \brief Stop the clock of \a module once its last user is done
+ */
+void power_put(enum power_module module)
+{
+	Assert(power_users[module]);
+
+	sleepmgr_unlock_mode(SLEEPMGR_IDLE);
+	if (!--power_users[module]) {
+		sysclk_disable_module((enum sysclk_port_id)
+				power_clocks[module].port, power_clocks[module].id);
+	}
+}
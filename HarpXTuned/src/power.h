@@ -0,0 +1,44 @@
+/**
+ * \file
+ *
+ * \brief Clock gating of the peripherals that idle between uses
+ *
+ * sysclk_init() stops the clock of every peripheral, and the ASF drivers
+ * start them on init. The ADC and DAC drivers count their users and stop
+ * the clock again with the last one, so ADCB between \ref auxadc.h
+ * readings and DACB between tones already draw nothing. The SPI and TC
+ * drivers do not: SPIC for the DataFlash and the panel, and TCD0 for the
+ * tone, would run from init on, while the DataFlash is talked to a few
+ * times a second during a recording only, the panel sends a page now and
+ * then and the tone plays now and then.
+ *
+ * Their users take the clock with \ref power_get() around each use and
+ * give it back with \ref power_put(), which stops it with the last user.
+ * A gated module keeps its registers but ignores accesses, so a driver
+ * configures it under a \ref power_get() and may then let it go. While
+ * held, a module also holds the idle sleep lock, as the ADC and DAC
+ * drivers do, so the CPU does not sleep past its clock.
+ *
+ * The USARTs are left running: USARTC0 and CHAIN_USART must always hear
+ * the host and the chain bus.
+ *
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <compiler.h>
+
+//! Gated peripherals
+enum power_module {
+	//! SPIC, shared by \ref dataflash.h and \ref lcd.h
+	POWER_SPIC,
+	//! TCD0, TONE_TC of \ref tone.h
+	POWER_TONE,
+	POWER_MODULES
+};
+
+void power_get(enum power_module module);
+void power_put(enum power_module module);
+
+#endif /* POWER_H */
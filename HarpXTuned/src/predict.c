@@ -0,0 +1,208 @@
+/**
+ * \file
+ *
+ * \brief Prediction of the next string tuned, from the order so far
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "harp.h"
+#include "notes.h"
+#include "pitch.h"
+#include "predict.h"
+
+//! \internal No string guessed
+#define PREDICT_NONE            HARP_STRINGS
+
+#if PREDICT_SETTLE < 1 || PREDICT_SETTLE > 255
+#  error "PREDICT_SETTLE must fit the 8-bit run count"
+#endif
+
+//! \internal Strings tuned, the newest first
+static uint8_t predict_history[PREDICT_HISTORY];
+//! \internal Entries of predict_history in use
+static uint8_t predict_depth;
+//! \internal String guessed next, PREDICT_NONE for none
+static uint8_t predict_guess;
+//! \internal Rule counter, 2 and up for the step two back
+static uint8_t predict_rule;
+//! \internal Strings tuned while there was a guess, and guessed right
+static uint16_t predict_guessed;
+static uint16_t predict_right;
+//! \internal String of the estimates of each channel, and their run
+static uint8_t predict_run_string[CHANNELS];
+static uint8_t predict_run[CHANNELS];
+
+/**
+ * \internal
+ * \brief String \a step strings from \a from, PREDICT_NONE if that is no
+ * step of an order or off the harp
+ */
+static uint8_t predict_step(uint8_t from, int8_t step)
+{
+	int16_t to = (int16_t)from + step;
+
+	if (!step || step > PREDICT_MAX_STEP || step < -PREDICT_MAX_STEP
+			|| to < 0 || to >= HARP_STRINGS) {
+		return PREDICT_NONE;
+	}
+	return to;
+}
+
+/**
+ * \internal
+ * \brief Guess of one rule from the history
+ *
+ * \param before Repeat the step two back rather than the last one
+ */
+static uint8_t predict_by(bool before)
+{
+	const uint8_t *h = predict_history;
+
+	if (before) {
+		if (predict_depth < 3) {
+			return PREDICT_NONE;
+		}
+		return predict_step(h[0], (int8_t)(h[1] - h[2]));
+	}
+	if (predict_depth < 2) {
+		return PREDICT_NONE;
+	}
+	return predict_step(h[0], (int8_t)(h[0] - h[1]));
+}
+
+/**
+ * \internal
+ * \brief Hand \a string to the engine of the channel that has it as a
+ * candidate, and no string to the others
+ */
+static void predict_prewarm(uint8_t string)
+{
+	uint8_t ch;
+	uint8_t i;
+
+	for (ch = 0; ch < CHANNELS; ch++) {
+		i = string - harp_groups[ch].first;
+		if (string == PREDICT_NONE || i >= harp_groups[ch].count
+				|| !(harp_candidates(ch) & (1U << i))) {
+			i = HARP_GROUP_MAX;
+		}
+		pitch_prewarm(ch, i);
+	}
+}
+
+/**
+ * \internal
+ * \brief Take \a string as tuned and guess the next one
+ */
+static void predict_push(uint8_t string)
+{
+	bool last = predict_by(false) == string;
+	bool before = predict_by(true) == string;
+
+	// Train the counter only where the rules disagree
+	if (before && !last && predict_rule < 3) {
+		predict_rule++;
+	} else if (last && !before && predict_rule > 0) {
+		predict_rule--;
+	}
+	if (predict_guess != PREDICT_NONE) {
+		if (predict_guessed == UINT16_MAX) {
+			predict_guessed >>= 1;
+			predict_right >>= 1;
+		}
+		predict_guessed++;
+		if (predict_guess == string) {
+			predict_right++;
+		}
+	}
+
+	memmove(&predict_history[1], &predict_history[0],
+			PREDICT_HISTORY - 1);
+	predict_history[0] = string;
+	if (predict_depth < PREDICT_HISTORY) {
+		predict_depth++;
+	}
+
+	predict_guess = predict_by(predict_rule >= 2);
+	if (predict_guess == PREDICT_NONE) {
+		predict_guess = predict_by(predict_rule < 2);
+	}
+	predict_prewarm(predict_guess);
+}
+
+/**
+ * \brief Forget the order and the guess
+ */
+void predict_reset(void)
+{
+	predict_depth = 0;
+	predict_guess = PREDICT_NONE;
+	predict_rule = 1;
+	predict_guessed = 0;
+	predict_right = 0;
+	memset(predict_run, 0, sizeof(predict_run));
+	predict_prewarm(PREDICT_NONE);
+}
+
+/**
+ * \brief Take the new reading of channel \a ch, from \ref pitch_filter()
+ */
+void predict_reading(uint8_t ch)
+{
+	pitch_hz_t freq = pitch_readings[ch].freq;
+	uint8_t string;
+
+	if (!freq || pitch_is_chromatic(ch)) {
+		predict_run[ch] = 0;
+		return;
+	}
+	string = harp_nearest_string(ch, freq);
+	if (string != predict_run_string[ch]) {
+		predict_run_string[ch] = string;
+		predict_run[ch] = 0;
+	}
+	if (predict_run[ch] == PREDICT_SETTLE) {
+		return;
+	}
+	if (++predict_run[ch] == PREDICT_SETTLE
+			&& (!predict_depth || string != predict_history[0])) {
+		predict_push(string);
+	}
+}
+
+/**
+ * \brief String guessed to be tuned next
+ *
+ * \return The string, HARP_STRINGS without a guess
+ */
+uint8_t predict_next(void)
+{
+	return predict_guess;
+}
+
+/**
+ * \brief Print the history, the guess and its record on the stdio USART
+ */
+void predict_dump(void)
+{
+	char name[NOTES_NAME_MAX + 1];
+	uint8_t i;
+
+	if (!predict_depth) {
+		printf_P(PSTR("predict nothing tuned yet\r\n"));
+		return;
+	}
+	if (predict_guess == PREDICT_NONE) {
+		printf_P(PSTR("predict no guess after"));
+	} else {
+		notes_name(harp_string_note(predict_guess), name);
+		printf_P(PSTR("predict next %u %s after"), predict_guess, name);
+	}
+	for (i = predict_depth; i--; ) {
+		printf_P(PSTR(" %u"), predict_history[i]);
+	}
+	printf_P(PSTR(", %u of %u right\r\n"), predict_right, predict_guessed);
+}
@@ -0,0 +1,59 @@
+/**
+ * \file
+ *
+ * \brief Prediction of the next string tuned, from the order so far
+ *
+ * A harpist tunes in a fixed order: up or down the strings one by one, a
+ * pitch class octave by octave, or the C and F strings of each octave in
+ * turn. Once the readings of a channel have stayed on one string for
+ * PREDICT_SETTLE estimates in a row, outside chromatic mode, the string
+ * counts as tuned and goes into a history of the last three. The next
+ * string is guessed from it with one of two rules:
+ * - the last step again, C4 to D4 to E4, or C2 to C3 to C4;
+ * - the step before it again, C4 to F4 to C5 to F5, each step repeating
+ *   the one two back.
+ * A two bit counter picks the rule that has been guessing right, the way
+ * a branch predictor does. Steps longer than PREDICT_MAX_STEP are jumps,
+ * not an order, and give no guess.
+ *
+ * The guess goes to the engine of the channel whose candidates hold the
+ * string with \ref pitch_prewarm(). The \ref pitch_goertzel.h bank places
+ * a second pair of side bins around that string, so a pluck of the string
+ * guessed is refined from the first block instead of the second, and so
+ * is one of the string just tuned.
+ * The reference frequencies are in the \ref harp.h table in SRAM already,
+ * so there is nothing to fetch ahead.
+ *
+ * "predict dump" on the \ref shell.h prints the history, the guess and
+ * how many strings were guessed right:
+ * \code
+	predict next 25 C5 after 18 21 22, 5 of 7 right
+\endcode
+ * "predict reset" forgets the order.
+ *
+ */
+
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <compiler.h>
+
+//! Estimates in a row on one string before it counts as tuned
+#ifndef PREDICT_SETTLE
+#  define PREDICT_SETTLE        4
+#endif
+
+//! Longest step of an order, in strings: an octave
+#ifndef PREDICT_MAX_STEP
+#  define PREDICT_MAX_STEP      7
+#endif
+
+//! Strings kept in the history
+#define PREDICT_HISTORY         3
+
+void predict_reset(void);
+void predict_reading(uint8_t ch);
+uint8_t predict_next(void);
+void predict_dump(void);
+
+#endif /* PREDICT_H */
@@ -0,0 +1,188 @@
+/**
+ * \file
+ *
+ * \brief Cycle count probes for interrupts and analysis stages
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "capture.h"
+#include "prof.h"
+#include "tc32.h"
+
+#ifdef CONFIG_PROF
+
+static struct prof_stat prof_stats[PROF_PROBES];
+
+//! \internal Cycles of an empty PROF_BEGIN()/PROF_END() pair
+static uint32_t prof_overhead;
+
+//! \internal Probe names, in \ref prof_probe order
+static PROGMEM_DECLARE(char, prof_name_capture[]) = "capture";
+static PROGMEM_DECLARE(char, prof_name_consume[]) = "consume";
+static PROGMEM_DECLARE(char, prof_name_analysis[]) = "analysis";
+static PROGMEM_DECLARE(char, prof_name_record[]) = "record";
+static PROGMEM_DECLARE(char, prof_name_display[]) = "display";
+static PROGMEM_DECLARE(char, prof_name_telemetry[]) = "telemetry";
+static PROGMEM_DECLARE(char, prof_name_hostlink[]) = "hostlink";
+static PROGMEM_DECLARE(char, prof_name_chain[]) = "chain";
+static PROGMEM_DECLARE(char, prof_name_sync[]) = "sync";
+static PROGMEM_DECLARE(char, prof_name_pedal[]) = "pedal";
+static PROGMEM_DECLARE(char, prof_name_listen[]) = "listen";
+static PROGMEM_DECLARE(char, prof_name_tempcomp[]) = "tempcomp";
+static PROGMEM_DECLARE(char, prof_name_selfcheck[]) = "selfcheck";
+static PROGMEM_DECLARE(char, prof_name_tableload[]) = "tableload";
+static PROGMEM_DECLARE(char, prof_name_loopback[]) = "loopback";
+static PROGMEM_DECLARE(char, prof_name_gliss[]) = "gliss";
+static PROGMEM_DECLARE(char, prof_name_shell[]) = "shell";
+
+static PROGMEM_DECLARE(PROGMEM_STRING_T, prof_names[PROF_PROBES]) = {
+	prof_name_capture,
+	prof_name_consume,
+	prof_name_analysis,
+	prof_name_record,
+	prof_name_display,
+	prof_name_telemetry,
+	prof_name_hostlink,
+	prof_name_chain,
+	prof_name_sync,
+	prof_name_pedal,
+	prof_name_listen,
+	prof_name_tempcomp,
+	prof_name_selfcheck,
+	prof_name_tableload,
+	prof_name_loopback,
+	prof_name_gliss,
+	prof_name_shell,
+};
+
+//! \internal Largest expected stretch of each probe, 0 for none
+static PROGMEM_DECLARE(uint32_t, prof_targets[PROF_PROBES]) = {
+	CAPTURE_CYCLE_TARGET,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+	0,
+};
+
+/**
+ * \brief Start the cycle counter and clear all probes
+ *
+ * The counter runs from the peripheral clock, which equals the CPU clock
+ * with the prescalers of conf_clock.h.
+ */
+void prof_init(void)
+{
+	uint32_t start;
+
+	tc32_init(&PROF_TC, &PROF_TC_HIGH, PROF_CARRY_EVENT_CH,
+			EVSYS_CHMUX_TCE1_OVF_gc, TC_CLKSEL_DIV1_gc);
+
+	start = prof_now();
+	prof_overhead = prof_now() - start;
+	prof_reset();
+}
+
+/**
+ * \brief Current count of the free-running cycle counter
+ *
+ * Works at any interrupt level.
+ */
+uint32_t prof_now(void)
+{
+	return tc32_read(&PROF_TC, &PROF_TC_HIGH);
+}
+
+/**
+ * \brief Add a stretch of \a cycles to \a probe
+ *
+ * Safe from interrupt context, as long as a probe is only recorded at one
+ * interrupt level.
+ */
+void prof_record(enum prof_probe probe, uint32_t cycles)
+{
+	struct prof_stat *st = &prof_stats[probe];
+
+	cycles -= prof_overhead;
+	if (cycles < st->min) {
+		st->min = cycles;
+	}
+	if (cycles > st->max) {
+		st->max = cycles;
+	}
+	// Halve both before the sum can wrap, the average stays valid
+	if (st->sum > UINT32_MAX - cycles) {
+		st->sum >>= 1;
+		st->count >>= 1;
+	}
+	st->sum += cycles;
+	st->count++;
+}
+
+/**
+ * \brief Clear the statistics of every probe
+ */
+void prof_reset(void)
+{
+	irqflags_t flags;
+	uint8_t i;
+
+	flags = cpu_irq_save();
+	for (i = 0; i < PROF_PROBES; i++) {
+		prof_stats[i].min = UINT32_MAX;
+		prof_stats[i].max = 0;
+		prof_stats[i].sum = 0;
+		prof_stats[i].count = 0;
+	}
+	cpu_irq_restore(flags);
+}
+
+/**
+ * \brief Print the statistics of every probe on the stdio USART
+ */
+void prof_dump(void)
+{
+	struct prof_stat st;
+	irqflags_t flags;
+	uint32_t target;
+	uint8_t i;
+
+	for (i = 0; i < PROF_PROBES; i++) {
+		flags = cpu_irq_save();
+		st = prof_stats[i];
+		cpu_irq_restore(flags);
+
+		if (!st.count) {
+			printf_P(PSTR("%-10S no samples\r\n"),
+					(PROGMEM_STRING_T)PROGMEM_READ_WORD(&prof_names[i]));
+			continue;
+		}
+		printf_P(PSTR("%-10S n %lu  min %lu  avg %lu  max %lu cycles\r\n"),
+				(PROGMEM_STRING_T)PROGMEM_READ_WORD(&prof_names[i]),
+				(unsigned long)st.count, (unsigned long)st.min,
+				(unsigned long)(st.sum / st.count),
+				(unsigned long)st.max);
+
+		target = pgm_read_dword(&prof_targets[i]);
+		if (target) {
+			printf_P(PSTR("%-10S target %lu: %S\r\n"),
+					PSTR(""), (unsigned long)target,
+					(st.max > target) ? PSTR("OVER") : PSTR("ok"));
+		}
+	}
+}
+
+#endif /* CONFIG_PROF */
@@ -0,0 +1,105 @@
+/**
+ * \file
+ *
+ * \brief Cycle count probes for interrupts and analysis stages
+ *
+ * PROF_TC runs free at the CPU clock and its overflow clocks PROF_TC_HIGH
+ * through PROF_CARRY_EVENT_CH, a \ref tc32.h pair with no interrupt to
+ * disturb the stretches measured, so the difference of two
+ * \ref prof_now() reads is a cycle count, also for an FFT pass of several
+ * million cycles. Every probe keeps the minimum, maximum, sum and count
+ * of its stretches in SRAM. \ref prof_dump() prints them on the stdio USART, see
+ * \ref shell.h for the commands. Probes with a cycle target, such as
+ * CAPTURE_CYCLE_TARGET for the capture interrupt, are checked against it.
+ *
+ * A stretch is bracketed by PROF_BEGIN() and PROF_END() in the same block:
+ * \code
+	PROF_BEGIN(PROF_CAPTURE);
+	capture_decimate(raw);
+	PROF_END(PROF_CAPTURE);
+\endcode
+ *
+ * The probes only exist when CONFIG_PROF is defined; otherwise the macros
+ * are empty and nothing is linked.
+ *
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include <compiler.h>
+#include <tc.h>
+
+//! Free-running counters, low and high, not to be used for anything else
+#define PROF_TC                 TCE1
+#define PROF_TC_HIGH            TCD1
+//! Event channel of the PROF_TC overflow, after that of timebase.h
+#define PROF_CARRY_EVENT_CH     6
+
+//! Probes, add new ones before PROF_PROBES and name them in prof.c
+enum prof_probe {
+	//! Capture interrupt: one DMA half-buffer, or one sweep in sweep mode
+	PROF_CAPTURE,
+	//! One slice of each scheduler task, in \ref sched_task_id order
+	PROF_TASK_CONSUME,
+	PROF_TASK_ANALYSIS,
+	PROF_TASK_RECORD,
+	PROF_TASK_DISPLAY,
+	PROF_TASK_TELEMETRY,
+	PROF_TASK_HOSTLINK,
+	PROF_TASK_CHAIN,
+	PROF_TASK_SYNC,
+	PROF_TASK_PEDAL,
+	PROF_TASK_LISTEN,
+	PROF_TASK_TEMPCOMP,
+	PROF_TASK_SELFCHECK,
+	PROF_TASK_TABLELOAD,
+	PROF_TASK_LOOPBACK,
+	PROF_TASK_GLISS,
+	PROF_TASK_SHELL,
+	PROF_PROBES
+};
+
+//! Statistics of one probe
+struct prof_stat {
+	uint32_t min;
+	uint32_t max;
+	uint32_t sum;
+	uint32_t count;
+};
+
+#ifdef CONFIG_PROF
+
+void prof_init(void);
+uint32_t prof_now(void);
+void prof_record(enum prof_probe probe, uint32_t cycles);
+void prof_reset(void);
+void prof_dump(void);
+
+//! Start the stretch of \a probe, opens a local in the current block
+#  define PROF_BEGIN(probe) \
+	uint32_t prof_start_##probe = prof_now()
+//! End the stretch of \a probe and record it
+#  define PROF_END(probe) \
+	prof_record(probe, prof_now() - prof_start_##probe)
+//! Start a stretch whose probe is only known at run time
+#  define PROF_BEGIN_ANY() \
+	uint32_t prof_start_any = prof_now()
+//! End the stretch of PROF_BEGIN_ANY() and record it for \a probe
+#  define PROF_END_ANY(probe) \
+	prof_record(probe, prof_now() - prof_start_any)
+
+#else
+
+static inline void prof_init(void) {}
+static inline void prof_reset(void) {}
+static inline void prof_dump(void) {}
+
+#  define PROF_BEGIN(probe)
+#  define PROF_END(probe)
+#  define PROF_BEGIN_ANY()
+#  define PROF_END_ANY(probe)
+
+#endif
+
+#endif /* PROF_H */
@@ -0,0 +1,377 @@
+/**
+ * \file
+ *
+ * \brief Capture recorder on the DataFlash
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "record.h"
+#include "sched.h"
+#include "scratch.h"
+#include "serial_tx.h"
+#include "dsp/adpcm.h"
+
+//! \internal Largest distance to the capture write position still safe
+#define RECORD_MAX_LAG          (MAXBUFFER - MAXBUFFER / 8)
+
+//! \internal Bytes of the recording per dump line
+#define RECORD_DUMP_LINE        32
+
+//! \internal Pages of a RECORD_SECONDS recording
+#define RECORD_PAGES \
+	((RECORD_SECONDS * 1UL * RECORD_RATE + RECORD_PAGE_FRAMES - 1) \
+	/ RECORD_PAGE_FRAMES)
+
+#if RECORD_PAGES > DATAFLASH_PAGES
+#  error "RECORD_SECONDS exceeds the DataFlash"
+#endif
+
+static enum record_state record_state;
+//! \internal The DataFlash has been looked for
+static bool record_probed;
+
+//! \internal Next ring position to record
+static uint16_t record_pos;
+//! \internal Page the buffer being filled goes to, and the end of the take
+static uint16_t record_page;
+static uint16_t record_end_page;
+//! \internal SRAM buffer being filled, and the bytes in it
+static uint8_t record_buf;
+static uint16_t record_offset;
+//! \internal The buffer is complete and waits for the chip to be ready
+static bool record_full;
+//! \internal Bytes programmed into the array
+static uint32_t record_bytes;
+//! \internal A dump is being sent, and the next byte of it
+static bool record_dumping;
+static uint32_t record_dump_addr;
+
+//! \internal Decimator sums and frame count
+static int32_t record_acc[CHANNELS];
+static uint8_t record_acc_count;
+//! \internal Recorded frames of the group being built
+static uint8_t record_group_frames;
+
+#if RECORD_FORMAT == RECORD_FORMAT_ADPCM
+//! \internal Coder state, and the code of the group's first frame
+static struct adpcm_state record_adpcm[CHANNELS];
+static uint8_t record_codes[CHANNELS];
+#endif
+
+//! \internal State names, in \ref record_state order
+static PROGMEM_DECLARE(char, record_name_idle[]) = "idle";
+static PROGMEM_DECLARE(char, record_name_running[]) = "running";
+static PROGMEM_DECLARE(char, record_name_done[]) = "done";
+static PROGMEM_DECLARE(char, record_name_overrun[]) = "overrun";
+static PROGMEM_DECLARE(char, record_name_absent[]) = "no DataFlash";
+
+static PROGMEM_DECLARE(PROGMEM_STRING_T, record_names[]) = {
+	record_name_idle,
+	record_name_running,
+	record_name_done,
+	record_name_overrun,
+	record_name_absent,
+};
+
+/**
+ * \internal
+ * \brief Frames the capture is ahead of the recorder
+ */
+static uint16_t record_get_lag(void)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t pos = capture_write_pos;
+
+	cpu_irq_restore(flags);
+	return ring_distance(record_pos, pos, MAXBUFFER);
+}
+
+/**
+ * \internal
+ * \brief Look for the DataFlash, on the first use of the recorder
+ */
+static void record_probe(void)
+{
+	if (!record_probed) {
+		record_probed = true;
+		record_state = dataflash_init() ? RECORD_IDLE : RECORD_ABSENT;
+	}
+}
+
+/**
+ * \brief Start a recording of RECORD_SECONDS from the newest frame on
+ *
+ * Overwrites the previous recording. Does nothing without a DataFlash.
+ */
+void record_start(void)
+{
+	irqflags_t flags;
+	uint8_t ch;
+
+	record_probe();
+	if (record_state == RECORD_ABSENT) {
+		return;
+	}
+	flags = cpu_irq_save();
+	record_pos = capture_write_pos;
+	cpu_irq_restore(flags);
+
+	record_page = 0;
+	record_end_page = RECORD_PAGES;
+	record_buf = 0;
+	record_offset = 0;
+	record_full = false;
+	record_bytes = 0;
+	for (ch = 0; ch < CHANNELS; ch++) {
+		record_acc[ch] = 0;
+#if RECORD_FORMAT == RECORD_FORMAT_ADPCM
+		adpcm_reset(&record_adpcm[ch]);
+#endif
+	}
+	record_acc_count = 0;
+	record_group_frames = 0;
+	record_dumping = false;
+	record_state = RECORD_RUNNING;
+}
+
+#if RECORD_FORMAT == RECORD_FORMAT_ADPCM
+/**
+ * \internal
+ * \brief Write out a group holding only its first frame
+ *
+ * The second code of each byte is 0, the smallest step, so the frame it
+ * decodes to stays next to the last one recorded.
+ */
+static void record_flush_group(void)
+{
+	uint8_t out[RECORD_GROUP_BYTES];
+	uint8_t len = 0;
+	uint8_t ch;
+
+	if (!record_group_frames) {
+		return;
+	}
+	for (ch = 0; ch < CHANNELS; ch++) {
+		if (RECORD_CHANNELS & (1 << ch)) {
+			out[len++] = record_codes[ch];
+		}
+	}
+	dataflash_buffer_write(record_buf, record_offset, out, len);
+	record_offset += len;
+	record_group_frames = 0;
+}
+#endif
+
+/**
+ * \brief End the recording early
+ *
+ * A group half built is completed and the page being filled is still
+ * programmed, by the recorder task.
+ */
+void record_stop(void)
+{
+	if (record_state != RECORD_RUNNING) {
+		return;
+	}
+#if RECORD_FORMAT == RECORD_FORMAT_ADPCM
+	// A page with no room left would have been taken as full
+	if (!record_full) {
+		record_flush_group();
+	}
+#endif
+	if (record_full || record_offset) {
+		record_full = true;
+		record_end_page = record_page + 1;
+	} else {
+		record_state = RECORD_DONE;
+	}
+}
+
+/**
+ * \brief Current state of the recorder
+ */
+enum record_state record_get_state(void)
+{
+	return record_state;
+}
+
+/**
+ * \internal
+ * \brief Send the next line of the dump
+ *
+ * \retval true while more lines are to come
+ */
+static bool record_dump_line(void)
+{
+	uint8_t line[RECORD_DUMP_LINE];
+	uint16_t len;
+	uint8_t i;
+
+	// Wait for the chip and for room, rather than block the slice
+	if (!dataflash_is_ready()
+			|| serial_tx_get_free() < 2 * RECORD_DUMP_LINE + 2) {
+		return true;
+	}
+	len = min(record_bytes - record_dump_addr, sizeof(line));
+	dataflash_read(record_dump_addr / DATAFLASH_PAGE_SIZE,
+			record_dump_addr % DATAFLASH_PAGE_SIZE, line, len);
+	for (i = 0; i < len; i++) {
+		printf_P(PSTR("%02x"), line[i]);
+	}
+	printf_P(PSTR("\r\n"));
+	record_dump_addr += len;
+	record_dumping = record_dump_addr < record_bytes;
+	return record_dumping;
+}
+
+/**
+ * \brief Move captured frames into the DataFlash, or send a dump,
+ * scheduler task
+ *
+ * Each slice either hands a full buffer to the chip, if it is ready, or
+ * writes up to RECORD_CHUNK_FRAMES frames into the other buffer. During
+ * a \ref record_dump() it sends one line instead.
+ *
+ * \retval true if more frames or lines are waiting
+ */
+bool record_run(void)
+{
+	capture_frame_t *frames;
+	uint8_t *out;
+	uint16_t lag;
+	uint16_t count;
+	uint16_t room;
+	uint16_t need;
+	uint16_t len = 0;
+	uint16_t i;
+	uint8_t ch;
+
+	if (record_dumping) {
+		return record_dump_line();
+	}
+	if (record_state != RECORD_RUNNING) {
+		return false;
+	}
+
+	if (record_full) {
+		if (!dataflash_is_ready()) {
+			return false;
+		}
+		dataflash_buffer_program(record_buf, record_page);
+		record_bytes += record_offset;
+		record_full = false;
+		record_buf ^= 1;
+		record_offset = 0;
+		if (++record_page == record_end_page) {
+			record_state = RECORD_DONE;
+			return false;
+		}
+	}
+
+	lag = record_get_lag();
+	if (lag > RECORD_MAX_LAG) {
+		record_state = RECORD_OVERRUN;
+		return false;
+	}
+
+	// No more frames than complete the page
+	room = DATAFLASH_PAGE_SIZE - Max(record_offset, RECORD_PAGE_HEADER);
+	need = ((room / RECORD_GROUP_BYTES * RECORD_GROUP_FRAMES
+			- record_group_frames) << RECORD_LOG2_DECIM) - record_acc_count;
+	count = min(min(lag, need), RECORD_CHUNK_FRAMES);
+	if (!count) {
+		return false;
+	}
+	// The frames of this step, and the page header and groups made from
+	// them
+	frames = scratch_alloc(RECORD_CHUNK_FRAMES * sizeof(capture_frame_t));
+	out = scratch_alloc(RECORD_PAGE_HEADER + RECORD_CHUNK_FRAMES
+			/ RECORD_GROUP_FRAMES * RECORD_GROUP_BYTES);
+	capture_read_frames(record_pos, frames, count);
+	record_pos = (record_pos + count) & (MAXBUFFER - 1);
+
+#if RECORD_FORMAT == RECORD_FORMAT_ADPCM
+	// A page starts on a group, with the coder state it starts from
+	if (!record_offset) {
+		for (ch = 0; ch < CHANNELS; ch++) {
+			if (RECORD_CHANNELS & (1 << ch)) {
+				const struct adpcm_state *st = &record_adpcm[ch];
+
+				out[len++] = (uint8_t)st->pred;
+				out[len++] = (uint8_t)((uint16_t)st->pred >> 8);
+				out[len++] = st->index;
+			}
+		}
+	}
+#endif
+
+	for (i = 0; i < count; i++) {
+		for (ch = 0; ch < CHANNELS; ch++) {
+			if (RECORD_CHANNELS & (1 << ch)) {
+				record_acc[ch] += frames[i].ch[ch];
+			}
+		}
+		if (++record_acc_count < (1U << RECORD_LOG2_DECIM)) {
+			continue;
+		}
+		record_acc_count = 0;
+		for (ch = 0; ch < CHANNELS; ch++) {
+			if (RECORD_CHANNELS & (1 << ch)) {
+				int16_t x = (int16_t)(record_acc[ch] >> RECORD_LOG2_DECIM);
+#if RECORD_FORMAT == RECORD_FORMAT_ADPCM
+				uint8_t code = adpcm_encode(&record_adpcm[ch], x);
+
+				if (record_group_frames) {
+					out[len++] = record_codes[ch] | (code << 4);
+				} else {
+					record_codes[ch] = code;
+				}
+#else
+				out[len++] = (uint8_t)x;
+				out[len++] = (uint8_t)((uint16_t)x >> 8);
+#endif
+				record_acc[ch] = 0;
+			}
+		}
+		if (++record_group_frames == RECORD_GROUP_FRAMES) {
+			record_group_frames = 0;
+		}
+	}
+
+	if (len) {
+		dataflash_buffer_write(record_buf, record_offset, out, len);
+		record_offset += len;
+	}
+	if (record_offset == DATAFLASH_PAGE_SIZE) {
+		record_full = true;
+	}
+	return lag > count;
+}
+
+/**
+ * \brief Print the last recording on the stdio USART, in hex
+ *
+ * A header line gives the state, size, rate, channels, format and page
+ * size, then RECORD_DUMP_LINE bytes follow per line, one line per slice
+ * of the recorder task, so the dump does not hold up the others. Refused
+ * while recording.
+ */
+void record_dump(void)
+{
+	record_probe();
+	printf_P(PSTR("record %S: %lu bytes, %u Hz, channels 0x%02x, %S,"
+			" page %u\r\n"),
+			(PROGMEM_STRING_T)PROGMEM_READ_WORD(&record_names[record_state]),
+			(unsigned long)record_bytes, (unsigned int)RECORD_RATE,
+			(unsigned int)RECORD_CHANNELS,
+			(RECORD_FORMAT == RECORD_FORMAT_ADPCM) ? PSTR("adpcm")
+			: PSTR("pcm"), (unsigned int)DATAFLASH_PAGE_SIZE);
+	if (record_state == RECORD_RUNNING || record_state == RECORD_ABSENT) {
+		return;
+	}
+	record_dump_addr = 0;
+	record_dumping = record_bytes != 0;
+	sched_post(SCHED_RECORD);
+}
@@ -0,0 +1,142 @@
+/**
+ * \file
+ *
+ * \brief Capture recorder on the DataFlash
+ *
+ * Streams frames from the capture ring into the \ref dataflash.h array, for
+ * offline analysis of string decays. The selected RECORD_CHANNELS are kept,
+ * averaged over 2^RECORD_LOG2_DECIM frames, and written from page 0 in the
+ * \ref RECORD_FORMAT:
+ * - \ref RECORD_FORMAT_PCM: little endian int16 samples, frame after frame.
+ * - \ref RECORD_FORMAT_ADPCM: 4-bit IMA ADPCM codes, see \ref adpcm.h, a
+ *   quarter of the bytes. Every page starts with the coder state of each
+ *   channel, its predictor as little endian int16 and its step index, so
+ *   each page decodes on its own. Two frames follow per group of one
+ *   byte per channel, the first frame in the low nibble.
+ *
+ * bench-p2 -d of the host bench decodes a \ref record_dump() into a
+ * snapshot file.
+ *
+ * The two SRAM buffers of the chip alternate: while one is programmed into
+ * the array, the next page of samples is written into the other. The
+ * recorder runs as a scheduler task behind the capture, which can run up to
+ * MAXBUFFER frames ahead, so a page program never stalls the capture. If
+ * the recorder falls that far behind it stops with \ref RECORD_OVERRUN
+ * rather than leave a gap.
+ *
+ * The DataFlash is looked for on the first \ref record_start() or
+ * \ref record_dump(), not at start-up.
+ *
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "dataflash.h"
+
+//! \name Recording formats
+//@{
+#define RECORD_FORMAT_PCM       0   //!< int16 samples
+#define RECORD_FORMAT_ADPCM     1   //!< 4-bit IMA ADPCM codes
+//@}
+
+#ifndef RECORD_FORMAT
+#  define RECORD_FORMAT RECORD_FORMAT_ADPCM
+#endif
+
+//! Channels to record, bit n for channel n
+#ifndef RECORD_CHANNELS
+#  define RECORD_CHANNELS       0x01
+#endif
+
+//! log2 of the frames averaged per recorded sample, 0 for raw frames
+#ifndef RECORD_LOG2_DECIM
+#  define RECORD_LOG2_DECIM     2
+#endif
+
+//! Length of a recording started with \ref record_start(), seconds
+#ifndef RECORD_SECONDS
+#  define RECORD_SECONDS        10
+#endif
+
+//! Release period of the recorder task in RTC ticks
+#ifndef RECORD_PERIOD
+#  define RECORD_PERIOD         8
+#endif
+
+//! Worst case array write rate of the AT45DB642D, bytes per second
+#define RECORD_MAX_BYTE_RATE    26000UL
+
+//! Number of recorded channels
+#define RECORD_CHANNEL_COUNT \
+	(((RECORD_CHANNELS) & 1) + ((RECORD_CHANNELS) >> 1 & 1) \
+	+ ((RECORD_CHANNELS) >> 2 & 1) + ((RECORD_CHANNELS) >> 3 & 1) \
+	+ ((RECORD_CHANNELS) >> 4 & 1) + ((RECORD_CHANNELS) >> 5 & 1) \
+	+ ((RECORD_CHANNELS) >> 6 & 1) + ((RECORD_CHANNELS) >> 7 & 1))
+
+#if RECORD_FORMAT == RECORD_FORMAT_PCM
+//! Recorded frames per group of whole bytes
+#  define RECORD_GROUP_FRAMES   1
+//! Bytes of one group
+#  define RECORD_GROUP_BYTES    (2 * RECORD_CHANNEL_COUNT)
+//! Bytes at the start of each page
+#  define RECORD_PAGE_HEADER    0
+#elif RECORD_FORMAT == RECORD_FORMAT_ADPCM
+#  define RECORD_GROUP_FRAMES   2
+#  define RECORD_GROUP_BYTES    RECORD_CHANNEL_COUNT
+#  define RECORD_PAGE_HEADER    (3 * RECORD_CHANNEL_COUNT)
+#else
+#  error "Unknown RECORD_FORMAT"
+#endif
+
+//! Recorded frames per page
+#define RECORD_PAGE_FRAMES \
+	((DATAFLASH_PAGE_SIZE - RECORD_PAGE_HEADER) / RECORD_GROUP_BYTES \
+	* RECORD_GROUP_FRAMES)
+
+//! Ring frames taken per step
+#define RECORD_CHUNK_FRAMES     16
+
+//! \ref scratch.h bytes of one step: the frames, and the page header and
+//! groups made from them
+#define RECORD_SCRATCH \
+	(RECORD_CHUNK_FRAMES * 2U * CHANNELS + RECORD_PAGE_HEADER \
+	+ RECORD_CHUNK_FRAMES / RECORD_GROUP_FRAMES * RECORD_GROUP_BYTES)
+
+//! Recorded frames per second
+#define RECORD_RATE             (SAMPLERATE >> RECORD_LOG2_DECIM)
+
+#if !RECORD_CHANNEL_COUNT || (RECORD_CHANNELS >> CHANNELS)
+#  error "RECORD_CHANNELS must select some of the CHANNELS"
+#endif
+#if (DATAFLASH_PAGE_SIZE - RECORD_PAGE_HEADER) % RECORD_GROUP_BYTES
+#  error "Recorded groups must not straddle DataFlash pages"
+#endif
+#if RECORD_RATE * 1UL * RECORD_GROUP_BYTES / RECORD_GROUP_FRAMES \
+		> RECORD_MAX_BYTE_RATE
+#  error "Recording rate exceeds the DataFlash write rate"
+#endif
+
+//! Recorder states
+enum record_state {
+	//! Nothing recorded since start-up
+	RECORD_IDLE,
+	//! Recording
+	RECORD_RUNNING,
+	//! Recording complete or stopped
+	RECORD_DONE,
+	//! Stopped because the capture overran the recorder
+	RECORD_OVERRUN,
+	//! No DataFlash found
+	RECORD_ABSENT,
+};
+
+void record_start(void);
+void record_stop(void);
+enum record_state record_get_state(void);
+bool record_run(void);
+void record_dump(void);
+
+#endif /* RECORD_H */
@@ -0,0 +1,227 @@
+/**
+ * \file
+ *
+ * \brief Residency of the sleep modes and the system states
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "capture.h"
+#include "residency.h"
+#include "serial_tx.h"
+#include "timebase.h"
+#include "tone.h"
+
+//! \internal RTC ticks per second, see conf_rtc.h
+#define RESIDENCY_RTC_HZ        1024
+
+#ifdef CONFIG_RESIDENCY
+
+static PROGMEM_DECLARE(char, residency_name_active[]) = "active";
+static PROGMEM_DECLARE(char, residency_name_idle[]) = "idle";
+static PROGMEM_DECLARE(char, residency_name_estdby[]) = "estdby";
+static PROGMEM_DECLARE(char, residency_name_psave[]) = "psave";
+static PROGMEM_DECLARE(char, residency_name_stdby[]) = "stdby";
+static PROGMEM_DECLARE(char, residency_name_pdown[]) = "pdown";
+
+static PROGMEM_DECLARE(PROGMEM_STRING_T,
+		residency_mode_names[SLEEPMGR_NR_OF_MODES]) = {
+	residency_name_active,
+	residency_name_idle,
+	residency_name_estdby,
+	residency_name_psave,
+	residency_name_stdby,
+	residency_name_pdown,
+};
+
+static PROGMEM_DECLARE(char, residency_name_stopped[]) = "stopped";
+static PROGMEM_DECLARE(char, residency_name_listening[]) = "listen";
+static PROGMEM_DECLARE(char, residency_name_capture[]) = "capture";
+static PROGMEM_DECLARE(char, residency_name_tx[]) = "tx";
+static PROGMEM_DECLARE(char, residency_name_analysis[]) = "analysis";
+static PROGMEM_DECLARE(char, residency_name_tone[]) = "tone";
+
+static PROGMEM_DECLARE(PROGMEM_STRING_T,
+		residency_state_names[RESIDENCY_STATES]) = {
+	residency_name_stopped,
+	residency_name_listening,
+	residency_name_capture,
+	residency_name_tx,
+	residency_name_analysis,
+	residency_name_tone,
+};
+
+//! \internal Microseconds in each sleep mode and each state
+static uint32_t residency_modes[SLEEPMGR_NR_OF_MODES];
+static uint32_t residency_states[RESIDENCY_STATES];
+//! \internal Sum of either table
+static uint32_t residency_total;
+//! \internal timebase_now() at the last mark
+static uint32_t residency_last;
+//! \internal rtc_get_time() as the CPU went to sleep
+static uint32_t residency_rtc;
+//! \internal Sleep mode and state since the last mark
+static enum sleepmgr_mode residency_mode;
+static enum residency_state residency_state;
+
+/**
+ * \internal
+ * \brief State of the system from here on, \a analysis if a slice of the
+ * analysis starts
+ */
+static enum residency_state residency_now(bool analysis)
+{
+	if (tone_is_playing()) {
+		return RESIDENCY_TONE;
+	}
+	if (analysis) {
+		return RESIDENCY_ANALYSIS;
+	}
+	if (serial_tx_get_free() < SERIAL_TX_SIZE) {
+		return RESIDENCY_TX;
+	}
+	switch (capture_get_state()) {
+	case CAPTURE_RUNNING:
+		return RESIDENCY_CAPTURE;
+	case CAPTURE_LISTENING:
+	case CAPTURE_HEARD:
+		return RESIDENCY_LISTENING;
+	default:
+		return RESIDENCY_STOPPED;
+	}
+}
+
+/**
+ * \internal
+ * \brief Count the stretch since the last mark, ending at \a now
+ */
+static void residency_mark(uint32_t now)
+{
+	uint32_t us = now - residency_last;
+	uint8_t i;
+
+	residency_last = now;
+	if (residency_total + us >= 0x80000000UL) {
+		residency_total = 0;
+		for (i = 0; i < SLEEPMGR_NR_OF_MODES; i++) {
+			residency_modes[i] >>= 1;
+			residency_total += residency_modes[i];
+		}
+		for (i = 0; i < RESIDENCY_STATES; i++) {
+			residency_states[i] >>= 1;
+		}
+	}
+	residency_modes[residency_mode] += us;
+	residency_states[residency_state] += us;
+	residency_total += us;
+}
+
+/**
+ * \brief Clear both tables
+ */
+void residency_reset(void)
+{
+	memset(residency_modes, 0, sizeof(residency_modes));
+	memset(residency_states, 0, sizeof(residency_states));
+	residency_total = 0;
+	residency_last = timebase_now();
+}
+
+/**
+ * \brief Mark the start or the end of a scheduler slice at \a now
+ *
+ * \param analysis A slice of the analysis starts
+ */
+void residency_slice(bool analysis, uint32_t now)
+{
+	residency_mark(now);
+	residency_state = residency_now(analysis);
+}
+
+/**
+ * \brief Mark the CPU going to sleep in \a mode, with interrupts off
+ */
+void residency_sleep(enum sleepmgr_mode mode)
+{
+	residency_mark(timebase_now());
+	residency_mode = mode;
+	residency_state = residency_now(false);
+	residency_rtc = rtc_get_time();
+}
+
+/**
+ * \brief Mark the CPU back from sleep
+ *
+ * Below idle the peripheral clock stops and the timebase with it, so the
+ * sleep is timed on the RTC instead, which runs on to raise the scheduler
+ * alarm.
+ */
+void residency_wake(void)
+{
+	uint32_t ticks;
+
+	if (residency_mode > SLEEPMGR_IDLE) {
+		ticks = rtc_get_time() - residency_rtc;
+		// In two parts, not to overflow within the 36 minutes
+		residency_last -= (ticks / RESIDENCY_RTC_HZ) * TIMEBASE_HZ
+				+ (ticks % RESIDENCY_RTC_HZ) * TIMEBASE_HZ
+				/ RESIDENCY_RTC_HZ;
+	}
+	residency_mark(timebase_now());
+	residency_mode = SLEEPMGR_ACTIVE;
+	residency_state = residency_now(false);
+}
+
+/**
+ * \brief Write the line of the sleep modes, or of the \a states, into
+ * \a line of \a size bytes, leaving out the entries still 0
+ *
+ * \return The length of the line, its CR LF included
+ */
+int residency_format(char *line, uint8_t size, bool states)
+{
+	const uint32_t *table = states ? residency_states : residency_modes;
+	const PROGMEM_STRING_T *names = states ? residency_state_names
+			: residency_mode_names;
+	uint8_t count = states ? RESIDENCY_STATES : SLEEPMGR_NR_OF_MODES;
+	uint32_t total = residency_total;
+	uint16_t permille;
+	int len;
+	uint8_t i;
+
+	len = snprintf_P(line, size, PSTR("residency"));
+	for (i = 0; i < count && len < size; i++) {
+		if (!table[i]) {
+			continue;
+		}
+		permille = (uint64_t)table[i] * 1000 / total;
+		len += snprintf_P(line + len, size - len, PSTR(" %S %u.%u%%"),
+				(PROGMEM_STRING_T)PROGMEM_READ_WORD(&names[i]),
+				permille / 10, permille % 10);
+	}
+	if (len < size) {
+		len += snprintf_P(line + len, size - len, PSTR("\r\n"));
+	}
+	return Min(len, size - 1);
+}
+
+/**
+ * \brief Print both tables on the stdio USART
+ */
+void residency_dump(void)
+{
+	char line[RESIDENCY_LINE_MAX];
+
+	if (!residency_total) {
+		printf_P(PSTR("residency nothing yet\r\n"));
+		return;
+	}
+	residency_format(line, sizeof(line), false);
+	printf_P(PSTR("%s"), line);
+	residency_format(line, sizeof(line), true);
+	printf_P(PSTR("%s"), line);
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * \file
+ *
+ * \brief Residency of the sleep modes and the system states
+ *
+ * For setting measured supply current against what the firmware was doing.
+ * The scheduler marks every slice and every sleep on the \ref timebase.h
+ * clock, or on the RTC for a sleep that stops the timebase, and the time
+ * between two marks goes to two tables:
+ * - the sleep mode the CPU was in, SLEEPMGR_ACTIVE while it ran, as
+ *   \ref sleepmgr_get_sleep_mode() chose it. The interrupt that wakes the
+ *   CPU counts with the sleep, up to the next pass of the scheduler loop;
+ * - the system state at the start of the stretch, the first that holds of
+ *   a \ref tone.h tone playing, an analysis or \ref gliss.h slice
+ *   running, the \ref serial_tx.h ring sending, the capture running, the
+ *   capture listening in standby, and stopped.
+ *
+ * Both tables sum to the same total. Once it reaches 2^31 us, 36 minutes,
+ * every entry is halved, so the shares are of a window that fades out
+ * rather than wraps.
+ *
+ * "profile dump" prints the shares in tenths of a percent and "profile
+ * reset" clears them; the \ref telemetry.h readings add the same two
+ * lines every RESIDENCY_REPORT_CYCLES rounds of the channels:
+ * \code
+	residency active 18.2% idle 81.8%
+	residency capture 66.0% tx 3.1% analysis 30.9%
+\endcode
+ * with the entries that are still 0 left out.
+ *
+ * The marks only exist when CONFIG_RESIDENCY is defined; otherwise the
+ * calls are empty and nothing is linked.
+ *
+ */
+
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <compiler.h>
+#include <sleepmgr.h>
+
+//! System states, in order of precedence, least first
+enum residency_state {
+	//! Capture stopped, a snapshot say
+	RESIDENCY_STOPPED,
+	//! Capture listening in standby
+	RESIDENCY_LISTENING,
+	//! Capture running and nothing else
+	RESIDENCY_CAPTURE,
+	//! Serial output queued
+	RESIDENCY_TX,
+	//! An analysis or glissando slice running
+	RESIDENCY_ANALYSIS,
+	//! A tone playing
+	RESIDENCY_TONE,
+	RESIDENCY_STATES
+};
+
+//! Longest line, with its terminating nul: every entry of either table
+#define RESIDENCY_LINE_MAX      96
+
+//! Rounds of the telemetry readings between two reports, about 10 s
+#ifndef RESIDENCY_REPORT_CYCLES
+#  define RESIDENCY_REPORT_CYCLES 40
+#endif
+
+#ifdef CONFIG_RESIDENCY
+
+void residency_reset(void);
+void residency_slice(bool analysis, uint32_t now);
+void residency_sleep(enum sleepmgr_mode mode);
+void residency_wake(void);
+int residency_format(char *line, uint8_t size, bool states);
+void residency_dump(void);
+
+#else
+
+static inline void residency_reset(void) {}
+static inline void residency_slice(bool analysis, uint32_t now) {}
+static inline void residency_sleep(enum sleepmgr_mode mode) {}
+static inline void residency_wake(void) {}
+static inline void residency_dump(void) {}
+
+#endif
+
+#endif /* RESIDENCY_H */
@@ -0,0 +1,168 @@
+/**
+ * \file
+ *
+ * \brief Typed single-producer single-consumer rings
+ *
+ * \ref RING_DEFINE() makes a ring of a fixed number of slots of one type,
+ * a power of two up to 128, with inline accessors named after it. The
+ * producer only writes \c head and the consumer only writes \c tail,
+ * both free-running single bytes, so neither side masks interrupts, and
+ * the slot of an index is the index masked with slots - 1. A ring of N
+ * slots holds N items, as the indices tell full from empty by their
+ * difference.
+ *
+ * The \ref ring_span helpers split a run of ring positions into the two
+ * contiguous pieces either side of the wrap, for any power of two ring:
+ * the typed rings here and the SDRAM sample rings of \ref capture.h alike.
+ *
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <compiler.h>
+
+/**
+ * \brief A run of ring positions, as at most two contiguous pieces
+ *
+ * The first piece starts at \c pos, the second, if any, at position 0.
+ */
+struct ring_span {
+	//! Position of the first item
+	uint16_t pos;
+	//! Items of each piece
+	uint16_t len[2];
+};
+
+/**
+ * \brief Distance from position \a from on to \a to in a ring of \a size
+ */
+static inline uint16_t ring_distance(uint16_t from, uint16_t to,
+		uint16_t size)
+{
+	return (to - from) & (size - 1);
+}
+
+/**
+ * \brief Span of the \a count items from position \a pos on
+ *
+ * \param count At most \a size
+ */
+static inline void ring_span_after(struct ring_span *sp, uint16_t pos,
+		uint16_t count, uint16_t size)
+{
+	uint16_t first;
+
+	pos &= size - 1;
+	first = Min(count, size - pos);
+	sp->pos = pos;
+	sp->len[0] = first;
+	sp->len[1] = count - first;
+}
+
+/**
+ * \brief Span of the \a count items before position \a end
+ *
+ * \param count At most \a size
+ */
+static inline void ring_span_before(struct ring_span *sp, uint16_t end,
+		uint16_t count, uint16_t size)
+{
+	ring_span_after(sp, end - count, count, size);
+}
+
+/**
+ * \brief Define struct \a name, a ring of \a slots items of \a type
+ *
+ * With it come, for a struct name *r:
+ * - name_reset(r): empty the ring, while neither side runs;
+ * - name_get_fill(r): items waiting;
+ * - producer: name_get_free(r), the slot to fill next or NULL when the
+ *   ring is full, name_commit(r) to hand it over, and
+ *   name_get_free_spans(r, sp) with name_commit_n(r, n) for runs;
+ * - consumer: name_peek(r), the oldest item or NULL when the ring is
+ *   empty, name_release(r) to give it back, and name_get_spans(r, sp)
+ *   with name_release_n(r, n) for runs.
+ *
+ * Check that \a slots is a power of two up to 128 where it is set.
+ */
+#define RING_DEFINE(name, type, slots) \
+	struct name { \
+		volatile uint8_t head; \
+		volatile uint8_t tail; \
+		type slot[slots]; \
+	}; \
+	\
+	static inline void name##_reset(struct name *r) \
+	{ \
+		r->head = 0; \
+		r->tail = 0; \
+	} \
+	\
+	static inline uint8_t name##_get_fill(const struct name *r) \
+	{ \
+		return (uint8_t)(r->head - r->tail); \
+	} \
+	\
+	static inline type *name##_get_free(struct name *r) \
+	{ \
+		uint8_t head = r->head; \
+		\
+		if ((uint8_t)(head - r->tail) >= (slots)) { \
+			return NULL; \
+		} \
+		return &r->slot[head & ((slots) - 1)]; \
+	} \
+	\
+	static inline void name##_commit_n(struct name *r, uint8_t n) \
+	{ \
+		barrier(); \
+		r->head += n; \
+	} \
+	\
+	static inline void name##_commit(struct name *r) \
+	{ \
+		name##_commit_n(r, 1); \
+	} \
+	\
+	static inline void name##_get_free_spans(struct name *r, \
+			struct ring_span *sp) \
+	{ \
+		uint8_t head = r->head; \
+		\
+		ring_span_after(sp, head, \
+				(slots) - (uint8_t)(head - r->tail), (slots)); \
+	} \
+	\
+	static inline type *name##_peek(struct name *r) \
+	{ \
+		uint8_t tail = r->tail; \
+		\
+		if (tail == r->head) { \
+			return NULL; \
+		} \
+		barrier(); \
+		return &r->slot[tail & ((slots) - 1)]; \
+	} \
+	\
+	static inline void name##_release_n(struct name *r, uint8_t n) \
+	{ \
+		barrier(); \
+		r->tail += n; \
+	} \
+	\
+	static inline void name##_release(struct name *r) \
+	{ \
+		name##_release_n(r, 1); \
+	} \
+	\
+	static inline void name##_get_spans(struct name *r, \
+			struct ring_span *sp) \
+	{ \
+		uint8_t tail = r->tail; \
+		\
+		ring_span_after(sp, tail, (uint8_t)(r->head - tail), (slots)); \
+		barrier(); \
+	}
+
+#endif /* RING_H */
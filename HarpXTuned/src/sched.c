@@ -0,0 +1,374 @@
+/**
+ * \file
+ *
+ * \brief Cooperative task scheduler
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "frameq.h"
+#include "prof.h"
+#include "residency.h"
+#include "sched.h"
+#include "scratch.h"
+#include "sdram.h"
+#include "timebase.h"
+
+volatile uint16_t sched_ready;
+
+//! \internal Task table, SCHED_TASKS entries
+static const struct sched_task *sched_tasks;
+
+//! \internal Next release of each periodic task, RTC ticks
+static uint32_t sched_release[SCHED_TASKS];
+
+//! \internal Periodic tasks whose period is dropped, bit n for task n
+static uint16_t sched_stopped;
+
+//! \internal Deadlines missed by each task
+static uint16_t sched_misses[SCHED_TASKS];
+
+//! \internal Slices of each task over its budget
+static uint16_t sched_overruns[SCHED_TASKS];
+
+//! \internal The last reset was by the watchdog
+static bool sched_wdt_reset;
+
+//! \internal Set the RTC alarm before sleeping, see sched_set_alarm()
+static bool sched_alarm;
+
+//! \internal Task names, in \ref sched_task_id order
+static PROGMEM_DECLARE(char, sched_name_consume[]) = "consume";
+static PROGMEM_DECLARE(char, sched_name_analysis[]) = "analysis";
+static PROGMEM_DECLARE(char, sched_name_record[]) = "record";
+static PROGMEM_DECLARE(char, sched_name_display[]) = "display";
+static PROGMEM_DECLARE(char, sched_name_telemetry[]) = "telemetry";
+static PROGMEM_DECLARE(char, sched_name_hostlink[]) = "hostlink";
+static PROGMEM_DECLARE(char, sched_name_chain[]) = "chain";
+static PROGMEM_DECLARE(char, sched_name_sync[]) = "sync";
+static PROGMEM_DECLARE(char, sched_name_pedal[]) = "pedal";
+static PROGMEM_DECLARE(char, sched_name_listen[]) = "listen";
+static PROGMEM_DECLARE(char, sched_name_tempcomp[]) = "tempcomp";
+static PROGMEM_DECLARE(char, sched_name_selfcheck[]) = "selfcheck";
+static PROGMEM_DECLARE(char, sched_name_tableload[]) = "tableload";
+static PROGMEM_DECLARE(char, sched_name_loopback[]) = "loopback";
+static PROGMEM_DECLARE(char, sched_name_gliss[]) = "gliss";
+static PROGMEM_DECLARE(char, sched_name_shell[]) = "shell";
+
+static PROGMEM_DECLARE(PROGMEM_STRING_T, sched_names[SCHED_TASKS]) = {
+	sched_name_consume,
+	sched_name_analysis,
+	sched_name_record,
+	sched_name_display,
+	sched_name_telemetry,
+	sched_name_hostlink,
+	sched_name_chain,
+	sched_name_sync,
+	sched_name_pedal,
+	sched_name_listen,
+	sched_name_tempcomp,
+	sched_name_selfcheck,
+	sched_name_tableload,
+	sched_name_loopback,
+	sched_name_gliss,
+	sched_name_shell,
+};
+
+/**
+ * \internal
+ * \brief Release period of task \a id, 0 while it is dropped
+ */
+static uint16_t sched_period(uint8_t id)
+{
+	return (sched_stopped & (1U << id)) ? 0 : sched_tasks[id].period;
+}
+
+/**
+ * \internal
+ * \brief Choose the next task to run
+ *
+ * \return Task id, or SCHED_TASKS if none is ready
+ */
+static uint8_t sched_pick(uint32_t now)
+{
+	// Read unlocked; a post caught halfway is seen on the next pass
+	uint16_t ready = sched_ready;
+	uint8_t pick = SCHED_TASKS;
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		uint16_t period = sched_period(id);
+		int32_t late = (int32_t)(now - sched_release[id]);
+
+		if (period && late >= 0) {
+			if (late >= period) {
+				return id;
+			}
+			ready |= 1U << id;
+		}
+		if (pick == SCHED_TASKS && (ready & (1U << id))) {
+			pick = id;
+		}
+	}
+	return pick;
+}
+
+/**
+ * \internal
+ * \brief Set the RTC alarm at the earliest release of the periodic tasks
+ *
+ * At least two ticks ahead, as the compare only takes effect once written
+ * through to the RTC clock domain.
+ */
+static void sched_set_next_alarm(void)
+{
+	uint32_t now = rtc_get_time();
+	uint32_t next = now + UINT16_MAX;
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		if (sched_period(id)
+				&& (int32_t)(sched_release[id] - next) < 0) {
+			next = sched_release[id];
+		}
+	}
+	if ((int32_t)(next - now) < 2) {
+		next = now + 2;
+	}
+	rtc_set_alarm(next);
+}
+
+/**
+ * \internal
+ * \brief Run one slice of task \a id and account for it
+ */
+static void sched_dispatch(uint8_t id, uint32_t now)
+{
+	uint16_t period = sched_period(id);
+	uint16_t budget = sched_tasks[id].budget;
+	uint16_t bit = 1U << id;
+	irqflags_t flags;
+	uint32_t start;
+	uint32_t end;
+	bool more;
+
+	if (period && (int32_t)(now - sched_release[id]) >= 0) {
+		if ((int32_t)(now - sched_release[id]) >= period) {
+			// Skip the releases that were missed
+			sched_misses[id]++;
+			sched_release[id] = now + period;
+		} else {
+			sched_release[id] += period;
+		}
+	}
+
+	flags = cpu_irq_save();
+	sched_ready &= ~bit;
+	cpu_irq_restore(flags);
+
+	scratch_begin((enum sched_task_id)id);
+	start = timebase_now();
+	residency_slice(id == SCHED_ANALYSIS || id == SCHED_GLISS, start);
+	PROF_BEGIN_ANY();
+	more = sched_tasks[id].run();
+	PROF_END_ANY((enum prof_probe)(PROF_TASK_CONSUME + id));
+	end = timebase_now();
+	residency_slice(false, end);
+	if (budget && end - start > budget) {
+		sched_overruns[id]++;
+	}
+
+	if (more) {
+		sched_post((enum sched_task_id)id);
+	}
+}
+
+/**
+ * \brief Take the task table and release every periodic task now
+ *
+ * Also starts the watchdog, and notes whether it caused the last reset.
+ *
+ * \param tasks SCHED_TASKS entries, in \ref sched_task_id order. The RTC
+ * and the \ref timebase.h clock must be running.
+ */
+void sched_init(const struct sched_task *tasks)
+{
+	uint32_t now = rtc_get_time();
+	uint8_t id;
+
+	sched_tasks = tasks;
+	sched_stopped = 0;
+	for (id = 0; id < SCHED_TASKS; id++) {
+		sched_release[id] = now;
+	}
+	sched_reset();
+	residency_reset();
+
+	sched_wdt_reset = RST.STATUS & RST_WDRF_bm;
+	RST.STATUS = RST_WDRF_bm;
+#if SCHED_WATCHDOG
+	wdt_set_timeout_period(SCHED_WDT_PERIOD);
+	wdt_enable();
+#endif
+}
+
+/**
+ * \brief Run the tasks, sleeping whenever none is ready
+ *
+ * Never returns.
+ */
+void sched_run(void)
+{
+	uint32_t now;
+	uint8_t id;
+
+	while (1) {
+#if SCHED_WATCHDOG
+		wdt_reset();
+#endif
+		now = rtc_get_time();
+		id = sched_pick(now);
+		if (id < SCHED_TASKS) {
+			sched_dispatch(id, now);
+			continue;
+		}
+
+		/*
+		 * Nothing due. sched_ready is checked again with interrupts
+		 * off; sleepmgr_enter_sleep() turns them back on right before
+		 * the sleep instruction, so a post in between still wakes the
+		 * CPU. With the alarm on no capture interrupt comes, and the
+		 * SDRAM sleeps in self refresh until the tasks run again.
+		 */
+		cpu_irq_disable();
+		if (!sched_ready) {
+			if (sched_alarm) {
+				sched_set_next_alarm();
+				sdram_sleep();
+			}
+			residency_sleep(sleepmgr_get_sleep_mode());
+			sleepmgr_enter_sleep();
+			residency_wake();
+			sdram_wake();
+		} else {
+			cpu_irq_enable();
+		}
+	}
+}
+
+/**
+ * \brief Wake the CPU with the RTC alarm, for while no capture interrupt
+ * comes many times per tick
+ *
+ * Setting the alarm waits for the RTC to synchronise, up to two ticks with
+ * interrupts off, so it is left off while the capture runs.
+ */
+void sched_set_alarm(bool on)
+{
+	sched_alarm = on;
+}
+
+/**
+ * \brief Drop the period of task \a id, or take it up again from now
+ *
+ * For a periodic task that only has work for a while, so that it is not
+ * released for nothing once done. A task stopped runs only when posted.
+ * Not from interrupts.
+ */
+void sched_set_periodic(enum sched_task_id id, bool on)
+{
+	if (on) {
+		sched_release[id] = rtc_get_time();
+		sched_stopped &= ~(1U << id);
+	} else {
+		sched_stopped |= 1U << id;
+	}
+}
+
+/**
+ * \brief Count a missed deadline of posted task \a id
+ *
+ * For the task that posts it, on finding the last job unfinished. Not
+ * from interrupts.
+ */
+void sched_miss(enum sched_task_id id)
+{
+	sched_misses[id]++;
+}
+
+/**
+ * \brief Deadlines missed by all tasks, and blocks the frame queue dropped
+ */
+uint16_t sched_get_misses(void)
+{
+	uint16_t sum = frameq_get_overruns();
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		sum += sched_misses[id];
+	}
+	return sum;
+}
+
+/**
+ * \brief Slices of all tasks over their budget
+ */
+uint16_t sched_get_overruns(void)
+{
+	uint16_t sum = 0;
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		sum += sched_overruns[id];
+	}
+	return sum;
+}
+
+/**
+ * \brief Whether the watchdog caused the last reset
+ */
+bool sched_get_wdt_reset(void)
+{
+	return sched_wdt_reset;
+}
+
+/**
+ * \brief Clear the deadline statistics
+ *
+ * The frame queue drops are only cleared with the capture.
+ */
+void sched_reset(void)
+{
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		sched_misses[id] = 0;
+		sched_overruns[id] = 0;
+	}
+	scratch_reset();
+}
+
+/**
+ * \brief Print the missed deadlines and overruns of every task on the
+ * stdio USART
+ *
+ * The slice times are printed by \ref prof_dump().
+ */
+void sched_dump(void)
+{
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		printf_P(PSTR("%-10S period %u ticks, %u deadlines missed,"
+				" %u slices over %u us, %u scratch bytes\r\n"),
+				(PROGMEM_STRING_T)PROGMEM_READ_WORD(&sched_names[id]),
+				sched_period(id), sched_misses[id],
+				sched_overruns[id], sched_tasks[id].budget,
+				scratch_get_peak((enum sched_task_id)id));
+	}
+	printf_P(PSTR("frameq %u blocks dropped\r\n"), frameq_get_overruns());
+	if (sched_wdt_reset) {
+		printf_P(PSTR("last reset by the watchdog\r\n"));
+	}
+}
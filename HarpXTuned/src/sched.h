@@ -0,0 +1,139 @@
+/**
+ * \file
+ *
+ * \brief Cooperative task scheduler
+ *
+ * Tasks run to completion in short slices and never preempt each other;
+ * interrupts still preempt them. A task is ready when it has been posted
+ * with \ref sched_post(), by an interrupt or another task, or, for a task
+ * with a period, when its release time has come. The ready task of
+ * highest priority runs first, except that a periodic task still waiting
+ * one period after its release has missed its deadline and runs before
+ * any other. \ref sched_set_periodic() drops the period of a task that
+ * has no work for a while, and takes it up again.
+ *
+ * A task that has more work returns true and stays ready, so a long job
+ * such as the analysis of all channels is split into one slice per
+ * channel, and the display and telemetry tasks get in between slices.
+ *
+ * Time is counted in RTC ticks, see conf_rtc.h. When no task is ready
+ * the CPU sleeps until the next interrupt. Periodic tasks rely on the
+ * capture interrupt, many times per tick, to wake the CPU in time; while
+ * it is off, \ref sched_set_alarm() has the RTC alarm wake it for the next
+ * release instead.
+ *
+ * The slices of every task are measured with the \ref prof.h probes from
+ * PROF_TASK_CONSUME on, and missed deadlines are counted per task. Those
+ * counters are kept in every build, for the field: a periodic task misses
+ * when it starts a period late, a posted task when the task that posts it
+ * finds its last job unfinished and says so with \ref sched_miss(), and
+ * any task overruns when one slice takes longer than the budget of its
+ * table entry, timed on the \ref timebase.h clock. The \ref telemetry.h
+ * readings carry a line with the totals whenever they change.
+ *
+ * With CONFIG_RESIDENCY every slice and every sleep is marked for the
+ * \ref residency.h shares of the sleep modes and the system states.
+ *
+ * With SCHED_WATCHDOG the hardware watchdog is fed on every pass of the
+ * scheduler loop, so it only resets the board when a task or an interrupt
+ * storm holds the loop for SCHED_WDT_PERIOD; \ref sched_dump() tells
+ * after such a reset.
+ *
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <compiler.h>
+#include <wdt.h>
+
+//! Tasks in priority order, add new ones before SCHED_TASKS
+enum sched_task_id {
+	//! Take a block from the frame queue
+	SCHED_CONSUME,
+	//! Run the pitch engine on one channel
+	SCHED_ANALYSIS,
+	//! Stream frames to the DataFlash
+	SCHED_RECORD,
+	//! Refresh the tuning LEDs
+	SCHED_DISPLAY,
+	//! Send readings on the stdio USART
+	SCHED_TELEMETRY,
+	//! Send binary frames on the stdio USART
+	SCHED_HOSTLINK,
+	//! Poll or answer on the \ref chain.h bus
+	SCHED_CHAIN,
+	//! Trim the sample clock to the \ref sync.h edges
+	SCHED_SYNC,
+	//! Poll the pedal buttons
+	SCHED_PEDAL,
+	//! Enter and leave standby listening
+	SCHED_LISTEN,
+	//! Follow the RC oscillator drift with the temperature sensor
+	SCHED_TEMPCOMP,
+	//! Measure the sample rate after start-up and on demand
+	SCHED_SELFCHECK,
+	//! Write the chunks of a \ref tableload.h table load
+	SCHED_TABLELOAD,
+	//! Time the bursts of a \ref loopback.h test
+	SCHED_LOOPBACK,
+	//! Analyse the onsets queued by a \ref gliss.h burst
+	SCHED_GLISS,
+	//! Run the commands received on the stdio USART
+	SCHED_SHELL,
+	SCHED_TASKS
+};
+
+//! One task of the table handed to \ref sched_init()
+struct sched_task {
+	//! Run one slice, return true if more slices are pending
+	bool (*run)(void);
+	//! Release period in RTC ticks, 0 if the task only runs when posted
+	uint16_t period;
+	//! Longest slice in microseconds before it counts as an overrun, 0
+	//! for no limit
+	uint16_t budget;
+};
+
+//! Feed the hardware watchdog from the scheduler loop
+#ifndef SCHED_WATCHDOG
+#  define SCHED_WATCHDOG        1
+#endif
+
+//! Watchdog timeout, above the longest sleep and the longest slice
+#ifndef SCHED_WDT_PERIOD
+#  define SCHED_WDT_PERIOD      WDT_TIMEOUT_PERIOD_2KCLK
+#endif
+
+#if SCHED_TASKS > 16
+#  error "The ready mask holds at most 16 tasks"
+#endif
+
+//! Tasks posted and not yet run, bit n for task n
+extern volatile uint16_t sched_ready;
+
+/**
+ * \brief Make task \a id ready
+ *
+ * Safe from interrupts.
+ */
+static inline void sched_post(enum sched_task_id id)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	sched_ready |= 1U << id;
+	cpu_irq_restore(flags);
+}
+
+void sched_init(const struct sched_task *tasks);
+void sched_run(void) __attribute__((noreturn));
+void sched_set_alarm(bool on);
+void sched_set_periodic(enum sched_task_id id, bool on);
+void sched_miss(enum sched_task_id id);
+uint16_t sched_get_misses(void);
+uint16_t sched_get_overruns(void);
+bool sched_get_wdt_reset(void);
+void sched_reset(void);
+void sched_dump(void);
+
+#endif /* SCHED_H */
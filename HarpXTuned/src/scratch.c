@@ -0,0 +1,92 @@
+/**
+ * \file
+ *
+ * \brief Scratch arena shared by the task slices
+ *
+ */
+
+#include <asf.h>
+#include "pitch_fft.h"
+#include "record.h"
+#include "scratch.h"
+#include "sdram.h"
+
+//! \internal FFT scratch, only with channels on that engine
+#if PITCH_FFT_CHANNELS
+#  define SCRATCH_FFT           PITCH_FFT_SCRATCH
+#else
+#  define SCRATCH_FFT           0
+#endif
+
+//! \internal Arena size, the largest need of any stage
+#define SCRATCH_SIZE \
+	Max(Max(SCRATCH_FFT, RECORD_SCRATCH), SDRAM_BENCH_SCRATCH)
+
+#if SCRATCH_SIZE > UINT16_MAX
+#  error "Scratch arena out of range"
+#endif
+
+//! \internal The arena
+static uint8_t scratch_arena[SCRATCH_SIZE];
+//! \internal Bytes taken in this slice
+static uint16_t scratch_top;
+//! \internal Task of this slice
+static uint8_t scratch_owner;
+//! \internal Most bytes each task took in one slice
+static uint16_t scratch_peak[SCHED_TASKS];
+
+/**
+ * \brief Empty the arena for a slice of task \a owner
+ */
+void scratch_begin(enum sched_task_id owner)
+{
+	scratch_top = 0;
+	scratch_owner = owner;
+}
+
+/**
+ * \brief Take \a size bytes of the arena until the end of the slice
+ *
+ * The stages only take what their scratch macro accounts for, so this
+ * cannot run out.
+ */
+void *scratch_alloc(uint16_t size)
+{
+	void *p = &scratch_arena[scratch_top];
+
+	Assert(size <= SCRATCH_SIZE - scratch_top);
+
+	scratch_top += size;
+	if (scratch_top > scratch_peak[scratch_owner]) {
+		scratch_peak[scratch_owner] = scratch_top;
+	}
+	return p;
+}
+
+/**
+ * \brief Size of the arena in bytes
+ */
+uint16_t scratch_get_size(void)
+{
+	return SCRATCH_SIZE;
+}
+
+/**
+ * \brief Most bytes task \a owner took in one slice
+ */
+uint16_t scratch_get_peak(enum sched_task_id owner)
+{
+	return scratch_peak[owner];
+}
+
+/**
+ * \brief Clear the high-water marks
+ */
+void scratch_reset(void)
+{
+	uint8_t id;
+
+	for (id = 0; id < SCHED_TASKS; id++) {
+		scratch_peak[id] = 0;
+	}
+}
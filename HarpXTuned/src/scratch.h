@@ -0,0 +1,36 @@
+/**
+ * \file
+ *
+ * \brief Scratch arena shared by the task slices
+ *
+ * Tasks never preempt each other, so a buffer that a stage only needs
+ * within one slice does not need its own static array: the FFT work area
+ * and magnitudes of \ref pitch_fft.h and the frame chunk of
+ * \ref record.h, and the chunks of \ref sdram_bench(), all come from one
+ * arena, as large as the largest of them.
+ * The scheduler empties it before every slice with \ref scratch_begin(),
+ * and the stage takes its buffers with \ref scratch_alloc(), a bump of
+ * the top; nothing is freed one by one, and nothing taken may be kept past
+ * the slice. Interrupts have their own buffers.
+ *
+ * Each stage states its need as a macro next to its own settings, and
+ * scratch.c sizes the arena from them at compile time, so a larger window
+ * or more channels in one stage is checked against the others by the
+ * compiler. The most each task took in one slice is kept for
+ * \ref sched_dump().
+ *
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <compiler.h>
+#include "sched.h"
+
+void scratch_begin(enum sched_task_id owner);
+void *scratch_alloc(uint16_t size);
+uint16_t scratch_get_size(void);
+uint16_t scratch_get_peak(enum sched_task_id owner);
+void scratch_reset(void);
+
+#endif /* SCRATCH_H */
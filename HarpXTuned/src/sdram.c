@@ -0,0 +1,377 @@
+/**
+ * \file
+ *
+ * \brief External SDRAM arena
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "scratch.h"
+#include "sdram.h"
+#include "timebase.h"
+
+//! \internal Next free byte of the arena
+static hugemem_ptr_t sdram_next = SDRAM_BASE;
+
+#if SDRAM_SELF_REFRESH
+//! \internal The SDRAM is in self refresh, see sdram_sleep()
+static bool sdram_asleep;
+#endif
+
+//! \internal Ways of moving data timed by sdram_bench()
+enum sdram_bench_method {
+	SDRAM_BENCH_WORD,
+	SDRAM_BENCH_BLOCK,
+	SDRAM_BENCH_DMA,
+	SDRAM_BENCH_METHODS
+};
+
+/**
+ * \brief Set up the EBI for the on-board SDRAM and wait until it is ready
+ *
+ * Three-port mode, with the timing of the SDRAM profile in \ref sdram.h.
+ *
+ * The EBI refreshes the SDRAM from the peripheral clock, so sleep modes
+ * below idle are locked out from here on.
+ */
+void sdram_init(void)
+{
+	struct ebi_cs_config cs_config;
+	struct ebi_sdram_config sdram_config;
+
+	Assert(sysclk_get_per2_hz() <= SDRAM_PROFILE_HZ);
+
+	memset(&cs_config, 0, sizeof(struct ebi_cs_config));
+	memset(&sdram_config, 0, sizeof(struct ebi_sdram_config));
+
+	ebi_setup_port(12, 0, 0, EBI_PORT_3PORT | EBI_PORT_SDRAM);
+
+	ebi_cs_set_mode(&cs_config, EBI_CS_MODE_SDRAM_gc);
+	ebi_cs_set_address_size(&cs_config, EBI_CS_ASPACE_8MB_gc);
+	ebi_cs_set_base_address(&cs_config, SDRAM_BASE);
+
+	ebi_sdram_set_mode(&cs_config, EBI_CS_SDMODE_NORMAL_gc);
+
+	ebi_sdram_set_row_bits(&sdram_config, SDRAM_ROW_BITS);
+	ebi_sdram_set_col_bits(&sdram_config, SDRAM_COL_BITS);
+
+	ebi_sdram_set_cas_latency(&sdram_config, SDRAM_CAS_LATENCY);
+	ebi_sdram_set_mode_delay(&sdram_config, SDRAM_MODE_DELAY);
+	ebi_sdram_set_row_cycle_delay(&sdram_config, SDRAM_ROW_CYCLE_DELAY);
+	ebi_sdram_set_row_to_precharge_delay(&sdram_config,
+			SDRAM_PRECHARGE_DELAY);
+	ebi_sdram_set_write_recovery_delay(&sdram_config,
+			SDRAM_WRITE_RECOVERY_DELAY);
+	ebi_sdram_set_self_refresh_to_active_delay(&sdram_config,
+			SDRAM_SELF_REFRESH_DELAY);
+	ebi_sdram_set_row_to_col_delay(&sdram_config, SDRAM_ROW_TO_COL_DELAY);
+	ebi_sdram_set_refresh_period(&sdram_config, SDRAM_REFRESH_PERIOD);
+	ebi_sdram_set_initialization_delay(&sdram_config, SDRAM_INIT_DELAY);
+
+	ebi_sdram_write_config(&sdram_config);
+	ebi_cs_write_config(EBI_SDRAM_CS, &cs_config);
+
+	ebi_enable_cs(EBI_SDRAM_CS, &cs_config);
+
+	while (!ebi_sdram_is_ready()) {
+		// Wait
+	}
+	sleepmgr_lock_mode(SLEEPMGR_IDLE);
+}
+
+/**
+ * \brief Reserve \a size bytes of SDRAM
+ *
+ * Blocks are aligned to 16 bits.
+ *
+ * \return Address of the block, or HUGEMEM_NULL if the arena is exhausted
+ */
+hugemem_ptr_t sdram_alloc(uint32_t size)
+{
+	hugemem_ptr_t block = sdram_next;
+
+	size = (size + 1) & ~1UL;
+	if (size > sdram_get_free()) {
+		return HUGEMEM_NULL;
+	}
+	sdram_next += size;
+	return block;
+}
+
+/**
+ * \brief Number of arena bytes not yet reserved
+ */
+uint32_t sdram_get_free(void)
+{
+	return SDRAM_BASE + SDRAM_SIZE - sdram_next;
+}
+
+/**
+ * \brief Put the SDRAM in self refresh for a sleep of the scheduler
+ *
+ * For while no interrupt touches the SDRAM, as the capture one does. The
+ * EBI stops sending refreshes, and the SDRAM refreshes itself at a
+ * fraction of the current. This also drops the idle sleep lock of
+ * \ref sdram_init(); the ADCs and the DMA controller keep theirs.
+ */
+void sdram_sleep(void)
+{
+#if SDRAM_SELF_REFRESH
+	ebi_sdram_enable_self_refresh();
+	sdram_asleep = true;
+#endif
+}
+
+/**
+ * \brief Take the SDRAM out of self refresh, if \ref sdram_sleep() put it
+ * there
+ *
+ * The EBI waits out SDRAM_SELF_REFRESH_DELAY before the next access.
+ */
+void sdram_wake(void)
+{
+#if SDRAM_SELF_REFRESH
+	if (sdram_asleep) {
+		ebi_sdram_disable_self_refresh();
+		sdram_asleep = false;
+	}
+#endif
+}
+
+/**
+ * \internal
+ * \brief Move \a size bytes from \a src to \a dest on DMA channel \a num
+ *
+ * A single block transfer, requested by software and polled for. The DMA
+ * addresses are 24 bits wide, so 64 KiB boundaries need no care. Two byte
+ * bursts halve the arbitration when the size allows.
+ *
+ * \return false if the transfer stopped on an error
+ */
+static bool sdram_dma_copy(dma_channel_num_t num, uint32_t dest,
+		uint32_t src, uint16_t size)
+{
+	DMA_CH_t *channel = dma_get_channel_address_from_num(num);
+	struct dma_channel_config config;
+	uint8_t flags;
+
+	// Off when neither the capture nor the tone uses DMA
+	if (!(DMA.CTRL & DMA_ENABLE_bm)) {
+		dma_enable();
+	}
+	// A completed transfer would enable the partner of a double buffer pair
+	Assert(!(DMA.CTRL & ((num < 2) ? DMA_DBUFMODE_CH01_gc
+			: DMA_DBUFMODE_CH23_gc)));
+
+	memset(&config, 0, sizeof(config));
+	dma_channel_set_burst_length(&config, (size & 1)
+			? DMA_CH_BURSTLEN_1BYTE_gc : DMA_CH_BURSTLEN_2BYTE_gc);
+	dma_channel_set_transfer_count(&config, size);
+	dma_channel_set_src_mode(&config, DMA_CH_SRCRELOAD_NONE_gc,
+			DMA_CH_SRCDIR_INC_gc);
+	dma_channel_set_dest_mode(&config, DMA_CH_DESTRELOAD_NONE_gc,
+			DMA_CH_DESTDIR_INC_gc);
+	dma_channel_set_source_address(&config, src);
+	dma_channel_set_destination_address(&config, dest);
+	dma_channel_write_config(num, &config);
+
+	dma_channel_enable(num);
+	channel->CTRLA |= DMA_CH_TRFREQ_bm;
+	do {
+		flags = channel->CTRLB;
+	} while (!(flags & (DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm)));
+	channel->CTRLB |= DMA_CH_ERRIF_bm | DMA_CH_TRNIF_bm;
+
+	return !(flags & DMA_CH_ERRIF_bm);
+}
+
+/**
+ * \brief Copy \a size bytes at \a from in the arena into internal SRAM
+ *
+ * On SDRAM_DMA_CH if configured, falling back to the CPU on a transfer
+ * error.
+ */
+void sdram_read(void *to, hugemem_ptr_t from, uint16_t size)
+{
+	if (!size) {
+		return;
+	}
+#ifdef SDRAM_DMA_CH
+	if (sdram_dma_copy(SDRAM_DMA_CH, (uint16_t)to, from, size)) {
+		return;
+	}
+#endif
+	hugemem_read_block(to, from, size);
+}
+
+/**
+ * \brief Copy \a size bytes of internal SRAM to \a to in the arena
+ *
+ * As \ref sdram_read(), the other way.
+ */
+void sdram_write(hugemem_ptr_t to, const void *from, uint16_t size)
+{
+	if (!size) {
+		return;
+	}
+#ifdef SDRAM_DMA_CH
+	if (sdram_dma_copy(SDRAM_DMA_CH, to, (uint16_t)from, size)) {
+		return;
+	}
+#endif
+	hugemem_write_block(to, from, size);
+}
+
+/**
+ * \internal
+ * \brief Fill \a buf with pattern \a seed of the chunk at \a offset
+ *
+ * Every word of the bench area gets its own value, so a wrong row or
+ * column bit shows up as well as a bad bit.
+ */
+static void sdram_bench_fill(uint16_t *buf, uint16_t offset, uint8_t seed)
+{
+	uint16_t i;
+
+	for (i = 0; i < SDRAM_BENCH_CHUNK / 2; i++) {
+		buf[i] = (offset / 2 + i) ^ ((uint16_t)seed * 0x5a5a);
+	}
+}
+
+/**
+ * \internal
+ * \brief Move the chunk in \a buf to or from \a addr with \a method
+ *
+ * \return Microseconds taken, or 0 if the DMA transfer failed
+ */
+static uint32_t sdram_bench_chunk(enum sdram_bench_method method,
+		bool write, hugemem_ptr_t addr, uint16_t *buf,
+		dma_channel_num_t dma_ch)
+{
+	uint32_t start = timebase_now();
+	uint16_t i;
+
+	switch (method) {
+	case SDRAM_BENCH_WORD:
+		for (i = 0; i < SDRAM_BENCH_CHUNK / 2; i++) {
+			if (write) {
+				hugemem_write16(addr + 2 * i, buf[i]);
+			} else {
+				buf[i] = hugemem_read16(addr + 2 * i);
+			}
+		}
+		break;
+
+	case SDRAM_BENCH_BLOCK:
+		if (write) {
+			hugemem_write_block(addr, buf, SDRAM_BENCH_CHUNK);
+		} else {
+			hugemem_read_block(buf, addr, SDRAM_BENCH_CHUNK);
+		}
+		break;
+
+	default:
+		if (!(write ? sdram_dma_copy(dma_ch, addr, (uint16_t)buf,
+				SDRAM_BENCH_CHUNK) : sdram_dma_copy(dma_ch,
+				(uint16_t)buf, addr, SDRAM_BENCH_CHUNK))) {
+			return 0;
+		}
+		break;
+	}
+	return Max(timebase_now() - start, 1);
+}
+
+/**
+ * \brief Time sequential writes and reads of the free end of the arena,
+ * and print the rates
+ *
+ * SDRAM_BENCH_SIZE bytes go each way in chunks of SDRAM_BENCH_CHUNK
+ * bytes: with hugemem_write16() and hugemem_read16() word by word, with
+ * the hugemem block copies, and by DMA on \a dma_ch. Only the moves are
+ * timed. The reads check the pattern the writes left, so a profile that
+ * is too tight shows as bad words.
+ *
+ * \param dma_ch DMA channel with nothing to do for the whole call; its
+ * double buffer pair is turned off meanwhile
+ *
+ * \retval false if the arena has no SDRAM_BENCH_SIZE bytes left
+ */
+bool sdram_bench(dma_channel_num_t dma_ch)
+{
+	uint16_t *buf;
+	uint16_t *expect;
+	// kB/s, the writes first, 0 if the DMA failed
+	uint32_t rate[2][SDRAM_BENCH_METHODS];
+	uint32_t us;
+	uint8_t dbuf;
+	uint16_t offset;
+	uint16_t bad = 0;
+	uint16_t i;
+	uint8_t method;
+	uint8_t pass;
+
+	if (sdram_get_free() < SDRAM_BENCH_SIZE) {
+		return false;
+	}
+	buf = scratch_alloc(SDRAM_BENCH_CHUNK);
+	expect = scratch_alloc(SDRAM_BENCH_CHUNK);
+
+	if (!(DMA.CTRL & DMA_ENABLE_bm)) {
+		dma_enable();
+	}
+	dbuf = DMA.CTRL & DMA_DBUFMODE_gm;
+	dma_set_double_buffer_mode((DMA_DBUFMODE_t)(dbuf
+			& ~((dma_ch < 2) ? DMA_DBUFMODE_CH01_gc
+			: DMA_DBUFMODE_CH23_gc)));
+
+	for (method = 0; method < SDRAM_BENCH_METHODS; method++) {
+		rate[0][method] = 0;
+		rate[1][method] = 0;
+		for (pass = 0; pass < 2; pass++) {
+			bool write = !pass;
+
+			us = 0;
+			for (offset = 0; offset < SDRAM_BENCH_SIZE;
+					offset += SDRAM_BENCH_CHUNK) {
+				uint32_t t;
+
+				sdram_bench_fill(expect, offset, method);
+				if (write) {
+					memcpy(buf, expect, SDRAM_BENCH_CHUNK);
+				}
+				t = sdram_bench_chunk(
+						(enum sdram_bench_method)method,
+						write, sdram_next + offset, buf,
+						dma_ch);
+				if (!t) {
+					break;
+				}
+				us += t;
+				for (i = 0; !write && i < SDRAM_BENCH_CHUNK / 2;
+						i++) {
+					if (buf[i] != expect[i]) {
+						bad++;
+					}
+				}
+			}
+			if (offset < SDRAM_BENCH_SIZE) {
+				// Nothing to read back after a failed write
+				break;
+			}
+			rate[pass][method] = (uint32_t)SDRAM_BENCH_SIZE * 1000
+					/ us;
+		}
+	}
+	dma_set_double_buffer_mode((DMA_DBUFMODE_t)dbuf);
+
+	printf_P(PSTR("sdram write word %lu block %lu dma %lu kB/s\r\n"),
+			rate[0][SDRAM_BENCH_WORD], rate[0][SDRAM_BENCH_BLOCK],
+			rate[0][SDRAM_BENCH_DMA]);
+	printf_P(PSTR("sdram read word %lu block %lu dma %lu kB/s\r\n"),
+			rate[1][SDRAM_BENCH_WORD], rate[1][SDRAM_BENCH_BLOCK],
+			rate[1][SDRAM_BENCH_DMA]);
+	printf_P(PSTR("sdram %u bad words\r\n"), bad);
+	return true;
+}
@@ -0,0 +1,110 @@
+/**
+ * \file
+ *
+ * \brief External SDRAM arena
+ *
+ * The on-board SDRAM is mapped by the EBI above the internal memories and
+ * accessed through \ref hugemem_group. Large buffers are carved out of it
+ * with \ref sdram_alloc(); nothing is ever freed.
+ *
+ * Windows move between the arena and internal SRAM with \ref sdram_read()
+ * and \ref sdram_write(). These run on the DMA channel SDRAM_DMA_CH when
+ * one is configured, and otherwise with hugemem_read_block() and
+ * hugemem_write_block(), which set RAMPZ once per 64 KiB bank. All four
+ * channels belong to the capture, the tone and \ref tableload.h in the
+ * default build, so SDRAM_DMA_CH is left undefined there. Define it only
+ * to a channel none of them uses whose double buffer pair is never
+ * enabled, such as 2 with CAPTURE_MODE_SWEEP and TONE_MODE_ISR.
+ *
+ * While no capture interrupt comes, the scheduler sleeps with the SDRAM in
+ * self refresh, see \ref sdram_sleep(). "sdram bench" on the
+ * \ref shell.h times \ref sdram_bench().
+ *
+ */
+
+#ifndef SDRAM_H
+#define SDRAM_H
+
+#include <compiler.h>
+#include <dma.h>
+#include <hugemem.h>
+#include <conf_board.h>
+
+#ifndef CONFIG_HAVE_HUGEMEM
+#  error "The SDRAM arena needs CONFIG_HAVE_HUGEMEM"
+#endif
+
+//! First byte of the SDRAM address space
+#define SDRAM_BASE  BOARD_EBI_SDRAM_BASE
+//! Size of the SDRAM in bytes
+#define SDRAM_SIZE  BOARD_EBI_SDRAM_SIZE
+
+/**
+ * \name SDRAM profile
+ *
+ * The Micron MT48LC16M4A2-75 of the XMEGA-A1 Xplained: four banks of 4096
+ * rows of 1024 columns, and 4096 refreshes every 64 ms. The EBI clocks it
+ * with CLKper2, 32 MHz or 31.25 ns a cycle here. The delays are the data
+ * sheet minimums rounded up to whole cycles: tRC 66 ns, tRP and tRCD
+ * 20 ns, tWR 15 ns, tXSR 75 ns and tMRD 2 cycles. CAS latency 2 holds up
+ * to 100 MHz. A faster CLKper2 needs the delays worked out again, which
+ * \ref sdram_init() asserts.
+ *
+ * @{
+ */
+//! CLKper2 the delays are worked out for
+#define SDRAM_PROFILE_HZ            32000000UL
+#define SDRAM_ROW_BITS              12
+#define SDRAM_COL_BITS              10
+#define SDRAM_CAS_LATENCY           2
+//! tMRD
+#define SDRAM_MODE_DELAY            EBI_MRDLY_2CLK_gc
+//! tRC, also from a refresh to the next activate
+#define SDRAM_ROW_CYCLE_DELAY       EBI_ROWCYCDLY_3CLK_gc
+//! tRP
+#define SDRAM_PRECHARGE_DELAY       EBI_RPDLY_1CLK_gc
+//! tWR
+#define SDRAM_WRITE_RECOVERY_DELAY  EBI_WRDLY_1CLK_gc
+//! tXSR
+#define SDRAM_SELF_REFRESH_DELAY    EBI_ESRDLY_3CLK_gc
+//! tRCD
+#define SDRAM_ROW_TO_COL_DELAY      EBI_ROWCOLDLY_1CLK_gc
+//! CLKper2 cycles from one row refresh to the next, 64 ms / 4096
+#define SDRAM_REFRESH_PERIOD        (sysclk_get_per2_hz() / 64000)
+//! CLKper2 cycles from power to the first command, 200 us
+#define SDRAM_INIT_DELAY            (sysclk_get_per2_hz() / 5000)
+//! @}
+
+//! Put the SDRAM in self refresh while the scheduler sleeps; 0 never does
+#ifndef SDRAM_SELF_REFRESH
+#  define SDRAM_SELF_REFRESH        1
+#endif
+
+//! Bytes moved each way per method by \ref sdram_bench()
+#ifndef SDRAM_BENCH_SIZE
+#  define SDRAM_BENCH_SIZE          32768U
+#endif
+
+//! Bytes per move of \ref sdram_bench()
+#define SDRAM_BENCH_CHUNK           512
+//! Scratch of \ref sdram_bench(), the chunk and the pattern it checks
+#define SDRAM_BENCH_SCRATCH         (2 * SDRAM_BENCH_CHUNK)
+
+#if SDRAM_BENCH_SIZE % SDRAM_BENCH_CHUNK || SDRAM_BENCH_SIZE > 32768
+#  error "SDRAM_BENCH_SIZE must be chunks of SDRAM_BENCH_CHUNK, 32 KiB at most"
+#endif
+
+#if defined(SDRAM_DMA_CH) && SDRAM_DMA_CH > 3
+#  error "SDRAM_DMA_CH must be a DMA channel, 0 to 3"
+#endif
+
+void sdram_init(void);
+hugemem_ptr_t sdram_alloc(uint32_t size);
+uint32_t sdram_get_free(void);
+void sdram_read(void *to, hugemem_ptr_t from, uint16_t size);
+void sdram_write(hugemem_ptr_t to, const void *from, uint16_t size);
+void sdram_sleep(void);
+void sdram_wake(void);
+bool sdram_bench(dma_channel_num_t dma_ch);
+
+#endif /* SDRAM_H */
@@ -0,0 +1,122 @@
+/**
+ * \file
+ *
+ * \brief Check of the achieved sample rate on the running capture
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "capture.h"
+#include "sched.h"
+#include "selfcheck.h"
+#include "tables.h"
+
+//! \internal Longest measurement accepted, in RTC ticks
+#define SELFCHECK_TICKS_MAX     (2 * SELFCHECK_TICKS)
+
+#if SELFCHECK_TICKS_MAX * 1UL * SAMPLERATE / SELFCHECK_RTC_HZ \
+		>= 256UL * CAPTURE_HOP
+#  error "The hop count wraps within a measurement"
+#endif
+
+//! \internal Steps of the measurement, none until asked for
+enum selfcheck_step {
+	SELFCHECK_DONE,
+	SELFCHECK_START,
+	SELFCHECK_FINISH,
+};
+
+//! \internal Next step
+static enum selfcheck_step selfcheck_step;
+//! \internal RTC tick, hop count and ring position at the start
+static uint32_t selfcheck_tick;
+static uint8_t selfcheck_hops;
+static uint16_t selfcheck_pos;
+
+/**
+ * \internal
+ * \brief Wait for the next RTC tick and take the capture position there
+ *
+ * \return The tick
+ */
+static uint32_t selfcheck_take(uint8_t *hops, uint16_t *pos)
+{
+	uint32_t start = rtc_get_time();
+	irqflags_t flags;
+
+	while (rtc_get_time() == start);
+	// Both move in the same interrupt, the hops at the hop boundaries
+	flags = cpu_irq_save();
+	*hops = capture_hops;
+	*pos = capture_write_pos;
+	cpu_irq_restore(flags);
+	return start + 1;
+}
+
+/**
+ * \brief Ask for a check, from the next release of the task on
+ *
+ * Not from interrupts.
+ */
+void selfcheck_start(void)
+{
+	selfcheck_step = SELFCHECK_START;
+	sched_set_periodic(SCHED_SELFCHECK, true);
+}
+
+/**
+ * \brief Measure the sample rate and report it, scheduler task
+ *
+ * Released every SELFCHECK_TICKS from \ref selfcheck_start() on: the
+ * first release takes the start, the second the end and prints the
+ * result; then the task drops its period until the next check. A capture
+ * that is not running at either end, or a release so late that the hop
+ * count could have wrapped, starts the measurement over.
+ *
+ * \retval false always
+ */
+bool selfcheck_run(void)
+{
+	uint32_t frames;
+	uint32_t ticks;
+	uint32_t rate;
+	uint32_t error;
+	uint16_t pos;
+	uint8_t hops;
+	bool ok;
+
+	if (selfcheck_step == SELFCHECK_DONE) {
+		sched_set_periodic(SCHED_SELFCHECK, false);
+		return false;
+	}
+	if (capture_get_state() != CAPTURE_RUNNING) {
+		selfcheck_step = SELFCHECK_START;
+		return false;
+	}
+	if (selfcheck_step == SELFCHECK_START) {
+		selfcheck_tick = selfcheck_take(&selfcheck_hops, &selfcheck_pos);
+		selfcheck_step = SELFCHECK_FINISH;
+		return false;
+	}
+
+	ticks = selfcheck_take(&hops, &pos) - selfcheck_tick;
+	if (ticks > SELFCHECK_TICKS_MAX) {
+		selfcheck_step = SELFCHECK_START;
+		return false;
+	}
+	frames = (uint32_t)(uint8_t)(hops - selfcheck_hops) * CAPTURE_HOP
+			+ pos % CAPTURE_HOP - selfcheck_pos % CAPTURE_HOP;
+
+	rate = frames * SELFCHECK_RTC_HZ / ticks;
+	error = (rate > SAMPLERATE) ? rate - SAMPLERATE : SAMPLERATE - rate;
+	ok = error * 1000 <= (uint32_t)SAMPLERATE * SELFCHECK_TOLERANCE;
+
+	printf_P(PSTR("sample rate %lu Hz, expected %lu Hz: %S\r\n"),
+			(unsigned long)rate, (unsigned long)SAMPLERATE,
+			ok ? PSTR("ok") : PSTR("FAIL"));
+	tables_check();
+	selfcheck_step = SELFCHECK_DONE;
+	sched_set_periodic(SCHED_SELFCHECK, false);
+	return false;
+}
@@ -0,0 +1,40 @@
+/**
+ * \file
+ *
+ * \brief Check of the achieved sample rate on the running capture
+ *
+ * Counts the frames the capture stores over SELFCHECK_TICKS ticks of the
+ * RTC, from a scheduler task, so that the tuner listens from the start
+ * rather than after a measurement. \ref selfcheck_start() asks for a
+ * check: once after start-up, and on "selfcheck" from the \ref shell.h.
+ * The RTC runs from the 32 kHz RC oscillator, not from the system clock,
+ * so a wrong clock setup, a lost DFLL lock or a bad timer period shows up
+ * as a rate off SAMPLERATE. The result is printed on the
+ * USART_SERIAL port of conf_usart_serial.h, followed by the check of the
+ * flash tables of \ref tables.h.
+ *
+ */
+
+#ifndef SELFCHECK_H
+#define SELFCHECK_H
+
+#include <compiler.h>
+
+//! RTC ticks per second, see conf_rtc.h
+#define SELFCHECK_RTC_HZ        1024
+
+//! Length of the measurement in RTC ticks, a quarter second, and the
+//! release period of the task while it measures
+#ifndef SELFCHECK_TICKS
+#  define SELFCHECK_TICKS 256
+#endif
+
+//! Largest accepted rate error in 1/1000, the 32 kHz RC tolerance
+#ifndef SELFCHECK_TOLERANCE
+#  define SELFCHECK_TOLERANCE 10
+#endif
+
+void selfcheck_start(void);
+bool selfcheck_run(void);
+
+#endif /* SELFCHECK_H */
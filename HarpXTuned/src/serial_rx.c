@@ -0,0 +1,105 @@
+/**
+ * \file
+ *
+ * \brief Interrupt driven receive path of the stdio USART
+ *
+ */
+
+#include <asf.h>
+#include <conf_usart_serial.h>
+#include "irqlevel.h"
+#include "sched.h"
+#include "serial_rx.h"
+
+//! \internal Receive ring
+static uint8_t serial_rx_buf[SERIAL_RX_SIZE];
+static fifo_desc_t serial_rx_fifo;
+
+//! \internal Bytes that found the ring full
+static volatile uint16_t serial_rx_dropped;
+
+/**
+ * \internal
+ * \brief Queue the received byte, and post the shell at a line end
+ */
+ISR(USART_SERIAL_RXC_vect)
+{
+	uint8_t c = usart_get(USART_SERIAL);
+
+	if (fifo_push_uint8(&serial_rx_fifo, c) != FIFO_OK) {
+		serial_rx_dropped++;
+		return;
+	}
+	if (c == '\r' || c == '\n') {
+		sched_post(SCHED_SHELL);
+	}
+}
+
+/**
+ * \internal
+ * \brief stdio read hook, waits for a byte
+ */
+static void serial_rx_stdio_get(void volatile *usart, int *c)
+{
+	uint8_t byte;
+
+	(void)usart;
+
+	while (!serial_rx_get(&byte));
+	*c = byte;
+}
+
+/**
+ * \brief Route the stdio USART input through the ring
+ *
+ * Call after \ref serial_tx_init(), which sets up the USART.
+ */
+void serial_rx_init(void)
+{
+	fifo_init(&serial_rx_fifo, serial_rx_buf, SERIAL_RX_SIZE);
+	ptr_get = serial_rx_stdio_get;
+	usart_set_rx_interrupt_level(USART_SERIAL, IRQLEVEL_USART);
+}
+
+/**
+ * \brief Leave the received bytes to another reader
+ *
+ * Turns the receive interrupt off, so a DMA channel triggered by the
+ * receive complete flag gets every byte, until \ref serial_rx_resume().
+ */
+void serial_rx_suspend(void)
+{
+	usart_set_rx_interrupt_level(USART_SERIAL, USART_INT_LVL_OFF);
+}
+
+/**
+ * \brief Take the received bytes into the ring again
+ */
+void serial_rx_resume(void)
+{
+	usart_set_rx_interrupt_level(USART_SERIAL, IRQLEVEL_USART);
+}
+
+/**
+ * \brief Take the oldest received byte into \a c
+ *
+ * \retval true if there was one
+ * \retval false if the ring is empty
+ */
+bool serial_rx_get(uint8_t *c)
+{
+	return fifo_pull_uint8(&serial_rx_fifo, c) == FIFO_OK;
+}
+
+/**
+ * \brief Bytes dropped since start-up
+ */
+uint16_t serial_rx_get_dropped(void)
+{
+	uint16_t dropped;
+	irqflags_t flags = cpu_irq_save();
+
+	dropped = serial_rx_dropped;
+	cpu_irq_restore(flags);
+	return dropped;
+}
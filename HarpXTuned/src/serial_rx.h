@@ -0,0 +1,42 @@
+/**
+ * \file
+ *
+ * \brief Interrupt driven receive path of the stdio USART
+ *
+ * The receive complete interrupt moves every byte into a \ref fifo_group
+ * ring of SERIAL_RX_SIZE bytes, so input is neither lost between polls
+ * nor waited for: \ref serial_rx_get() returns at once, with or without a
+ * byte. A byte arriving with the ring full is dropped and counted. The
+ * interrupt posts \ref SCHED_SHELL at every line end, so the
+ * \ref shell.h task only runs when there is a line to read.
+ *
+ * stdio input reads the ring too, and still waits for a byte as it did on
+ * the bare USART.
+ *
+ * \ref serial_rx_suspend() hands the bytes to another reader, as the
+ * \ref tableload.h DMA, until \ref serial_rx_resume().
+ *
+ */
+
+#ifndef SERIAL_RX_H
+#define SERIAL_RX_H
+
+#include <compiler.h>
+#include <fifo.h>
+
+//! Ring size in bytes, a power of two up to 128
+#ifndef SERIAL_RX_SIZE
+#  define SERIAL_RX_SIZE    64
+#endif
+
+#if SERIAL_RX_SIZE > 128 || (SERIAL_RX_SIZE & (SERIAL_RX_SIZE - 1))
+#  error "SERIAL_RX_SIZE must be a power of two up to 128"
+#endif
+
+void serial_rx_init(void);
+void serial_rx_suspend(void);
+void serial_rx_resume(void);
+bool serial_rx_get(uint8_t *c);
+uint16_t serial_rx_get_dropped(void);
+
+#endif /* SERIAL_RX_H */
@@ -0,0 +1,175 @@
+/**
+ * \file
+ *
+ * \brief Interrupt driven transmit path of the stdio USART
+ *
+ */
+
+#include <asf.h>
+#include <conf_usart_serial.h>
+#include "irqlevel.h"
+#include "serial_tx.h"
+
+//! \internal Transmit ring
+static uint8_t serial_tx_buf[SERIAL_TX_SIZE];
+static fifo16_desc_t serial_tx_fifo;
+
+//! \internal Policy of the stdio writes
+static enum serial_tx_policy serial_tx_policy = SERIAL_TX_BLOCK;
+
+//! \internal Bytes discarded by the drop policy
+static uint16_t serial_tx_dropped;
+
+/**
+ * \internal
+ * \brief Move the next queued byte to the USART
+ *
+ * Turns the interrupt off when the ring runs empty; \ref serial_tx_put()
+ * turns it on again.
+ */
+ISR(USART_SERIAL_DRE_vect)
+{
+	uint8_t c;
+
+	if (fifo16_pull_uint8(&serial_tx_fifo, &c) != FIFO_OK) {
+		usart_set_dre_interrupt_level(USART_SERIAL, USART_INT_LVL_OFF);
+		return;
+	}
+	usart_put(USART_SERIAL, c);
+}
+
+/**
+ * \internal
+ * \brief Make sure the interrupt drains what has been queued
+ */
+static void serial_tx_kick(void)
+{
+	irqflags_t flags = cpu_irq_save();
+
+	usart_set_dre_interrupt_level(USART_SERIAL, IRQLEVEL_USART);
+	cpu_irq_restore(flags);
+}
+
+/**
+ * \internal
+ * \brief Send one queued byte from the caller, for when the interrupt
+ * cannot run
+ */
+static void serial_tx_drain_one(void)
+{
+	uint8_t c;
+
+	if (fifo16_pull_uint8(&serial_tx_fifo, &c) == FIFO_OK) {
+		while (!usart_data_register_is_empty(USART_SERIAL));
+		usart_put(USART_SERIAL, c);
+	}
+}
+
+/**
+ * \internal
+ * \brief stdio write hook, applies the current policy
+ */
+static int serial_tx_stdio_put(void volatile *usart, int c)
+{
+	(void)usart;
+
+	serial_tx_put(c, serial_tx_policy);
+	return 0;
+}
+
+/**
+ * \brief Set up the stdio USART and route stdio output through the ring
+ */
+void serial_tx_init(void)
+{
+	const usart_serial_options_t usart_options = {
+		.baudrate = USART_SERIAL_BAUDRATE,
+		.charlength = USART_SERIAL_CHAR_LENGTH,
+		.paritytype = USART_SERIAL_PARITY,
+		.stopbits = USART_SERIAL_STOP_BIT
+	};
+
+	fifo16_init(&serial_tx_fifo, serial_tx_buf, SERIAL_TX_SIZE);
+	stdio_serial_init(USART_SERIAL, &usart_options);
+	ptr_put = serial_tx_stdio_put;
+}
+
+/**
+ * \brief Queue \a c for transmission
+ *
+ * \retval true if the byte was queued or sent
+ * \retval false if it was dropped
+ */
+bool serial_tx_put(uint8_t c, enum serial_tx_policy policy)
+{
+	return serial_tx_write(&c, 1, policy);
+}
+
+/**
+ * \brief Queue the \a count bytes at \a buf for transmission
+ *
+ * The bytes are queued as one block, so with the drop policy either all
+ * of them go out or none.
+ *
+ * \retval true if the bytes were queued
+ * \retval false if they were dropped
+ */
+bool serial_tx_write(const void *buf, uint16_t count,
+		enum serial_tx_policy policy)
+{
+	Assert(count <= SERIAL_TX_SIZE);
+
+	while (fifo16_push_block(&serial_tx_fifo, buf, count) != FIFO_OK) {
+		if (policy == SERIAL_TX_DROP) {
+			serial_tx_dropped += count;
+			return false;
+		}
+		if (cpu_irq_is_enabled()) {
+			serial_tx_kick();
+		} else {
+			// The interrupt cannot drain the ring, do its work here
+			serial_tx_drain_one();
+		}
+	}
+	serial_tx_kick();
+	return true;
+}
+
+/**
+ * \brief Set the policy of the stdio writes
+ *
+ * \return The previous policy, for the caller to restore
+ */
+enum serial_tx_policy serial_tx_set_policy(enum serial_tx_policy policy)
+{
+	enum serial_tx_policy old = serial_tx_policy;
+
+	serial_tx_policy = policy;
+	return old;
+}
+
+/**
+ * \brief Bytes that can be queued without blocking or dropping
+ */
+uint16_t serial_tx_get_free(void)
+{
+	return fifo16_get_free_size(&serial_tx_fifo);
+}
+
+/**
+ * \brief Bytes dropped since start-up
+ */
+uint16_t serial_tx_get_dropped(void)
+{
+	return serial_tx_dropped;
+}
+
+/**
+ * \brief Wait until every queued byte has been handed to the USART
+ *
+ * Interrupts must be enabled.
+ */
+void serial_tx_flush(void)
+{
+	while (!fifo16_is_empty(&serial_tx_fifo));
+}
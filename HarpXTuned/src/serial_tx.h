@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * \brief Interrupt driven transmit path of the stdio USART
+ *
+ * stdio output is queued in a \ref fifo16_group ring of SERIAL_TX_SIZE bytes
+ * and drained by the USART data register empty interrupt, so a printf()
+ * returns in microseconds as long as the ring has room.
+ *
+ * What happens when it has none is up to the caller, see
+ * \ref serial_tx_policy: the default blocks until the interrupt has made
+ * room, the drop policy discards the byte. Output that must not be torn,
+ * such as a telemetry line, is formatted into a buffer first and queued
+ * with \ref serial_tx_write(), which drops all of it or none. With
+ * interrupts disabled the blocking policy writes to the USART directly. Do not write from an interrupt handler:
+ * the low level data register empty interrupt cannot drain the ring
+ * while it runs.
+ *
+ */
+
+#ifndef SERIAL_TX_H
+#define SERIAL_TX_H
+
+#include <compiler.h>
+#include <fifo.h>
+
+//! Ring size in bytes, a power of two up to FIFO16_SIZE_MAX
+#ifndef SERIAL_TX_SIZE
+#  define SERIAL_TX_SIZE    256
+#endif
+
+#if SERIAL_TX_SIZE > FIFO16_SIZE_MAX || (SERIAL_TX_SIZE & (SERIAL_TX_SIZE - 1))
+#  error "SERIAL_TX_SIZE must be a power of two up to FIFO16_SIZE_MAX"
+#endif
+
+//! What a write does when the ring is full
+enum serial_tx_policy {
+	//! Wait until the interrupt has made room
+	SERIAL_TX_BLOCK,
+	//! Discard the byte
+	SERIAL_TX_DROP,
+};
+
+void serial_tx_init(void);
+bool serial_tx_put(uint8_t c, enum serial_tx_policy policy);
+bool serial_tx_write(const void *buf, uint16_t count,
+		enum serial_tx_policy policy);
+enum serial_tx_policy serial_tx_set_policy(enum serial_tx_policy policy);
+uint16_t serial_tx_get_free(void);
+uint16_t serial_tx_get_dropped(void);
+void serial_tx_flush(void);
+
+#endif /* SERIAL_TX_H */
@@ -0,0 +1,634 @@
+/**
+ * \file
+ *
+ * \brief Command shell on the stdio USART
+ *
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <asf.h>
+#include "calib.h"
+#include "chain.h"
+#include "cv.h"
+#include "capture.h"
+#include "display.h"
+#include "harp.h"
+#include "gliss.h"
+#include "hostlink.h"
+#include "jitter.h"
+#include "listen.h"
+#include "loopback.h"
+#include "pedal.h"
+#include "pitch.h"
+#include "predict.h"
+#include "prof.h"
+#include "record.h"
+#include "residency.h"
+#include "sched.h"
+#include "serial_rx.h"
+#include "serial_tx.h"
+#include "sdram.h"
+#include "selfcheck.h"
+#include "shell.h"
+#include "sram.h"
+#include "stats.h"
+#include "sync.h"
+#include "tableload.h"
+#include "telemetry.h"
+#include "tone.h"
+
+//! \internal Line being received, and its length
+static char shell_line[SHELL_LINE_MAX];
+static uint8_t shell_len;
+//! \internal The line outgrew shell_line and is thrown away at its end
+static bool shell_overlong;
+
+/**
+ * \internal
+ * \brief Whether \a word is \a name, from program memory, in any case
+ */
+static bool shell_is(const char *word, const char *name)
+{
+	return !strcasecmp_P(word, name);
+}
+
+/**
+ * \internal
+ * \brief Parse decimal \a s into \a value
+ *
+ * \retval false if \a s is not a number up to UINT16_MAX
+ */
+static bool shell_parse_uint(const char *s, uint16_t *value)
+{
+	uint32_t v = 0;
+
+	if (!*s) {
+		return false;
+	}
+	for (; *s; s++) {
+		if (*s < '0' || *s > '9') {
+			return false;
+		}
+		v = v * 10 + (*s - '0');
+		if (v > UINT16_MAX) {
+			return false;
+		}
+	}
+	*value = v;
+	return true;
+}
+
+/**
+ * \internal
+ * \brief Parse a frequency such as "442" or "441.5" into \a freq
+ *
+ * Digits past the fourth decimal are ignored.
+ *
+ * \retval false if \a s is not a frequency below 65536 Hz
+ */
+static bool shell_parse_hz(const char *s, pitch_hz_t *freq)
+{
+	uint32_t whole = 0;
+	uint32_t frac = 0;
+	uint32_t scale = 1;
+	bool digits = false;
+
+	for (; *s >= '0' && *s <= '9'; s++) {
+		whole = whole * 10 + (*s - '0');
+		if (whole > UINT16_MAX) {
+			return false;
+		}
+		digits = true;
+	}
+	if (*s == '.') {
+		for (s++; *s >= '0' && *s <= '9'; s++) {
+			if (scale < 10000) {
+				frac = frac * 10 + (*s - '0');
+				scale *= 10;
+			}
+			digits = true;
+		}
+	}
+	if (*s || !digits) {
+		return false;
+	}
+	*freq = PITCH_HZ(whole) + (frac << 16) / scale;
+	return true;
+}
+
+/**
+ * \internal
+ * \brief Split the line into at most SHELL_ARGS_MAX words at \a argv
+ *
+ * \return the number of words, or SHELL_ARGS_MAX + 1 if there are more
+ */
+static uint8_t shell_split(char *line, char **argv)
+{
+	uint8_t argc = 0;
+
+	while (1) {
+		while (*line == ' ' || *line == '\t') {
+			*line++ = '\0';
+		}
+		if (!*line) {
+			return argc;
+		}
+		if (argc == SHELL_ARGS_MAX) {
+			return SHELL_ARGS_MAX + 1;
+		}
+		argv[argc++] = line;
+		while (*line && *line != ' ' && *line != '\t') {
+			line++;
+		}
+	}
+}
+
+/**
+ * \internal
+ * \brief "set a4 <hz>"
+ */
+static bool shell_set(uint8_t argc, char **argv)
+{
+	pitch_hz_t a4;
+	uint8_t ch;
+
+	if (argc != 3 || !shell_is(argv[1], PSTR("a4"))
+			|| !shell_parse_hz(argv[2], &a4) || !harp_set_a4(a4)) {
+		return false;
+	}
+	calib_write(CALIB_KEY_A4, &a4, sizeof(a4));
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_retune(ch);
+	}
+	printf_P(PSTR("a4 %lu.%02u Hz\r\n"), (unsigned long)(a4 >> 16),
+			(unsigned int)(((a4 & 0xffff) * 100) >> 16));
+	return true;
+}
+
+/**
+ * \internal
+ * \brief "profile dump" and "profile reset"
+ */
+static bool shell_profile(uint8_t argc, char **argv)
+{
+	if (argc != 2) {
+		return false;
+	}
+	if (shell_is(argv[1], PSTR("dump"))) {
+		prof_dump();
+		jitter_dump();
+		residency_dump();
+		sched_dump();
+		display_latency_dump();
+		telemetry_dump();
+		printf_P(PSTR("serial %u bytes dropped out, %u in\r\n"),
+				serial_tx_get_dropped(), serial_rx_get_dropped());
+	} else if (shell_is(argv[1], PSTR("reset"))) {
+		prof_reset();
+		jitter_reset();
+		residency_reset();
+		sched_reset();
+		display_latency_reset();
+		telemetry_reset();
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \internal
+ * \brief "record start", "record stop" and "record dump"
+ */
+static bool shell_record(uint8_t argc, char **argv)
+{
+	if (argc != 2) {
+		return false;
+	}
+	if (shell_is(argv[1], PSTR("start"))) {
+		if (record_get_state() != RECORD_RUNNING) {
+			record_start();
+		}
+	} else if (shell_is(argv[1], PSTR("stop"))) {
+		if (record_get_state() == RECORD_RUNNING) {
+			record_stop();
+		}
+	} else if (shell_is(argv[1], PSTR("dump"))) {
+		record_dump();
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * \internal
+ * \brief "stream raw <ch>" and "stream off"
+ */
+static bool shell_stream(uint8_t argc, char **argv)
+{
+	uint16_t ch;
+
+	if (argc == 2 && shell_is(argv[1], PSTR("off"))) {
+		hostlink_set_samples(CHANNELS);
+		return true;
+	}
+	if (argc != 3 || !shell_is(argv[1], PSTR("raw"))
+			|| !shell_parse_uint(argv[2], &ch) || ch >= CHANNELS) {
+		return false;
+	}
+	hostlink_set_samples(ch);
+	return true;
+}
+
+/**
+ * \internal
+ * \brief "tone", "tone <string>" and "tone off"
+ *
+ * With no string, the one nearest the strongest reading, if any.
+ */
+static bool shell_tone(uint8_t argc, char **argv)
+{
+	uint16_t string = HARP_STRINGS;
+	uint16_t level = 0;
+	pitch_hz_t freq;
+	uint8_t ch;
+
+	if (argc == 2 && shell_is(argv[1], PSTR("off"))) {
+		tone_stop();
+		return true;
+	}
+	if (argc == 2) {
+		if (!shell_parse_uint(argv[1], &string)
+				|| string >= HARP_STRINGS) {
+			return false;
+		}
+	} else if (argc == 1) {
+		for (ch = 0; ch < CHANNELS; ch++) {
+			freq = pitch_readings[ch].freq;
+			if (freq && pitch_readings[ch].level > level) {
+				level = pitch_readings[ch].level;
+				string = harp_nearest_string(ch, freq);
+			}
+		}
+		if (string == HARP_STRINGS) {
+			printf_P(PSTR("no reading\r\n"));
+			return true;
+		}
+	} else {
+		return false;
+	}
+	freq = harp_string_freq(string);
+	tone_start(freq);
+	printf_P(PSTR("tone string %u %lu Hz\r\n"), string,
+			(unsigned long)(freq >> 16));
+	return true;
+}
+
+/**
+ * \internal
+ * \brief "pedal <C..B> <b|n|#>"
+ */
+static bool shell_pedal(uint8_t argc, char **argv)
+{
+	enum harp_pedal pedal;
+	char letter;
+
+	if (argc != 3 || argv[1][1] || argv[2][1]) {
+		return false;
+	}
+	letter = toupper(argv[1][0]);
+	if (letter < 'A' || letter > 'G') {
+		return false;
+	}
+	switch (argv[2][0]) {
+	case 'b':
+		pedal = HARP_FLAT;
+		break;
+	case 'n':
+		pedal = HARP_NATURAL;
+		break;
+	case '#':
+		pedal = HARP_SHARP;
+		break;
+	default:
+		return false;
+	}
+	// Pitch class from C
+	pedal_set((letter - 'A' + 5) % 7, pedal);
+	return true;
+}
+
+/**
+ * \internal
+ * \brief Whether word \a argv[1] is "on" or "off", into \a on
+ */
+static bool shell_on_off(uint8_t argc, char **argv, bool *on)
+{
+	if (argc != 2) {
+		return false;
+	}
+	*on = shell_is(argv[1], PSTR("on"));
+	return *on || shell_is(argv[1], PSTR("off"));
+}
+
+/**
+ * \internal
+ * \brief "chromatic on" and "chromatic off", on every channel whose
+ * engine has the mode
+ */
+static bool shell_chromatic(uint8_t argc, char **argv)
+{
+	uint8_t count = 0;
+	uint8_t ch;
+	bool on;
+
+	if (!shell_on_off(argc, argv, &on)) {
+		return false;
+	}
+	for (ch = 0; ch < CHANNELS; ch++) {
+		count += pitch_set_chromatic(ch, on);
+	}
+	if (on) {
+		printf_P(PSTR("chromatic %u of %u channels\r\n"), count, CHANNELS);
+	}
+	return true;
+}
+
+/**
+ * \internal
+ * \brief "tables dump", "tables load <name>" and "tables clear <name>"
+ */
+static bool shell_tables(uint8_t argc, char **argv)
+{
+	enum tableload_table table;
+
+	if (argc == 2 && shell_is(argv[1], PSTR("dump"))) {
+		tableload_dump();
+		return true;
+	}
+	if (argc != 3) {
+		return false;
+	}
+	if (shell_is(argv[2], PSTR("temperaments"))) {
+		table = TABLELOAD_TEMPERAMENTS;
+	} else if (shell_is(argv[2], PSTR("strings"))) {
+		table = TABLELOAD_STRINGS;
+	} else {
+		return false;
+	}
+	if (shell_is(argv[1], PSTR("load"))) {
+		return tableload_start(table);
+	} else if (shell_is(argv[1], PSTR("clear"))) {
+		return tableload_clear(table);
+	}
+	return false;
+}
+
+/**
+ * \internal
+ * \brief "sdram bench", with the capture stopped for its DMA channels
+ */
+static bool shell_sdram(uint8_t argc, char **argv)
+{
+	enum capture_state state;
+	bool done;
+
+	if (argc != 2 || !shell_is(argv[1], PSTR("bench"))
+			|| hostlink_is_active()
+			|| record_get_state() == RECORD_RUNNING) {
+		return false;
+	}
+	state = listen_suspend();
+	done = sdram_bench(CAPTURE_DMA_CH_A);
+	listen_restore(state);
+	return done;
+}
+
+/**
+ * \internal
+ * \brief Run the command of the \a argc words at \a argv
+ *
+ * \retval false if there is no such command or its words are wrong
+ */
+static bool shell_dispatch(uint8_t argc, char **argv)
+{
+	const char *cmd = argv[0];
+	bool on;
+
+	if (shell_is(cmd, PSTR("help"))) {
+		printf_P(PSTR("set a4 <hz> | profile dump|reset | readings on|off"
+				" | record start|stop|dump | calib dump | sram dump"
+				" | sdram bench"
+				" | chain dump"
+				" | link on|off"
+				" | stream raw <ch>|off | snapshot | tone [<string>|off]"
+				" | loopback [off] | chromatic on|off"
+				" | gliss on|off|dump | stats dump|reset"
+				" | predict dump|reset | cv cents|level|off"
+				" | selfcheck"
+				" | pedal <C..B> <b|n|#>"
+				" | tables dump|load|clear [temperaments|strings]\r\n"));
+		return true;
+	}
+	if (shell_is(cmd, PSTR("set"))) {
+		return shell_set(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("profile"))) {
+		return shell_profile(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("readings"))) {
+		if (!shell_on_off(argc, argv, &on)) {
+			return false;
+		}
+		telemetry_set_enabled(on);
+		return true;
+	}
+	if (shell_is(cmd, PSTR("record"))) {
+		return shell_record(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("chain"))) {
+		if (argc != 2 || !shell_is(argv[1], PSTR("dump"))) {
+			return false;
+		}
+		chain_dump();
+		sync_dump();
+		return true;
+	}
+	if (shell_is(cmd, PSTR("calib"))) {
+		if (argc != 2 || !shell_is(argv[1], PSTR("dump"))) {
+			return false;
+		}
+		calib_dump();
+		return true;
+	}
+	if (shell_is(cmd, PSTR("sram"))) {
+		if (argc != 2 || !shell_is(argv[1], PSTR("dump"))) {
+			return false;
+		}
+		sram_dump();
+		return true;
+	}
+	if (shell_is(cmd, PSTR("sdram"))) {
+		return shell_sdram(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("link"))) {
+		if (!shell_on_off(argc, argv, &on)) {
+			return false;
+		}
+		if (on && !hostlink_is_active()) {
+			hostlink_start();
+		} else if (!on && hostlink_is_active()) {
+			hostlink_stop();
+		}
+		return true;
+	}
+	if (shell_is(cmd, PSTR("stream"))) {
+		return shell_stream(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("snapshot"))) {
+		if (argc != 1) {
+			return false;
+		}
+		hostlink_snapshot();
+		return true;
+	}
+	if (shell_is(cmd, PSTR("tone"))) {
+		return shell_tone(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("loopback"))) {
+		if (argc == 2 && shell_is(argv[1], PSTR("off"))) {
+			loopback_stop();
+			return true;
+		}
+		return argc == 1 && loopback_start();
+	}
+	if (shell_is(cmd, PSTR("chromatic"))) {
+		return shell_chromatic(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("gliss"))) {
+		if (argc == 2 && shell_is(argv[1], PSTR("dump"))) {
+			gliss_dump();
+			return true;
+		}
+		if (!shell_on_off(argc, argv, &on)) {
+			return false;
+		}
+		if (!on) {
+			gliss_stop();
+			return true;
+		}
+		return gliss_start();
+	}
+	if (shell_is(cmd, PSTR("stats"))) {
+		if (argc != 2) {
+			return false;
+		}
+		if (shell_is(argv[1], PSTR("dump"))) {
+			stats_dump();
+		} else if (shell_is(argv[1], PSTR("reset"))) {
+			stats_reset();
+		} else {
+			return false;
+		}
+		return true;
+	}
+	if (shell_is(cmd, PSTR("predict"))) {
+		if (argc != 2) {
+			return false;
+		}
+		if (shell_is(argv[1], PSTR("dump"))) {
+			predict_dump();
+		} else if (shell_is(argv[1], PSTR("reset"))) {
+			predict_reset();
+		} else {
+			return false;
+		}
+		return true;
+	}
+	if (shell_is(cmd, PSTR("cv"))) {
+		if (argc != 2) {
+			return false;
+		}
+		if (shell_is(argv[1], PSTR("cents"))) {
+			cv_set_mode(CV_CENTS);
+		} else if (shell_is(argv[1], PSTR("level"))) {
+			cv_set_mode(CV_LEVEL);
+		} else if (shell_is(argv[1], PSTR("off"))) {
+			cv_set_mode(CV_OFF);
+		} else {
+			return false;
+		}
+		return true;
+	}
+	if (shell_is(cmd, PSTR("selfcheck"))) {
+		if (argc != 1) {
+			return false;
+		}
+		selfcheck_start();
+		return true;
+	}
+	if (shell_is(cmd, PSTR("pedal"))) {
+		return shell_pedal(argc, argv);
+	}
+	if (shell_is(cmd, PSTR("tables"))) {
+		return shell_tables(argc, argv);
+	}
+	return false;
+}
+
+/**
+ * \internal
+ * \brief Run the command of the line received
+ */
+static void shell_execute(void)
+{
+	char *argv[SHELL_ARGS_MAX];
+	uint8_t argc = shell_split(shell_line, argv);
+
+	if (!argc) {
+		return;
+	}
+	if (argc > SHELL_ARGS_MAX || !shell_dispatch(argc, argv)) {
+		printf_P(PSTR("bad command, try help\r\n"));
+	}
+}
+
+/**
+ * \brief Take the received bytes and run a command, scheduler task
+ *
+ * Backspace and delete take back the last byte of the line.
+ *
+ * \retval true after a line, to look for the next in another slice
+ * \retval false once the ring is empty
+ */
+bool shell_run(void)
+{
+	uint8_t c;
+
+	while (serial_rx_get(&c)) {
+		if (c == '\r' || c == '\n') {
+			if (shell_overlong) {
+				printf_P(PSTR("line too long\r\n"));
+			} else {
+				shell_line[shell_len] = '\0';
+				shell_execute();
+			}
+			shell_len = 0;
+			shell_overlong = false;
+			return true;
+		}
+		if (c == '\b' || c == 0x7f) {
+			if (shell_len) {
+				shell_len--;
+			}
+		} else if (shell_len < SHELL_LINE_MAX - 1) {
+			shell_line[shell_len++] = c;
+		} else {
+			shell_overlong = true;
+		}
+	}
+	return false;
+}
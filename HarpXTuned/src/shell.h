@@ -0,0 +1,74 @@
+/**
+ * \file
+ *
+ * \brief Command shell on the stdio USART
+ *
+ * Lines come from the \ref serial_rx.h ring, end in CR or LF and are split
+ * into words at spaces; case does not matter. The shell task is posted
+ * at each line end and runs one line per slice at the lowest priority,
+ * so a command never holds up the capture or the analysis and the rest
+ * of the tuner never waits for the host. The commands are
+ * - "help" lists them
+ * - "set a4 <hz>" moves and stores the A4 reference, "442" or "441.5"
+ * - "profile dump" prints the \ref prof.h probes, the \ref jitter.h
+ *   capture entries, the \ref residency.h shares, the \ref sched.h
+ *   deadlines, the \ref display.h latency and the lines and input bytes
+ *   dropped; "profile reset" clears them
+ * - "readings on" and "readings off" resume or stop the text readings
+ * - "record start", "record stop" and "record dump" run a \ref record.h
+ *   recording and print the last one
+ * - "calib dump" prints the \ref calib.h store
+ * - "sram dump" prints the \ref sram.h use and stack high-water
+ * - "sdram bench" stops the capture for a moment and prints the
+ *   \ref sdram.h write and read rates, and the words that did not read
+ *   back
+ * - "chain dump" prints the strings gathered on the \ref chain.h bus and
+ *   the \ref sync.h lock
+ * - "link on" and "link off" switch to or from the \ref hostlink.h
+ *   binary frames
+ * - "stream raw <ch>" streams the samples of channel \a ch on the link,
+ *   "stream off" stops them
+ * - "snapshot" sends the whole capture ring on the link
+ * - "tone" plays the \ref tone.h reference of the string nearest the
+ *   strongest reading, "tone <string>" that of a string, "tone off"
+ *   stops it
+ * - "loopback" times tone bursts through a speaker to pickup loopback
+ *   with \ref loopback.h, "loopback off" stops it
+ * - "chromatic on" tunes any instrument, the \ref pitch.h chromatic mode
+ *   on every channel that has it, "chromatic off" goes back to the harp
+ * - "gliss on" queues the onsets of a strum or glissando and reports the
+ *   strings out of tune after it with \ref gliss.h, "gliss dump" prints
+ *   the last report again, "gliss off" goes back to the live analysis
+ * - "stats dump" prints the \ref stats.h cents histogram of every string
+ *   played, "stats reset" clears them
+ * - "predict dump" prints the strings tuned and the one \ref predict.h
+ *   expects next, "predict reset" forgets them
+ * - "cv cents" and "cv level" drive the \ref cv.h analog output with the
+ *   error or the level of the current string, "cv off" stops it
+ * - "selfcheck" measures the \ref selfcheck.h sample rate again and
+ *   checks the flash tables
+ * - "pedal <C..B> <b|n|#>" sets a \ref pedal.h pedal flat, natural or
+ *   sharp
+ * - "tables load <name>" takes a new "temperaments" or "strings" table
+ *   with \ref tableload.h, "tables clear <name>" goes back to the
+ *   generated one, "tables dump" prints which are loaded
+ *
+ * A line the shell cannot take gets a one line error. There is no echo;
+ * use the local echo of the terminal.
+ *
+ */
+
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <compiler.h>
+
+//! Longest command line, with its terminating nul
+#define SHELL_LINE_MAX      48
+
+//! Most words on a line
+#define SHELL_ARGS_MAX      4
+
+bool shell_run(void);
+
+#endif /* SHELL_H */
@@ -0,0 +1,82 @@
+/**
+ * \file
+ *
+ * \brief Internal SRAM use: sections, stack high-water, interrupt nesting
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "scratch.h"
+#include "sram.h"
+
+//! \internal Section bounds from the linker script
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t _end;
+
+uint16_t sram_sp_min = RAMEND;
+uint8_t sram_nesting;
+
+void sram_paint(void) __attribute__((naked, used, section(".init3")));
+
+/**
+ * \brief Paint the free SRAM, from the start-up code
+ *
+ * Runs in .init3, after the stack pointer and the zero register are set
+ * and before .data and .bss, so only registers may be used.
+ */
+void sram_paint(void)
+{
+	uint8_t *p = &_end;
+
+	while (p <= (uint8_t *)SP) {
+		*p++ = SRAM_PAINT;
+	}
+}
+
+/**
+ * \brief Deepest stack use since reset, in bytes
+ */
+uint16_t sram_get_stack_peak(void)
+{
+	const uint8_t *p = &_end;
+
+	while (p <= (const uint8_t *)RAMEND && *p == SRAM_PAINT) {
+		p++;
+	}
+	return RAMEND + 1 - (uint16_t)p;
+}
+
+/**
+ * \brief Print the SRAM use on the stdio USART
+ */
+void sram_dump(void)
+{
+	irqflags_t flags;
+	uint16_t sp_min;
+	uint16_t scratch = 0;
+	uint8_t nesting;
+	uint8_t id;
+
+	flags = cpu_irq_save();
+	sp_min = sram_sp_min;
+	nesting = sram_nesting;
+	cpu_irq_restore(flags);
+
+	printf_P(PSTR("sram .data %u .bss %u bytes, stack %u of %u bytes"
+			" at most\r\n"),
+			(uint16_t)(&__data_end - &__data_start),
+			(uint16_t)(&__bss_end - &__bss_start),
+			sram_get_stack_peak(), RAMEND + 1 - (uint16_t)&_end);
+	printf_P(PSTR("sram capture interrupt stack %u bytes deep,"
+			" %u levels nested\r\n"),
+			RAMEND - sp_min, nesting);
+	for (id = 0; id < SCHED_TASKS; id++) {
+		scratch = Max(scratch, scratch_get_peak((enum sched_task_id)id));
+	}
+	printf_P(PSTR("sram scratch arena %u of %u bytes at most\r\n"),
+			scratch, scratch_get_size());
+}
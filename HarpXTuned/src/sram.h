@@ -0,0 +1,60 @@
+/**
+ * \file
+ *
+ * \brief Internal SRAM use: sections, stack high-water, interrupt nesting
+ *
+ * The 8 KB of internal SRAM hold .data, .bss and the stack, which grows
+ * down from RAMEND towards the end of .bss; nothing uses the heap. Before
+ * .data and .bss are set up, the start-up code runs \ref sram_paint(),
+ * which fills everything between the end of .bss and the stack with
+ * SRAM_PAINT. \ref sram_dump() scans up from the end of .bss for the first
+ * byte that lost the pattern, which gives the deepest the stack has been
+ * since reset, interrupts included.
+ *
+ * The capture interrupt, at the high level, also calls \ref sram_note()
+ * once per block. That records the deepest stack pointer it saw, and how
+ * many PMIC levels were then executing at once, from PMIC.STATUS. The
+ * \ref shell.h command "sram dump" prints these figures with the section
+ * sizes and the \ref scratch.h arena, to size MAXBUFFER, the windows and
+ * the arena for each profile with their margin known.
+ *
+ */
+
+#ifndef SRAM_H
+#define SRAM_H
+
+#include <compiler.h>
+
+//! Fill byte of the unused stack
+#define SRAM_PAINT              0xc5
+
+//! \internal Deepest stack pointer and interrupt nesting seen
+extern uint16_t sram_sp_min;
+extern uint8_t sram_nesting;
+
+/**
+ * \brief Note the stack pointer and the interrupt levels executing
+ *
+ * For the high level interrupt, which sees the deepest nesting.
+ */
+static inline void sram_note(void)
+{
+	uint8_t status = PMIC.STATUS;
+	uint8_t levels = (status & PMIC_LOLVLEX_bm ? 1 : 0)
+			+ (status & PMIC_MEDLVLEX_bm ? 1 : 0)
+			+ (status & PMIC_HILVLEX_bm ? 1 : 0)
+			+ (status & PMIC_NMIEX_bm ? 1 : 0);
+	uint16_t sp = SP;
+
+	if (sp < sram_sp_min) {
+		sram_sp_min = sp;
+	}
+	if (levels > sram_nesting) {
+		sram_nesting = levels;
+	}
+}
+
+uint16_t sram_get_stack_peak(void);
+void sram_dump(void);
+
+#endif /* SRAM_H */
@@ -0,0 +1,157 @@
+/**
+ * \file
+ *
+ * \brief Per-string tuning statistics over a session
+ *
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <asf.h>
+#include "harp.h"
+#include "notes.h"
+#include "pitch.h"
+#include "sdram.h"
+#include "stats.h"
+
+//! \internal Statistics of one string
+struct stats_string {
+	//! Readings in the bins
+	uint16_t count;
+	//! Sum of their errors, Q8.8 cents
+	int32_t sum;
+	uint16_t bins[STATS_BINS];
+};
+
+//! \internal Record of each string in SDRAM, HUGEMEM_NULL without room
+static hugemem_ptr_t stats_strings = HUGEMEM_NULL;
+
+//! \internal SDRAM address of the record of \a string
+#define STATS_RECORD(string) \
+	(stats_strings + (uint16_t)(string) * sizeof(struct stats_string))
+//! \internal SDRAM address of field \a field of the record of \a string
+#define STATS_FIELD(string, field) \
+	(STATS_RECORD(string) + offsetof(struct stats_string, field))
+
+/**
+ * \brief Reserve the records and clear them
+ *
+ * Call after \ref sdram_init(). Without room, no statistics are kept.
+ */
+void stats_init(void)
+{
+	stats_strings = sdram_alloc((uint32_t)HARP_STRINGS
+			* sizeof(struct stats_string));
+	stats_reset();
+}
+
+/**
+ * \brief Clear the statistics of every string
+ */
+void stats_reset(void)
+{
+	struct stats_string record = { 0 };
+	uint8_t string;
+
+	if (stats_strings == HUGEMEM_NULL) {
+		return;
+	}
+	for (string = 0; string < HARP_STRINGS; string++) {
+		sdram_write(STATS_RECORD(string), &record, sizeof(record));
+	}
+}
+
+/**
+ * \internal
+ * \brief Halve the bins, count and sum of the record of \a string
+ */
+static void stats_halve(uint8_t string)
+{
+	struct stats_string record;
+	uint8_t i;
+
+	sdram_read(&record, STATS_RECORD(string), sizeof(record));
+	record.count = 0;
+	for (i = 0; i < STATS_BINS; i++) {
+		record.bins[i] >>= 1;
+		record.count += record.bins[i];
+	}
+	record.sum /= 2;
+	sdram_write(STATS_RECORD(string), &record, sizeof(record));
+}
+
+/**
+ * \brief Take the new reading of channel \a ch, from \ref pitch_filter()
+ */
+void stats_reading(uint8_t ch)
+{
+	pitch_hz_t freq = pitch_readings[ch].freq;
+	notes_offset_t error;
+	hugemem_ptr_t at;
+	uint16_t count;
+	uint8_t string;
+	uint8_t bin;
+	int32_t from;
+
+	if (!freq || stats_strings == HUGEMEM_NULL || pitch_is_chromatic(ch)) {
+		return;
+	}
+	string = harp_nearest_string(ch, freq);
+	error = notes_offset(notes_from_hz(freq), harp_string_pitch(string));
+
+	from = (int32_t)error + NOTES_OFFSET(-STATS_LOW_CENTS);
+	if (from < 0) {
+		bin = 0;
+	} else {
+		bin = Min((uint32_t)from / NOTES_OFFSET(STATS_BIN_CENTS),
+				STATS_BINS - 1);
+	}
+
+	count = hugemem_read16(STATS_FIELD(string, count));
+	if (count == UINT16_MAX) {
+		stats_halve(string);
+		count = hugemem_read16(STATS_FIELD(string, count));
+	}
+	hugemem_write16(STATS_FIELD(string, count), count + 1);
+	hugemem_write32(STATS_FIELD(string, sum),
+			(int32_t)hugemem_read32(STATS_FIELD(string, sum)) + error);
+	at = STATS_FIELD(string, bins) + bin * sizeof(uint16_t);
+	hugemem_write16(at, hugemem_read16(at) + 1);
+}
+
+/**
+ * \brief Print the statistics of every string with readings on the stdio
+ * USART
+ */
+void stats_dump(void)
+{
+	struct stats_string record;
+	char name[NOTES_NAME_MAX + 1];
+	uint8_t string;
+	int32_t mean;
+	uint16_t tenths;
+	uint8_t i;
+
+	if (stats_strings == HUGEMEM_NULL) {
+		printf_P(PSTR("stats no room\r\n"));
+		return;
+	}
+	printf_P(PSTR("stats bins of %u cents from %d\r\n"), STATS_BIN_CENTS,
+			STATS_LOW_CENTS);
+	for (string = 0; string < HARP_STRINGS; string++) {
+		sdram_read(&record, STATS_RECORD(string), sizeof(record));
+		if (!record.count) {
+			continue;
+		}
+		mean = record.sum / record.count;
+		tenths = ((uint32_t)Abs(mean) * 10 + 128) >> 8;
+		notes_name(harp_string_note(string), name);
+		printf_P(PSTR("  %u %s n %u mean %c%u.%u:"), string, name,
+				record.count, (mean < 0) ? '-' : '+',
+				tenths / 10, tenths % 10);
+		for (i = 0; i < STATS_BINS; i++) {
+			printf_P(PSTR(" %u"), record.bins[i]);
+		}
+		printf_P(PSTR("\r\n"));
+	}
+}
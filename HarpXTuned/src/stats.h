@@ -0,0 +1,56 @@
+/**
+ * \file
+ *
+ * \brief Per-string tuning statistics over a session
+ *
+ * Every reading that \ref pitch_filter() hands on, outside chromatic
+ * mode, goes into a histogram of the cents off its nearest string:
+ * STATS_BINS bins of STATS_BIN_CENTS, centred on the string, the first
+ * and last taking everything beyond. The count and the sum of the errors
+ * give the mean. A reading costs three reads and writes of the
+ * \ref sdram.h arena, whatever the number of bins; the whole harp takes
+ * HARP_STRINGS records there.
+ *
+ * When the readings of a string reach UINT16_MAX, its bins, count and sum
+ * are halved together, so the oldest readings fade out on a long session
+ * instead of wrapping.
+ *
+ * "stats dump" on the \ref shell.h prints the strings that have readings
+ * in one go, one line each, much less than the readings themselves would
+ * have taken on the USART:
+ * \code
+	stats bins of 2 cents from -16
+	  18 C4 n 5123 mean +0.4: 0 0 0 2 15 210 1830 2410 590 61 5 0 0 0 0 0
+\endcode
+ * "stats reset" clears them for the next session.
+ *
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <compiler.h>
+
+//! Bins of each histogram
+#ifndef STATS_BINS
+#  define STATS_BINS            16
+#endif
+
+//! Cents per bin
+#ifndef STATS_BIN_CENTS
+#  define STATS_BIN_CENTS       2
+#endif
+
+//! Cents of the lower edge of the first bin
+#define STATS_LOW_CENTS         (-(STATS_BINS / 2) * STATS_BIN_CENTS)
+
+#if STATS_BINS < 2 || STATS_BINS % 2 || STATS_BINS * STATS_BIN_CENTS > 200
+#  error "STATS_BINS must be even and span at most a whole tone"
+#endif
+
+void stats_init(void);
+void stats_reading(uint8_t ch);
+void stats_dump(void);
+void stats_reset(void);
+
+#endif /* STATS_H */
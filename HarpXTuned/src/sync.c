@@ -0,0 +1,173 @@
+/**
+ * \file
+ *
+ * \brief Sample clocks of the chained boards locked to the master
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "capture.h"
+#include "evsys.h"
+#include "irqlevel.h"
+#include "sync.h"
+#include "tc32.h"
+
+//! \internal One hop in microseconds, the span of the phase error
+#define SYNC_HOP_US \
+	(CAPTURE_HOP * TIMEBASE_HZ / SAMPLERATE)
+
+#if CAPTURE_HOP * TIMEBASE_HZ % SAMPLERATE
+#  error "A hop must be a whole number of microseconds"
+#endif
+
+//! \internal Largest rate trim, one TCC1 clock per sweep
+#define SYNC_TRIM_MAX           0x10000L
+
+/**
+ * \internal
+ * \brief Rate trim taking back one microsecond of phase in one hop
+ *
+ * One microsecond is PROFILE_PER_HZ / TIMEBASE_HZ clocks, spread over the
+ * CAPTURE_HOP * PROFILE_ADC_SWEEPS sweeps of a hop.
+ */
+#define SYNC_GAIN \
+	(((PROFILE_PER_HZ / TIMEBASE_HZ) << 16) \
+	/ (CAPTURE_HOP * 1UL * PROFILE_ADC_SWEEPS))
+
+//! \internal Loop gains: a quarter of the error each hop, and its integral
+#define SYNC_KP                 ((int32_t)(SYNC_GAIN / 4))
+#define SYNC_KI                 ((int32_t)(SYNC_GAIN / 32))
+
+#if SYNC_GAIN / 32 < 1
+#  error "Hop too long for the sync loop gains"
+#endif
+
+#if SYNC_EVENT_CH == TIMEBASE_EVENT_CH
+#  error "The sync edges need their own event channel"
+#endif
+
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_SLAVE
+
+volatile uint32_t sync_hop_time;
+int32_t sync_rate;
+int32_t sync_dither;
+
+//! \internal Time of the newest master edge, and edges caught
+static volatile uint32_t sync_edge_time;
+static volatile uint8_t sync_edges;
+//! \internal Edge count at the last sync slice
+static uint8_t sync_edges_seen;
+//! \internal Hops since the last edge
+static uint8_t sync_quiet = SYNC_LOST;
+//! \internal Integral of the loop, 2^-16 clocks per sweep
+static int32_t sync_freq;
+//! \internal Last phase error in microseconds, positive when behind
+static int16_t sync_error;
+
+//! \internal Master edge, captured by both timers of the timebase
+static inline void sync_edge(void)
+{
+	sync_edge_time = tc32_read_cc(&TIMEBASE_TC, &TIMEBASE_TC_HIGH);
+	sync_edges++;
+}
+
+TC_BIND_DIRECT(TCF0, CCA, sync_edge)
+
+//! \internal Clamp \a v to the trim range
+static int32_t sync_clamp(int32_t v)
+{
+	return Max(Min(v, SYNC_TRIM_MAX), -SYNC_TRIM_MAX);
+}
+
+#endif
+
+/**
+ * \brief Drive or catch the sync line
+ *
+ * Call after \ref timebase_init().
+ */
+void sync_init(void)
+{
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_MASTER
+	ioport_configure_pin(SYNC_PIN, IOPORT_DIR_OUTPUT | IOPORT_INIT_LOW);
+#elif SYNC_ENABLE
+	ioport_configure_pin(SYNC_PIN, IOPORT_DIR_INPUT | IOPORT_BOTHEDGES);
+	evsys_route(SYNC_EVENT_CH, SYNC_CHMUX);
+	tc32_set_input_capture(&TIMEBASE_TC, &TIMEBASE_TC_HIGH,
+			(TC_EVSEL_t)(TC_EVSEL_CH0_gc + SYNC_EVENT_CH));
+	tc_set_cca_interrupt_level(&TIMEBASE_TC, IRQLEVEL_TC);
+#endif
+}
+
+/**
+ * \brief Trim the sample clock to the newest master edge, scheduler task
+ *
+ * Posted at each slave hop. The error is the distance from the newest
+ * edge to this hop folded into half a hop either way, so an edge a little
+ * late for this hop still counts for it.
+ *
+ * \retval false always
+ */
+bool sync_run(void)
+{
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_SLAVE
+	irqflags_t flags;
+	uint32_t hop;
+	uint32_t edge;
+	uint8_t edges;
+	int32_t err;
+	int32_t rate;
+
+	flags = cpu_irq_save();
+	hop = sync_hop_time;
+	edge = sync_edge_time;
+	edges = sync_edges;
+	cpu_irq_restore(flags);
+
+	if (edges == sync_edges_seen) {
+		// Coast on the last rate
+		if (sync_quiet < SYNC_LOST) {
+			sync_quiet++;
+		}
+		return false;
+	}
+	sync_edges_seen = edges;
+	sync_quiet = 0;
+
+	err = (int32_t)(hop - edge) % (int32_t)SYNC_HOP_US;
+	if (err > (int32_t)SYNC_HOP_US / 2) {
+		err -= SYNC_HOP_US;
+	} else if (err < -(int32_t)SYNC_HOP_US / 2) {
+		err += SYNC_HOP_US;
+	}
+	sync_error = err;
+
+	// Behind the master, so shorten the sweeps
+	sync_freq = sync_clamp(sync_freq - err * SYNC_KI);
+	rate = sync_clamp(sync_freq - err * SYNC_KP);
+
+	flags = cpu_irq_save();
+	sync_rate = rate;
+	cpu_irq_restore(flags);
+#endif
+	return false;
+}
+
+/**
+ * \brief Print the lock of the sample clock
+ */
+void sync_dump(void)
+{
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_SLAVE
+	printf_P(PSTR("sync %S error %d us trim %ld/65536 clk\r\n"),
+			(sync_quiet >= SYNC_LOST) ? PSTR("lost")
+			: (sync_error <= SYNC_LOCK_US && sync_error >= -SYNC_LOCK_US)
+			? PSTR("locked") : PSTR("pulling"),
+			sync_error, (long)sync_rate);
+#elif SYNC_ENABLE
+	printf_P(PSTR("sync master\r\n"));
+#else
+	printf_P(PSTR("sync off\r\n"));
+#endif
+}
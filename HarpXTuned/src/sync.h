@@ -0,0 +1,111 @@
+/**
+ * \file
+ *
+ * \brief Sample clocks of the chained boards locked to the master
+ *
+ * Every board of a \ref chain.h bus samples on its own TCC1 and its own
+ * oscillator, so the frames of two units drift apart by the difference of
+ * their clocks. With a role set, the master toggles SYNC_PIN at every
+ * capture hop and each slave locks its own hops to those edges:
+ * - both edges of SYNC_PIN go through SYNC_EVENT_CH to an input capture
+ *   of the \ref timebase.h counter, so an edge is stamped in hardware;
+ * - the slave stamps its own hops with \ref timebase_now() in the same
+ *   spot of the capture interrupt as the master toggles, so the interrupt
+ *   latencies of the two boards cancel;
+ * - the sync task, posted at each slave hop, takes the distance to the
+ *   newest edge, within half a hop, as the phase error, and a proportional
+ *   and integral loop turns it into a TCC1 rate trim in 2^-16 clocks per
+ *   sweep, one clock at most either way;
+ * - \ref sync_block() dithers the TCC1 period by a clock from block to
+ *   block to give that rate.
+ *
+ * Locked, the slaves sample the same instants as the master within a few
+ * microseconds, so the readings of a string on two units are of the same
+ * frames. Without edges for SYNC_LOST hops the slave keeps its last rate.
+ * The timebases themselves are not set: each unit stamps its own frames.
+ *
+ * SYNC_PIN is PF0, beside the bus pins, wired between every board.
+ *
+ */
+
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <compiler.h>
+#include <ioport.h>
+#include <tc.h>
+#include <conf_profile.h>
+#include "chain.h"
+#include "sched.h"
+#include "timebase.h"
+
+//! Built with a bus role
+#define SYNC_ENABLE             (CHAIN_ROLE != CHAIN_NONE)
+
+//! \name Sync line, an output on the master and an input on the slaves
+//@{
+#define SYNC_PIN                IOPORT_CREATE_PIN(PORTF, 0)
+#define SYNC_PORT               PORTF
+#define SYNC_PIN_MASK           (1 << 0)
+#define SYNC_CHMUX              EVSYS_CHMUX_PORTF_PIN0_gc
+//@}
+
+//! Event channel of the sync edges, after that of timebase.h
+#define SYNC_EVENT_CH           4
+
+//! Phase error in microseconds below which a slave counts as locked
+#ifndef SYNC_LOCK_US
+#  define SYNC_LOCK_US          4
+#endif
+
+//! Hops without an edge after which a slave counts as lost
+#ifndef SYNC_LOST
+#  define SYNC_LOST             8
+#endif
+
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_SLAVE
+//! \internal Time of the newest slave hop
+extern volatile uint32_t sync_hop_time;
+//! \internal TCC1 rate trim, 2^-16 clocks per sweep, and its dither
+extern int32_t sync_rate;
+extern int32_t sync_dither;
+#endif
+
+/**
+ * \brief Mark a capture hop, from the capture interrupt
+ */
+static inline void sync_hop(void)
+{
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_MASTER
+	SYNC_PORT.OUTTGL = SYNC_PIN_MASK;
+#elif SYNC_ENABLE
+	sync_hop_time = timebase_now();
+	sched_post(SCHED_SYNC);
+#endif
+}
+
+/**
+ * \brief Set the TCC1 period of the next block, from the capture interrupt
+ */
+static inline void sync_block(void)
+{
+#if SYNC_ENABLE && CHAIN_ROLE == CHAIN_SLAVE
+	int16_t trim = 0;
+
+	sync_dither += sync_rate;
+	if (sync_dither >= 0x8000L) {
+		trim = 1;
+		sync_dither -= 0x10000L;
+	} else if (sync_dither < -0x8000L) {
+		trim = -1;
+		sync_dither += 0x10000L;
+	}
+	tc_write_period_buffer(&TCC1, PROFILE_SWEEP_PERIOD - 1 + trim);
+#endif
+}
+
+void sync_init(void);
+bool sync_run(void);
+void sync_dump(void);
+
+#endif /* SYNC_H */
@@ -0,0 +1,380 @@
+/**
+ * \file
+ *
+ * \brief Field update of the tuning tables over the stdio USART
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+#include <asf.h>
+#include <conf_usart_serial.h>
+#include "capture.h"
+#include "harp.h"
+#include "hostlink.h"
+#include "listen.h"
+#include "pitch.h"
+#include "record.h"
+#include "sched.h"
+#include "serial_rx.h"
+#include "serial_tx.h"
+#include "tableload.h"
+
+//! \internal Bytes of one chunk as received, with its CRC
+#define TABLELOAD_FRAME         (TABLELOAD_CHUNK + 2)
+
+//! \internal Bytes of each table, in \ref tableload_table order
+static const uint16_t tableload_sizes[TABLELOAD_TABLES] = {
+	TABLELOAD_TEMPERAMENTS_SIZE,
+	TABLELOAD_STRINGS_SIZE,
+};
+
+//! \internal Table names, in \ref tableload_table order
+static PROGMEM_DECLARE(char, tableload_name_temperaments[]) = "temperaments";
+static PROGMEM_DECLARE(char, tableload_name_strings[]) = "strings";
+
+static PROGMEM_DECLARE(PROGMEM_STRING_T, tableload_names[TABLELOAD_TABLES]) = {
+	tableload_name_temperaments,
+	tableload_name_strings,
+};
+
+//! \internal Tables whose page holds a complete replacement
+static bool tableload_valid[TABLELOAD_TABLES];
+
+//! \internal Table being loaded, TABLELOAD_TABLES when none
+static uint8_t tableload_table = TABLELOAD_TABLES;
+//! \internal Bytes of the table written, and their CRC
+static uint16_t tableload_done;
+static uint16_t tableload_crc;
+//! \internal Half of the double buffer to complete next
+static uint8_t tableload_half;
+//! \internal Bad chunks in a row
+static uint8_t tableload_bad;
+//! \internal RTC time of the last chunk, or of the start
+static uint32_t tableload_time;
+//! \internal State of the capture when the load started
+static enum capture_state tableload_resume;
+
+//! \internal Double buffer of the chunks, one half per DMA channel
+static uint8_t tableload_buf[2][TABLELOAD_FRAME];
+
+//! \internal CRC-CCITT of \a len bytes of flash at \a addr, from \a crc
+static uint16_t tableload_flash_crc(uint16_t crc, flash_addr_t addr,
+		uint16_t len)
+{
+	while (len--) {
+		crc = _crc_ccitt_update(crc, pgm_read_byte_far(addr++));
+	}
+	return crc;
+}
+
+//! \internal Whether the CRC after \a chunk matches it
+static bool tableload_chunk_ok(const uint8_t *chunk)
+{
+	uint16_t crc = 0xffff;
+	uint16_t i;
+
+	for (i = 0; i < TABLELOAD_CHUNK; i++) {
+		crc = _crc_ccitt_update(crc, chunk[i]);
+	}
+	return crc == (chunk[TABLELOAD_CHUNK]
+			| ((uint16_t)chunk[TABLELOAD_CHUNK + 1] << 8));
+}
+
+/**
+ * \internal
+ * \brief Whether the page of \a table holds a complete replacement
+ */
+static bool tableload_check(enum tableload_table table)
+{
+	flash_addr_t addr = TABLELOAD_ADDR(table);
+	uint16_t len = tableload_sizes[table];
+
+	return nvm_flash_read_word(addr) == TABLELOAD_MAGIC
+			&& nvm_flash_read_word(addr + 2) == len
+			&& nvm_flash_read_word(addr + 4) == tableload_flash_crc(0xffff,
+			addr + sizeof(struct tableload_header), len);
+}
+
+/**
+ * \internal
+ * \brief Write \a len bytes of \a buf to flash at \a addr and read them
+ * back
+ *
+ * The CPU halts until the page is written.
+ *
+ * \retval false if they do not read back
+ */
+static bool tableload_write(flash_addr_t addr, const void *buf, uint16_t len)
+{
+	const uint8_t *p = buf;
+
+	nvm_flash_erase_and_write_buffer(addr, buf, len, true);
+	while (len--) {
+		if (pgm_read_byte_far(addr++) != *p++) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * \internal
+ * \brief Go back to the generated \a table and retune to it
+ */
+static void tableload_drop(enum tableload_table table)
+{
+	uint8_t ch;
+
+	tableload_valid[table] = false;
+	harp_reload();
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_retune(ch);
+	}
+	nvm_wait_until_ready();
+	nvm_flash_erase_app_page(TABLELOAD_ADDR(table));
+	nvm_flash_flush_buffer();
+}
+
+/**
+ * \internal
+ * \brief Configure one DMA channel of the receive double buffer
+ *
+ * Each received byte moves into the next byte of \a dest, reloaded after
+ * every chunk. The channel raises no interrupt, so the callbacks of the
+ * capture stay as they are.
+ */
+static void tableload_dma_channel_init(dma_channel_num_t num, uint8_t *dest)
+{
+	struct dma_channel_config config;
+
+	memset(&config, 0, sizeof(config));
+	dma_channel_set_burst_length(&config, DMA_CH_BURSTLEN_1BYTE_gc);
+	dma_channel_set_single_shot(&config);
+	dma_channel_set_repeats(&config, 0);
+	dma_channel_set_transfer_count(&config, TABLELOAD_FRAME);
+	dma_channel_set_trigger_source(&config, USART_SERIAL_RXC_TRIGSRC);
+	dma_channel_set_src_mode(&config, DMA_CH_SRCRELOAD_NONE_gc,
+			DMA_CH_SRCDIR_FIXED_gc);
+	dma_channel_set_dest_mode(&config, DMA_CH_DESTRELOAD_BLOCK_gc,
+			DMA_CH_DESTDIR_INC_gc);
+	dma_channel_set_source_address(&config,
+			(uint16_t)&(USART_SERIAL)->DATA);
+	dma_channel_set_destination_address(&config, (uint16_t)dest);
+	dma_channel_write_config(num, &config);
+}
+
+/**
+ * \internal
+ * \brief Take the receive path back, use the tables in flash and carry on
+ * capturing
+ */
+static void tableload_end(void)
+{
+	enum tableload_table table = (enum tableload_table)tableload_table;
+	uint8_t ch;
+
+	dma_channel_disable(CAPTURE_DMA_CH_A);
+	dma_channel_disable(CAPTURE_DMA_CH_B);
+	serial_rx_resume();
+
+	tableload_valid[table] = tableload_check(table);
+	tableload_table = TABLELOAD_TABLES;
+	harp_reload();
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_retune(ch);
+	}
+	listen_restore(tableload_resume);
+	printf_P(tableload_valid[table] ? PSTR("loaded\r\n")
+			: PSTR("load failed\r\n"));
+}
+
+/**
+ * \internal
+ * \brief Write the chunk in \a chunk, and the header after the last one
+ *
+ * \retval false if the write does not read back
+ */
+static bool tableload_chunk(const uint8_t *chunk)
+{
+	enum tableload_table table = (enum tableload_table)tableload_table;
+	flash_addr_t addr = TABLELOAD_ADDR(table);
+	uint16_t size = tableload_sizes[table];
+	uint16_t len = Min(TABLELOAD_CHUNK, size - tableload_done);
+	struct tableload_header header;
+	uint16_t i;
+
+	if (tableload_done + len < size) {
+		// Out before the CPU halts, so the host sends the next chunk
+		// into the other half during the write
+		printf_P(PSTR("next\r\n"));
+		serial_tx_flush();
+	}
+	if (!tableload_write(addr + sizeof(header) + tableload_done,
+			chunk, len)) {
+		return false;
+	}
+	for (i = 0; i < len; i++) {
+		tableload_crc = _crc_ccitt_update(tableload_crc, chunk[i]);
+	}
+	tableload_done += len;
+	if (tableload_done < size) {
+		return true;
+	}
+
+	header.magic = TABLELOAD_MAGIC;
+	header.len = size;
+	header.crc = tableload_crc;
+	return tableload_write(addr, &header, sizeof(header));
+}
+
+/**
+ * \brief Take in the tables loaded before
+ *
+ * Call before \ref harp_init().
+ */
+void tableload_init(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < TABLELOAD_TABLES; i++) {
+		Assert(tableload_sizes[i] + sizeof(struct tableload_header)
+				<= FLASH_PAGE_SIZE);
+
+		tableload_valid[i] = tableload_check((enum tableload_table)i);
+	}
+}
+
+/**
+ * \brief Flash address of loaded \a table
+ *
+ * \return the address of its first byte, or 0 if the generated table is
+ * in use
+ */
+flash_addr_t tableload_get(enum tableload_table table)
+{
+	if (!tableload_valid[table]) {
+		return 0;
+	}
+	return TABLELOAD_ADDR(table) + sizeof(struct tableload_header);
+}
+
+/**
+ * \brief Stop the capture and wait for the chunks of \a table
+ *
+ * \retval false if a load, a \ref hostlink.h link or a \ref record.h
+ * recording runs
+ */
+bool tableload_start(enum tableload_table table)
+{
+	if (tableload_table != TABLELOAD_TABLES || hostlink_is_active()
+			|| record_get_state() == RECORD_RUNNING) {
+		return false;
+	}
+	tableload_resume = listen_suspend();
+	tableload_drop(table);
+
+	// Off, or with pair 2/3 alone, when the capture does not use DMA
+	if (!(DMA.CTRL & DMA_ENABLE_bm)) {
+		dma_enable();
+	}
+	if ((DMA.CTRL & DMA_DBUFMODE_gm) == DMA_DBUFMODE_DISABLED_gc) {
+		dma_set_double_buffer_mode(DMA_DBUFMODE_CH01_gc);
+	} else if ((DMA.CTRL & DMA_DBUFMODE_gm) == DMA_DBUFMODE_CH23_gc) {
+		dma_set_double_buffer_mode(DMA_DBUFMODE_CH01CH23_gc);
+	}
+	tableload_dma_channel_init(CAPTURE_DMA_CH_A, tableload_buf[0]);
+	tableload_dma_channel_init(CAPTURE_DMA_CH_B, tableload_buf[1]);
+	serial_rx_suspend();
+	dma_channel_enable(CAPTURE_DMA_CH_A);
+
+	tableload_table = table;
+	tableload_done = 0;
+	tableload_crc = 0xffff;
+	tableload_half = 0;
+	tableload_bad = 0;
+	tableload_time = rtc_get_time();
+	sched_post(SCHED_TABLELOAD);
+	printf_P(PSTR("load %u %u\r\n"), tableload_sizes[table],
+			TABLELOAD_CHUNK);
+	return true;
+}
+
+/**
+ * \brief Go back to the generated \a table
+ *
+ * The page erase holds the capture interrupt back for some milliseconds,
+ * so a block may be lost.
+ *
+ * \retval false if a load runs
+ */
+bool tableload_clear(enum tableload_table table)
+{
+	if (tableload_table != TABLELOAD_TABLES) {
+		return false;
+	}
+	tableload_drop(table);
+	return true;
+}
+
+/**
+ * \brief Take the chunk received, scheduler task
+ *
+ * Posted by \ref tableload_start(); the DMA raises no interrupt, so the
+ * task polls the half due until the load ends.
+ *
+ * \retval true while the load runs
+ * \retval false once it has ended
+ */
+bool tableload_run(void)
+{
+	dma_channel_num_t num;
+	const uint8_t *chunk;
+
+	if (tableload_table == TABLELOAD_TABLES) {
+		return false;
+	}
+
+	num = tableload_half ? CAPTURE_DMA_CH_B : CAPTURE_DMA_CH_A;
+	if (dma_get_channel_status(num) != DMA_CH_TRANSFER_COMPLETED) {
+		if (rtc_get_time() - tableload_time >= TABLELOAD_TIMEOUT) {
+			tableload_end();
+			return false;
+		}
+		return true;
+	}
+	dma_get_channel_address_from_num(num)->CTRLB |= DMA_CH_TRNIF_bm;
+	chunk = tableload_buf[tableload_half];
+	tableload_half ^= 1;
+	tableload_time = rtc_get_time();
+
+	if (tableload_chunk_ok(chunk)) {
+		tableload_bad = 0;
+		if (!tableload_chunk(chunk)
+				|| tableload_done == tableload_sizes[tableload_table]) {
+			tableload_end();
+			return false;
+		}
+	} else if (++tableload_bad >= TABLELOAD_RETRIES) {
+		tableload_end();
+		return false;
+	} else {
+		printf_P(PSTR("again\r\n"));
+	}
+	return true;
+}
+
+/**
+ * \brief Print which tables are loaded
+ */
+void tableload_dump(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < TABLELOAD_TABLES; i++) {
+		printf_P(PSTR("%S %S\r\n"),
+				(PROGMEM_STRING_T)PROGMEM_READ_WORD(&tableload_names[i]),
+				tableload_valid[i] ? PSTR("loaded") : PSTR("generated"));
+	}
+}
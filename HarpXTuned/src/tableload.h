@@ -0,0 +1,118 @@
+/**
+ * \file
+ *
+ * \brief Field update of the tuning tables over the stdio USART
+ *
+ * The temperaments and the string layout can be replaced on a tuner in
+ * the field without a firmware update. A replacement lives in the
+ * application table section, one flash page per table at
+ * \ref TABLELOAD_ADDR(), behind a \ref tableload_header with its length
+ * and CRC. \ref harp.h reads a table from its page while the header
+ * matches, and the generated one of notes_table.c and harp_table.c
+ * otherwise.
+ *
+ * "tables load <name>" on the \ref shell.h stops the capture, erases the
+ * page and answers "load <bytes> <chunk>". The host then sends the table
+ * in chunks of TABLELOAD_CHUNK bytes, the last one padded, each followed
+ * by its CRC-CCITT from 0xffff, little endian. The board answers each
+ * chunk with one line:
+ * - "next" once the chunk checks, before it is written;
+ * - "again" if its CRC fails, for the same chunk once more;
+ * - "loaded" after the last one is written, with the header;
+ * - "load failed" if a chunk does not read back, after TABLELOAD_RETRIES
+ *   bad chunks in a row, or after TABLELOAD_TIMEOUT without a chunk.
+ *
+ * Writing a page halts the CPU for some milliseconds, interrupts
+ * included, as the vectors and the code are in the application section.
+ * So the bytes do not go through the \ref serial_rx.h interrupt: the
+ * receive complete trigger moves them by DMA into one half of a double
+ * buffer on CAPTURE_DMA_CH_A and CAPTURE_DMA_CH_B, free while the capture
+ * is stopped. The DMA controller reads nothing from flash and keeps
+ * storing while the page is written. With "next" sent before the write,
+ * the host sends the next chunk into the other half during it, and never
+ * has more than one chunk in flight.
+ *
+ * Each chunk is written with nvm_flash_erase_and_write_buffer(), which
+ * keeps the rest of its page. The header goes last, so a load cut short
+ * leaves the generated table in use rather than half a new one.
+ * "tables clear <name>" erases the page and goes back to the generated
+ * table. tools/tableload.py sends the tables of tools/notes_table.py.
+ * The pages are outside the image, which must end below
+ * APPTABLE_SECTION_START; the .map tells.
+ *
+ * End the command line with CR alone: the DMA takes every byte after it.
+ *
+ */
+
+#ifndef TABLELOAD_H
+#define TABLELOAD_H
+
+#include <compiler.h>
+#include <nvm.h>
+#include "harp.h"
+#include "notes.h"
+
+//! Tables that can be loaded
+enum tableload_table {
+	//! NOTES_TEMPERAMENTS rows of 12 int16_t, as notes_temperament_table
+	TABLELOAD_TEMPERAMENTS,
+	//! HARP_STRINGS open string frequencies, \ref pitch_hz_t at A4 =
+	//! 440 Hz, then HARP_STRINGS notes, as notes_string_table
+	TABLELOAD_STRINGS,
+	TABLELOAD_TABLES
+};
+
+//! Bytes of each table
+#define TABLELOAD_TEMPERAMENTS_SIZE (NOTES_TEMPERAMENTS * 12 * 2)
+#define TABLELOAD_STRINGS_SIZE      (HARP_STRINGS * 5)
+//! Offset of the notes in the string table
+#define TABLELOAD_STRINGS_NOTES     (HARP_STRINGS * 4)
+
+//! Start of the flash page of \a table
+#define TABLELOAD_ADDR(table) \
+	(APPTABLE_SECTION_START + (flash_addr_t)(table) * FLASH_PAGE_SIZE)
+
+//! Header of a loaded table, at the start of its page
+struct tableload_header {
+	//! TABLELOAD_MAGIC; erased flash reads 0xffff
+	uint16_t magic;
+	//! Bytes of the table that follows
+	uint16_t len;
+	//! CRC-CCITT of the table from 0xffff
+	uint16_t crc;
+};
+
+//! \ref tableload_header::magic of a complete table
+#define TABLELOAD_MAGIC         0x7442
+
+//! Bytes of the table per chunk, even and up to FLASH_PAGE_SIZE
+#ifndef TABLELOAD_CHUNK
+#  define TABLELOAD_CHUNK       64
+#endif
+
+//! RTC ticks without a chunk before a load is abandoned, 2 s
+#ifndef TABLELOAD_TIMEOUT
+#  define TABLELOAD_TIMEOUT     2048
+#endif
+
+//! Bad chunks in a row before a load is abandoned
+#ifndef TABLELOAD_RETRIES
+#  define TABLELOAD_RETRIES     3
+#endif
+
+#if (TABLELOAD_CHUNK & 1) || TABLELOAD_CHUNK > FLASH_PAGE_SIZE
+#  error "TABLELOAD_CHUNK must be even and fit a flash page"
+#endif
+
+#if HARP_STRINGS * 5 + 6 > FLASH_PAGE_SIZE
+#  error "The string table must fit a flash page"
+#endif
+
+void tableload_init(void);
+flash_addr_t tableload_get(enum tableload_table table);
+bool tableload_start(enum tableload_table table);
+bool tableload_clear(enum tableload_table table);
+bool tableload_run(void);
+void tableload_dump(void);
+
+#endif /* TABLELOAD_H */
@@ -0,0 +1,123 @@
+/**
+ * \file
+ *
+ * \brief Check of the constant tables in flash
+ *
+ */
+
+#include <stdio.h>
+#include <util/crc16.h>
+#include <asf.h>
+#include "calib.h"
+#include "harp.h"
+#include "notes.h"
+#include "tables.h"
+#include "tables_crc.h"
+#include "tempcomp.h"
+#include "dsp/fft.h"
+#include "dsp/window.h"
+
+//! \internal Flash range of one table, and the CRC shipped with it
+struct tables_range {
+	const void *start;
+	uint16_t size;
+	uint16_t crc;
+};
+
+//! \internal Tables covered by the check
+static const struct tables_range tables_ranges[] = {
+	{ fft_sin_table, sizeof(fft_sin_table),
+			TABLES_CRC_FFT_SIN_TABLE },
+	{ window_table, sizeof(window_table),
+			TABLES_CRC_WINDOW_TABLE },
+	{ notes_log2_table, sizeof(notes_log2_table),
+			TABLES_CRC_NOTES_LOG2_TABLE },
+	{ notes_temperament_table, sizeof(notes_temperament_table),
+			TABLES_CRC_NOTES_TEMPERAMENT_TABLE },
+	{ notes_string_table, sizeof(notes_string_table),
+			TABLES_CRC_NOTES_STRING_TABLE },
+	{ tempcomp_table, sizeof(tempcomp_table),
+			TABLES_CRC_TEMPCOMP_TABLE },
+};
+
+//! \internal Number of tables covered
+#define TABLES_COUNT    (sizeof(tables_ranges) / sizeof(tables_ranges[0]))
+
+/**
+ * \internal
+ * \brief NVM flash range CRC of \a range
+ *
+ * The CPU halts while the controller reads the range, a few microseconds
+ * per hundred bytes.
+ */
+static uint32_t tables_crc(const struct tables_range *range)
+{
+	flash_addr_t start = (flash_addr_t)(uintptr_t)range->start;
+
+	nvm_wait_until_ready();
+	nvm_issue_flash_range_crc(start, start + range->size - 1);
+	nvm_wait_until_ready();
+	return NVM.DATA0 | ((uint32_t)NVM.DATA1 << 8)
+			| ((uint32_t)NVM.DATA2 << 16);
+}
+
+/**
+ * \internal
+ * \brief Whether \a range matches the CRC shipped with it
+ */
+static bool tables_shipped_ok(const struct tables_range *range)
+{
+	const uint8_t *p = range->start;
+	uint16_t crc = 0xffff;
+	uint16_t i;
+
+	for (i = 0; i < range->size; i++) {
+		crc = _crc_ccitt_update(crc, PROGMEM_READ_BYTE(p + i));
+	}
+	return crc == range->crc;
+}
+
+/**
+ * \brief Check the tables against their shipped CRCs and their record,
+ * or take the record
+ *
+ * Call once the capture runs; the result is printed on the stdio USART.
+ *
+ * \retval false if a table does not match its shipped CRC or its record
+ */
+bool tables_check(void)
+{
+	struct tables_stamp stamp;
+	uint32_t crc = 0;
+	uint8_t i;
+	bool ok = true;
+
+	for (i = 0; i < TABLES_COUNT; i++) {
+		if (!tables_shipped_ok(&tables_ranges[i])) {
+			printf_P(PSTR("tables %u not as shipped: FAIL\r\n"), i);
+			ok = false;
+		}
+		// Rotated, so two tables swapped do not cancel
+		crc = ((crc << 5) | (crc >> 27)) ^ tables_crc(&tables_ranges[i]);
+	}
+	if (!ok) {
+		// A table corrupt from the start is not taken as the record
+		return false;
+	}
+
+	if (!calib_read(CALIB_KEY_TABLES, &stamp, sizeof(stamp))
+			|| stamp.version != TABLES_VERSION
+			|| stamp.profile != CONF_PROFILE) {
+		stamp.version = TABLES_VERSION;
+		stamp.profile = CONF_PROFILE;
+		stamp.crc = crc;
+		calib_write(CALIB_KEY_TABLES, &stamp, sizeof(stamp));
+		printf_P(PSTR("tables v%u crc %08lx: recorded\r\n"),
+				TABLES_VERSION, (unsigned long)crc);
+		return true;
+	}
+	ok = stamp.crc == crc;
+	printf_P(PSTR("tables v%u crc %08lx: %S\r\n"), TABLES_VERSION,
+			(unsigned long)crc, ok ? PSTR("ok") : PSTR("FAIL"));
+	return ok;
+}
@@ -0,0 +1,46 @@
+/**
+ * \file
+ *
+ * \brief Check of the constant tables in flash
+ *
+ * The window, twiddle, cents, temperament, string and sensor tables are
+ * generated by the tools/ scripts and live in flash, so nothing of them is
+ * worked out in SRAM at start-up. \ref tables_check() first checks each
+ * table against the CRC-CCITT shipped with it in tables_crc.h, made by
+ * tools/tables_crc.py from the generated sources; a table that does not
+ * match is reported as corrupt, whatever was recorded before. It then
+ * runs the NVM flash range CRC over each of them and folds the results
+ * into one value:
+ * - with no record for this TABLES_VERSION and CONF_PROFILE in the
+ *   \ref calib.h store, as on the first start of a new image, the value is
+ *   recorded;
+ * - otherwise it must match the record, and a mismatch is reported as a
+ *   corrupt table.
+ *
+ * The NVM CRC is the one the controller computes, so its record is
+ * always taken on the board itself, and only once the shipped CRCs have
+ * passed. Regenerate tables_crc.h and bump TABLES_VERSION whenever a
+ * generated table changes.
+ *
+ */
+
+#ifndef TABLES_H
+#define TABLES_H
+
+#include <compiler.h>
+
+//! Version of the generated tables
+#define TABLES_VERSION          1
+
+//! Value of the CALIB_KEY_TABLES record
+struct tables_stamp {
+	//! TABLES_VERSION and CONF_PROFILE the CRC was taken for
+	uint8_t version;
+	uint8_t profile;
+	//! Folded CRC of the tables
+	uint32_t crc;
+};
+
+bool tables_check(void);
+
+#endif /* TABLES_H */
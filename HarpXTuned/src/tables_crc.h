@@ -0,0 +1,25 @@
+/**
+ * \file
+ *
+ * \brief CRCs of the generated tables in flash, see tables.h
+ *
+ * CRC-CCITT of each table from 0xffff, as avr-libc _crc_ccitt_update()
+ * takes it. Generated by tools/tables_crc.py, do not edit.
+ *
+ */
+
+#ifndef TABLES_CRC_H
+#define TABLES_CRC_H
+
+#define TABLES_CRC_FFT_SIN_TABLE            0xc862
+#if WINDOW_TYPE == WINDOW_HANN
+#  define TABLES_CRC_WINDOW_TABLE          0x430e
+#elif WINDOW_TYPE == WINDOW_BLACKMAN
+#  define TABLES_CRC_WINDOW_TABLE          0x7302
+#endif
+#define TABLES_CRC_NOTES_LOG2_TABLE         0xf1bf
+#define TABLES_CRC_NOTES_TEMPERAMENT_TABLE  0x417a
+#define TABLES_CRC_NOTES_STRING_TABLE       0xc1f1
+#define TABLES_CRC_TEMPCOMP_TABLE           0x0433
+
+#endif /* TABLES_CRC_H */
@@ -0,0 +1,99 @@
+/**
+ * \file
+ *
+ * \brief 32-bit counters of two cascaded timers
+ *
+ * The overflow of the low timer is routed to an event channel that clocks
+ * the high timer, so the pair counts to 32 bits in hardware and no
+ * overflow interrupt carries into a high word in SRAM. The carry reaches
+ * the high timer one peripheral clock after the low one wraps.
+ *
+ * \ref tc32_read() reads the high word on either side of the low one and
+ * tries again when they differ, which handles a carry landing mid-read.
+ * Interrupts are held off for the reads as the 16-bit accesses go through
+ * the TEMP register of each timer, which an interrupt reading the same
+ * timer would overwrite.
+ *
+ * For a 32-bit input capture, both timers capture on the same event, with
+ * the event delay on the high one so that it sees the carry of an event
+ * arriving as the low timer wraps.
+ *
+ */
+
+#ifndef TC32_H
+#define TC32_H
+
+#include <compiler.h>
+#include <tc.h>
+#include "evsys.h"
+
+/**
+ * \brief Cascade \a high onto \a low and start both from 0
+ *
+ * \param carry_ch Event channel of the carry
+ * \param carry Event of the overflow of \a low, such as
+ *        EVSYS_CHMUX_TCF0_OVF_gc for TCF0
+ * \param clksel Clock source of \a low
+ */
+static inline void tc32_init(volatile void *low, volatile void *high,
+		uint8_t carry_ch, EVSYS_CHMUX_t carry, TC_CLKSEL_t clksel)
+{
+	evsys_route(carry_ch, carry);
+
+	tc_enable(high);
+	tc_write_period(high, 0xffff);
+	tc_write_clock_source(high, EVSYS_TC_CLKSEL(carry_ch));
+
+	tc_enable(low);
+	tc_write_period(low, 0xffff);
+	tc_write_clock_source(low, clksel);
+}
+
+/**
+ * \brief Count of the pair \a low and \a high, at any interrupt level
+ */
+static inline uint32_t tc32_read(volatile void *low, volatile void *high)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t again = tc_read_count(high);
+	uint16_t hi;
+	uint16_t lo;
+
+	do {
+		hi = again;
+		lo = tc_read_count(low);
+		again = tc_read_count(high);
+	} while (hi != again);
+	cpu_irq_restore(flags);
+	return ((uint32_t)hi << 16) | lo;
+}
+
+/**
+ * \brief Capture the count of the pair on the events of \a evsel in CCA
+ */
+static inline void tc32_set_input_capture(volatile void *low,
+		volatile void *high, TC_EVSEL_t evsel)
+{
+	tc_set_input_capture(high, evsel, TC_EVACT_CAPT_gc);
+	tc_enable_delay(high);
+	tc_enable_cc_channels(high, TC_CCAEN);
+	tc_set_input_capture(low, evsel, TC_EVACT_CAPT_gc);
+	tc_enable_cc_channels(low, TC_CCAEN);
+}
+
+/**
+ * \brief Count of the pair at its last CCA capture
+ *
+ * Read before the next event, from the CCA interrupt of \a low.
+ */
+static inline uint32_t tc32_read_cc(volatile void *low, volatile void *high)
+{
+	irqflags_t flags = cpu_irq_save();
+	uint16_t lo = tc_read_cc(low, TC_CCA);
+	uint16_t hi = tc_read_cc(high, TC_CCA);
+
+	cpu_irq_restore(flags);
+	return ((uint32_t)hi << 16) | lo;
+}
+
+#endif /* TC32_H */
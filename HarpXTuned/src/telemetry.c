@@ -0,0 +1,220 @@
+/**
+ * \file
+ *
+ * \brief Readings on the stdio USART
+ *
+ */
+
+#include <stdio.h>
+#include <asf.h>
+#include "capture.h"
+#include "harp.h"
+#include "hostlink.h"
+#include "jitter.h"
+#include "notes.h"
+#include "pitch.h"
+#include "pitch_fft.h"
+#include "residency.h"
+#include "sched.h"
+#include "serial_tx.h"
+#include "telemetry.h"
+
+//! \internal Next channel to send
+static uint8_t telemetry_ch;
+
+//! \internal Readings are sent
+static bool telemetry_enabled = true;
+
+//! \internal Lines skipped for want of ring space
+static uint16_t telemetry_skipped;
+
+//! \internal Scheduler faults in the last faults line
+static uint16_t telemetry_misses;
+static uint16_t telemetry_overruns;
+//! \internal The watchdog reset is still to be told
+static bool telemetry_wdt_untold = true;
+#ifdef CONFIG_JITTER
+//! \internal Capture entry figures in the last jitter line
+static uint16_t telemetry_jitter_max;
+static uint32_t telemetry_jitter_missed;
+#endif
+#ifdef CONFIG_RESIDENCY
+//! \internal Rounds of the channels until the next residency report
+static uint8_t telemetry_residency_wait = RESIDENCY_REPORT_CYCLES;
+#endif
+
+/**
+ * \brief Send the readings or stop them
+ */
+void telemetry_set_enabled(bool on)
+{
+	telemetry_enabled = on;
+}
+
+/**
+ * \brief Print the lines skipped
+ */
+void telemetry_dump(void)
+{
+	printf_P(PSTR("telemetry %u lines skipped\r\n"), telemetry_skipped);
+}
+
+/**
+ * \brief Clear the lines skipped
+ */
+void telemetry_reset(void)
+{
+	telemetry_skipped = 0;
+}
+
+/**
+ * \internal
+ * \brief Send the scheduler faults if they grew since the last time
+ */
+static void telemetry_faults(void)
+{
+	uint16_t misses = sched_get_misses();
+	uint16_t overruns = sched_get_overruns();
+	bool wdt = telemetry_wdt_untold && sched_get_wdt_reset();
+	char line[TELEMETRY_LINE_MAX];
+	int len;
+
+	if (misses == telemetry_misses && overruns == telemetry_overruns
+			&& !wdt) {
+		return;
+	}
+	len = snprintf_P(line, sizeof(line),
+			PSTR("faults %u missed %u over%S\r\n"), misses, overruns,
+			wdt ? PSTR(" wdt reset") : PSTR(""));
+	if (!serial_tx_write(line, len, SERIAL_TX_DROP)) {
+		telemetry_skipped++;
+		return;
+	}
+	telemetry_misses = misses;
+	telemetry_overruns = overruns;
+	telemetry_wdt_untold = false;
+}
+
+#ifdef CONFIG_JITTER
+/**
+ * \internal
+ * \brief Send the capture entry latency if its maximum or the sweeps
+ * missed grew since the last time
+ */
+static void telemetry_jitter(void)
+{
+	uint16_t max = jitter_get_max();
+	uint32_t missed = jitter_get_missed();
+	char line[TELEMETRY_LINE_MAX];
+	int len;
+
+	if (max == telemetry_jitter_max && missed == telemetry_jitter_missed) {
+		return;
+	}
+	len = snprintf_P(line, sizeof(line),
+			PSTR("jitter p99 %u max %u clocks missed %lu\r\n"),
+			jitter_get_p99(), max, (unsigned long)missed);
+	if (!serial_tx_write(line, len, SERIAL_TX_DROP)) {
+		telemetry_skipped++;
+		return;
+	}
+	telemetry_jitter_max = max;
+	telemetry_jitter_missed = missed;
+}
+#else
+static inline void telemetry_jitter(void) {}
+#endif
+
+#ifdef CONFIG_RESIDENCY
+/**
+ * \internal
+ * \brief Send the residency shares every RESIDENCY_REPORT_CYCLES rounds
+ */
+static void telemetry_residency(void)
+{
+	char line[RESIDENCY_LINE_MAX];
+	int len;
+
+	if (--telemetry_residency_wait) {
+		return;
+	}
+	telemetry_residency_wait = RESIDENCY_REPORT_CYCLES;
+	len = residency_format(line, sizeof(line), false);
+	if (!serial_tx_write(line, len, SERIAL_TX_DROP)) {
+		telemetry_skipped++;
+		return;
+	}
+	len = residency_format(line, sizeof(line), true);
+	if (!serial_tx_write(line, len, SERIAL_TX_DROP)) {
+		telemetry_skipped++;
+	}
+}
+#else
+static inline void telemetry_residency(void) {}
+#endif
+
+/**
+ * \brief Send the reading of the next channel, scheduler task
+ *
+ * \retval false always, one line per release
+ */
+bool telemetry_run(void)
+{
+	const struct pitch_reading *reading = &pitch_readings[telemetry_ch];
+	pitch_hz_t freq = reading->freq;
+	char line[TELEMETRY_LINE_MAX];
+	int len;
+
+	if (!telemetry_enabled || hostlink_is_active()) {
+		return false;
+	}
+
+	len = snprintf_P(line, sizeof(line), PSTR("ch%u %lu.%02u Hz level %u"),
+			telemetry_ch, (unsigned long)(freq >> 16),
+			(unsigned int)(((freq & 0xffff) * 100) >> 16),
+			reading->level);
+	if (freq) {
+		notes_cents_t error = notes_from_hz(freq);
+		char name[NOTES_NAME_MAX];
+		uint32_t tenths;
+
+		if (pitch_is_chromatic(telemetry_ch)) {
+			notes_cents_t target;
+
+			notes_name(harp_nearest_note(freq, &target), name);
+			error -= target;
+			len += snprintf_P(line + len, sizeof(line) - len,
+					PSTR(" note %s"), name);
+		} else {
+			uint8_t string = harp_nearest_string(telemetry_ch, freq);
+
+			notes_name(harp_string_note(string), name);
+			error -= harp_string_pitch(string);
+			len += snprintf_P(line + len, sizeof(line) - len,
+					PSTR(" string %u %s"), string, name);
+		}
+		tenths = (((error < 0) ? -error : error) * 10
+				+ NOTES_CENTS(1) / 2) >> NOTES_CENTS_SHIFT;
+		len += snprintf_P(line + len, sizeof(line) - len,
+				PSTR(" %c%lu.%u"), (error < 0) ? '-' : '+',
+				(unsigned long)(tenths / 10), (unsigned int)(tenths % 10));
+#if PITCH_FFT_CHANNELS && PITCH_FFT_PARTIALS
+		if (pitch_fft_inharmonicity(telemetry_ch)) {
+			len += snprintf_P(line + len, sizeof(line) - len, PSTR(" B %u"),
+					pitch_fft_inharmonicity(telemetry_ch));
+		}
+#endif
+	}
+	len += snprintf_P(line + len, sizeof(line) - len, PSTR("\r\n"));
+	if (!serial_tx_write(line, len, SERIAL_TX_DROP)) {
+		telemetry_skipped++;
+	}
+
+	if (++telemetry_ch == CHANNELS) {
+		telemetry_ch = 0;
+		telemetry_faults();
+		telemetry_jitter();
+		telemetry_residency();
+	}
+	return false;
+}
@@ -0,0 +1,57 @@
+/**
+ * \file
+ *
+ * \brief Readings on the stdio USART
+ *
+ * Every TELEMETRY_PERIOD the readings go out one line per channel, spread
+ * evenly over the period so one line drains before the next, as
+ * \code
+	ch0 261.63 Hz level 3606 string 21 C4 +0.3
+\endcode
+ * with the string's note and the cents from it, or 0.00 Hz and nothing
+ * more for a silent channel. The FFT partial tracker adds the string's
+ * inharmonicity, " B 310" for B = 310e-6, while it has one. After the
+ * last channel, a line
+ * \code
+	faults 3 missed 1 over
+\endcode
+ * gives the \ref sched.h deadlines missed, frame queue drops included, and
+ * the slices over budget whenever they change, with " wdt reset" the
+ * first time after a watchdog reset. With CONFIG_JITTER, a line
+ * \code
+	jitter p99 160 max 191 clocks missed 0
+\endcode
+ * follows whenever the \ref jitter.h largest entry latency or sweeps
+ * missed grow. With CONFIG_RESIDENCY, the two lines of the
+ * \ref residency.h shares follow every RESIDENCY_REPORT_CYCLES rounds.
+ * A line that does not fit the
+ * \ref serial_tx.h ring is skipped rather than waited for, so the
+ * readings never hold up the analysis. They stop while the
+ * \ref hostlink.h frames are on, and with the \ref shell.h command
+ * "readings off".
+ *
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <compiler.h>
+#include "capture.h"
+
+//! Longest reading line, with its terminating nul
+#define TELEMETRY_LINE_MAX  64
+
+//! Period of the readings in RTC ticks, 4 Hz
+#ifndef TELEMETRY_PERIOD
+#  define TELEMETRY_PERIOD  256
+#endif
+
+//! Release period of the telemetry task, one line per release
+#define TELEMETRY_LINE_PERIOD   (TELEMETRY_PERIOD / CHANNELS)
+
+bool telemetry_run(void);
+void telemetry_set_enabled(bool on);
+void telemetry_dump(void);
+void telemetry_reset(void);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,98 @@
+/**
+ * \file
+ *
+ * \brief Sample clock drift correction from the board temperature sensor
+ *
+ */
+
+#include <asf.h>
+#include "auxadc.h"
+#include "harp.h"
+#include "notes.h"
+#include "pitch.h"
+#include "tempcomp.h"
+
+#if TEMPCOMP_ENABLE
+
+//! \internal log2 of the smoothing of the sensor codes, in conversions
+#define TEMPCOMP_LOG2_SMOOTH    3
+
+//! \internal The clock is the RC oscillator, the task corrects it
+static bool tempcomp_active;
+//! \internal Smoothed sensor code, scaled by 2^TEMPCOMP_LOG2_SMOOTH, or
+//! -1 before the first conversion
+static int32_t tempcomp_code = -1;
+//! \internal Offset handed to harp_set_clock_offset() last
+static notes_cents_t tempcomp_offset;
+
+/**
+ * \internal
+ * \brief Oscillator error at sensor code \a code, interpolated
+ */
+static notes_cents_t tempcomp_lookup(uint16_t code)
+{
+	uint8_t i = code >> TEMPCOMP_LOG2_STEP;
+	uint8_t frac = code & ((1 << TEMPCOMP_LOG2_STEP) - 1);
+	int16_t lo = PROGMEM_READ_WORD(&tempcomp_table[i]);
+	int16_t hi = PROGMEM_READ_WORD(&tempcomp_table[i + 1]);
+
+	return lo + (((int32_t)(hi - lo) * frac) >> TEMPCOMP_LOG2_STEP);
+}
+
+/**
+ * \internal
+ * \brief Take sensor code \a code and move the references if due
+ */
+static void tempcomp_update(int16_t code)
+{
+	notes_cents_t offset;
+	uint8_t ch;
+
+	code = Max(code, 0);
+	if (tempcomp_code < 0) {
+		tempcomp_code = (int32_t)code << TEMPCOMP_LOG2_SMOOTH;
+	} else {
+		tempcomp_code += code - (tempcomp_code >> TEMPCOMP_LOG2_SMOOTH);
+	}
+
+	offset = tempcomp_lookup(tempcomp_code >> TEMPCOMP_LOG2_SMOOTH);
+	if (offset - tempcomp_offset < NOTES_CENTS(TEMPCOMP_STEP)
+			&& tempcomp_offset - offset < NOTES_CENTS(TEMPCOMP_STEP)) {
+		return;
+	}
+	tempcomp_offset = offset;
+	harp_set_clock_offset(offset);
+	for (ch = 0; ch < CHANNELS; ch++) {
+		pitch_retune(ch);
+	}
+}
+
+#endif
+
+/**
+ * \brief Turn the correction on if the system clock is the 32 MHz RC
+ * oscillator
+ *
+ * Call after \ref harp_init() and \ref auxadc_init().
+ */
+void tempcomp_init(void)
+{
+#if TEMPCOMP_ENABLE
+	tempcomp_active = (CONFIG_SYSCLK_SOURCE == SYSCLK_SRC_RC32MHZ);
+#endif
+}
+
+/**
+ * \brief Convert the sensor and move the references, scheduler task
+ *
+ * \retval false always, one conversion per period
+ */
+bool tempcomp_run(void)
+{
+#if TEMPCOMP_ENABLE
+	if (tempcomp_active) {
+		tempcomp_update(auxadc_read(TEMPERATURE_SENSOR_ADC_INPUT));
+	}
+#endif
+	return false;
+}
@@ -0,0 +1,58 @@
+/**
+ * \file
+ *
+ * \brief Sample clock drift correction from the board temperature sensor
+ *
+ * Without the DFLL, the 32 MHz RC oscillator drifts with temperature and
+ * so does the sample clock: a clock running fast reads every pitch low.
+ * The tempcomp task converts the board NTC with \ref auxadc_read() once
+ * every TEMPCOMP_PERIOD, maps the smoothed result through tempcomp_table, the
+ * oscillator error over the sensor reading from tools/tempcomp_table.py,
+ * and moves the string references of \ref harp.h with it through
+ * \ref harp_set_clock_offset(). The engines are retuned whenever the
+ * references have moved by TEMPCOMP_STEP cents. The capture and the
+ * readings are left as they are.
+ *
+ * Only built when conf_clock.h has no DFLL, and ADCB is not part of the
+ * capture; \ref tempcomp_init() also leaves it off unless the system clock
+ * is the 32 MHz RC oscillator.
+ *
+ */
+
+#ifndef TEMPCOMP_H
+#define TEMPCOMP_H
+
+#include <compiler.h>
+#include <conf_board.h>
+#include <conf_clock.h>
+#include <progmem.h>
+#include "auxadc.h"
+
+#if !defined(CONFIG_OSC_AUTOCAL) && AUXADC_ENABLE \
+		&& defined(CONF_BOARD_ENABLE_TEMPERATURE_SENSOR)
+#  define TEMPCOMP_ENABLE       1
+#else
+#  define TEMPCOMP_ENABLE       0
+#endif
+
+//! Sensor conversion period in RTC ticks, 1 s
+#ifndef TEMPCOMP_PERIOD
+#  define TEMPCOMP_PERIOD       1024
+#endif
+
+//! Smallest move of the references, in cents
+#ifndef TEMPCOMP_STEP
+#  define TEMPCOMP_STEP         1
+#endif
+
+//! log2 of the sensor codes per table step, must match tempcomp_table.c
+#define TEMPCOMP_LOG2_STEP      7
+#define TEMPCOMP_STEPS          (2048 >> TEMPCOMP_LOG2_STEP)
+
+//! Oscillator error at each step of the sensor code, \ref notes_cents_t
+extern PROGMEM_DECLARE(int16_t, tempcomp_table[TEMPCOMP_STEPS + 1]);
+
+void tempcomp_init(void);
+bool tempcomp_run(void);
+
+#endif /* TEMPCOMP_H */
@@ -0,0 +1,20 @@
+/**
+ * \file
+ *
+ * \brief RC oscillator drift table of tempcomp.h
+ *
+ * Generated by tools/tempcomp_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "tempcomp.h"
+
+// RC32M error in 2^-NOTES_CENTS_SHIFT cent at each sensor code step,
+// -300 ppm/C from 25 C, held above 85 C and below -20 C
+PROGMEM_DECLARE(int16_t, tempcomp_table[TEMPCOMP_STEPS + 1]) = {
+	 -503,  -503,  -503,  -412,  -334,  -275,  -225,  -183,
+	 -145,  -111,   -80,   -50,   -22,     5,    32,    59,
+	   85,
+};
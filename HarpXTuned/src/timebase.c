@@ -0,0 +1,43 @@
+/**
+ * \file
+ *
+ * \brief Microsecond timebase for stamping blocks and readings
+ *
+ */
+
+#include <asf.h>
+#include <conf_profile.h>
+#include "evsys.h"
+#include "tc32.h"
+#include "timebase.h"
+
+//! \internal Prescaler event of TIMEBASE_HZ from the peripheral clock
+#if PROFILE_PER_HZ == 32000000UL
+#  define TIMEBASE_CHMUX        EVSYS_CHMUX_PRESCALER_32_gc
+#elif PROFILE_PER_HZ == 16000000UL
+#  define TIMEBASE_CHMUX        EVSYS_CHMUX_PRESCALER_16_gc
+#elif PROFILE_PER_HZ == 8000000UL
+#  define TIMEBASE_CHMUX        EVSYS_CHMUX_PRESCALER_8_gc
+#elif PROFILE_PER_HZ == 2000000UL
+#  define TIMEBASE_CHMUX        EVSYS_CHMUX_PRESCALER_2_gc
+#else
+#  error "No prescaler event gives TIMEBASE_HZ from PROFILE_PER_HZ"
+#endif
+
+/**
+ * \brief Start the timebase from 0
+ */
+void timebase_init(void)
+{
+	evsys_route(TIMEBASE_EVENT_CH, TIMEBASE_CHMUX);
+	tc32_init(&TIMEBASE_TC, &TIMEBASE_TC_HIGH, TIMEBASE_CARRY_EVENT_CH,
+			EVSYS_CHMUX_TCF0_OVF_gc, EVSYS_TC_CLKSEL(TIMEBASE_EVENT_CH));
+}
+
+/**
+ * \brief Microseconds since \ref timebase_init(), at any interrupt level
+ */
+uint32_t timebase_now(void)
+{
+	return tc32_read(&TIMEBASE_TC, &TIMEBASE_TC_HIGH);
+}
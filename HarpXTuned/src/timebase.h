@@ -0,0 +1,41 @@
+/**
+ * \file
+ *
+ * \brief Microsecond timebase for stamping blocks and readings
+ *
+ * TIMEBASE_TC counts the peripheral clock prescaler event at 1 MHz on
+ * TIMEBASE_EVENT_CH, and its overflow clocks TIMEBASE_TC_HIGH through
+ * TIMEBASE_CARRY_EVENT_CH, a \ref tc32.h pair with no interrupt: \ref
+ * timebase_now() is monotonic in microseconds and wraps after
+ * 71 minutes, so stamps are compared by difference only. Capture blocks
+ * are stamped at their last frame, the \ref pitch_readings with the stamp
+ * of the newest frame they were worked out from, and the \ref hostlink.h
+ * readings frames carry both, which gives the pluck to display latency on
+ * the host.
+ *
+ * The scheduler stays on the RTC, whose tick of 1/1024 s is not a whole
+ * number of microseconds.
+ *
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <compiler.h>
+#include <tc.h>
+
+//! Low and high counters of the timebase, also named by sync.c
+#define TIMEBASE_TC             TCF0
+#define TIMEBASE_TC_HIGH        TCF1
+//! Event channel of the 1 MHz prescaler output, after those of tone.h
+#define TIMEBASE_EVENT_CH       3
+//! Event channel of the TIMEBASE_TC overflow, after that of sync.h
+#define TIMEBASE_CARRY_EVENT_CH 5
+
+//! Timebase ticks per second
+#define TIMEBASE_HZ             1000000UL
+
+void timebase_init(void);
+uint32_t timebase_now(void);
+
+#endif /* TIMEBASE_H */
@@ -0,0 +1,277 @@
+/**
+ * \file
+ *
+ * \brief Reference tone on the board speaker
+ *
+ */
+
+#include <string.h>
+#include <asf.h>
+#include "dsp/fft.h"
+#include "evsys.h"
+#include "irqlevel.h"
+#include "power.h"
+#include "tone.h"
+
+//! \internal DAC code of 0 V out of the sine, mid scale of 12 bits
+#define TONE_MID                2048
+
+//! \internal Phase accumulator, a full turn being 2^32
+static uint32_t tone_phase;
+//! \internal Phase step per sample
+static uint32_t tone_step;
+//! \internal A tone is playing
+static bool tone_playing;
+//! \internal Channels of SPEAKER_DAC_MODULE in use, DAC_CH0 and DAC_CH1
+static uint8_t tone_dac_users;
+
+/**
+ * \internal
+ * \brief Next DAC sample of the oscillator
+ *
+ * The top FFT_LOG2_N_MAX bits of the phase index the sine table without
+ * interpolation, which puts the phase truncation spurs 60 dB down.
+ */
+static inline uint16_t tone_next(void)
+{
+	q15_t s = fft_cos(tone_phase >> (32 - FFT_LOG2_N_MAX));
+
+	tone_phase += tone_step;
+	return TONE_MID + (s >> (4 + TONE_LEVEL_SHIFT));
+}
+
+#if TONE_MODE == TONE_MODE_DMA
+
+//! \internal DAC samples, one half per channel of the DMA pair
+static uint16_t tone_buf[2][TONE_BLOCK];
+
+/**
+ * \internal
+ * \brief Fill half \a half of the DMA buffer
+ */
+static void tone_fill(uint8_t half)
+{
+	uint16_t *p = tone_buf[half];
+	uint8_t i;
+
+	for (i = 0; i < TONE_BLOCK; i++) {
+		*p++ = tone_next();
+	}
+}
+
+//! \internal First half sent, the second is being sent
+static void tone_half0_done(enum dma_channel_status status)
+{
+	if (status == DMA_CH_TRANSFER_COMPLETED) {
+		tone_fill(0);
+	}
+}
+
+//! \internal Second half sent, the first is being sent
+static void tone_half1_done(enum dma_channel_status status)
+{
+	if (status == DMA_CH_TRANSFER_COMPLETED) {
+		tone_fill(1);
+	}
+}
+
+/**
+ * \internal
+ * \brief Configure one DMA channel of the double buffer pair
+ *
+ * Each DAC data register empty request moves one 2 byte burst from
+ * \a src into CH0DATA. The source address is reloaded after every block,
+ * the destination after every burst.
+ */
+static void tone_dma_channel_init(dma_channel_num_t num, uint16_t *src)
+{
+	struct dma_channel_config config;
+
+	memset(&config, 0, sizeof(config));
+	dma_channel_set_burst_length(&config, DMA_CH_BURSTLEN_2BYTE_gc);
+	dma_channel_set_single_shot(&config);
+	dma_channel_set_repeats(&config, 0);
+	dma_channel_set_transfer_count(&config, sizeof(tone_buf[0]));
+	dma_channel_set_trigger_source(&config, DMA_CH_TRIGSRC_DACB_CH0_gc);
+	dma_channel_set_src_mode(&config, DMA_CH_SRCRELOAD_BLOCK_gc,
+			DMA_CH_SRCDIR_INC_gc);
+	dma_channel_set_dest_mode(&config, DMA_CH_DESTRELOAD_BURST_gc,
+			DMA_CH_DESTDIR_INC_gc);
+	dma_channel_set_source_address(&config, (uint16_t)src);
+	dma_channel_set_destination_address(&config,
+			(uint16_t)&DACB.CH0DATA);
+	dma_channel_set_interrupt_level(&config, IRQLEVEL_TONE_DMA);
+	dma_channel_write_config(num, &config);
+}
+
+#else /* TONE_MODE_ISR */
+
+//! \internal One sample per TONE_TC overflow, converted on the next one
+static inline void tone_tick(void)
+{
+	DACB.CH0DATA = tone_next();
+}
+
+TC_BIND_DIRECT(TCD0, OVF, tone_tick)
+
+#endif
+
+/**
+ * \internal
+ * \brief Enable the DACB channels in tone_dac_users, in dual channel mode
+ * as soon as channel 1 is among them
+ *
+ * Single channel mode of this DAC converts channel 0 only, so channel 1
+ * needs dual mode even on its own. The channels held in dual mode are
+ * refreshed every 30 us, the longest the sample and hold allows.
+ */
+static void tone_dac_configure(void)
+{
+	struct dac_config conf;
+	bool dual = tone_dac_users & DAC_CH1;
+
+	dac_read_configuration(&SPEAKER_DAC_MODULE, &conf);
+	dac_set_active_channel(&conf, tone_dac_users, 0);
+	if (dual) {
+		conf.ctrlb = (conf.ctrlb & ~DAC_CHSEL_gm) | DAC_CHSEL_DUAL_gc;
+	}
+	dac_set_refresh_interval(&conf, dual ? 30 : 0);
+	dac_set_conversion_interval(&conf, dual ? 2 : 1);
+	dac_write_configuration(&SPEAKER_DAC_MODULE, &conf);
+}
+
+/**
+ * \brief Start DACB channel \a ch, and the DAC with its first user
+ *
+ * DACB is shared by the tone on channel 0 and the \ref cv.h output on
+ * channel 1, each holding its channel while it plays. The other channel
+ * keeps its value.
+ *
+ * \param ch DAC_CH0 or DAC_CH1
+ */
+void tone_dac_get(uint8_t ch)
+{
+	Assert(!(tone_dac_users & ch));
+
+	if (!tone_dac_users) {
+		dac_enable(&SPEAKER_DAC_MODULE);
+	}
+	tone_dac_users |= ch;
+	tone_dac_configure();
+}
+
+/**
+ * \brief Stop DACB channel \a ch, and the DAC with its last user
+ *
+ * The output of the channel goes high impedance.
+ */
+void tone_dac_put(uint8_t ch)
+{
+	Assert(tone_dac_users & ch);
+
+	tone_dac_users &= ~ch;
+	if (tone_dac_users) {
+		tone_dac_configure();
+	} else {
+		dac_disable(&SPEAKER_DAC_MODULE);
+	}
+}
+
+/**
+ * \brief Set up DACB and TONE_TC, silent
+ *
+ * Call after \ref capture_init(), which resets the DMA controller.
+ */
+void tone_init(void)
+{
+	struct dac_config conf;
+
+	dac_read_configuration(&SPEAKER_DAC_MODULE, &conf);
+	dac_set_conversion_parameters(&conf, DAC_REF_AVCC, DAC_ADJ_RIGHT);
+	dac_set_active_channel(&conf, SPEAKER_DAC_CHANNEL, 0);
+	dac_set_conversion_trigger(&conf, SPEAKER_DAC_CHANNEL, TONE_EVENT_CH);
+	dac_write_configuration(&SPEAKER_DAC_MODULE, &conf);
+
+	evsys_route(TONE_EVENT_CH, EVSYS_CHMUX_TCD0_OVF_gc);
+
+	// Set up under the clock, which runs while a tone plays only
+	power_get(POWER_TONE);
+	tc_write_clock_source(&TONE_TC, TC_CLKSEL_OFF_gc);
+	tc_write_period(&TONE_TC, PROFILE_PER_HZ / TONE_RATE - 1);
+
+#if TONE_MODE == TONE_MODE_DMA
+	// Pair 2/3 next to the capture's 0/1, which keeps its priority
+	if (!(DMA.CTRL & DMA_ENABLE_bm)) {
+		dma_enable();
+	}
+	if ((DMA.CTRL & DMA_DBUFMODE_gm) == DMA_DBUFMODE_CH01_gc) {
+		dma_set_double_buffer_mode(DMA_DBUFMODE_CH01CH23_gc);
+	} else {
+		dma_set_double_buffer_mode(DMA_DBUFMODE_CH23_gc);
+	}
+	dma_set_priority_mode(DMA_PRIMODE_CH01RR23_gc);
+	dma_set_callback(TONE_DMA_CH_A, tone_half0_done);
+	dma_set_callback(TONE_DMA_CH_B, tone_half1_done);
+#else
+	tc_set_overflow_interrupt_level(&TONE_TC, IRQLEVEL_TONE_TC);
+#endif
+	power_put(POWER_TONE);
+}
+
+/**
+ * \brief Play a sine of \a freq, or retune the one playing
+ */
+void tone_start(pitch_hz_t freq)
+{
+	// freq is Q16.16 Hz, the step a fraction of 2^32 per sample
+	uint32_t step = (uint32_t)(((uint64_t)freq << 16) / TONE_RATE);
+	irqflags_t flags = cpu_irq_save();
+
+	tone_step = step;
+	cpu_irq_restore(flags);
+	if (tone_playing) {
+		return;
+	}
+
+	tone_phase = 0;
+	power_get(POWER_TONE);
+	tone_dac_get(SPEAKER_DAC_CHANNEL);
+#if TONE_MODE == TONE_MODE_DMA
+	tone_fill(0);
+	tone_fill(1);
+	tone_dma_channel_init(TONE_DMA_CH_A, tone_buf[0]);
+	tone_dma_channel_init(TONE_DMA_CH_B, tone_buf[1]);
+	dma_channel_enable(TONE_DMA_CH_A);
+#else
+	DACB.CH0DATA = tone_next();
+#endif
+	tc_write_count(&TONE_TC, 0);
+	tc_write_clock_source(&TONE_TC, TC_CLKSEL_DIV1_gc);
+	tone_playing = true;
+}
+
+/**
+ * \brief Stop the tone, the DAC output goes high impedance
+ */
+void tone_stop(void)
+{
+	if (!tone_playing) {
+		return;
+	}
+	tc_write_clock_source(&TONE_TC, TC_CLKSEL_OFF_gc);
+#if TONE_MODE == TONE_MODE_DMA
+	dma_channel_disable(TONE_DMA_CH_A);
+	dma_channel_disable(TONE_DMA_CH_B);
+#endif
+	tone_dac_put(SPEAKER_DAC_CHANNEL);
+	power_put(POWER_TONE);
+	tone_playing = false;
+}
+
+/**
+ * \brief Whether a tone is playing
+ */
+bool tone_is_playing(void)
+{
+	return tone_playing;
+}
@@ -0,0 +1,100 @@
+/**
+ * \file
+ *
+ * \brief Reference tone on the board speaker
+ *
+ * A direct digital synthesis oscillator plays a sine at the target pitch
+ * of a string, for tuning by ear. A 32-bit phase accumulator steps
+ * through the \ref fft.h quarter-wave sine table in flash, and DACB
+ * channel 0 drives the speaker amplifier on PB2.
+ *
+ * TONE_TC overflows at TONE_RATE and, through event channel
+ * TONE_EVENT_CH, start each DAC conversion, so the output timing is set by
+ * hardware and does not depend on when the next sample is written. The
+ * samples come from one of two paths chosen with \ref TONE_MODE:
+ * - \ref TONE_MODE_DMA: DMA channels 2 and 3, a double buffer pair
+ *   triggered by the DAC data register, move TONE_BLOCK samples each; the
+ *   low level completion interrupt refills the finished half.
+ * - \ref TONE_MODE_ISR: a low level TONE_TC overflow interrupt writes one
+ *   sample, for the dual ADC builds where the capture owns all four DMA
+ *   channels.
+ *
+ * Neither touches the ADCA sweep: it is started by the TCC1 event and
+ * read by the high level capture interrupt or DMA channels 0 and 1, which
+ * have priority over the tone channels.
+ *
+ * DACB channel 1 on PB3 is left to the \ref cv.h output. Each of the two
+ * holds its channel with \ref tone_dac_get() while in use, and the DAC
+ * runs in dual channel mode while channel 1 is, as single channel mode
+ * converts channel 0 only; only channel 0 converts on TONE_EVENT_CH, as
+ * the DAC has a single event select.
+ *
+ * The board header gives PQ3 as both the speaker enable and the DataFlash
+ * chip select, so the amplifier mutes for the length of each DataFlash
+ * transfer.
+ *
+ */
+
+#ifndef TONE_H
+#define TONE_H
+
+#include <compiler.h>
+#include "capture.h"
+#include "pitch.h"
+
+//! \name Sample paths
+//@{
+//! DMA double buffer, refilled per half
+#define TONE_MODE_DMA           0
+//! One low level interrupt per sample
+#define TONE_MODE_ISR           1
+//@}
+
+#ifndef TONE_MODE
+#  if CAPTURE_ADC == CAPTURE_ADC_SINGLE || CAPTURE_MODE != CAPTURE_MODE_DMA
+#    define TONE_MODE TONE_MODE_DMA
+#  else
+#    define TONE_MODE TONE_MODE_ISR
+#  endif
+#endif
+
+#if TONE_MODE == TONE_MODE_DMA && CAPTURE_ADC != CAPTURE_ADC_SINGLE
+#  error "The dual ADC arrangements use DMA channels 2 and 3"
+#endif
+
+//! Timer clocking the DAC conversions, also named by the event mux and
+//! interrupt of tone.c
+#define TONE_TC                 TCD0
+//! Event channel from TONE_TC to the DAC, after those of capture.h
+#define TONE_EVENT_CH           2
+//! DMA double buffer pair of \ref TONE_MODE_DMA
+#define TONE_DMA_CH_A           2
+#define TONE_DMA_CH_B           3
+
+//! Output sample rate in Hz
+#ifndef TONE_RATE
+#  define TONE_RATE             32000UL
+#endif
+
+//! Samples per DMA half buffer
+#ifndef TONE_BLOCK
+#  define TONE_BLOCK            32
+#endif
+
+//! Right shift of the full scale sine, 0 for full scale
+#ifndef TONE_LEVEL_SHIFT
+#  define TONE_LEVEL_SHIFT      2
+#endif
+
+#if PROFILE_PER_HZ % TONE_RATE || PROFILE_PER_HZ / TONE_RATE > 0x10000UL
+#  error "TONE_RATE must divide the peripheral clock into a timer period"
+#endif
+
+void tone_init(void);
+void tone_start(pitch_hz_t freq);
+void tone_stop(void);
+bool tone_is_playing(void);
+void tone_dac_get(uint8_t ch);
+void tone_dac_put(uint8_t ch);
+
+#endif /* TONE_H */
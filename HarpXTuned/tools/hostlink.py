@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Decode the binary frames of src/hostlink.h into CSV lines.
+
+Reads the raw byte stream from a file or a serial device already set to
+the link rate, e.g.
+
+    stty -F /dev/ttyACM0 1000000 raw
+    python3 tools/hostlink.py /dev/ttyACM0 > session.csv
+
+Readings come out as
+    R,time,ch,freq_hz,cents,string,flags,level,inharm,age
+with time in microseconds and age how old the reading was as it left,
+also in microseconds
+and samples as
+    S,ch,frame,decim,sample,sample,...
+A snapshot of the capture ring is written to snapshot-<n>.raw, frames of
+interleaved little endian int16 samples oldest first, and noted as
+    F,n,file,rate,channels,frames
+Frames failing the CRC are counted on stderr and skipped.
+"""
+
+import struct
+import sys
+
+# Must match capture.h and hostlink.h
+CHANNELS = 4
+READINGS = 1
+SAMPLES = 2
+SNAPSHOT = 3
+
+snapshot = {"count": 0, "data": bytearray()}
+
+
+def crc_ccitt(data):
+    """CRC of avr-libc _crc_ccitt_update() from 0xffff."""
+    crc = 0xffff
+    for b in data:
+        b ^= crc & 0xff
+        b = (b ^ (b << 4)) & 0xff
+        crc = ((b << 8) | (crc >> 8)) ^ (b >> 4) ^ (b << 3)
+        crc &= 0xffff
+    return crc
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xff and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+def frame(data, out):
+    kind, seq = data[0], data[1]
+    body = data[2:]
+    if kind == READINGS:
+        (time,) = struct.unpack_from("<I", body)
+        for ch in range(CHANNELS):
+            (freq, cents, string, flags, level, inharm,
+             stamp) = struct.unpack_from("<IhBBHHI", body, 4 + 16 * ch)
+            out.write("R,%u,%u,%.3f,%.2f,%d,%u,%u,%u,%u\n" % (
+                time, ch, freq / 65536.0, cents / 256.0,
+                -1 if string == 0xff else string, flags, level, inharm,
+                (time - stamp) & 0xffffffff))
+    elif kind == SAMPLES:
+        ch, decim, first = struct.unpack_from("<BBI", body)
+        n = (len(body) - 6) // 2
+        samples = struct.unpack_from("<%dh" % n, body, 6)
+        out.write("S,%u,%u,%u,%s\n" % (
+            ch, first, decim, ",".join(str(s) for s in samples)))
+    elif kind == SNAPSHOT:
+        first, total, rate, chans = struct.unpack_from("<HHHB", body)
+        if first == 0:
+            snapshot["data"] = bytearray()
+        if first == len(snapshot["data"]) // (2 * chans):
+            snapshot["data"] += body[7:]
+        frames = len(snapshot["data"]) // (2 * chans)
+        if frames == total:
+            name = "snapshot-%u.raw" % snapshot["count"]
+            with open(name, "wb") as f:
+                f.write(snapshot["data"])
+            out.write("F,%u,%s,%u,%u,%u\n" % (
+                snapshot["count"], name, rate, chans, total))
+            snapshot["count"] += 1
+            snapshot["data"] = bytearray()
+    return seq
+
+
+def main():
+    src = open(sys.argv[1], "rb") if len(sys.argv) > 1 else sys.stdin.buffer
+    out = sys.stdout
+    buf = bytearray()
+    bad = 0
+    lost = 0
+    last = None
+    while True:
+        chunk = src.read(1) if src.isatty() else src.read(4096)
+        if not chunk:
+            break
+        buf += chunk
+        while True:
+            end = buf.find(0)
+            if end < 0:
+                break
+            data = cobs_decode(bytes(buf[:end]))
+            del buf[:end + 1]
+            if (data is None or len(data) < 4
+                    or crc_ccitt(data[:-2]) != struct.unpack("<H", data[-2:])[0]):
+                bad += 1
+                continue
+            seq = frame(data[:-2], out)
+            if last is not None:
+                lost += (seq - last - 1) & 0xff
+            last = seq
+    sys.stderr.write("%u bad frames, %u dropped\n" % (bad, lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Generate src/notes_table.c, the note and cents tables of notes.h, and
+src/harp_table.c, the notes of the strings of harp.h.
+
+Run from the project directory after changing a table below, the
+NOTES_* sizes in notes.h or the strings of harp.h:
+
+    python3 tools/notes_table.py > src/notes_table.c
+    python3 tools/notes_table.py --strings > src/harp_table.c
+"""
+
+import math
+import sys
+
+# Must match notes.h
+CENTS_SHIFT = 4
+LOG2_STEPS = 6
+
+# Strings of the harp from C1, a diatonic C major scale, see harp.h
+STRINGS = 47
+FIRST_NOTE = 24
+SCALE = [0, 2, 4, 5, 7, 9, 11]
+
+# Offsets from equal temperament in cents, C to B, with A kept at 0 so
+# that A4 stays the reference
+TEMPERAMENTS = [
+    ("equal", [0.0] * 12),
+    ("pythagorean", None),
+    ("just", None),
+    ("meantone", None),
+    ("werckmeister", None),
+    ("vallotti", None),
+]
+
+
+def from_ratios(ratios):
+    """Offsets of 12 ratios over C, shifted to leave A in place."""
+    cents = [1200 * math.log2(r) - 100 * i for i, r in enumerate(ratios)]
+    return [c - cents[9] for c in cents]
+
+
+def from_fifths(tempering):
+    """Chain of fifths from Eb to G#, the fifth i narrowed by tempering[i]
+    of the Pythagorean comma, or of the syntonic comma for ("S", part)."""
+    pc = 1200 * math.log2(3 ** 12 / 2 ** 19)
+    sc = 1200 * math.log2(81 / 80)
+    note = 3
+    pitch = {note: 0.0}
+    cents = 0.0
+    for t in tempering:
+        narrow = sc * t[1] if isinstance(t, tuple) else pc * t
+        cents += 1200 * math.log2(1.5) - narrow
+        note = (note + 7) % 12
+        pitch[note] = cents
+    offs = [pitch[i] - 100 * i for i in range(12)]
+    offs = [(o + 600) % 1200 - 600 for o in offs]
+    return [o - offs[9] for o in offs]
+
+
+def build():
+    temps = dict(TEMPERAMENTS)
+    temps["pythagorean"] = from_fifths([0] * 11)
+    temps["just"] = from_ratios([1, 16 / 15, 9 / 8, 6 / 5, 5 / 4, 4 / 3,
+                                 45 / 32, 3 / 2, 8 / 5, 5 / 3, 9 / 5, 15 / 8])
+    temps["meantone"] = from_fifths([("S", 0.25)] * 11)
+    # Eb Bb F C G D A E B F# C# G#
+    temps["werckmeister"] = from_fifths([0, 0, 0, 0.25, 0.25, 0.25, 0, 0,
+                                         0.25, 0, 0])
+    temps["vallotti"] = from_fifths([0, 0] + [1 / 6] * 6 + [0, 0, 0])
+    return temps
+
+
+def strings():
+    notes = [FIRST_NOTE + 12 * (i // 7) + SCALE[i % 7] for i in range(STRINGS)]
+    out = []
+    out.append("""/**
+ * \\file
+ *
+ * \\brief String notes of harp.h
+ *
+ * Generated by tools/notes_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "harp.h"
+""")
+    out.append("// Equal temperament note of each string, C1 to G7")
+    out.append("PROGMEM_DECLARE(uint8_t, "
+               "notes_string_table[HARP_STRINGS]) = {")
+    for i in range(0, len(notes), 7):
+        out.append("\t" + " ".join("%3d," % v for v in notes[i:i + 7]))
+    out.append("};")
+    print("\n".join(out))
+
+
+def main():
+    if sys.argv[1:] == ["--strings"]:
+        strings()
+        return
+    one = 1 << CENTS_SHIFT
+    steps = 1 << LOG2_STEPS
+    log2 = [round(1200 * one * math.log2(1 + i / steps))
+            for i in range(steps + 1)]
+    temps = build()
+
+    out = []
+    out.append("""/**
+ * \\file
+ *
+ * \\brief Note and cents tables of notes.h
+ *
+ * Generated by tools/notes_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "notes.h"
+""")
+    out.append("// 1200 * 2^NOTES_CENTS_SHIFT * log2(1 + i / NOTES_LOG2_STEPS)")
+    out.append("PROGMEM_DECLARE(uint16_t, "
+               "notes_log2_table[NOTES_LOG2_STEPS + 1]) = {")
+    for i in range(0, len(log2), 8):
+        out.append("\t" + " ".join("%5d," % v for v in log2[i:i + 8]))
+    out.append("};\n")
+    out.append("// Cents from equal temperament, 2^-NOTES_CENTS_SHIFT, "
+               "C to B")
+    out.append("PROGMEM_DECLARE(int16_t, "
+               "notes_temperament_table[NOTES_TEMPERAMENTS][12]) = {")
+    for name, _ in TEMPERAMENTS:
+        vals = [round(c * one) for c in temps[name]]
+        out.append("\t// %s" % name)
+        out.append("\t{ " + ", ".join("%d" % v for v in vals) + " },")
+    out.append("};")
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Load the temperaments or the strings of tools/notes_table.py into a
+running tuner with the "tables load" command of src/tableload.h.
+
+Edit the tables in notes_table.py, then, with the serial device set to
+the text rate and the link off,
+
+    stty -F /dev/ttyACM0 115200 raw
+    python3 tools/tableload.py /dev/ttyACM0 temperaments
+    python3 tools/tableload.py /dev/ttyACM0 strings
+
+The strings go out as their notes with the open frequencies at A4 =
+440 Hz worked out here.
+"""
+
+import os
+import struct
+import sys
+
+import notes_table
+from hostlink import crc_ccitt
+
+
+def temperaments():
+    temps = notes_table.build()
+    one = 1 << notes_table.CENTS_SHIFT
+    values = [round(c * one) for name, _ in notes_table.TEMPERAMENTS
+              for c in temps[name]]
+    return struct.pack("<%dh" % len(values), *values)
+
+
+def strings():
+    notes = [notes_table.FIRST_NOTE + 12 * (i // 7)
+             + notes_table.SCALE[i % 7] for i in range(notes_table.STRINGS)]
+    freqs = [round(440 * 2 ** ((n - 69) / 12) * 65536) for n in notes]
+    return struct.pack("<%dI" % len(freqs), *freqs) + bytes(notes)
+
+
+def readline(fd):
+    line = bytearray()
+    while not line.endswith(b"\n"):
+        c = os.read(fd, 1)
+        if not c:
+            raise EOFError("device closed")
+        line += c
+    return line.strip().decode("ascii", "replace")
+
+
+def main():
+    if len(sys.argv) != 3 or sys.argv[2] not in ("temperaments", "strings"):
+        sys.exit("usage: tableload.py DEVICE temperaments|strings")
+    table = temperaments() if sys.argv[2] == "temperaments" else strings()
+    fd = os.open(sys.argv[1], os.O_RDWR | os.O_NOCTTY)
+
+    # CR alone: the board takes every byte after it as the table
+    os.write(fd, b"tables load %s\r" % sys.argv[2].encode())
+    line = readline(fd)
+    while not line.startswith("load "):
+        if line.startswith("bad command"):
+            sys.exit("refused: link on, recording, or a load running")
+        line = readline(fd)
+    size, chunk = (int(v) for v in line.split()[1:3])
+    if size != len(table):
+        # The board gives up after its timeout
+        sys.exit("board expects %u bytes, not %u" % (size, len(table)))
+
+    pos = 0
+    while True:
+        data = table[pos:pos + chunk].ljust(chunk, b"\xff")
+        os.write(fd, data + struct.pack("<H", crc_ccitt(data)))
+        line = readline(fd)
+        if line == "next":
+            pos += chunk
+        elif line == "again":
+            continue
+        elif line == "loaded":
+            print("loaded %u bytes" % size)
+            return
+        else:
+            sys.exit(line)
+
+
+if __name__ == "__main__":
+    main()
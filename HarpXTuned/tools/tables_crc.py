@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Generate src/tables_crc.h, the CRCs shipped with the flash tables that
+tables.c checks.
+
+Run from the project directory after regenerating any of the tables:
+
+    python3 tools/tables_crc.py > src/tables_crc.h
+
+The tables are read back from the generated sources, so the CRC is taken
+over the bytes the compiler lays out in flash, little-endian.
+"""
+
+import re
+import struct
+import sys
+
+sys.path.insert(0, "tools")
+from hostlink import crc_ccitt
+
+# Generated sources of the tables that tables.c covers
+SOURCES = [
+    "src/dsp/fft_table.c",
+    "src/dsp/window_table.c",
+    "src/notes_table.c",
+    "src/harp_table.c",
+    "src/tempcomp_table.c",
+]
+
+FORMATS = {"int8_t": "b", "uint8_t": "B", "int16_t": "h", "uint16_t": "H"}
+
+DECLARE = re.compile(r"PROGMEM_DECLARE\((\w+), (\w+)\[.*?\) = \{(.*?)\n\};",
+                     re.S)
+CONDITION = re.compile(r"^#(?:el)?if (.*)$", re.M)
+
+
+def tables(path):
+    """(condition, name, CRC) of each array of the source at path."""
+    text = open(path).read()
+    text = re.sub(r"//.*", "", text)
+    out = []
+    for m in DECLARE.finditer(text):
+        ctype, name, body = m.groups()
+        values = [int(v, 0) for v in re.findall(r"-?\w+", body)]
+        data = struct.pack("<%d%s" % (len(values), FORMATS[ctype]), *values)
+        cond = None
+        for c in CONDITION.finditer(text, 0, m.start()):
+            cond = c.group(1)
+        out.append((cond, name, crc_ccitt(data)))
+    return out
+
+
+def main():
+    print("""/**
+ * \\file
+ *
+ * \\brief CRCs of the generated tables in flash, see tables.h
+ *
+ * CRC-CCITT of each table from 0xffff, as avr-libc _crc_ccitt_update()
+ * takes it. Generated by tools/tables_crc.py, do not edit.
+ *
+ */
+
+#ifndef TABLES_CRC_H
+#define TABLES_CRC_H
+""")
+    for path in SOURCES:
+        entries = tables(path)
+        conditional = entries[0][0] is not None
+        for i, (cond, name, crc) in enumerate(entries):
+            macro = "TABLES_CRC_" + name.upper()
+            if conditional:
+                print("#%s %s" % ("if" if i == 0 else "elif", cond))
+                print("#  define %-32s 0x%04x" % (macro, crc))
+            else:
+                print("#define %-35s 0x%04x" % (macro, crc))
+        if conditional:
+            print("#endif")
+    print("""
+#endif /* TABLES_CRC_H */""")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Generate src/tempcomp_table.c, the RC oscillator drift over the board
+temperature sensor reading of tempcomp.h.
+
+Run from the project directory after changing the sensor or oscillator
+model below, or TEMPCOMP_LOG2_STEP in tempcomp.h:
+
+    python3 tools/tempcomp_table.py > src/tempcomp_table.c
+"""
+
+import math
+
+# Must match notes.h and tempcomp.h
+CENTS_SHIFT = 4
+LOG2_STEP = 7
+CODES = 2048
+
+# ADCB, signed single-ended against VCC / 1.6
+REF_RATIO = 1 / 1.6
+
+# Board sensor: the NTC from the signal to the enable pin, driven low, and
+# the series resistor up to VCC
+NTC_R25 = 100e3
+NTC_B = 4250.0
+SERIES_R = 100e3
+
+# RC32M slope around its calibration point, from the typical curve of the
+# XMEGA A datasheet; measure the part for a closer fit
+RC_PPM_PER_C = -300.0
+RC_CAL_C = 25.0
+# Operating range, the table holds its ends beyond it
+MIN_C = -20.0
+MAX_C = 85.0
+
+
+def celsius(code):
+    """Sensor temperature at ADC result code, None out of range."""
+    ratio = code / CODES * REF_RATIO
+    if ratio <= 0 or ratio >= 1:
+        return None
+    r = SERIES_R * ratio / (1 - ratio)
+    inv = 1 / 298.15 + math.log(r / NTC_R25) / NTC_B
+    return 1 / inv - 273.15
+
+
+def offset(code):
+    """Clock error in 2^-CENTS_SHIFT cent, positive when fast."""
+    t = celsius(max(1, min(code, CODES - 1)))
+    t = max(MIN_C, min(t, MAX_C))
+    ppm = RC_PPM_PER_C * (t - RC_CAL_C)
+    return round(1200 * (1 << CENTS_SHIFT) * math.log2(1 + ppm * 1e-6))
+
+
+def main():
+    steps = CODES >> LOG2_STEP
+    values = [offset(i << LOG2_STEP) for i in range(steps + 1)]
+    print("""/**
+ * \\file
+ *
+ * \\brief RC oscillator drift table of tempcomp.h
+ *
+ * Generated by tools/tempcomp_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "tempcomp.h"
+
+// RC32M error in 2^-NOTES_CENTS_SHIFT cent at each sensor code step,
+// %g ppm/C from %g C, held above %g C and below %g C
+PROGMEM_DECLARE(int16_t, tempcomp_table[TEMPCOMP_STEPS + 1]) = {"""
+          % (RC_PPM_PER_C, RC_CAL_C, MAX_C, MIN_C))
+    for i in range(0, len(values), 8):
+        print("\t" + " ".join("%5d," % v for v in values[i:i + 8]))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Generate src/dsp/window_table.c, the window tables of dsp/window.h.
+
+Run from the project directory after changing WINDOW_LOG2_N_MAX or adding
+a window:
+
+    python3 tools/window_table.py > src/dsp/window_table.c
+"""
+
+import math
+
+# Must match dsp/window.h
+LOG2_N_MAX = 10
+
+# Name, table name and cosine coefficients a0, a1, a2 of
+# a0 - a1 cos(2 pi i / N) + a2 cos(4 pi i / N)
+WINDOWS = [
+    ("WINDOW_HANN", "Hann", (0.5, 0.5, 0.0)),
+    ("WINDOW_BLACKMAN", "Blackman", (0.42, 0.5, 0.08)),
+]
+
+
+def table(coefs):
+    """First half of the periodic window, up to and with its peak."""
+    n = 1 << LOG2_N_MAX
+    a0, a1, a2 = coefs
+    out = []
+    for i in range(n // 2 + 1):
+        x = 2 * math.pi * i / n
+        w = a0 - a1 * math.cos(x) + a2 * math.cos(2 * x)
+        out.append(max(0, min(32767, round(32767 * w))))
+    return out
+
+
+def main():
+    out = []
+    out.append("""/**
+ * \\file
+ *
+ * \\brief Window tables of dsp/window.h
+ *
+ * The first half of each periodic window of WINDOW_N_MAX points, to its
+ * peak, in Q15. Generated by tools/window_table.py, do not edit.
+ *
+ */
+
+#include <compiler.h>
+#include <progmem.h>
+#include "window.h"
+""")
+    for i, (macro, name, coefs) in enumerate(WINDOWS):
+        out.append("#%s WINDOW_TYPE == %s" % ("if" if i == 0 else "elif",
+                                               macro))
+        out.append("// %s" % name)
+        out.append("PROGMEM_DECLARE(uint16_t, "
+                   "window_table[WINDOW_N_MAX / 2 + 1]) = {")
+        vals = table(coefs)
+        for j in range(0, len(vals), 8):
+            out.append("\t" + " ".join("%5d," % v for v in vals[j:j + 8]))
+        out.append("};")
+    out.append("#else")
+    out.append("#  error \"Unknown WINDOW_TYPE\"")
+    out.append("#endif")
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()